@@ -429,7 +429,11 @@ cdef extern from 'client/client.h' namespace 'cl':
         weaver_client_returncode start_migration()
         weaver_client_returncode single_stream_migration()
         weaver_client_returncode exit_weaver()
+        weaver_client_returncode set_traversal_sampling(uint64_t period)
         weaver_client_returncode get_node_count(vector[uint64_t]&)
+        weaver_client_returncode get_metrics(vector[string]&)
+        weaver_client_returncode set_prog_trace_sampling(uint64_t period)
+        weaver_client_returncode get_prog_traces(vector[string]&)
         bint aux_index()
 
 class WeaverError(Exception):
@@ -1143,6 +1147,10 @@ cdef class Client:
         code = self.thisptr.exit_weaver()
         if code != WEAVER_CLIENT_SUCCESS:
             raise WeaverError(code)
+    def set_traversal_sampling(self, period):
+        code = self.thisptr.set_traversal_sampling(period)
+        if code != WEAVER_CLIENT_SUCCESS:
+            raise WeaverError(code)
     def get_node_count(self):
         cdef vector[uint64_t] node_count
         code = self.thisptr.get_node_count(node_count)
@@ -1154,5 +1162,21 @@ cdef class Client:
             count.append(deref(iter))
             inc(iter)
         return count
+    def get_metrics(self):
+        cdef vector[string] dumps
+        code = self.thisptr.get_metrics(dumps)
+        if code != WEAVER_CLIENT_SUCCESS:
+            raise WeaverError(code)
+        return [d for d in dumps]
+    def set_prog_trace_sampling(self, period):
+        code = self.thisptr.set_prog_trace_sampling(period)
+        if code != WEAVER_CLIENT_SUCCESS:
+            raise WeaverError(code)
+    def get_prog_traces(self):
+        cdef vector[string] traces
+        code = self.thisptr.get_prog_traces(traces)
+        if code != WEAVER_CLIENT_SUCCESS:
+            raise WeaverError(code)
+        return [t for t in traces]
     def aux_index(self):
         return self.thisptr.aux_index()
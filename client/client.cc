@@ -499,6 +499,35 @@ client :: run_pathless_reach_program(std::vector<std::pair<std::string, node_pro
     SPECIFIC_NODE_PROG(node_prog::PATHLESS_REACHABILITY);
 }
 
+weaver_client_returncode
+client :: run_n_hop_reach_program(std::vector<std::pair<std::string, node_prog::n_hop_reach_params>> &initial_args, node_prog::n_hop_reach_params &return_param)
+{
+    SPECIFIC_NODE_PROG(node_prog::N_HOP_REACHABILITY);
+}
+
+weaver_client_returncode
+client :: run_dijkstra_program(std::vector<std::pair<std::string, node_prog::dijkstra_params>> &initial_args, node_prog::dijkstra_params &return_param)
+{
+    if (initial_args.size() != 1) {
+        return WEAVER_CLIENT_LOGICALERROR;
+    }
+    SPECIFIC_NODE_PROG(node_prog::DIJKSTRA);
+}
+
+weaver_client_returncode
+client :: run_triangle_program(std::vector<std::pair<std::string, node_prog::triangle_params>> &initial_args, node_prog::triangle_params &return_param)
+{
+    if (initial_args.empty()) {
+        return WEAVER_CLIENT_LOGICALERROR;
+    }
+    for (auto &p: initial_args) {
+        p.second.phase = node_prog::TRIANGLE_PHASE_START;
+        p.second.root.handle = initial_args.front().first;
+        p.second.num_nodes = initial_args.size();
+    }
+    SPECIFIC_NODE_PROG(node_prog::TRIANGLE_COUNT);
+}
+
 weaver_client_returncode
 client :: run_clustering_program(std::vector<std::pair<std::string, node_prog::clustering_params>> &initial_args, node_prog::clustering_params &return_param)
 {
@@ -566,6 +595,44 @@ client :: get_btc_block_program(std::vector<std::pair<std::string, node_prog::ge
 
 #undef SPECIFIC_NODE_PROG
 
+// whole-graph jobs run for many supersteps, so keep waiting on timeout instead of resending
+weaver_client_returncode
+client :: run_bsp_program(bsp::params &params, bsp::result &result)
+{
+    CHECK_INIT;
+
+    message::message msg;
+    msg.prepare_message(message::CLIENT_BSP_REQ, params);
+    busybee_returncode send_code = send_coord(msg.buf);
+
+    if (send_code == BUSYBEE_DISRUPTED) {
+        reconfigure();
+        return WEAVER_CLIENT_DISRUPTED;
+    } else if (send_code != BUSYBEE_SUCCESS) {
+        return WEAVER_CLIENT_INTERNALMSGERROR;
+    }
+
+    while (true) {
+        busybee_returncode recv_code = recv_coord(&msg.buf);
+
+        switch (recv_code) {
+            case BUSYBEE_TIMEOUT:
+                break;
+
+            case BUSYBEE_DISRUPTED:
+                reconfigure();
+                return WEAVER_CLIENT_DISRUPTED;
+
+            case BUSYBEE_SUCCESS:
+                msg.unpack_message(message::CLIENT_BSP_REPLY, result);
+                return WEAVER_CLIENT_SUCCESS;
+
+            default:
+                return WEAVER_CLIENT_INTERNALMSGERROR;
+        }
+    }
+}
+
 weaver_client_returncode
 client :: start_migration()
 {
@@ -607,6 +674,20 @@ client :: exit_weaver()
     return WEAVER_CLIENT_SUCCESS;
 }
 
+weaver_client_returncode
+client :: set_traversal_sampling(uint64_t period)
+{
+    CHECK_INIT;
+
+    message::message msg;
+    msg.prepare_message(message::TRAVERSAL_SAMPLING, period);
+    if (send_coord(msg.buf) != BUSYBEE_SUCCESS) {
+        return WEAVER_CLIENT_INTERNALMSGERROR;
+    }
+
+    return WEAVER_CLIENT_SUCCESS;
+}
+
 weaver_client_returncode
 client :: get_node_count(std::vector<uint64_t> &node_count)
 {
@@ -644,6 +725,94 @@ client :: get_node_count(std::vector<uint64_t> &node_count)
     }
 }
 
+weaver_client_returncode
+client :: get_metrics(std::vector<std::string> &dumps)
+{
+    CHECK_INIT;
+
+    dumps.clear();
+
+    while(true) {
+        message::message msg;
+        msg.prepare_message(message::CLIENT_METRICS_REQ);
+        busybee_returncode send_code = send_coord(msg.buf);
+
+        if (send_code == BUSYBEE_DISRUPTED) {
+            reconfigure();
+            continue;
+        } else if (send_code != BUSYBEE_SUCCESS) {
+            return WEAVER_CLIENT_INTERNALMSGERROR;
+        }
+
+        busybee_returncode recv_code = recv_coord(&msg.buf);
+
+        switch (recv_code) {
+            case BUSYBEE_DISRUPTED:
+            case BUSYBEE_TIMEOUT:
+                reconfigure();
+                break;
+
+            case BUSYBEE_SUCCESS:
+                msg.unpack_message(message::CLIENT_METRICS_REPLY, dumps);
+                return WEAVER_CLIENT_SUCCESS;
+
+            default:
+                return WEAVER_CLIENT_INTERNALMSGERROR;
+        }
+    }
+}
+
+weaver_client_returncode
+client :: set_prog_trace_sampling(uint64_t period)
+{
+    CHECK_INIT;
+
+    message::message msg;
+    msg.prepare_message(message::PROG_TRACE_SAMPLING, period);
+    if (send_coord(msg.buf) != BUSYBEE_SUCCESS) {
+        return WEAVER_CLIENT_INTERNALMSGERROR;
+    }
+
+    return WEAVER_CLIENT_SUCCESS;
+}
+
+weaver_client_returncode
+client :: get_prog_traces(std::vector<std::string> &traces)
+{
+    CHECK_INIT;
+
+    traces.clear();
+
+    while(true) {
+        message::message msg;
+        msg.prepare_message(message::CLIENT_TRACES_REQ);
+        busybee_returncode send_code = send_coord(msg.buf);
+
+        if (send_code == BUSYBEE_DISRUPTED) {
+            reconfigure();
+            continue;
+        } else if (send_code != BUSYBEE_SUCCESS) {
+            return WEAVER_CLIENT_INTERNALMSGERROR;
+        }
+
+        busybee_returncode recv_code = recv_coord(&msg.buf);
+
+        switch (recv_code) {
+            case BUSYBEE_DISRUPTED:
+            case BUSYBEE_TIMEOUT:
+                reconfigure();
+                break;
+
+            case BUSYBEE_SUCCESS:
+                msg.unpack_message(message::CLIENT_TRACES_REPLY, traces);
+                return WEAVER_CLIENT_SUCCESS;
+
+            default:
+                return WEAVER_CLIENT_INTERNALMSGERROR;
+        }
+    }
+}
+
 #undef CHECK_INIT
 
 bool
@@ -21,11 +21,15 @@
 #include "common/message_constants.h"
 #include "common/server_manager_link_wrapper.h"
 #include "common/transaction.h"
+#include "common/bsp.h"
 #include "client/comm_wrapper.h"
 #include "client/datastructures.h"
 #include "node_prog/node_prog_type.h"
 #include "node_prog/reach_program.h"
 #include "node_prog/pathless_reach_program.h"
+#include "node_prog/n_hop_reach_program.h"
+#include "node_prog/dijkstra_program.h"
+#include "node_prog/triangle_program.h"
 #include "node_prog/clustering_program.h"
 #include "node_prog/two_neighborhood_program.h"
 #include "node_prog/read_node_props_program.h"
@@ -91,6 +95,10 @@ namespace cl
             weaver_client_returncode run_node_program(node_prog::prog_type prog_to_run, std::vector<std::pair<std::string, ParamsType>> &initial_args, ParamsType &return_param);
             weaver_client_returncode run_reach_program(std::vector<std::pair<std::string, node_prog::reach_params>> &initial_args, node_prog::reach_params&);
             weaver_client_returncode run_pathless_reach_program(std::vector<std::pair<std::string, node_prog::pathless_reach_params>> &initial_args, node_prog::pathless_reach_params&);
+            weaver_client_returncode run_n_hop_reach_program(std::vector<std::pair<std::string, node_prog::n_hop_reach_params>> &initial_args, node_prog::n_hop_reach_params&);
+            weaver_client_returncode run_dijkstra_program(std::vector<std::pair<std::string, node_prog::dijkstra_params>> &initial_args, node_prog::dijkstra_params&);
+            // sets root and num_nodes of all initial args, root is the first start node and must be a handle, not an alias
+            weaver_client_returncode run_triangle_program(std::vector<std::pair<std::string, node_prog::triangle_params>> &initial_args, node_prog::triangle_params&);
             weaver_client_returncode run_clustering_program(std::vector<std::pair<std::string, node_prog::clustering_params>> &initial_args, node_prog::clustering_params&);
             weaver_client_returncode run_two_neighborhood_program(std::vector<std::pair<std::string, node_prog::two_neighborhood_params>> &initial_args, node_prog::two_neighborhood_params&);
             weaver_client_returncode read_node_props_program(std::vector<std::pair<std::string, node_prog::read_node_props_params>> &initial_args, node_prog::read_node_props_params&);
@@ -101,12 +109,22 @@ namespace cl
             weaver_client_returncode traverse_props_program(std::vector<std::pair<std::string, node_prog::traverse_props_params>> &initial_args, node_prog::traverse_props_params&);
             weaver_client_returncode discover_paths_program(std::vector<std::pair<std::string, node_prog::discover_paths_params>> &initial_args, node_prog::discover_paths_params&);
             weaver_client_returncode get_btc_block_program(std::vector<std::pair<std::string, node_prog::get_btc_block_params>> &initial_args, node_prog::get_btc_block_params&);
+            // bulk synchronous job over the whole graph at one snapshot
+            weaver_client_returncode run_bsp_program(bsp::params&, bsp::result&);
 
             weaver_client_returncode start_migration();
             weaver_client_returncode single_stream_migration();
             weaver_client_returncode exit_weaver();
+            // sample one in 'period' node program visits on all shards, 0 turns sampling off
+            weaver_client_returncode set_traversal_sampling(uint64_t period);
             uint64_t get_vt_id() { return vtid; }
             weaver_client_returncode get_node_count(std::vector<uint64_t>&);
+            // Prometheus text dump of the timestamper this client talks to, followed by one per shard
+            weaver_client_returncode get_metrics(std::vector<std::string> &dumps);
+            // trace one in 'period' node programs started by this client's timestamper, 0 turns tracing off
+            weaver_client_returncode set_prog_trace_sampling(uint64_t period);
+            // critical paths of traced node programs finished since the last call
+            weaver_client_returncode get_prog_traces(std::vector<std::string> &traces);
             bool aux_index();
             void print_cur_tx();
 
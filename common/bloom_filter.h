@@ -0,0 +1,113 @@
+/*
+ * ===============================================================
+ *    Description:  Blocked Bloom filter over 64 bit hashes, safe
+ *                  for concurrent inserts and lookups.
+ *
+ *        Created:  2026-10-19 15:46:24
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_common_bloom_filter_h_
+#define weaver_common_bloom_filter_h_
+
+#include <stdint.h>
+#include <cmath>
+#include <atomic>
+#include <memory>
+
+#include "common/types.h"
+
+#define BLOOM_BLOCK_WORDS 8 // 512 bit blocks, size of a cache line
+#define BLOOM_NUM_PROBES 6 // bits set per key, all in the same block
+
+namespace weaver_util
+{
+    // All bits of a key fall in a single 64 byte block, so a lookup costs about one cache miss.
+    // No false negatives: may_contain returns false only if the hash was never inserted.
+    // Keys cannot be removed, deleted keys are only dropped when the filter is rebuilt.
+    class bloom_filter
+    {
+        private:
+            struct block
+            {
+                std::atomic<uint64_t> words[BLOOM_BLOCK_WORDS];
+            };
+
+            uint64_t num_blocks;
+            std::unique_ptr<block[]> blocks;
+
+            block& block_of(uint64_t hash) const
+            {
+                // block chosen with bits independent of those that choose bits within the block
+                uint64_t mixed = hash_node_id(hash);
+                return blocks[(uint64_t)(((unsigned __int128)mixed * num_blocks) >> 64)];
+            }
+
+        public:
+            bloom_filter(uint64_t num_bits)
+                : num_blocks((num_bits + 511) / 512)
+                , blocks(new block[num_blocks])
+            {
+                clear();
+            }
+
+            // bits for num_keys keys at false positive rate fp_rate
+            static uint64_t bits_for(uint64_t num_keys, double fp_rate)
+            {
+                // an unblocked filter has rate (1 - e^(-k/b))^k at b bits per key,
+                // keys crowding some blocks more than others cost about a tenth more bits
+                double bits_per_key = -BLOOM_NUM_PROBES / std::log(1 - std::pow(fp_rate, 1.0 / BLOOM_NUM_PROBES));
+                return (uint64_t)(1.1 * bits_per_key * num_keys) + 512;
+            }
+
+            uint64_t num_bits() const
+            {
+                return num_blocks * 512;
+            }
+
+            // drops all keys, not safe with concurrent inserts or lookups
+            void resize(uint64_t num_bits)
+            {
+                num_blocks = (num_bits + 511) / 512;
+                blocks.reset(new block[num_blocks]);
+                clear();
+            }
+
+            void clear()
+            {
+                for (uint64_t i = 0; i < num_blocks; i++) {
+                    for (uint64_t j = 0; j < BLOOM_BLOCK_WORDS; j++) {
+                        blocks[i].words[j].store(0, std::memory_order_relaxed);
+                    }
+                }
+            }
+
+            void insert(uint64_t hash)
+            {
+                block &b = block_of(hash);
+                for (uint64_t i = 0; i < BLOOM_NUM_PROBES; i++) {
+                    uint64_t bit = (hash >> (9*i)) & 511;
+                    b.words[bit >> 6].fetch_or(1ULL << (bit & 63), std::memory_order_relaxed);
+                }
+            }
+
+            bool may_contain(uint64_t hash) const
+            {
+                const block &b = block_of(hash);
+                for (uint64_t i = 0; i < BLOOM_NUM_PROBES; i++) {
+                    uint64_t bit = (hash >> (9*i)) & 511;
+                    if (!(b.words[bit >> 6].load(std::memory_order_relaxed) & (1ULL << (bit & 63)))) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+    };
+}
+
+#undef BLOOM_BLOCK_WORDS
+#undef BLOOM_NUM_PROBES
+
+#endif
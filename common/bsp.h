@@ -0,0 +1,65 @@
+/*
+ * ===============================================================
+ *    Description:  Parameters and results of bulk synchronous
+ *                  whole-graph analytics jobs.
+ *
+ *        Created:  2026-10-19 16:19:12
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_common_bsp_h_
+#define weaver_common_bsp_h_
+
+#include <stdint.h>
+#include <vector>
+
+#include "common/types.h"
+
+namespace bsp
+{
+    enum algorithm
+    {
+        PAGERANK = 0,
+        CONNECTED_COMPONENTS, // weakly connected
+        DEGREE_DISTRIBUTION
+    };
+
+    struct params
+    {
+        uint32_t algo;
+        uint32_t max_supersteps; // pagerank iterations, limit for connected components
+        double damping; // pagerank
+        uint32_t top_k; // nodes or components in result
+
+        params()
+            : algo(PAGERANK)
+            , max_supersteps(20)
+            , damping(0.85)
+            , top_k(10)
+        { }
+    };
+
+    struct result
+    {
+        uint64_t supersteps;
+        uint64_t num_nodes;
+        uint64_t num_components;
+        // pagerank: top_k nodes by rank
+        // connected components: top_k largest components as (smallest node handle, size)
+        std::vector<std::pair<node_handle_t, double>> top;
+        // degree distribution: (out degree, nodes), connected components: (size, components)
+        std::vector<std::pair<uint64_t, uint64_t>> histogram;
+        // degree distribution: (in degree, nodes)
+        std::vector<std::pair<uint64_t, uint64_t>> in_histogram;
+
+        result()
+            : supersteps(0)
+            , num_nodes(0)
+            , num_components(0)
+        { }
+    };
+}
+
+#endif
@@ -15,5 +15,6 @@
 #define weaver_common_cache_constants_h_
 
 extern uint16_t MaxCacheEntries;
+extern uint64_t CacheBudgetMB; // all node program cache entries of a shard, 0 for no limit
 
 #endif
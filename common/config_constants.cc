@@ -25,6 +25,7 @@ init_config_constants(const char *config_file_name)
     ClkSz = UINT64_MAX;
     NumShards = UINT64_MAX;
     MaxCacheEntries = UINT16_MAX;
+    CacheBudgetMB = 0;
     HyperdexCoordIpaddr = nullptr;
     HyperdexCoordPort = UINT16_MAX;
     KronosIpaddr = nullptr;
@@ -36,6 +37,13 @@ init_config_constants(const char *config_file_name)
     BulkLoadNodeAliasKey = "";
     BulkLoadEdgeIndexKey = "";
     BulkLoadEdgeHandlePrefix = "e";
+    NumericHandleHash = false;
+    TraversalSamplePeriod = 0;
+    ProgTraceSamplePeriod = 0;
+    EdgeIndexKeys.clear();
+    EdgeIndexMinDegree = 0;
+    StorageBackend = "hyperdex";
+    StorageDir = "/var/lib/weaver";
 
     FILE *config_file = nullptr;
     if (config_file_name != nullptr) {
@@ -169,6 +177,11 @@ init_config_constants(const char *config_file_name)
                     PARSE_VALUE_SCALAR;
                     PARSE_INT(MaxCacheEntries);
 
+                } else if (strncmp((const char*)token.data.scalar.value, "cache_budget_mb", TOKEN_STRCMP_LEN(15)) == 0) {
+                    yaml_token_delete(&token);
+                    PARSE_VALUE_SCALAR;
+                    PARSE_INT(CacheBudgetMB);
+
                 } else if (strncmp((const char*)token.data.scalar.value, "hyperdex_coord", TOKEN_STRCMP_LEN(14)) == 0) {
                     yaml_token_delete(&token);
                     PARSE_VALUE_IPADDR_PORT_BLOCK(HyperdexCoord);
@@ -219,6 +232,53 @@ init_config_constants(const char *config_file_name)
                     PARSE_VALUE_SCALAR;
                     PARSE_STRING(BulkLoadEdgeHandlePrefix);
 
+                } else if (strncmp((const char*)token.data.scalar.value, "numeric_handle_hash", TOKEN_STRCMP_LEN(19)) == 0) {
+                    yaml_token_delete(&token);
+                    PARSE_VALUE_SCALAR;
+                    PARSE_BOOL(NumericHandleHash);
+
+                } else if (strncmp((const char*)token.data.scalar.value, "traversal_sample_period", TOKEN_STRCMP_LEN(23)) == 0) {
+                    yaml_token_delete(&token);
+                    PARSE_VALUE_SCALAR;
+                    PARSE_INT(TraversalSamplePeriod);
+
+                } else if (strncmp((const char*)token.data.scalar.value, "prog_trace_sample_period", TOKEN_STRCMP_LEN(24)) == 0) {
+                    yaml_token_delete(&token);
+                    PARSE_VALUE_SCALAR;
+                    PARSE_INT(ProgTraceSamplePeriod);
+
+                } else if (strncmp((const char*)token.data.scalar.value, "edge_index_keys", TOKEN_STRCMP_LEN(15)) == 0) {
+                    yaml_token_delete(&token);
+                    PARSE_VALUE_SCALAR;
+                    std::string keys;
+                    PARSE_STRING(keys);
+                    size_t start = 0;
+                    while (start <= keys.size()) {
+                        size_t end = keys.find(',', start);
+                        if (end == std::string::npos) {
+                            end = keys.size();
+                        }
+                        if (end > start) {
+                            EdgeIndexKeys.emplace_back(keys.substr(start, end - start));
+                        }
+                        start = end + 1;
+                    }
+
+                } else if (strncmp((const char*)token.data.scalar.value, "edge_index_min_degree", TOKEN_STRCMP_LEN(21)) == 0) {
+                    yaml_token_delete(&token);
+                    PARSE_VALUE_SCALAR;
+                    PARSE_INT(EdgeIndexMinDegree);
+
+                } else if (strncmp((const char*)token.data.scalar.value, "storage_backend", TOKEN_STRCMP_LEN(15)) == 0) {
+                    yaml_token_delete(&token);
+                    PARSE_VALUE_SCALAR;
+                    PARSE_STRING(StorageBackend);
+
+                } else if (strncmp((const char*)token.data.scalar.value, "storage_dir", TOKEN_STRCMP_LEN(11)) == 0) {
+                    yaml_token_delete(&token);
+                    PARSE_VALUE_SCALAR;
+                    PARSE_STRING(StorageDir);
+
                 } else {
                     WDEBUG << "unexpected key " << token.data.scalar.value << std::endl;
                 }
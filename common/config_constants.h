@@ -44,6 +44,13 @@ extern char BulkLoadPropertyValueDelimiter;
 extern std::string BulkLoadNodeAliasKey;
 extern std::string BulkLoadEdgeIndexKey;
 extern std::string BulkLoadEdgeHandlePrefix;
+extern bool NumericHandleHash;
+extern uint64_t TraversalSamplePeriod;
+extern uint64_t ProgTraceSamplePeriod;
+extern std::vector<std::string> EdgeIndexKeys;
+extern uint64_t EdgeIndexMinDegree;
+extern std::string StorageBackend;
+extern std::string StorageDir;
 
 bool init_config_constants(const char *config_file_name=nullptr);
 void update_config_constants(uint64_t num_shards);
@@ -74,7 +81,15 @@ uint64_t get_num_shards();
     std::string BulkLoadNodeAliasKey; \
     std::string BulkLoadEdgeIndexKey; \
     std::string BulkLoadEdgeHandlePrefix; \
-    uint16_t MaxCacheEntries;
+    bool NumericHandleHash; \
+    uint64_t TraversalSamplePeriod; \
+    uint64_t ProgTraceSamplePeriod; \
+    std::vector<std::string> EdgeIndexKeys; \
+    uint64_t EdgeIndexMinDegree; \
+    std::string StorageBackend; \
+    std::string StorageDir; \
+    uint16_t MaxCacheEntries; \
+    uint64_t CacheBudgetMB;
 
 
 #endif
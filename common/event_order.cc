@@ -14,6 +14,7 @@
 //#define weaver_debug_
 #include "common/event_order.h"
 #include "common/config_constants.h"
+#include "common/metrics.h"
 
 using order::oracle;
 
@@ -228,8 +229,10 @@ oracle :: compare_vts(const std::vector<vc::vclock> &clocks)
         chronos_returncode status;
         ssize_t cret;
 
+        uint64_t kronos_start = metrics::clock_ns();
         int64_t ret = kronos_cl->weaver_order(wpair, num_pairs, &status, &cret);
         ret = kronos_cl->wait(ret, 100000, &status);
+        metrics::get().kronos_call_ns.record_since(kronos_start);
 
         wp = wpair;
         std::vector<bool> large_upd = large;
@@ -365,8 +368,10 @@ oracle :: assign_vt_order(const std::vector<vc::vclock> &before, const vc::vcloc
     // actual kronos call
     chronos_returncode status;
     ssize_t cret;
+    uint64_t kronos_start = metrics::clock_ns();
     int64_t ret = kronos_cl->weaver_order(wpair, num_pairs, &status, &cret);
     ret = kronos_cl->wait(ret, 100000, &status);
+    metrics::get().kronos_call_ns.record_since(kronos_start);
 
     // check kronos returned orders
     for (uint64_t i = 0; i < num_pairs; i++) {
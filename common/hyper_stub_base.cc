@@ -15,6 +15,7 @@
 #include "common/weaver_constants.h"
 #include "common/hyper_stub_base.h"
 #include "common/config_constants.h"
+#include "common/metrics.h"
 
 hyper_stub_base :: hyper_stub_base()
     : graph_attrs{"shard",
@@ -129,9 +130,11 @@ hyper_stub_base :: hyper_stub_base()
 #define HYPERDEX_LOOP \
     { \
         int num_hdex_calls = 0; \
+        uint64_t hdex_start = metrics::clock_ns(); \
         do { \
             hdex_id = hyperdex_client_loop(cl, -1, &loop_status); \
         } while (hdex_id < 0 && loop_status == HYPERDEX_CLIENT_INTERRUPTED && num_hdex_calls++ < 5); \
+        metrics::get().hyperdex_wait_ns.record_since(hdex_start); \
     } \
     HYPERDEX_CHECK_ID(loop_status);
 
@@ -202,9 +205,13 @@ hyper_stub_base :: hyper_stub_base()
     HYPERDEX_CHECK_ID(del_status);
 
 #define HYPERDEX_LOOP \
-    do { \
-        hdex_id = hyperdex_client_loop(cl, -1, &loop_status); \
-    } while (hdex_id < 0 && loop_status == HYPERDEX_CLIENT_INTERRUPTED); \
+    { \
+        uint64_t hdex_start = metrics::clock_ns(); \
+        do { \
+            hdex_id = hyperdex_client_loop(cl, -1, &loop_status); \
+        } while (hdex_id < 0 && loop_status == HYPERDEX_CLIENT_INTERRUPTED); \
+        metrics::get().hyperdex_wait_ns.record_since(hdex_start); \
+    } \
     HYPERDEX_CHECK_ID(loop_status);
 
 #define HYPERDEX_CHECK_STATUSES(status, fail_check) \
@@ -226,11 +233,12 @@ hyper_stub_base :: begin_tx()
     hyper_tx = hyperdex_client_begin_transaction(cl);
 }
 
-void
-hyper_stub_base :: commit_tx(hyperdex_client_returncode &commit_status)
+storage_commit_status
+hyper_stub_base :: commit_tx()
 {
     bool success = true;
     int success_calls = 0;
+    hyperdex_client_returncode commit_status = HYPERDEX_CLIENT_GARBAGE;
     hyperdex_client_returncode loop_status;
 
     int64_t hdex_id = hyperdex_client_commit_transaction(hyper_tx, &commit_status);
@@ -241,6 +249,19 @@ hyper_stub_base :: commit_tx(hyperdex_client_returncode &commit_status)
         HYPERDEX_CHECK_STATUSES(commit_status,
             commit_status != HYPERDEX_CLIENT_ABORTED && commit_status != HYPERDEX_CLIENT_SUCCESS);
     }
+
+    switch (commit_status) {
+        case HYPERDEX_CLIENT_SUCCESS:
+            return STORAGE_COMMITTED;
+
+        case HYPERDEX_CLIENT_ABORTED:
+            return STORAGE_ABORTED;
+
+        default:
+            WDEBUG << "hyperdex commit failed, status = "
+                   << hyperdex_client_returncode_to_string(commit_status) << std::endl;
+            return STORAGE_ERROR;
+    }
 }
 
 void
@@ -726,6 +747,9 @@ hyper_stub_base :: recreate_node(const hyperdex_client_attribute *cl_attr, db::n
     n.state = db::node::mode::STABLE;
     n.in_use = false;
     n.base.update_creat_time(create_clk);
+    // writes since creation are unknown
+    n.max_upd_clk.clear();
+    n.start_change_log();
 
     // out edges
     unpack_buffer<std::vector<db::edge*>>(cl_attr[idx[3]].value, cl_attr[idx[3]].value_sz, n.out_edges);
@@ -998,6 +1022,40 @@ hyper_stub_base :: update_nmap(const node_handle_t &handle, uint64_t loc)
     return call(hyperdex_client_put, graph_space, handle.c_str(), handle.size(), &attr, 1);
 }
 
+// all puts issued before waiting for any
+bool
+hyper_stub_base :: update_nmap_bulk(const std::unordered_map<node_handle_t, uint64_t> &mappings)
+{
+    uint64_t num_nodes = mappings.size();
+    if (num_nodes == 0) {
+        return true;
+    }
+
+    std::vector<hyper_func> funcs(num_nodes, &hyperdex_client_put);
+    std::vector<const char*> spaces(num_nodes, graph_space);
+    std::vector<const char*> keys(num_nodes);
+    std::vector<size_t> key_szs(num_nodes);
+    std::vector<hyperdex_client_attribute*> attrs(num_nodes);
+    std::vector<size_t> num_attrs(num_nodes, 1);
+    std::vector<hyperdex_client_attribute> attrs_to_add(num_nodes);
+
+    uint64_t i = 0;
+    for (const auto &p: mappings) {
+        keys[i] = p.first.c_str();
+        key_szs[i] = p.first.size();
+
+        attrs_to_add[i].attr = graph_attrs[0];
+        attrs_to_add[i].value = (const char*)&p.second;
+        attrs_to_add[i].value_sz = sizeof(int64_t);
+        attrs_to_add[i].datatype = graph_dtypes[0];
+        attrs[i] = &attrs_to_add[i];
+
+        i++;
+    }
+
+    return multiple_call(funcs, spaces, keys, key_szs, attrs, num_attrs);
+}
+
 uint64_t
 hyper_stub_base :: get_nmap(node_handle_t &handle)
 {
@@ -1227,6 +1285,138 @@ hyper_stub_base :: del_indices(std::vector<std::string> &indices)
 }
 
 
+bool
+hyper_stub_base :: put_tx_data(uint64_t vt_id, transaction::pending_tx &tx)
+{
+    hyperdex_client_attribute attr[NUM_TX_ATTRS];
+    attr[0].attr = tx_attrs[0];
+    attr[0].value = (const char*)&vt_id;
+    attr[0].value_sz = sizeof(int64_t);
+    attr[0].datatype = tx_dtypes[0];
+
+    std::unique_ptr<e::buffer> buf;
+    prepare_buffer(tx, buf);
+    attr[1].attr = tx_attrs[1];
+    attr[1].value = (const char*)buf->data();
+    attr[1].value_sz = buf->size();
+    attr[1].datatype = tx_dtypes[1];
+
+    return call(&hyperdex_client_xact_put, tx_space, (const char*)&tx.id, sizeof(int64_t), attr, NUM_TX_ATTRS);
+}
+
+bool
+hyper_stub_base :: del_tx_data(uint64_t tx_id)
+{
+    return del(tx_space, (const char*)&tx_id, sizeof(int64_t));
+}
+
+bool
+hyper_stub_base :: recreate_tx(const hyperdex_client_attribute *cl_attr, size_t num_attrs, transaction::pending_tx &tx)
+{
+    for (size_t i = 0; i < num_attrs; i++) {
+        if (strcmp(cl_attr[i].attr, tx_attrs[1]) == 0) {
+            assert(cl_attr[i].datatype == tx_dtypes[1]);
+            unpack_buffer(cl_attr[i].value, cl_attr[i].value_sz, tx);
+            return true;
+        }
+    }
+
+    WDEBUG << "logical error: recreate tx, no tx data" << std::endl;
+    return false;
+}
+
+// search for the objects in space with int attribute attr == val, calls found for each
+bool
+hyper_stub_base :: search(const char *space,
+    const char *attr, enum hyperdatatype dtype, uint64_t val,
+    std::function<void(const hyperdex_client_attribute*, size_t)> found)
+{
+    const hyperdex_client_attribute *cl_attr;
+    size_t num_attrs;
+    const hyperdex_client_attribute_check attr_check = {attr, (const char*)&val, sizeof(int64_t), dtype, HYPERPREDICATE_EQUALS};
+    enum hyperdex_client_returncode search_status, loop_status;
+
+    int64_t call_id = hyperdex_client_search(cl, space, &attr_check, 1, &search_status, &cl_attr, &num_attrs);
+    if (call_id < 0) {
+        WDEBUG << "Hyperdex function failed, op id = " << call_id
+               << ", status = " << hyperdex_client_returncode_to_string(search_status) << std::endl;
+        WDEBUG << "error message: " << hyperdex_client_error_message(cl) << std::endl;
+        WDEBUG << "error loc: " << hyperdex_client_error_location(cl) << std::endl;
+        return false;
+    }
+
+    int64_t loop_id;
+    bool loop_done = false;
+    while (!loop_done) {
+        // loop until search done
+        loop_id = hyperdex_client_loop(cl, -1, &loop_status);
+        if (loop_id != call_id
+         || loop_status != HYPERDEX_CLIENT_SUCCESS
+         || (search_status != HYPERDEX_CLIENT_SUCCESS && search_status != HYPERDEX_CLIENT_SEARCHDONE)) {
+            WDEBUG << "Hyperdex function failed, call id = " << call_id
+                   << ", loop_id = " << loop_id
+                   << ", loop status = " << hyperdex_client_returncode_to_string(loop_status)
+                   << ", search status = " << hyperdex_client_returncode_to_string(search_status) << std::endl;
+            WDEBUG << "error message: " << hyperdex_client_error_message(cl) << std::endl;
+            WDEBUG << "error loc: " << hyperdex_client_error_location(cl) << std::endl;
+            return false;
+        }
+
+        if (search_status == HYPERDEX_CLIENT_SEARCHDONE) {
+            loop_done = true;
+        } else if (search_status == HYPERDEX_CLIENT_SUCCESS) {
+            found(cl_attr, num_attrs);
+            hyperdex_client_destroy_attrs(cl_attr, num_attrs);
+        } else {
+            WDEBUG << "unexpected search status " << search_status << std::endl;
+        }
+    }
+
+    return true;
+}
+
+bool
+hyper_stub_base :: get_vt_txs(uint64_t vt_id, std::vector<std::shared_ptr<transaction::pending_tx>> &txs)
+{
+    return search(tx_space, tx_attrs[0], tx_dtypes[0], vt_id,
+        [&](const hyperdex_client_attribute *cl_attr, size_t num_attrs) {
+            assert(num_attrs == (NUM_TX_ATTRS+1));
+            auto tx = std::make_shared<transaction::pending_tx>(transaction::UPDATE);
+            if (recreate_tx(cl_attr, num_attrs, *tx)) {
+                txs.emplace_back(tx);
+            }
+        });
+}
+
+bool
+hyper_stub_base :: get_shard_nodes(uint64_t shard,
+    std::function<db::node*(const node_handle_t&)> alloc_node,
+    std::function<void(db::node*)> restored_node)
+{
+    return search(graph_space, graph_attrs[0], graph_dtypes[0], shard,
+        [&](const hyperdex_client_attribute *cl_attr, size_t num_attrs) {
+            assert(num_attrs == NUM_GRAPH_ATTRS+1); // node handle + graph attrs
+
+            uint64_t key_idx = UINT64_MAX;
+            hyperdex_client_attribute node_attrs[NUM_GRAPH_ATTRS];
+            for (uint64_t i = 0, j = 0; i < num_attrs; i++) {
+                if (strcmp(cl_attr[i].attr, graph_key) == 0) {
+                    key_idx = i;
+                } else {
+                    node_attrs[j++] = cl_attr[i];
+                }
+            }
+            assert(key_idx != UINT64_MAX);
+
+            db::node *n = alloc_node(node_handle_t(cl_attr[key_idx].value, cl_attr[key_idx].value_sz));
+            if (recreate_node(node_attrs, *n)) {
+                restored_node(n);
+            } else {
+                delete n;
+            }
+        });
+}
+
 void
 hyper_stub_base :: pack_uint64(e::buffer::packer &pkr, uint64_t num)
 {
@@ -1,6 +1,6 @@
 /*
  * ===============================================================
- *    Description:  Base class for Hyperdex client, used by both
+ *    Description:  HyperDex storage backend, used by both
  *                  db::hyper_stub and coordinator::hyper_stub.
  *
  *        Created:  2014-02-26 15:23:54
@@ -26,6 +26,7 @@
 
 #include "common/message.h"
 #include "common/transaction.h"
+#include "common/storage_backend.h"
 #include "db/types.h"
 #include "db/node.h"
 
@@ -39,7 +40,7 @@ enum persist_node_state
     MOVING
 };
 
-class hyper_stub_base
+class hyper_stub_base : public storage_backend
 {
     protected:
         // node handle -> node data
@@ -83,9 +84,6 @@ class hyper_stub_base
         hyperdex_client *cl;
         hyperdex_client_transaction *hyper_tx;
 
-        void begin_tx();
-        void commit_tx(hyperdex_client_returncode &commit_status);
-        void abort_tx();
         bool call(hyper_func h,
             const char *space,
             const char *key, size_t key_sz,
@@ -138,33 +136,48 @@ class hyper_stub_base
         bool multiple_del(std::vector<const char*> &spaces,
             std::vector<const char*> &keys, std::vector<size_t> &key_szs);
 
-        // graph data functions
         bool get_node(db::node &n);
+        bool del_node(const node_handle_t &h);
+        bool recreate_node(const hyperdex_client_attribute *cl_attr, db::node &n);
+
+    private:
+        bool recreate_index(const hyperdex_client_attribute *cl_attr, std::pair<node_handle_t, uint64_t> &value);
+        bool recreate_tx(const hyperdex_client_attribute *cl_attr, size_t num_attrs, transaction::pending_tx &tx);
+        bool search(const char *space,
+            const char *attr, enum hyperdatatype dtype, uint64_t val,
+            std::function<void(const hyperdex_client_attribute*, size_t)> found);
+        void sort_and_pack_as_set(std::vector<std::string>&, std::unique_ptr<e::buffer>&);
+
+    public:
+        // storage_backend
+        void begin_tx();
+        storage_commit_status commit_tx();
+        void abort_tx();
+
+        // graph data functions
         bool get_nodes(std::unordered_map<node_handle_t, db::node*> &nodes, bool tx);
-        //bool put_node(db::node &n);
         bool put_nodes(std::unordered_map<node_handle_t, db::node*> &nodes, bool if_not_exist);
         bool put_nodes_bulk(std::unordered_map<node_handle_t, db::node*> &nodes, vc::vclock&, vc::vclock_t&);
-        bool del_node(const node_handle_t &h);
         bool del_nodes(std::unordered_set<node_handle_t> &to_del);
-        bool recreate_node(const hyperdex_client_attribute *cl_attr, db::node &n);
+        bool get_shard_nodes(uint64_t shard,
+            std::function<db::node*(const node_handle_t&)> alloc_node,
+            std::function<void(db::node*)> restored_node);
 
         // node map functions
         bool update_nmap(const node_handle_t &handle, uint64_t loc);
+        bool update_nmap_bulk(const std::unordered_map<node_handle_t, uint64_t> &mappings);
         std::unordered_map<node_handle_t, uint64_t> get_nmap(std::unordered_set<node_handle_t> &toGet, bool tx);
         uint64_t get_nmap(node_handle_t &handle);
 
         // auxiliary index functions
-    private:
-        bool recreate_index(const hyperdex_client_attribute *cl_attr, std::pair<node_handle_t, uint64_t> &value);
-        void sort_and_pack_as_set(std::vector<std::string>&, std::unique_ptr<e::buffer>&);
-    public:
         bool add_indices(std::unordered_map<std::string, db::node*> &indices, bool tx, bool if_not_exist);
         bool get_indices(std::unordered_map<std::string, std::pair<node_handle_t, uint64_t>> &indices, bool tx);
         bool del_indices(std::vector<std::string> &indices);
 
         // tx data functions
-        bool put_tx_data(transaction::pending_tx *tx);
+        bool put_tx_data(uint64_t vt_id, transaction::pending_tx &tx);
         bool del_tx_data(uint64_t tx_id);
+        bool get_vt_txs(uint64_t vt_id, std::vector<std::shared_ptr<transaction::pending_tx>> &txs);
 
         template <typename T> void prepare_buffer(const T &t, std::unique_ptr<e::buffer> &buf);
         template <typename T> void unpack_buffer(const char *buf, uint64_t buf_sz, T &t);
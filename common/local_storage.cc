@@ -0,0 +1,385 @@
+/*
+ * ===============================================================
+ *    Description:  Local storage sessions: nodes, node map, aux
+ *                  index and txs as records of a local_store.
+ *
+ *        Created:  2026-10-19 15:58:10
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <e/buffer.h>
+
+#define weaver_debug_
+#include "common/weaver_constants.h"
+#include "common/config_constants.h"
+#include "common/message.h"
+#include "common/local_storage.h"
+
+namespace
+{
+    // same contents as the HyperDex graph attributes, except the shard which is the record num
+    void
+    encode_node(const db::node &n, const vc::vclock &last_upd_clk, const vc::vclock_t &restore_clk, std::string &out)
+    {
+        uint64_t sz = message::size(n.base.get_creat_time())
+                    + message::size(n.base.properties)
+                    + message::size(n.out_edges)
+                    + message::size(last_upd_clk)
+                    + message::size(restore_clk)
+                    + message::size(n.aliases);
+        std::unique_ptr<e::buffer> buf(e::buffer::create(sz));
+        e::buffer::packer packer = buf->pack_at(0);
+        message::pack_buffer(packer, n.base.get_creat_time());
+        message::pack_buffer(packer, n.base.properties);
+        message::pack_buffer(packer, n.out_edges);
+        message::pack_buffer(packer, last_upd_clk);
+        message::pack_buffer(packer, restore_clk);
+        message::pack_buffer(packer, n.aliases);
+        out.assign((const char*)buf->data(), buf->size());
+    }
+
+    bool
+    decode_node(const local_store::record &rec, db::node &n)
+    {
+        if (rec.data.empty()) {
+            return false;
+        }
+
+        std::unique_ptr<e::buffer> buf(e::buffer::create(rec.data.data(), rec.data.size()));
+        e::unpacker unpacker = buf->unpack_from(0);
+        vc::vclock_ptr_t create_clk;
+        n.shard = rec.num;
+        message::unpack_buffer(unpacker, create_clk);
+        message::unpack_buffer(unpacker, n.base.properties);
+        message::unpack_buffer(unpacker, n.out_edges);
+        n.last_upd_clk.reset(new vc::vclock());
+        message::unpack_buffer(unpacker, *n.last_upd_clk);
+        n.restore_clk.reset(new vc::vclock_t());
+        message::unpack_buffer(unpacker, *n.restore_clk);
+        message::unpack_buffer(unpacker, n.aliases);
+
+        n.state = db::node::mode::STABLE;
+        n.in_use = false;
+        n.base.update_creat_time(create_clk);
+        // writes since creation are unknown
+        n.max_upd_clk.clear();
+        n.start_change_log();
+
+        if (n.restore_clk->size() != ClkSz) {
+            WDEBUG << "unpack error, restore_clk->size=" << n.restore_clk->size() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    std::string
+    tx_key(uint64_t tx_id)
+    {
+        return std::string((const char*)&tx_id, sizeof(uint64_t));
+    }
+}
+
+local_storage :: local_storage(const std::string &d)
+    : dir(d)
+    , store(nullptr)
+    , in_tx(false)
+{ }
+
+// opened on first use, so that backup servers do not take the directory
+void
+local_storage :: open_store()
+{
+    if (store == nullptr) {
+        store = local_store::shared(dir);
+    }
+}
+
+void
+local_storage :: begin_tx()
+{
+    in_tx = true;
+    read_set.clear();
+    ops.clear();
+}
+
+storage_commit_status
+local_storage :: commit_tx()
+{
+    open_store();
+    storage_commit_status status = store->commit(read_set, ops);
+    in_tx = false;
+    read_set.clear();
+    ops.clear();
+    return status;
+}
+
+void
+local_storage :: abort_tx()
+{
+    in_tx = false;
+    read_set.clear();
+    ops.clear();
+}
+
+bool
+local_storage :: read(local_table table, const std::string &key, bool tx, local_store::record &rec)
+{
+    open_store();
+    bool found = store->get(table, key, rec);
+    if (tx && in_tx) {
+        read_set.emplace_back(local_store::read_version{table, key, found? rec.version : 0});
+    }
+    return found;
+}
+
+// outside a transaction, the writes commit on their own
+bool
+local_storage :: write(std::vector<local_store::op> &new_ops)
+{
+    open_store();
+    if (in_tx) {
+        ops.insert(ops.end(), new_ops.begin(), new_ops.end());
+        return true;
+    } else {
+        std::vector<local_store::read_version> no_reads;
+        return store->commit(no_reads, new_ops) == STORAGE_COMMITTED;
+    }
+}
+
+bool
+local_storage :: get_nodes(std::unordered_map<node_handle_t, db::node*> &nodes, bool tx)
+{
+    bool success = true;
+    local_store::record rec;
+    for (auto &p: nodes) {
+        if (!read(LOCAL_GRAPH, p.first, tx, rec) || !decode_node(rec, *p.second)) {
+            WDEBUG << "node " << p.first << " not in storage" << std::endl;
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool
+local_storage :: put_nodes(std::unordered_map<node_handle_t, db::node*> &nodes, bool if_not_exist)
+{
+    std::vector<local_store::op> new_ops(nodes.size());
+    uint64_t i = 0;
+    for (auto &p: nodes) {
+        local_store::op &o = new_ops[i++];
+        o.type = if_not_exist? local_store::LOCAL_PUT_IF_NOT_EXIST : local_store::LOCAL_PUT;
+        o.table = LOCAL_GRAPH;
+        o.key = p.first;
+        o.num = p.second->shard;
+        encode_node(*p.second, *p.second->last_upd_clk, *p.second->restore_clk, o.data);
+    }
+    return write(new_ops);
+}
+
+bool
+local_storage :: put_nodes_bulk(std::unordered_map<node_handle_t, db::node*> &nodes, vc::vclock &last_upd_clk, vc::vclock_t &restore_clk)
+{
+    std::vector<local_store::op> new_ops(nodes.size());
+    uint64_t i = 0;
+    for (auto &p: nodes) {
+        local_store::op &o = new_ops[i++];
+        o.type = local_store::LOCAL_PUT;
+        o.table = LOCAL_GRAPH;
+        o.key = p.first;
+        o.num = p.second->shard;
+        encode_node(*p.second, last_upd_clk, restore_clk, o.data);
+    }
+    return write(new_ops);
+}
+
+bool
+local_storage :: del_nodes(std::unordered_set<node_handle_t> &to_del)
+{
+    std::vector<local_store::op> new_ops(to_del.size());
+    uint64_t i = 0;
+    for (const node_handle_t &h: to_del) {
+        local_store::op &o = new_ops[i++];
+        o.type = local_store::LOCAL_DEL;
+        o.table = LOCAL_GRAPH;
+        o.key = h;
+    }
+    return write(new_ops);
+}
+
+bool
+local_storage :: get_shard_nodes(uint64_t shard,
+    std::function<db::node*(const node_handle_t&)> alloc_node,
+    std::function<void(db::node*)> restored_node)
+{
+    open_store();
+    store->for_each(LOCAL_GRAPH, [&](const std::string &handle, const local_store::record &rec) {
+        if (rec.num != shard || rec.data.empty()) {
+            return;
+        }
+        db::node *n = alloc_node(handle);
+        if (decode_node(rec, *n)) {
+            restored_node(n);
+        } else {
+            delete n;
+        }
+    });
+
+    return true;
+}
+
+bool
+local_storage :: update_nmap(const node_handle_t &handle, uint64_t loc)
+{
+    std::vector<local_store::op> new_ops(1);
+    new_ops[0].type = local_store::LOCAL_PUT_NUM;
+    new_ops[0].table = LOCAL_GRAPH;
+    new_ops[0].key = handle;
+    new_ops[0].num = loc;
+    return write(new_ops);
+}
+
+bool
+local_storage :: update_nmap_bulk(const std::unordered_map<node_handle_t, uint64_t> &mappings)
+{
+    std::vector<local_store::op> new_ops(mappings.size());
+    uint64_t i = 0;
+    for (const auto &p: mappings) {
+        new_ops[i].type = local_store::LOCAL_PUT_NUM;
+        new_ops[i].table = LOCAL_GRAPH;
+        new_ops[i].key = p.first;
+        new_ops[i].num = p.second;
+        i++;
+    }
+    return write(new_ops);
+}
+
+std::unordered_map<node_handle_t, uint64_t>
+local_storage :: get_nmap(std::unordered_set<node_handle_t> &toGet, bool tx)
+{
+    std::unordered_map<node_handle_t, uint64_t> mappings;
+    mappings.reserve(toGet.size());
+    local_store::record rec;
+    for (const node_handle_t &h: toGet) {
+        if (read(LOCAL_GRAPH, h, tx, rec)) {
+            mappings[h] = rec.num;
+        }
+    }
+    return mappings;
+}
+
+uint64_t
+local_storage :: get_nmap(node_handle_t &handle)
+{
+    local_store::record rec;
+    return read(LOCAL_GRAPH, handle, false, rec)? rec.num : UINT64_MAX;
+}
+
+bool
+local_storage :: add_indices(std::unordered_map<std::string, db::node*> &indices, bool, bool if_not_exist)
+{
+    if (!AuxIndex) {
+        WDEBUG << "logical error: aux index" << std::endl;
+        return false;
+    }
+
+    std::vector<local_store::op> new_ops(indices.size());
+    uint64_t i = 0;
+    for (auto &p: indices) {
+        local_store::op &o = new_ops[i++];
+        o.type = if_not_exist? local_store::LOCAL_PUT_IF_NOT_EXIST : local_store::LOCAL_PUT;
+        o.table = LOCAL_INDEX;
+        o.key = p.first;
+        o.num = p.second->shard;
+        o.data = p.second->get_handle();
+    }
+    return write(new_ops);
+}
+
+bool
+local_storage :: get_indices(std::unordered_map<std::string, std::pair<node_handle_t, uint64_t>> &indices, bool tx)
+{
+    if (!AuxIndex) {
+        WDEBUG << "logical error: aux index" << std::endl;
+        return false;
+    }
+
+    bool success = true;
+    local_store::record rec;
+    for (auto &p: indices) {
+        if (read(LOCAL_INDEX, p.first, tx, rec)) {
+            p.second.first = rec.data;
+            p.second.second = rec.num;
+        } else {
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool
+local_storage :: del_indices(std::vector<std::string> &indices)
+{
+    if (!AuxIndex) {
+        WDEBUG << "logical error: aux index" << std::endl;
+        return false;
+    }
+
+    std::vector<local_store::op> new_ops(indices.size());
+    for (uint64_t i = 0; i < indices.size(); i++) {
+        new_ops[i].type = local_store::LOCAL_DEL;
+        new_ops[i].table = LOCAL_INDEX;
+        new_ops[i].key = indices[i];
+    }
+    return write(new_ops);
+}
+
+bool
+local_storage :: put_tx_data(uint64_t vt_id, transaction::pending_tx &tx)
+{
+    std::vector<local_store::op> new_ops(1);
+    local_store::op &o = new_ops[0];
+    o.type = local_store::LOCAL_PUT;
+    o.table = LOCAL_TX;
+    o.key = tx_key(tx.id);
+    o.num = vt_id;
+
+    std::unique_ptr<e::buffer> buf(e::buffer::create(message::size(tx)));
+    e::buffer::packer packer = buf->pack_at(0);
+    message::pack_buffer(packer, tx);
+    o.data.assign((const char*)buf->data(), buf->size());
+
+    return write(new_ops);
+}
+
+bool
+local_storage :: del_tx_data(uint64_t tx_id)
+{
+    std::vector<local_store::op> new_ops(1);
+    new_ops[0].type = local_store::LOCAL_DEL;
+    new_ops[0].table = LOCAL_TX;
+    new_ops[0].key = tx_key(tx_id);
+    return write(new_ops);
+}
+
+bool
+local_storage :: get_vt_txs(uint64_t vt_id, std::vector<std::shared_ptr<transaction::pending_tx>> &txs)
+{
+    open_store();
+    store->for_each(LOCAL_TX, [&](const std::string&, const local_store::record &rec) {
+        if (rec.num != vt_id) {
+            return;
+        }
+        auto tx = std::make_shared<transaction::pending_tx>(transaction::UPDATE);
+        std::unique_ptr<e::buffer> buf(e::buffer::create(rec.data.data(), rec.data.size()));
+        e::unpacker unpacker = buf->unpack_from(0);
+        message::unpack_buffer(unpacker, *tx);
+        txs.emplace_back(tx);
+    });
+
+    return true;
+}
+
+#undef RECORD_HEADER_SZ
+#undef SNAPSHOT_RECORD_BYTES
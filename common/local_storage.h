@@ -0,0 +1,158 @@
+/*
+ * ===============================================================
+ *    Description:  Storage backend on local disk: in-memory tables
+ *                  made durable by an append-only log with group
+ *                  commit, compacted into periodic snapshots.
+ *                  Each process owns the directory it writes.
+ *
+ *        Created:  2026-10-19 15:58:10
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_common_local_storage_h_
+#define weaver_common_local_storage_h_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <po6/threads/mutex.h>
+#include <po6/threads/cond.h>
+
+#include "common/storage_backend.h"
+
+// log size after which the next flush starts a new log and writes a snapshot
+#define LOCAL_STORAGE_SNAPSHOT_BYTES (256ULL << 20)
+// a snapshot holds the store lock for one stripe of a table at a time
+#define LOCAL_STORAGE_STRIPES 64
+
+enum local_table
+{
+    LOCAL_GRAPH = 0, // node handle -> shard, node data
+    LOCAL_INDEX, // alias -> shard, node handle
+    LOCAL_TX, // tx id -> vt id, tx data
+    LOCAL_NUM_TABLES
+};
+
+// Tables of one storage directory, shared by all local_storage objects of a process,
+// and written only by that process.  Each shard has a directory for its partition of
+// the graph, and the timestamper one for the node map, aux index, and pending txs.
+// Each log record is one committed transaction.  A commit returns after its record is
+// on disk, and records that arrive while the log is being synced wait for the next
+// sync, so concurrent commits share one fdatasync.
+class local_store
+{
+    public:
+        struct record
+        {
+            uint64_t num; // shard or vt id
+            std::string data; // empty if only num was written
+            uint64_t version; // lsn of last write
+        };
+
+        enum op_type
+        {
+            LOCAL_PUT = 0,
+            LOCAL_PUT_IF_NOT_EXIST,
+            LOCAL_PUT_NUM, // update num, keep data
+            LOCAL_DEL
+        };
+
+        struct op
+        {
+            op_type type;
+            local_table table;
+            std::string key;
+            uint64_t num;
+            std::string data;
+        };
+
+        struct read_version
+        {
+            local_table table;
+            std::string key;
+            uint64_t version; // 0 if key did not exist
+        };
+
+    private:
+        typedef std::unordered_map<std::string, record> table_stripe;
+
+        const std::string dir;
+        int wal_fd, lock_fd;
+        po6::threads::mutex mtx;
+        po6::threads::cond durable_cond;
+        table_stripe tables[LOCAL_NUM_TABLES][LOCAL_STORAGE_STRIPES];
+        uint64_t last_lsn, durable_lsn;
+        std::string pending; // encoded records not yet written
+        uint64_t wal_bytes;
+        bool flushing, compacting;
+
+        table_stripe& stripe_of(local_table table, const std::string &key);
+        void apply(const op &o, uint64_t lsn);
+        bool replay();
+        bool replay_file(const std::string &path, bool snapshot, uint64_t &snapshot_lsn);
+        void wait_durable(uint64_t lsn);
+        bool start_log();
+        bool write_snapshot(uint64_t snapshot_lsn);
+
+    public:
+        local_store(const std::string &dir);
+        ~local_store();
+
+        bool open();
+        // applies ops if no key in read_set changed, returns when durable
+        storage_commit_status commit(const std::vector<read_version> &read_set, const std::vector<op> &ops);
+        // copy of the record, false if it does not exist
+        bool get(local_table table, const std::string &key, record &rec);
+        void for_each(local_table table, std::function<void(const std::string&, const record&)> func);
+
+        // store of the directory in this process, opened on first call
+        static local_store* shared(const std::string &dir);
+};
+
+// Per-thread session on a local_store.  Reads in a transaction are validated
+// at commit, a transaction aborts if another one wrote a key that it read.
+class local_storage : public storage_backend
+{
+    private:
+        const std::string dir;
+        local_store *store;
+        bool in_tx;
+        std::vector<local_store::read_version> read_set;
+        std::vector<local_store::op> ops;
+
+        void open_store();
+        bool read(local_table table, const std::string &key, bool tx, local_store::record &rec);
+        bool write(std::vector<local_store::op> &new_ops);
+
+    public:
+        local_storage(const std::string &dir);
+
+        void begin_tx();
+        storage_commit_status commit_tx();
+        void abort_tx();
+
+        bool get_nodes(std::unordered_map<node_handle_t, db::node*> &nodes, bool tx);
+        bool put_nodes(std::unordered_map<node_handle_t, db::node*> &nodes, bool if_not_exist);
+        bool put_nodes_bulk(std::unordered_map<node_handle_t, db::node*> &nodes, vc::vclock&, vc::vclock_t&);
+        bool del_nodes(std::unordered_set<node_handle_t> &to_del);
+        bool get_shard_nodes(uint64_t shard,
+            std::function<db::node*(const node_handle_t&)> alloc_node,
+            std::function<void(db::node*)> restored_node);
+
+        bool update_nmap(const node_handle_t &handle, uint64_t loc);
+        bool update_nmap_bulk(const std::unordered_map<node_handle_t, uint64_t> &mappings);
+        std::unordered_map<node_handle_t, uint64_t> get_nmap(std::unordered_set<node_handle_t> &toGet, bool tx);
+        uint64_t get_nmap(node_handle_t &handle);
+
+        bool add_indices(std::unordered_map<std::string, db::node*> &indices, bool tx, bool if_not_exist);
+        bool get_indices(std::unordered_map<std::string, std::pair<node_handle_t, uint64_t>> &indices, bool tx);
+        bool del_indices(std::vector<std::string> &indices);
+
+        bool put_tx_data(uint64_t vt_id, transaction::pending_tx &tx);
+        bool del_tx_data(uint64_t tx_id);
+        bool get_vt_txs(uint64_t vt_id, std::vector<std::shared_ptr<transaction::pending_tx>> &txs);
+};
+
+#endif
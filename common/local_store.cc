@@ -0,0 +1,630 @@
+/*
+ * ===============================================================
+ *    Description:  Tables and log of local storage: records,
+ *                  group commit, replay, and snapshots.
+ *
+ *        Created:  2026-10-19 12:38:20
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#define weaver_debug_
+#include "common/weaver_constants.h"
+#include "common/MurmurHash3.h"
+#include "common/local_storage.h"
+
+// log record: u32 payload size, u64 payload checksum, payload
+// payload: u64 lsn, u32 num ops, ops
+// op: u8 type, u8 table, u32 key size, key, u64 num, u32 data size, data
+// snapshot: records of puts all with the snapshot lsn, ended by a record with no ops
+#define RECORD_HEADER_SZ (sizeof(uint32_t) + sizeof(uint64_t))
+#define SNAPSHOT_RECORD_BYTES (64ULL << 20)
+
+namespace
+{
+    void
+    append_u8(std::string &out, uint8_t x)
+    {
+        out.push_back((char)x);
+    }
+
+    void
+    append_u32(std::string &out, uint32_t x)
+    {
+        out.append((const char*)&x, sizeof(uint32_t));
+    }
+
+    void
+    append_u64(std::string &out, uint64_t x)
+    {
+        out.append((const char*)&x, sizeof(uint64_t));
+    }
+
+    void
+    append_str(std::string &out, const std::string &s)
+    {
+        append_u32(out, s.size());
+        out.append(s);
+    }
+
+    // bounds checked reads from an encoded buffer
+    struct decoder
+    {
+        const char *cur, *end;
+
+        decoder(const char *buf, size_t sz) : cur(buf), end(buf+sz) { }
+
+        bool u8(uint8_t &x)
+        {
+            if (end - cur < 1) {
+                return false;
+            }
+            x = (uint8_t)*cur++;
+            return true;
+        }
+
+        bool u32(uint32_t &x)
+        {
+            if ((size_t)(end - cur) < sizeof(uint32_t)) {
+                return false;
+            }
+            memcpy(&x, cur, sizeof(uint32_t));
+            cur += sizeof(uint32_t);
+            return true;
+        }
+
+        bool u64(uint64_t &x)
+        {
+            if ((size_t)(end - cur) < sizeof(uint64_t)) {
+                return false;
+            }
+            memcpy(&x, cur, sizeof(uint64_t));
+            cur += sizeof(uint64_t);
+            return true;
+        }
+
+        bool str(std::string &s)
+        {
+            uint32_t sz;
+            if (!u32(sz) || (size_t)(end - cur) < sz) {
+                return false;
+            }
+            s.assign(cur, sz);
+            cur += sz;
+            return true;
+        }
+    };
+
+    bool
+    write_all(int fd, const char *buf, size_t sz)
+    {
+        while (sz > 0) {
+            ssize_t ret = write(fd, buf, sz);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            buf += ret;
+            sz -= ret;
+        }
+        return true;
+    }
+
+    uint64_t
+    checksum(const char *buf, size_t sz)
+    {
+        uint64_t out[2];
+        MurmurHash3_x64_128(buf, sz, 0xc0ffee, out);
+        return out[0];
+    }
+
+    void
+    append_op(std::string &out, uint8_t type, uint8_t table, const std::string &key, uint64_t num, const std::string &data)
+    {
+        append_u8(out, type);
+        append_u8(out, table);
+        append_str(out, key);
+        append_u64(out, num);
+        append_str(out, data);
+    }
+
+    // header, lsn, and op count are filled in by end_record
+    size_t
+    begin_record(std::string &out, uint64_t lsn)
+    {
+        size_t start = out.size();
+        append_u32(out, 0);
+        append_u64(out, 0);
+        append_u64(out, lsn);
+        append_u32(out, 0);
+        return start;
+    }
+
+    void
+    end_record(std::string &out, size_t start, uint32_t num_ops)
+    {
+        memcpy(&out[start + RECORD_HEADER_SZ + sizeof(uint64_t)], &num_ops, sizeof(uint32_t));
+        uint32_t payload_sz = out.size() - start - RECORD_HEADER_SZ;
+        uint64_t sum = checksum(out.data() + start + RECORD_HEADER_SZ, payload_sz);
+        memcpy(&out[start], &payload_sz, sizeof(uint32_t));
+        memcpy(&out[start + sizeof(uint32_t)], &sum, sizeof(uint64_t));
+    }
+
+    void
+    encode_record(uint64_t lsn, const std::vector<local_store::op> &ops, std::string &out)
+    {
+        size_t start = begin_record(out, lsn);
+        for (const local_store::op &o: ops) {
+            append_op(out, o.type, o.table, o.key, o.num, o.data);
+        }
+        end_record(out, start, ops.size());
+    }
+
+    bool
+    read_file(const std::string &path, std::string &contents, bool &exists)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            exists = false;
+            return errno == ENOENT;
+        }
+        exists = true;
+
+        char buf[1 << 16];
+        ssize_t ret;
+        contents.clear();
+        while ((ret = read(fd, buf, sizeof(buf))) != 0) {
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                close(fd);
+                return false;
+            }
+            contents.append(buf, ret);
+        }
+        close(fd);
+        return true;
+    }
+
+    bool
+    sync_dir(const std::string &dir)
+    {
+        int fd = ::open(dir.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        bool success = (fsync(fd) == 0);
+        close(fd);
+        return success;
+    }
+}
+
+local_store :: local_store(const std::string &d)
+    : dir(d)
+    , wal_fd(-1)
+    , lock_fd(-1)
+    , durable_cond(&mtx)
+    , last_lsn(0)
+    , durable_lsn(0)
+    , wal_bytes(0)
+    , flushing(false)
+    , compacting(false)
+{ }
+
+local_store :: ~local_store()
+{
+    if (wal_fd >= 0) {
+        close(wal_fd);
+    }
+    if (lock_fd >= 0) {
+        close(lock_fd);
+    }
+}
+
+local_store*
+local_store :: shared(const std::string &dir)
+{
+    static std::unordered_map<std::string, local_store*> stores;
+    static po6::threads::mutex init_mtx;
+
+    init_mtx.lock();
+    local_store *&store = stores[dir];
+    if (store == nullptr) {
+        store = new local_store(dir);
+        if (!store->open()) {
+            WDEBUG << "could not open local storage at " << dir << ", exiting now." << std::endl;
+            exit(-1);
+        }
+    }
+    init_mtx.unlock();
+
+    return store;
+}
+
+local_store::table_stripe&
+local_store :: stripe_of(local_table table, const std::string &key)
+{
+    return tables[table][std::hash<std::string>()(key) % LOCAL_STORAGE_STRIPES];
+}
+
+bool
+local_store :: open()
+{
+    size_t slash = dir.rfind('/');
+    if (slash != std::string::npos && slash > 0
+     && mkdir(dir.substr(0, slash).c_str(), 0755) != 0 && errno != EEXIST) {
+        WDEBUG << "mkdir " << dir.substr(0, slash) << " failed, errno " << errno << std::endl;
+        return false;
+    }
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        WDEBUG << "mkdir " << dir << " failed, errno " << errno << std::endl;
+        return false;
+    }
+    lock_fd = ::open((dir + "/lock").c_str(), O_RDWR | O_CREAT, 0644);
+    if (lock_fd < 0 || flock(lock_fd, LOCK_EX | LOCK_NB) != 0) {
+        WDEBUG << "storage dir " << dir << " is in use by another process" << std::endl;
+        return false;
+    }
+
+    if (!replay()) {
+        return false;
+    }
+
+    // truncate a torn record at the end of the log, if any
+    wal_fd = ::open((dir + "/log").c_str(), O_WRONLY | O_CREAT, 0644);
+    if (wal_fd < 0
+     || ftruncate(wal_fd, wal_bytes) != 0
+     || lseek(wal_fd, 0, SEEK_END) < 0) {
+        WDEBUG << "could not open log in " << dir << std::endl;
+        return false;
+    }
+    durable_lsn = last_lsn;
+
+    // finish a snapshot that was cut short, it still needs the previous log
+    if (access((dir + "/log.old").c_str(), F_OK) == 0) {
+        mtx.lock();
+        bool success = write_snapshot(last_lsn);
+        mtx.unlock();
+        if (!success) {
+            WDEBUG << "could not write snapshot in " << dir << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// log.old is the log before the last snapshot started, it exists until the snapshot is in place
+bool
+local_store :: replay()
+{
+    uint64_t snapshot_lsn = 0;
+    return replay_file(dir + "/snapshot", true, snapshot_lsn)
+        && replay_file(dir + "/log.old", false, snapshot_lsn)
+        && replay_file(dir + "/log", false, snapshot_lsn);
+}
+
+// apply every complete record in the file
+// log records up to the snapshot lsn are skipped, later ones must follow without a gap
+bool
+local_store :: replay_file(const std::string &path, bool snapshot, uint64_t &snapshot_lsn)
+{
+    std::string contents;
+    bool exists;
+    if (!read_file(path, contents, exists)) {
+        WDEBUG << "could not read " << path << std::endl;
+        return false;
+    }
+
+    size_t pos = 0;
+    bool snapshot_done = false;
+    std::vector<op> ops;
+    while (contents.size() - pos >= RECORD_HEADER_SZ) {
+        decoder header(contents.data() + pos, RECORD_HEADER_SZ);
+        uint32_t payload_sz;
+        uint64_t sum;
+        header.u32(payload_sz);
+        header.u64(sum);
+        if (contents.size() - pos - RECORD_HEADER_SZ < payload_sz) {
+            break;
+        }
+        const char *payload = contents.data() + pos + RECORD_HEADER_SZ;
+        if (checksum(payload, payload_sz) != sum) {
+            break;
+        }
+
+        decoder dec(payload, payload_sz);
+        uint64_t lsn;
+        uint32_t num_ops;
+        if (!dec.u64(lsn) || !dec.u32(num_ops)) {
+            break;
+        }
+        ops.resize(num_ops);
+        bool good = true;
+        for (op &o: ops) {
+            uint8_t type, table;
+            good = dec.u8(type) && dec.u8(table) && dec.str(o.key) && dec.u64(o.num) && dec.str(o.data)
+                && table < LOCAL_NUM_TABLES;
+            if (!good) {
+                break;
+            }
+            o.type = (op_type)type;
+            o.table = (local_table)table;
+        }
+        if (!good) {
+            WDEBUG << "corrupt record in " << path << " at offset " << pos << std::endl;
+            return false;
+        }
+
+        if (snapshot) {
+            if (last_lsn != 0 && lsn != last_lsn) {
+                WDEBUG << "corrupt snapshot " << path << std::endl;
+                return false;
+            }
+            snapshot_lsn = lsn;
+            snapshot_done = (num_ops == 0);
+        } else if (lsn <= snapshot_lsn) {
+            pos += RECORD_HEADER_SZ + payload_sz;
+            continue;
+        } else if (lsn != last_lsn + 1) {
+            WDEBUG << "gap in log " << path << ", expected lsn " << last_lsn+1 << ", found " << lsn << std::endl;
+            return false;
+        }
+
+        for (const op &o: ops) {
+            apply(o, lsn);
+        }
+        last_lsn = lsn;
+        pos += RECORD_HEADER_SZ + payload_sz;
+
+        if (snapshot_done) {
+            break;
+        }
+    }
+
+    if (snapshot && exists && !snapshot_done) {
+        WDEBUG << "incomplete snapshot " << path << std::endl;
+        return false;
+    }
+    if (!snapshot) {
+        wal_bytes = pos;
+    }
+    return true;
+}
+
+void
+local_store :: apply(const op &o, uint64_t lsn)
+{
+    table_stripe &table = stripe_of(o.table, o.key);
+    switch (o.type) {
+        case LOCAL_PUT:
+        case LOCAL_PUT_IF_NOT_EXIST: {
+            record &rec = table[o.key];
+            rec.num = o.num;
+            rec.data = o.data;
+            rec.version = lsn;
+            break;
+        }
+
+        case LOCAL_PUT_NUM: {
+            record &rec = table[o.key];
+            rec.num = o.num;
+            rec.version = lsn;
+            break;
+        }
+
+        case LOCAL_DEL:
+            table.erase(o.key);
+            break;
+    }
+}
+
+// caller holds mtx
+// the first waiter writes out everything pending while the others wait for it
+// when the log is full, that waiter also starts a new log and writes a snapshot,
+// other commits go on meanwhile
+void
+local_store :: wait_durable(uint64_t lsn)
+{
+    while (durable_lsn < lsn) {
+        if (flushing) {
+            durable_cond.wait();
+            continue;
+        }
+
+        flushing = true;
+        std::string buf;
+        buf.swap(pending);
+        uint64_t flush_lsn = last_lsn;
+        bool compact = !compacting && (wal_bytes + buf.size() > LOCAL_STORAGE_SNAPSHOT_BYTES);
+        mtx.unlock();
+
+        bool success = write_all(wal_fd, buf.data(), buf.size()) && fdatasync(wal_fd) == 0;
+        if (success && compact) {
+            success = start_log();
+        }
+        if (!success) {
+            // memory is ahead of disk, cannot make later commits durable
+            WDEBUG << "local storage write failed, errno " << errno << ", exiting now." << std::endl;
+            exit(-1);
+        }
+
+        mtx.lock();
+        wal_bytes = compact? 0 : (wal_bytes + buf.size());
+        durable_lsn = flush_lsn;
+        flushing = false;
+        durable_cond.broadcast();
+
+        if (compact) {
+            compacting = true;
+            if (!write_snapshot(flush_lsn)) {
+                WDEBUG << "local storage snapshot failed, errno " << errno << ", exiting now." << std::endl;
+                exit(-1);
+            }
+            compacting = false;
+        }
+    }
+}
+
+// called by the flusher, the current log becomes log.old until the next snapshot is in place
+bool
+local_store :: start_log()
+{
+    std::string log_path = dir + "/log";
+    if (rename(log_path.c_str(), (log_path + ".old").c_str()) != 0) {
+        return false;
+    }
+    int fd = ::open(log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (!sync_dir(dir)) {
+        close(fd);
+        return false;
+    }
+    close(wal_fd);
+    wal_fd = fd;
+
+    return true;
+}
+
+// every record of the live tables as a put at snapshot_lsn, all records after it are in the new log
+// mtx is held for one stripe at a time, so records may already include writes after snapshot_lsn,
+// which replaying the new log writes again in order
+// the snapshot replaces the old one only when all writes it may include are durable in the new log
+// caller holds mtx
+bool
+local_store :: write_snapshot(uint64_t snapshot_lsn)
+{
+    std::string snap_path = dir + "/snapshot";
+    mtx.unlock();
+    int fd = ::open((snap_path + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    mtx.lock();
+    if (fd < 0) {
+        return false;
+    }
+
+    bool success = true;
+    std::string buf;
+    for (int t = 0; t < LOCAL_NUM_TABLES && success; t++) {
+        for (int i = 0; i < LOCAL_STORAGE_STRIPES && success; i++) {
+            size_t start = begin_record(buf, snapshot_lsn);
+            uint32_t num_ops = 0;
+            for (const auto &p: tables[t][i]) {
+                append_op(buf, LOCAL_PUT, t, p.first, p.second.num, p.second.data);
+                num_ops++;
+                if (buf.size() - start > SNAPSHOT_RECORD_BYTES) {
+                    end_record(buf, start, num_ops);
+                    start = begin_record(buf, snapshot_lsn);
+                    num_ops = 0;
+                }
+            }
+            // a record with no ops ends the snapshot
+            if (num_ops > 0) {
+                end_record(buf, start, num_ops);
+            } else {
+                buf.resize(start);
+            }
+
+            mtx.unlock();
+            success = write_all(fd, buf.data(), buf.size());
+            mtx.lock();
+            buf.clear();
+        }
+    }
+    end_record(buf, begin_record(buf, snapshot_lsn), 0);
+
+    if (success) {
+        wait_durable(last_lsn);
+    }
+
+    mtx.unlock();
+    success = success
+           && write_all(fd, buf.data(), buf.size())
+           && fsync(fd) == 0;
+    close(fd);
+    success = success
+           && rename((snap_path + ".tmp").c_str(), snap_path.c_str()) == 0
+           && (unlink((dir + "/log.old").c_str()) == 0 || errno == ENOENT)
+           && sync_dir(dir);
+    mtx.lock();
+
+    return success;
+}
+
+storage_commit_status
+local_store :: commit(const std::vector<read_version> &read_set, const std::vector<op> &ops)
+{
+    mtx.lock();
+
+    for (const read_version &rv: read_set) {
+        table_stripe &table = stripe_of(rv.table, rv.key);
+        auto iter = table.find(rv.key);
+        uint64_t cur_version = (iter == table.end())? 0 : iter->second.version;
+        if (cur_version != rv.version) {
+            mtx.unlock();
+            return STORAGE_ABORTED;
+        }
+    }
+
+    for (const op &o: ops) {
+        if (o.type == LOCAL_PUT_IF_NOT_EXIST) {
+            table_stripe &table = stripe_of(o.table, o.key);
+            if (table.find(o.key) != table.end()) {
+                mtx.unlock();
+                return STORAGE_ERROR;
+            }
+        }
+    }
+
+    if (!ops.empty()) {
+        uint64_t lsn = ++last_lsn;
+        for (const op &o: ops) {
+            apply(o, lsn);
+        }
+        encode_record(lsn, ops, pending);
+        wait_durable(lsn);
+    }
+
+    mtx.unlock();
+    return STORAGE_COMMITTED;
+}
+
+bool
+local_store :: get(local_table table, const std::string &key, record &rec)
+{
+    mtx.lock();
+    table_stripe &stripe = stripe_of(table, key);
+    auto iter = stripe.find(key);
+    bool found = (iter != stripe.end());
+    if (found) {
+        rec = iter->second;
+    }
+    mtx.unlock();
+
+    return found;
+}
+
+void
+local_store :: for_each(local_table table, std::function<void(const std::string&, const record&)> func)
+{
+    mtx.lock();
+    for (const table_stripe &stripe: tables[table]) {
+        for (const auto &p: stripe) {
+            func(p.first, p.second);
+        }
+    }
+    mtx.unlock();
+}
@@ -73,6 +73,10 @@ message :: to_string(const msg_type &t)
             return "RESTORE_DONE";
         case LOADED_GRAPH:
             return "LOADED_GRAPH";
+        case STORE_BULK_LOAD:
+            return "STORE_BULK_LOAD";
+        case STORE_NMAP_UPDATE:
+            return "STORE_NMAP_UPDATE";
         case VT_CLOCK_UPDATE:
             return "VT_CLOCK_UPDATE";
         case VT_CLOCK_UPDATE_ACK:
@@ -81,8 +85,48 @@ message :: to_string(const msg_type &t)
             return "VT_NOP";
         case VT_NOP_ACK:
             return "VT_NOP_ACK";
+        case VT_READ_LEASE:
+            return "VT_READ_LEASE";
         case DONE_MIGR:
             return "DONE_MIGR";
+        case CLIENT_BSP_REQ:
+            return "CLIENT_BSP_REQ";
+        case CLIENT_BSP_REPLY:
+            return "CLIENT_BSP_REPLY";
+        case BSP_SUPERSTEP:
+            return "BSP_SUPERSTEP";
+        case BSP_MSGS:
+            return "BSP_MSGS";
+        case BSP_STEP_DONE:
+            return "BSP_STEP_DONE";
+        case CACHE_WATCH:
+            return "CACHE_WATCH";
+        case CACHE_UNWATCH:
+            return "CACHE_UNWATCH";
+        case CACHE_INVALIDATE:
+            return "CACHE_INVALIDATE";
+        case CACHE_WATERMARK:
+            return "CACHE_WATERMARK";
+        case TRAVERSAL_SAMPLING:
+            return "TRAVERSAL_SAMPLING";
+        case CLIENT_METRICS_REQ:
+            return "CLIENT_METRICS_REQ";
+        case CLIENT_METRICS_REPLY:
+            return "CLIENT_METRICS_REPLY";
+        case METRICS_REQ:
+            return "METRICS_REQ";
+        case METRICS_REPLY:
+            return "METRICS_REPLY";
+        case PROG_TRACE_SAMPLING:
+            return "PROG_TRACE_SAMPLING";
+        case TRACE_FETCH:
+            return "TRACE_FETCH";
+        case TRACE_SPANS:
+            return "TRACE_SPANS";
+        case CLIENT_TRACES_REQ:
+            return "CLIENT_TRACES_REQ";
+        case CLIENT_TRACES_REPLY:
+            return "CLIENT_TRACES_REPLY";
         case ERROR:
             return "ERROR";
     }
@@ -217,6 +261,38 @@ message :: size(const db::remote_node &t)
     return size(t.loc) + size(t.handle);
 }
 
+uint64_t
+message :: size(const bsp::params &t)
+{
+    return size(t.algo)
+        + size(t.max_supersteps)
+        + size(t.damping)
+        + size(t.top_k);
+}
+
+uint64_t
+message :: size(const bsp::result &t)
+{
+    return size(t.supersteps)
+        + size(t.num_nodes)
+        + size(t.num_components)
+        + size(t.top)
+        + size(t.histogram)
+        + size(t.in_histogram);
+}
+
+uint64_t
+message :: size(const prog_trace::span &t)
+{
+    return size(t.trace_id)
+        + size(t.hop_id)
+        + size(t.parent_hop)
+        + size(t.shard)
+        + size(t.kind)
+        + size(t.dur_ns)
+        + size(t.count);
+}
+
 uint64_t
 message :: size(const std::shared_ptr<transaction::pending_update> &t)
 {
@@ -466,6 +542,38 @@ message :: pack_buffer(e::buffer::packer &packer, const db::remote_node &t)
     pack_buffer(packer, t.handle);
 }
 
+void
+message :: pack_buffer(e::buffer::packer &packer, const bsp::params &t)
+{
+    pack_buffer(packer, t.algo);
+    pack_buffer(packer, t.max_supersteps);
+    pack_buffer(packer, t.damping);
+    pack_buffer(packer, t.top_k);
+}
+
+void
+message :: pack_buffer(e::buffer::packer &packer, const bsp::result &t)
+{
+    pack_buffer(packer, t.supersteps);
+    pack_buffer(packer, t.num_nodes);
+    pack_buffer(packer, t.num_components);
+    pack_buffer(packer, t.top);
+    pack_buffer(packer, t.histogram);
+    pack_buffer(packer, t.in_histogram);
+}
+
+void
+message :: pack_buffer(e::buffer::packer &packer, const prog_trace::span &t)
+{
+    pack_buffer(packer, t.trace_id);
+    pack_buffer(packer, t.hop_id);
+    pack_buffer(packer, t.parent_hop);
+    pack_buffer(packer, t.shard);
+    pack_buffer(packer, t.kind);
+    pack_buffer(packer, t.dur_ns);
+    pack_buffer(packer, t.count);
+}
+
 void
 message :: pack_buffer(e::buffer::packer &packer, const std::shared_ptr<transaction::pending_update> &t)
 {
@@ -723,6 +831,38 @@ message :: unpack_buffer(e::unpacker &unpacker, db::remote_node& t)
     unpack_buffer(unpacker, t.handle);
 }
 
+void
+message :: unpack_buffer(e::unpacker &unpacker, bsp::params &t)
+{
+    unpack_buffer(unpacker, t.algo);
+    unpack_buffer(unpacker, t.max_supersteps);
+    unpack_buffer(unpacker, t.damping);
+    unpack_buffer(unpacker, t.top_k);
+}
+
+void
+message :: unpack_buffer(e::unpacker &unpacker, bsp::result &t)
+{
+    unpack_buffer(unpacker, t.supersteps);
+    unpack_buffer(unpacker, t.num_nodes);
+    unpack_buffer(unpacker, t.num_components);
+    unpack_buffer(unpacker, t.top);
+    unpack_buffer(unpacker, t.histogram);
+    unpack_buffer(unpacker, t.in_histogram);
+}
+
+void
+message :: unpack_buffer(e::unpacker &unpacker, prog_trace::span &t)
+{
+    unpack_buffer(unpacker, t.trace_id);
+    unpack_buffer(unpacker, t.hop_id);
+    unpack_buffer(unpacker, t.parent_hop);
+    unpack_buffer(unpacker, t.shard);
+    unpack_buffer(unpacker, t.kind);
+    unpack_buffer(unpacker, t.dur_ns);
+    unpack_buffer(unpacker, t.count);
+}
+
 void
 message :: unpack_buffer(e::unpacker &unpacker, std::shared_ptr<transaction::pending_update> &t)
 {
@@ -31,6 +31,8 @@
 #include "common/vclock.h"
 #include "common/transaction.h"
 #include "common/property_predicate.h"
+#include "common/bsp.h"
+#include "common/prog_trace.h"
 #include "node_prog/node_prog_type.h"
 #include "node_prog/base_classes.h"
 #include "node_prog/property.h"
@@ -92,12 +94,40 @@ namespace message
         RESTORE_DONE,
         // initial graph loading
         LOADED_GRAPH,
+        // shard writes to timestamper local storage
+        STORE_BULK_LOAD,
+        STORE_NMAP_UPDATE,
         // coordinator group
         VT_CLOCK_UPDATE,
         VT_CLOCK_UPDATE_ACK,
         VT_NOP,
         VT_NOP_ACK,
+        VT_READ_LEASE,
         DONE_MIGR,
+        // bulk synchronous analytics
+        CLIENT_BSP_REQ,
+        CLIENT_BSP_REPLY,
+        BSP_SUPERSTEP,
+        BSP_MSGS,
+        BSP_STEP_DONE,
+        // node program cache invalidation
+        CACHE_WATCH,
+        CACHE_UNWATCH,
+        CACHE_INVALIDATE,
+        CACHE_WATERMARK,
+        // traversal telemetry
+        TRAVERSAL_SAMPLING,
+        // server metrics
+        CLIENT_METRICS_REQ,
+        CLIENT_METRICS_REPLY,
+        METRICS_REQ,
+        METRICS_REPLY,
+        // node program tracing
+        PROG_TRACE_SAMPLING,
+        TRACE_FETCH,
+        TRACE_SPANS,
+        CLIENT_TRACES_REQ,
+        CLIENT_TRACES_REPLY,
 
         ERROR
     };
@@ -146,6 +176,9 @@ namespace message
     uint64_t size(const node_prog::property &t);
     uint64_t size(const db::property &t);
     uint64_t size(const db::remote_node &t);
+    uint64_t size(const bsp::params &t);
+    uint64_t size(const bsp::result &t);
+    uint64_t size(const prog_trace::span &t);
     uint64_t size(const std::shared_ptr<transaction::pending_update> &ptr_t);
     uint64_t size(const std::shared_ptr<transaction::nop_data> &ptr_t);
     uint64_t size(const transaction::pending_tx &t);
@@ -168,6 +201,7 @@ namespace message
     uint64_t size(const db::edge &t);
     uint64_t size(const db::edge* const &t);
     uint64_t size(const db::node &t);
+    uint64_t size(const db::node* const &t);
     uint64_t size(const cl::node &t);
     uint64_t size(const cl::edge &t);
     uint64_t size(const enum predicate::relation&);
@@ -194,6 +228,9 @@ namespace message
     void pack_buffer(e::buffer::packer &packer, const node_prog::property &t);
     void pack_buffer(e::buffer::packer &packer, const db::property &t);
     void pack_buffer(e::buffer::packer &packer, const db::remote_node &t);
+    void pack_buffer(e::buffer::packer &packer, const bsp::params &t);
+    void pack_buffer(e::buffer::packer &packer, const bsp::result &t);
+    void pack_buffer(e::buffer::packer &packer, const prog_trace::span &t);
     void pack_buffer(e::buffer::packer &packer, const std::shared_ptr<transaction::pending_update> &ptr_t);
     void pack_buffer(e::buffer::packer &packer, const std::shared_ptr<transaction::nop_data> &ptr_t);
     void pack_buffer(e::buffer::packer &packer, const transaction::pending_tx &t);
@@ -216,6 +253,7 @@ namespace message
     void pack_buffer(e::buffer::packer &packer, const db::edge &t);
     void pack_buffer(e::buffer::packer &packer, const db::edge* const &t);
     void pack_buffer(e::buffer::packer &packer, const db::node &t);
+    void pack_buffer(e::buffer::packer &packer, const db::node* const &t);
     void pack_buffer(e::buffer::packer &packer, const cl::node &t);
     void pack_buffer(e::buffer::packer &packer, const cl::edge &t);
     void pack_buffer(e::buffer::packer &packer, const enum predicate::relation &t);
@@ -242,6 +280,9 @@ namespace message
     void unpack_buffer(e::unpacker &unpacker, node_prog::property &t);
     void unpack_buffer(e::unpacker &unpacker, db::property &t);
     void unpack_buffer(e::unpacker &unpacker, db::remote_node& t);
+    void unpack_buffer(e::unpacker &unpacker, bsp::params &t);
+    void unpack_buffer(e::unpacker &unpacker, bsp::result &t);
+    void unpack_buffer(e::unpacker &unpacker, prog_trace::span &t);
     void unpack_buffer(e::unpacker &unpacker, std::shared_ptr<transaction::pending_update> &ptr_t);
     void unpack_buffer(e::unpacker &unpacker, std::shared_ptr<transaction::nop_data> &ptr_t);
     void unpack_buffer(e::unpacker &unpacker, transaction::pending_tx &t);
@@ -20,6 +20,9 @@
 #include "node_prog/node_prog_type.h"
 #include "node_prog/reach_program.h"
 #include "node_prog/pathless_reach_program.h"
+#include "node_prog/n_hop_reach_program.h"
+#include "node_prog/triangle_program.h"
+#include "node_prog/dijkstra_program.h"
 #include "node_prog/clustering_program.h"
 #include "node_prog/read_node_props_program.h"
 #include "node_prog/read_n_edges_program.h"
@@ -44,12 +47,6 @@ uint64_t
 message :: size(const db::edge &t)
 {
     uint64_t sz = size(t.base)
-#ifdef WEAVER_CLDG
-        + size(t.msg_count)
-#endif
-#ifdef WEAVER_NEW_CLDG
-        + size(t.msg_count)
-#endif
         + size(t.nbr);
     return sz;
 }
@@ -67,16 +64,17 @@ message :: size(const db::node &t)
     sz += size(t.base);
     sz += size(t.out_edges);
     sz += size(t.aliases);
-#ifdef WEAVER_CLDG
-    sz += size(t.msg_count);
-#endif
-#ifdef WEAVER_NEW_CLDG
-    sz += size(t.msg_count);
-#endif
+    sz += size(t.max_upd_clk);
     sz += size(t.prog_states);
     return sz;
 }
 
+uint64_t
+message :: size(const db::node* const &t)
+{
+    return size(*t);
+}
+
 // packing methods
 void message :: pack_buffer(e::buffer::packer &packer, const db::element &t)
 {
@@ -89,12 +87,6 @@ void message :: pack_buffer(e::buffer::packer &packer, const db::element &t)
 void message :: pack_buffer(e::buffer::packer &packer, const db::edge &t)
 {
     pack_buffer(packer, t.base);
-#ifdef WEAVER_CLDG
-    pack_buffer(packer, t.msg_count);
-#endif
-#ifdef WEAVER_NEW_CLDG
-    pack_buffer(packer, t.msg_count);
-#endif
     pack_buffer(packer, t.nbr);
 }
 
@@ -109,15 +101,16 @@ message :: pack_buffer(e::buffer::packer &packer, const db::node &t)
     pack_buffer(packer, t.base);
     pack_buffer(packer, t.out_edges);
     pack_buffer(packer, t.aliases);
-#ifdef WEAVER_CLDG
-    pack_buffer(packer, t.msg_count);
-#endif
-#ifdef WEAVER_NEW_CLDG
-    pack_buffer(packer, t.msg_count);
-#endif
+    pack_buffer(packer, t.max_upd_clk);
     pack_buffer(packer, t.prog_states);
 }
 
+void
+message :: pack_buffer(e::buffer::packer &packer, const db::node* const &t)
+{
+    pack_buffer(packer, *t);
+}
+
 // unpacking methods
 void
 message :: unpack_buffer(e::unpacker &unpacker, db::element &t)
@@ -140,12 +133,6 @@ void
 message :: unpack_buffer(e::unpacker &unpacker, db::edge &t)
 {
     unpack_buffer(unpacker, t.base);
-#ifdef WEAVER_CLDG
-    unpack_buffer(unpacker, t.msg_count);
-#endif
-#ifdef WEAVER_NEW_CLDG
-    unpack_buffer(unpacker, t.msg_count);
-#endif
     unpack_buffer(unpacker, t.nbr);
 }
 void
@@ -173,12 +160,8 @@ message :: unpack_buffer(e::unpacker &unpacker, db::node &t)
     unpack_buffer(unpacker, t.base);
     unpack_buffer(unpacker, t.out_edges);
     unpack_buffer(unpacker, t.aliases);
-#ifdef WEAVER_CLDG
-    unpack_buffer(unpacker, t.msg_count);
-#endif
-#ifdef WEAVER_NEW_CLDG
-    unpack_buffer(unpacker, t.msg_count);
-#endif
+    unpack_buffer(unpacker, t.max_upd_clk);
+    t.start_change_log();
 
     // unpack node prog state
     // need to unroll because we have to first unpack into particular state type, and then upcast and save as base type
@@ -216,6 +199,18 @@ message :: unpack_buffer(e::unpacker &unpacker, db::node &t)
                     val = unpack_single_node_state<node_prog::pathless_reach_node_state>(unpacker);
                     break;
 
+                case node_prog::N_HOP_REACHABILITY:
+                    val = unpack_single_node_state<node_prog::n_hop_reach_node_state>(unpacker);
+                    break;
+
+                case node_prog::TRIANGLE_COUNT:
+                    val = unpack_single_node_state<node_prog::triangle_node_state>(unpacker);
+                    break;
+
+                case node_prog::DIJKSTRA:
+                    val = unpack_single_node_state<node_prog::dijkstra_node_state>(unpacker);
+                    break;
+
                 case node_prog::CLUSTERING:
                     val = unpack_single_node_state<node_prog::clustering_node_state>(unpacker);
                     break;
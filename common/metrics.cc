@@ -0,0 +1,221 @@
+/*
+ * ===============================================================
+ *    Description:  Server metrics implementation.
+ *
+ *        Created:  2026-10-19 16:54:33
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include <time.h>
+#include <stdio.h>
+#include <fstream>
+#include <iomanip>
+
+#include "common/weaver_constants.h"
+#include "common/message.h"
+#include "common/metrics.h"
+
+static_assert(message::ERROR < METRICS_MSG_TYPES, "METRICS_MSG_TYPES too small for msg_type");
+
+uint64_t
+metrics :: clock_ns()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_nsec + ((uint64_t)ts.tv_sec)*GIGA;
+}
+
+uint64_t
+metrics :: next_stripe()
+{
+    static std::atomic<uint64_t> num_threads(0);
+    return num_threads++ % METRICS_STRIPES;
+}
+
+uint64_t
+metrics :: counter :: value() const
+{
+    uint64_t v = 0;
+    for (uint64_t i = 0; i < METRICS_STRIPES; i++) {
+        v += stripes[i].val.load(std::memory_order_relaxed);
+    }
+    return v;
+}
+
+metrics :: histogram :: stripe_buckets :: stripe_buckets()
+    : sum(0)
+{
+    for (uint64_t b = 0; b < METRICS_BUCKETS; b++) {
+        buckets[b] = 0;
+    }
+}
+
+uint64_t
+metrics :: histogram :: bucket_of(uint64_t v)
+{
+    if (v < (1ULL << METRICS_SUB_BITS)) {
+        return v;
+    }
+    uint64_t exp = 63 - __builtin_clzll(v);
+    uint64_t sub = (v >> (exp - METRICS_SUB_BITS)) & ((1ULL << METRICS_SUB_BITS) - 1);
+    return ((exp - METRICS_SUB_BITS + 1) << METRICS_SUB_BITS) + sub;
+}
+
+uint64_t
+metrics :: histogram :: bucket_max(uint64_t b)
+{
+    if (b < (1ULL << METRICS_SUB_BITS)) {
+        return b;
+    }
+    uint64_t exp = (b >> METRICS_SUB_BITS) + METRICS_SUB_BITS - 1;
+    uint64_t sub = b & ((1ULL << METRICS_SUB_BITS) - 1);
+    uint64_t width = 1ULL << (exp - METRICS_SUB_BITS);
+    return (((1ULL << METRICS_SUB_BITS) + sub) << (exp - METRICS_SUB_BITS)) + (width - 1);
+}
+
+void
+metrics :: histogram :: record(uint64_t v)
+{
+    stripe_buckets &s = stripes[stripe()];
+    s.buckets[bucket_of(v)].fetch_add(1, std::memory_order_relaxed);
+    s.sum.fetch_add(v, std::memory_order_relaxed);
+}
+
+void
+metrics :: histogram :: get_snapshot(snapshot &snap) const
+{
+    snap.count = 0;
+    snap.sum = 0;
+    snap.buckets.assign(METRICS_BUCKETS, 0);
+    for (uint64_t i = 0; i < METRICS_STRIPES; i++) {
+        const stripe_buckets &s = stripes[i];
+        for (uint64_t b = 0; b < METRICS_BUCKETS; b++) {
+            uint64_t c = s.buckets[b].load(std::memory_order_relaxed);
+            snap.buckets[b] += c;
+            snap.count += c;
+        }
+        snap.sum += s.sum.load(std::memory_order_relaxed);
+    }
+}
+
+uint64_t
+metrics :: histogram :: snapshot :: percentile(double p) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t)(p * count);
+    if (rank >= count) {
+        rank = count - 1;
+    }
+    uint64_t seen = 0;
+    for (uint64_t b = 0; b < buckets.size(); b++) {
+        seen += buckets[b];
+        if (seen > rank) {
+            return bucket_max(b);
+        }
+    }
+    return bucket_max(buckets.size()-1);
+}
+
+metrics::server_metrics&
+metrics :: get()
+{
+    static server_metrics *m = new server_metrics();
+    return *m;
+}
+
+static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+// summary with quantiles, 'scale' converts recorded values to the unit of the metric
+static void
+dump_summary(std::ostream &out, const char *name, const char *help, const std::string &labels,
+    const metrics::histogram &h, double scale, bool header=true)
+{
+    metrics::histogram::snapshot snap;
+    h.get_snapshot(snap);
+    if (header) {
+        out << "# HELP " << name << " " << help << "\n"
+            << "# TYPE " << name << " summary\n";
+    }
+    for (double q: quantiles) {
+        out << name << "{" << labels << ",quantile=\"" << q << "\"} " << snap.percentile(q) * scale << "\n";
+    }
+    out << name << "_sum{" << labels << "} " << snap.sum * scale << "\n"
+        << name << "_count{" << labels << "} " << snap.count << "\n";
+}
+
+static void
+dump_counter(std::ostream &out, const char *name, const char *help, const std::string &labels, uint64_t val)
+{
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " counter\n"
+        << name << "{" << labels << "} " << val << "\n";
+}
+
+void
+metrics :: dump_prometheus(std::ostream &out, const std::string &server,
+    const std::vector<std::pair<std::string, uint64_t>> &extra)
+{
+    server_metrics &m = get();
+    std::string labels = "server=\"" + server + "\"";
+    double secs = 1.0 / GIGA;
+
+    out << std::setprecision(9);
+    dump_summary(out, "weaver_rd_queue_wait_seconds", "Time node programs waited in shard read queues.",
+        labels, m.rd_queue_wait_ns, secs);
+    dump_summary(out, "weaver_wr_queue_wait_seconds", "Time transactions waited in shard write queues.",
+        labels, m.wr_queue_wait_ns, secs);
+    dump_summary(out, "weaver_node_lock_wait_seconds", "Time exclusive node acquires waited for other holders.",
+        labels, m.node_lock_wait_ns, secs);
+    dump_summary(out, "weaver_kronos_call_seconds", "Latency of Kronos ordering calls.",
+        labels, m.kronos_call_ns, secs);
+    dump_summary(out, "weaver_hyperdex_wait_seconds", "Time waiting for HyperDex operations to complete.",
+        labels, m.hyperdex_wait_ns, secs);
+
+    dump_counter(out, "weaver_prog_visits_total", "Node program visits.", labels, m.prog_visits.value());
+    dump_counter(out, "weaver_prog_local_hops_total", "Node program hops to nodes on the same shard.",
+        labels, m.prog_local_hops.value());
+    dump_counter(out, "weaver_prog_remote_hops_total", "Node program hops to nodes on other shards.",
+        labels, m.prog_remote_hops.value());
+
+    bool header = true;
+    for (int t = 0; t < METRICS_MSG_TYPES; t++) {
+        metrics::histogram::snapshot snap;
+        m.msg_bytes[t].get_snapshot(snap);
+        if (snap.count == 0) {
+            continue;
+        }
+        std::string type_labels = labels + ",type=\"" + message::to_string((message::msg_type)t) + "\"";
+        dump_summary(out, "weaver_message_bytes", "Size of received messages by type.",
+            type_labels, m.msg_bytes[t], 1, header);
+        header = false;
+    }
+
+    for (const auto &p: extra) {
+        out << "# TYPE weaver_" << p.first << " untyped\n"
+            << "weaver_" << p.first << "{" << labels << "} " << p.second << "\n";
+    }
+}
+
+bool
+metrics :: dump_prometheus_file(const std::string &path, const std::string &server,
+    const std::vector<std::pair<std::string, uint64_t>> &extra)
+{
+    std::string tmp_path = path + ".tmp";
+    std::ofstream file(tmp_path, std::ofstream::out | std::ofstream::trunc);
+    if (!file) {
+        WDEBUG << "could not open metrics file " << tmp_path << std::endl;
+        return false;
+    }
+    dump_prometheus(file, server, extra);
+    file.close();
+    if (!file || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        WDEBUG << "could not write metrics file " << path << std::endl;
+        return false;
+    }
+    return true;
+}
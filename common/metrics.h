@@ -0,0 +1,126 @@
+/*
+ * ===============================================================
+ *    Description:  Process wide counters and latency histograms of
+ *                  a Weaver server, dumped as Prometheus text.
+ *
+ *        Created:  2026-10-19 16:54:33
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_common_metrics_h_
+#define weaver_common_metrics_h_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <ostream>
+
+#define METRICS_STRIPES 8 // threads beyond this share stripes
+#define METRICS_MSG_TYPES 64 // > message::ERROR
+#define METRICS_SUB_BITS 3 // histogram buckets per power of two = 2^METRICS_SUB_BITS
+#define METRICS_BUCKETS ((64 - METRICS_SUB_BITS + 1) << METRICS_SUB_BITS)
+#define METRICS_DUMP_INTERVAL_SECS 10 // --metrics-file rewrite period
+
+namespace metrics
+{
+    // nanoseconds on a monotonic clock
+    uint64_t clock_ns();
+
+    uint64_t next_stripe();
+
+    // stripe of the calling thread
+    inline uint64_t
+    stripe()
+    {
+        static thread_local uint64_t idx = next_stripe();
+        return idx;
+    }
+
+    // Updates are relaxed atomic adds to the stripe of the calling thread,
+    // so threads do not share cache lines.  Reads sum all stripes.
+    class counter
+    {
+        private:
+            struct alignas(64) padded
+            {
+                std::atomic<uint64_t> val;
+                padded() : val(0) { }
+            };
+            padded stripes[METRICS_STRIPES];
+
+        public:
+            void add(uint64_t v) { stripes[stripe()].val.fetch_add(v, std::memory_order_relaxed); }
+            void inc() { add(1); }
+            uint64_t value() const;
+    };
+
+    // Log linear buckets, as in HdrHistogram: values below 2^METRICS_SUB_BITS
+    // get a bucket each, larger values are bucketed with a relative error
+    // of at most 2^-METRICS_SUB_BITS.  Lock free, striped like counter.
+    class histogram
+    {
+        private:
+            // count is the sum of buckets
+            struct alignas(64) stripe_buckets
+            {
+                std::atomic<uint64_t> sum;
+                std::atomic<uint64_t> buckets[METRICS_BUCKETS];
+
+                stripe_buckets();
+            };
+            stripe_buckets stripes[METRICS_STRIPES];
+
+        public:
+            static uint64_t bucket_of(uint64_t v);
+            static uint64_t bucket_max(uint64_t b); // largest value in bucket b
+
+            void record(uint64_t v);
+            void record_since(uint64_t start_ns) { record(clock_ns() - start_ns); }
+
+            // merged over stripes, racing with writers so counts are approximate
+            struct snapshot
+            {
+                uint64_t count, sum;
+                std::vector<uint64_t> buckets;
+
+                uint64_t percentile(double p) const; // upper bound of value at percentile p in [0,1]
+            };
+            void get_snapshot(snapshot &s) const;
+    };
+
+    // all metrics of one server process, shard or timestamper
+    struct server_metrics
+    {
+        histogram rd_queue_wait_ns; // reads in shard rd_queues
+        histogram wr_queue_wait_ns; // writes in shard wr_queues
+        histogram node_lock_wait_ns; // exclusive node acquire that had to wait
+        histogram kronos_call_ns;
+        histogram hyperdex_wait_ns; // hyperdex_client_loop
+        counter prog_visits; // node program visits
+        counter prog_local_hops;
+        counter prog_remote_hops;
+        histogram msg_bytes[METRICS_MSG_TYPES]; // received messages by msg_type
+
+        void message_received(int type, uint64_t bytes)
+        {
+            if (type >= 0 && type < METRICS_MSG_TYPES) {
+                msg_bytes[type].record(bytes);
+            }
+        }
+    };
+
+    server_metrics& get();
+
+    // Prometheus text exposition format, every sample labeled server="<server>"
+    // 'extra' adds counters of the caller, tracked elsewhere
+    void dump_prometheus(std::ostream &out, const std::string &server,
+        const std::vector<std::pair<std::string, uint64_t>> &extra);
+    // write to a temporary file and rename it over 'path', so readers never see a partial dump
+    bool dump_prometheus_file(const std::string &path, const std::string &server,
+        const std::vector<std::pair<std::string, uint64_t>> &extra);
+}
+
+#endif
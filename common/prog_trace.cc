@@ -0,0 +1,203 @@
+/*
+ * ===============================================================
+ *    Description:  Node program trace recording and assembly.
+ *
+ *        Created:  2026-10-19 16:59:50
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include <assert.h>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <unordered_map>
+
+#include "common/weaver_constants.h"
+#include "common/thread_index.h"
+#include "common/prog_trace.h"
+
+using prog_trace::recorder;
+
+const char*
+prog_trace :: to_string(uint32_t kind)
+{
+    switch (kind) {
+        case QUEUED:
+            return "queued";
+        case ACQUIRE:
+            return "acquire";
+        case EXECUTED:
+            return "executed";
+        case CACHE_FETCH:
+            return "cache fetch";
+        case FORWARDED:
+            return "forwarded";
+        case RETURNED:
+            return "returned";
+    }
+
+    return "";
+}
+
+recorder :: recorder()
+    : num_rings(0)
+    , shard(0)
+    , hop_gen(0)
+{ }
+
+void
+recorder :: init(uint64_t num_threads, uint64_t shard_id)
+{
+    assert(num_threads > 0);
+    num_rings = num_threads;
+    rings.reset(new ring[num_rings]);
+    shard = shard_id;
+}
+
+// unique across shards, never 0
+uint64_t
+recorder :: new_hop_id()
+{
+    return (shard << 48) | (++hop_gen & 0x0000ffffffffffffULL);
+}
+
+void
+recorder :: record(uint64_t trace_id, uint64_t hop_id, uint64_t parent_hop, span_kind kind, uint64_t dur_ns, uint64_t count)
+{
+    assert(trace_id != 0);
+    ring &r = rings[thread_index::get() % num_rings];
+    r.mtx.lock();
+    if (r.spans.empty()) {
+        r.spans.resize(PROG_TRACE_RING_SPANS);
+    }
+    span &s = r.spans[r.next++ % PROG_TRACE_RING_SPANS];
+    s.trace_id = trace_id;
+    s.hop_id = hop_id;
+    s.parent_hop = parent_hop;
+    s.shard = shard;
+    s.kind = kind;
+    s.dur_ns = dur_ns;
+    s.count = count;
+    r.mtx.unlock();
+}
+
+void
+recorder :: collect(uint64_t trace_id, std::vector<span> &spans)
+{
+    for (uint64_t i = 0; i < num_rings; i++) {
+        ring &r = rings[i];
+        r.mtx.lock();
+        uint64_t num_spans = std::min(r.next, (uint64_t)r.spans.size());
+        for (uint64_t j = 0; j < num_spans; j++) {
+            if (r.spans[j].trace_id == trace_id) {
+                spans.emplace_back(r.spans[j]);
+            }
+        }
+        r.mtx.unlock();
+    }
+}
+
+static std::string
+us(uint64_t ns)
+{
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << (ns / 1000.0) << " us";
+    return out.str();
+}
+
+struct hop_summary
+{
+    uint64_t shard;
+    uint64_t parent_hop;
+    uint64_t dur_ns[prog_trace::RETURNED+1];
+    uint64_t count[prog_trace::RETURNED+1];
+    bool returned;
+
+    hop_summary()
+        : shard(0)
+        , parent_hop(0)
+        , returned(false)
+    {
+        for (int k = 0; k <= prog_trace::RETURNED; k++) {
+            dur_ns[k] = count[k] = 0;
+        }
+    }
+};
+
+std::string
+prog_trace :: critical_path(uint64_t trace_id, uint64_t total_ns, uint64_t mapping_ns, const std::vector<span> &spans)
+{
+    std::unordered_map<uint64_t, hop_summary> hops;
+    uint64_t returned_hop = 0;
+    for (const span &s: spans) {
+        hop_summary &h = hops[s.hop_id];
+        h.shard = s.shard;
+        h.parent_hop = s.parent_hop;
+        if (s.kind <= RETURNED) {
+            h.dur_ns[s.kind] += s.dur_ns;
+            h.count[s.kind] += s.count;
+        }
+        if (s.kind == RETURNED) {
+            h.returned = true;
+            returned_hop = s.hop_id;
+        }
+    }
+
+    // walk back from the returning hop
+    std::vector<std::pair<uint64_t, const hop_summary*>> path;
+    bool complete = (returned_hop != 0);
+    for (uint64_t hop = returned_hop; hop != 0;) {
+        auto iter = hops.find(hop);
+        if (iter == hops.end()) {
+            complete = false;
+            break;
+        }
+        path.emplace_back(hop, &iter->second);
+        hop = iter->second.parent_hop;
+        if (path.size() > hops.size()) { // cycle, should not happen
+            complete = false;
+            break;
+        }
+    }
+
+    uint64_t on_path_ns = mapping_ns;
+    for (const auto &p: path) {
+        for (int k = 0; k <= RETURNED; k++) {
+            on_path_ns += p.second->dur_ns[k];
+        }
+    }
+
+    std::ostringstream out;
+    out << "trace " << trace_id << ": total " << us(total_ns)
+        << ", vt mapping lookup " << us(mapping_ns)
+        << ", network and vt " << us(total_ns > on_path_ns? total_ns - on_path_ns : 0)
+        << ", " << path.size() << " hops on critical path, " << (hops.size() - path.size()) << " off";
+    if (!complete) {
+        out << " (incomplete, spans overwritten or not yet recorded)";
+    }
+    out << "\n";
+
+    uint64_t step = 1;
+    for (auto iter = path.rbegin(); iter != path.rend(); iter++, step++) {
+        const hop_summary &h = *iter->second;
+        out << "  " << step << ". shard " << h.shard
+            << ": queued " << us(h.dur_ns[QUEUED])
+            << ", acquire " << us(h.dur_ns[ACQUIRE])
+            << ", executed " << us(h.dur_ns[EXECUTED]) << " (" << h.count[EXECUTED] << " nodes)";
+        if (h.count[CACHE_FETCH] > 0) {
+            out << ", cache fetch " << us(h.dur_ns[CACHE_FETCH]);
+        }
+        if (h.count[FORWARDED] > 0) {
+            out << ", forwarded " << h.count[FORWARDED] << " progs to moved nodes";
+        }
+        if (h.returned) {
+            out << ", returned";
+        }
+        out << "\n";
+    }
+
+    return out.str();
+}
@@ -0,0 +1,93 @@
+/*
+ * ===============================================================
+ *    Description:  Sampled tracing of node programs: spans that
+ *                  shards record for the hops of a traced program,
+ *                  and the critical path the timestamper assembles
+ *                  from them.
+ *
+ *        Created:  2026-10-19 16:59:50
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_common_prog_trace_h_
+#define weaver_common_prog_trace_h_
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <po6/threads/mutex.h>
+
+#define PROG_TRACE_RING_SPANS 4096 // per shard thread, oldest spans are overwritten
+#define PROG_TRACE_KEEP 256 // assembled traces a timestamper keeps until a client reads them
+
+namespace prog_trace
+{
+    enum span_kind
+    {
+        QUEUED = 0, // in a shard rd_queue, waiting for the vt clocks
+        ACQUIRE, // node lookups and shared node lock waits
+        EXECUTED, // node program function calls, count = nodes visited
+        CACHE_FETCH, // waiting for NODE_CONTEXT_REPLYs, from the first fetch to the last reply
+        FORWARDED, // count = node programs sent on to the new shard of a moved node
+        RETURNED // this hop sent NODE_PROG_RETURN
+    };
+
+    const char* to_string(uint32_t kind);
+
+    // Every NODE_PROG message a shard handles for a traced program is a hop.
+    // Messages carry the trace id, 0 if the program is not traced, and the
+    // id of the hop that sent them, 0 if sent by the timestamper.  Durations
+    // are measured on the clock of one shard, so they add up across shards
+    // whose clocks differ.
+    struct span
+    {
+        uint64_t trace_id;
+        uint64_t hop_id;
+        uint64_t parent_hop;
+        uint64_t shard;
+        uint32_t kind;
+        uint64_t dur_ns;
+        uint64_t count;
+    };
+
+    // spans of the worker threads of a shard
+    // each thread writes its own ring, spans are only read for a trace fetch
+    class recorder
+    {
+        private:
+            struct ring
+            {
+                po6::threads::mutex mtx;
+                std::vector<span> spans;
+                uint64_t next;
+                char pad[64]; // rings are heap allocated, so pad rather than align
+
+                ring() : next(0) { }
+            };
+
+            std::unique_ptr<ring[]> rings;
+            uint64_t num_rings;
+            uint64_t shard;
+            std::atomic<uint64_t> hop_gen;
+
+
+        public:
+            recorder();
+            void init(uint64_t num_threads, uint64_t shard_id);
+            uint64_t new_hop_id();
+            void record(uint64_t trace_id, uint64_t hop_id, uint64_t parent_hop, span_kind kind, uint64_t dur_ns, uint64_t count=0);
+            // spans of this trace still in the rings
+            void collect(uint64_t trace_id, std::vector<span> &spans);
+    };
+
+    // Chain of hops from the one which returned back to the hop the
+    // timestamper sent, one line per hop.  Time not in any span on the
+    // path was spent in the network and the timestamper.
+    std::string critical_path(uint64_t trace_id, uint64_t total_ns, uint64_t mapping_ns, const std::vector<span> &spans);
+}
+
+#endif
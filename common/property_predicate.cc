@@ -10,56 +10,196 @@
  */
 
 #include <assert.h>
+#include <algorithm>
 
 #define weaver_debug_
 #include "common/weaver_constants.h"
 #include "common/property_predicate.h"
 
 using predicate::prop_predicate;
+using predicate::compiled_predicates;
+using predicate::value_test;
 
-bool
-prop_predicate :: check(const node_prog::property &prop) const
+namespace
+{
+    using predicate::relation;
+
+    template <relation R>
+    bool
+    test_value(const std::string &prop_value, const std::string &pred_value);
+
+    template <>
+    bool
+    test_value<predicate::EQUALS>(const std::string &prop_value, const std::string &pred_value)
+    {
+        return prop_value == pred_value;
+    }
+
+    template <>
+    bool
+    test_value<predicate::LESS>(const std::string &prop_value, const std::string &pred_value)
+    {
+        return prop_value < pred_value;
+    }
+
+    template <>
+    bool
+    test_value<predicate::GREATER>(const std::string &prop_value, const std::string &pred_value)
+    {
+        return prop_value > pred_value;
+    }
+
+    template <>
+    bool
+    test_value<predicate::LESS_EQUAL>(const std::string &prop_value, const std::string &pred_value)
+    {
+        return prop_value <= pred_value;
+    }
+
+    template <>
+    bool
+    test_value<predicate::GREATER_EQUAL>(const std::string &prop_value, const std::string &pred_value)
+    {
+        return prop_value >= pred_value;
+    }
+
+    template <>
+    bool
+    test_value<predicate::STARTS_WITH>(const std::string &prop_value, const std::string &pred_value)
+    {
+        return prop_value.size() >= pred_value.size()
+            && prop_value.compare(0, pred_value.size(), pred_value) == 0;
+    }
+
+    template <>
+    bool
+    test_value<predicate::ENDS_WITH>(const std::string &prop_value, const std::string &pred_value)
+    {
+        return prop_value.size() >= pred_value.size()
+            && prop_value.compare(prop_value.size()-pred_value.size(), pred_value.size(), pred_value) == 0;
+    }
+
+    template <>
+    bool
+    test_value<predicate::CONTAINS>(const std::string &prop_value, const std::string &pred_value)
+    {
+        return prop_value.find(pred_value) != std::string::npos;
+    }
+
+    bool
+    test_bad_rel(const std::string&, const std::string&)
+    {
+        return false;
+    }
+
+    // lower is more selective: an exact value matches fewer properties than
+    // a prefix or suffix, which match fewer than a substring or a range
+    int
+    selectivity_rank(relation rel)
+    {
+        switch (rel) {
+            case predicate::EQUALS:
+                return 0;
+            case predicate::STARTS_WITH:
+            case predicate::ENDS_WITH:
+                return 1;
+            case predicate::CONTAINS:
+                return 2;
+            default:
+                return 3;
+        }
+    }
+}
+
+value_test
+predicate :: test_for(relation rel)
 {
     switch (rel) {
         case EQUALS:
-            return key == prop.get_key() && prop.get_value() == value;
-            break;
+            return test_value<EQUALS>;
 
         case LESS:
-            return key == prop.get_key() && prop.get_value() < value;
-            break;
+            return test_value<LESS>;
 
         case GREATER:
-            return key == prop.get_key() && prop.get_value() > value;
-            break;
+            return test_value<GREATER>;
 
         case LESS_EQUAL:
-            return key == prop.get_key() && prop.get_value() <= value;
-            break;
+            return test_value<LESS_EQUAL>;
 
         case GREATER_EQUAL:
-            return key == prop.get_key() && prop.get_value() >= value;
-            break;
+            return test_value<GREATER_EQUAL>;
 
         case STARTS_WITH:
-            return key == prop.get_key()
-                && prop.get_value().size() >= value.size()
-                && prop.get_value().compare(0, value.size(), value) == 0;
-            break;
+            return test_value<STARTS_WITH>;
 
         case ENDS_WITH:
-            return key == prop.get_key()
-                && prop.get_value().size() >= value.size()
-                && prop.get_value().compare(prop.get_value().size()-value.size(), value.size(), value) == 0;
-            break;
+            return test_value<ENDS_WITH>;
 
         case CONTAINS:
-            return key == prop.get_key()
-                && prop.get_value().find(value) != std::string::npos;
-            break;
+            return test_value<CONTAINS>;
 
         default:
             WDEBUG << "bad rel " << rel << std::endl;
-            return false;
+            return test_bad_rel;
+    }
+}
+
+bool
+prop_predicate :: check(const node_prog::property &prop) const
+{
+    return key == prop.get_key() && test_for(rel)(prop.get_value(), value);
+}
+
+compiled_predicates :: compiled_predicates(const std::vector<prop_predicate> &preds)
+{
+    terms.reserve(preds.size());
+    for (const prop_predicate &p: preds) {
+        add_term(p.key, p.value, p.rel);
     }
+    order_terms();
+}
+
+compiled_predicates :: compiled_predicates(const std::vector<std::pair<std::string, std::string>> &props)
+{
+    terms.reserve(props.size());
+    for (const auto &p: props) {
+        add_term(p.first, p.second, EQUALS);
+    }
+    order_terms();
+}
+
+void
+compiled_predicates :: add_term(const std::string &key, const std::string &value, relation rel)
+{
+    for (const term &t: terms) {
+        if (t.rel == rel && t.key == key && t.value == value) {
+            return; // duplicate predicate
+        }
+    }
+
+    term t;
+    t.key = key;
+    t.value = value;
+    t.rel = rel;
+    t.test = test_for(rel);
+    terms.emplace_back(std::move(t));
+}
+
+// Static order, most selective relation first, and within a relation the
+// longer value first since it is less likely to match.  Evaluation stops at
+// the first term that fails, so this order tests few terms for most
+// elements that are rejected.
+void
+compiled_predicates :: order_terms()
+{
+    std::stable_sort(terms.begin(), terms.end(),
+        [](const term &t1, const term &t2) {
+            int r1 = selectivity_rank(t1.rel);
+            int r2 = selectivity_rank(t2.rel);
+            if (r1 != r2) {
+                return r1 < r2;
+            }
+            return t1.value.size() > t2.value.size();
+        });
 }
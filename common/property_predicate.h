@@ -13,6 +13,7 @@
 #define weaver_common_property_predicate_h_
 
 #include <string>
+#include <vector>
 
 #include "node_prog/property.h"
 
@@ -38,6 +39,43 @@ namespace predicate
 
         bool check(const node_prog::property &prop) const;
     };
+
+    typedef bool (*value_test)(const std::string &prop_value, const std::string &pred_value);
+
+    // test of a property value against a predicate value for this relation
+    value_test test_for(relation rel);
+
+    // Predicates of a node program request, compiled once and evaluated
+    // against every node or edge the request visits.  Each term has its
+    // relation resolved to a value_test, and terms are ordered so that the
+    // ones least likely to hold are tested first.  Values are compared as
+    // strings, as in prop_predicate::check.  Read only after construction,
+    // so one compiled_predicates can be shared by concurrent visits.
+    class compiled_predicates
+    {
+        public:
+            struct term
+            {
+                std::string key;
+                std::string value;
+                relation rel;
+                value_test test;
+            };
+
+        private:
+            std::vector<term> terms; // most selective first
+
+            void add_term(const std::string &key, const std::string &value, relation rel);
+            void order_terms();
+
+        public:
+            explicit compiled_predicates(const std::vector<prop_predicate> &preds);
+            // all EQUALS, as in has_all_properties
+            explicit compiled_predicates(const std::vector<std::pair<std::string, std::string>> &props);
+
+            bool empty() const { return terms.empty(); }
+            const std::vector<term>& get_terms() const { return terms; }
+    };
 }
 
 #endif
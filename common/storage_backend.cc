@@ -0,0 +1,34 @@
+/*
+ * ===============================================================
+ *    Description:  Storage backend selection.
+ *
+ *        Created:  2026-10-19 15:58:10
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include "common/weaver_constants.h"
+#include "common/config_constants.h"
+#include "common/hyper_stub_base.h"
+#include "common/local_storage.h"
+
+std::unique_ptr<storage_backend>
+storage_backend :: create(const std::string &partition)
+{
+    if (StorageBackend == "hyperdex") {
+        return std::unique_ptr<storage_backend>(new hyper_stub_base());
+    } else if (StorageBackend == "local") {
+        // the timestamper validates writes against the node map and node data in its own log,
+        // which several timestampers could not share
+        if (NumVts != 1) {
+            WDEBUG << "local storage backend needs num_vts = 1, have " << NumVts << ", exiting now." << std::endl;
+            exit(-1);
+        }
+        return std::unique_ptr<storage_backend>(new local_storage(StorageDir + "/" + partition));
+    } else {
+        WDEBUG << "unknown storage backend " << StorageBackend << ", exiting now." << std::endl;
+        exit(-1);
+    }
+}
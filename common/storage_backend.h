@@ -0,0 +1,80 @@
+/*
+ * ===============================================================
+ *    Description:  Interface to the durable store for graph data,
+ *                  node map, aux index, and pending transactions.
+ *                  Implemented by hyper_stub_base (HyperDex) and
+ *                  local_storage (per-process local logs).
+ *
+ *        Created:  2026-10-19 15:58:10
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_common_storage_backend_h_
+#define weaver_common_storage_backend_h_
+
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "common/transaction.h"
+#include "common/vclock.h"
+#include "db/types.h"
+#include "db/node.h"
+
+enum storage_commit_status
+{
+    STORAGE_COMMITTED = 0,
+    STORAGE_ABORTED, // conflicting concurrent tx, may retry
+    STORAGE_ERROR
+};
+
+// One object per thread, objects are not thread safe.
+// Methods with a 'tx' argument read within the open transaction if tx is true.
+// put_nodes, del_nodes, del_indices, put_tx_data, and del_tx_data
+// must be called between begin_tx and commit_tx/abort_tx.
+class storage_backend
+{
+    public:
+        virtual ~storage_backend() { }
+
+        virtual void begin_tx() = 0;
+        virtual storage_commit_status commit_tx() = 0;
+        virtual void abort_tx() = 0;
+
+        // graph data
+        virtual bool get_nodes(std::unordered_map<node_handle_t, db::node*> &nodes, bool tx) = 0;
+        virtual bool put_nodes(std::unordered_map<node_handle_t, db::node*> &nodes, bool if_not_exist) = 0;
+        virtual bool put_nodes_bulk(std::unordered_map<node_handle_t, db::node*> &nodes, vc::vclock&, vc::vclock_t&) = 0;
+        virtual bool del_nodes(std::unordered_set<node_handle_t> &to_del) = 0;
+        // every node stored for shard, alloc_node creates the node that is filled from storage,
+        // which is then passed to restored_node
+        virtual bool get_shard_nodes(uint64_t shard,
+            std::function<db::node*(const node_handle_t&)> alloc_node,
+            std::function<void(db::node*)> restored_node) = 0;
+
+        // node map
+        virtual bool update_nmap(const node_handle_t &handle, uint64_t loc) = 0;
+        virtual bool update_nmap_bulk(const std::unordered_map<node_handle_t, uint64_t> &mappings) = 0;
+        virtual std::unordered_map<node_handle_t, uint64_t> get_nmap(std::unordered_set<node_handle_t> &toGet, bool tx) = 0;
+        virtual uint64_t get_nmap(node_handle_t &handle) = 0;
+
+        // auxiliary index
+        virtual bool add_indices(std::unordered_map<std::string, db::node*> &indices, bool tx, bool if_not_exist) = 0;
+        virtual bool get_indices(std::unordered_map<std::string, std::pair<node_handle_t, uint64_t>> &indices, bool tx) = 0;
+        virtual bool del_indices(std::vector<std::string> &indices) = 0;
+
+        // tx data
+        virtual bool put_tx_data(uint64_t vt_id, transaction::pending_tx &tx) = 0;
+        virtual bool del_tx_data(uint64_t tx_id) = 0;
+        virtual bool get_vt_txs(uint64_t vt_id, std::vector<std::shared_ptr<transaction::pending_tx>> &txs) = 0;
+
+        // backend chosen by the storage_backend config option
+        // partition names the directory under storage_dir that this process owns when storage is local,
+        // e.g. "shard3" for the graph data of shard 3, and is ignored by HyperDex
+        static std::unique_ptr<storage_backend> create(const std::string &partition);
+};
+
+#endif
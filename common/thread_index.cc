@@ -0,0 +1,72 @@
+/*
+ * ===============================================================
+ *    Description:  Thread index allocation.
+ *
+ *        Created:  2026-10-19 15:43:35
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <po6/threads/mutex.h>
+
+#include "common/thread_index.h"
+
+namespace
+{
+    struct index_pool
+    {
+        po6::threads::mutex mtx;
+        uint64_t next;
+        std::vector<uint64_t> free_idx; // min heap
+
+        index_pool() : next(0) { }
+    };
+
+    // never destroyed, threads may exit after static destructors have run
+    index_pool&
+    pool()
+    {
+        static index_pool *p = new index_pool();
+        return *p;
+    }
+
+    // returns the index to the pool when the thread exits
+    struct index_holder
+    {
+        uint64_t idx;
+
+        index_holder()
+        {
+            index_pool &p = pool();
+            p.mtx.lock();
+            if (p.free_idx.empty()) {
+                idx = p.next++;
+            } else {
+                std::pop_heap(p.free_idx.begin(), p.free_idx.end(), std::greater<uint64_t>());
+                idx = p.free_idx.back();
+                p.free_idx.pop_back();
+            }
+            p.mtx.unlock();
+        }
+
+        ~index_holder()
+        {
+            index_pool &p = pool();
+            p.mtx.lock();
+            p.free_idx.emplace_back(idx);
+            std::push_heap(p.free_idx.begin(), p.free_idx.end(), std::greater<uint64_t>());
+            p.mtx.unlock();
+        }
+    };
+}
+
+uint64_t
+thread_index :: get()
+{
+    static thread_local index_holder holder;
+    return holder.idx;
+}
@@ -0,0 +1,26 @@
+/*
+ * ===============================================================
+ *    Description:  Small dense index of the calling thread, for
+ *                  per-thread slots in fixed size arrays.
+ *
+ *        Created:  2026-10-19 15:43:35
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_common_thread_index_h_
+#define weaver_common_thread_index_h_
+
+#include <stdint.h>
+
+namespace thread_index
+{
+    // Index of the calling thread among threads alive in this process.
+    // A thread gets the lowest free index on its first call and returns it
+    // when it exits, so indices stay below the peak number of live threads
+    // however many short lived threads come and go.
+    uint64_t get();
+}
+
+#endif
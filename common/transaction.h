@@ -62,7 +62,8 @@ namespace transaction
         EPOCH_CHANGE,
         // to shards
         NOP,
-        UPDATE
+        UPDATE,
+        READ_LEASE // not queued at shards, only advances read watermark
     };
 
     struct pending_tx
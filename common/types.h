@@ -178,9 +178,38 @@ typedef std::string edge_handle_t;
 typedef std::string node_handle_t;
 typedef std::string edge_handle_t;
 typedef std::string cache_key_t;
-inline uint64_t hash_node_handle(const node_handle_t &nh)
+
+// parse handle as a 64 bit integer id
+// only canonical decimal strings qualify, so that id -> handle is one-to-one
+inline bool parse_node_handle_id(const node_handle_t &nh, uint64_t &id)
+{
+    size_t len = nh.size();
+    if (len == 0 || len > 20 || (len > 1 && nh[0] == '0')) {
+        return false;
+    }
+
+    id = 0;
+    for (size_t i = 0; i < len; i++) {
+        uint64_t digit = nh[i] - '0';
+        if (digit > 9
+         || id > UINT64_MAX / 10
+         || id*10 > UINT64_MAX - digit) {
+            return false;
+        }
+        id = id*10 + digit;
+    }
+    return true;
+}
+
+// murmur3 finalizer, all bits of id affect all bits of hash
+inline uint64_t hash_node_id(uint64_t id)
 {
-    return weaver_util::murmur_hasher<std::string>()(nh);
+    id ^= id >> 33;
+    id *= 0xff51afd7ed558ccdULL;
+    id ^= id >> 33;
+    id *= 0xc4ceb9fe1a85ec53ULL;
+    id ^= id >> 33;
+    return id;
 }
 
 #endif
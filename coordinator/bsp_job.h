@@ -0,0 +1,59 @@
+/*
+ * ===============================================================
+ *    Description:  Timestamper state for a bulk synchronous
+ *                  analytics job, the global superstep barrier.
+ *
+ *        Created:  2026-10-19 16:19:12
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_coordinator_bsp_job_h_
+#define weaver_coordinator_bsp_job_h_
+
+#include <map>
+#include <vector>
+#include <unordered_map>
+
+#include "common/bsp.h"
+#include "common/vclock.h"
+#include "coordinator/current_prog.h"
+
+namespace coordinator
+{
+    struct bsp_job
+    {
+        current_prog *cp;
+        bsp::params params;
+        vc::vclock vclk;
+        uint64_t step; // superstep the shards are running
+        bool final_step;
+        uint64_t shards_left; // not yet reported this superstep
+
+        // summed over shard reports of this superstep
+        std::vector<uint64_t> expected; // BSP_MSGS per shard index for next superstep
+        uint64_t active;
+        double dangling;
+
+        uint64_t num_nodes; // from superstep 0
+        std::unordered_map<node_handle_t, uint64_t> component_sizes;
+        std::map<uint64_t, uint64_t> histogram, in_histogram;
+        bsp::result res;
+
+        bsp_job(current_prog *c, const bsp::params &p, const vc::vclock &vc, uint64_t num_shards)
+            : cp(c)
+            , params(p)
+            , vclk(vc)
+            , step(0)
+            , final_step(false)
+            , shards_left(num_shards)
+            , expected(num_shards, 0)
+            , active(0)
+            , dangling(0)
+            , num_nodes(0)
+        { }
+    };
+}
+
+#endif
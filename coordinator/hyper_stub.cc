@@ -1,6 +1,6 @@
 /*
  * ===============================================================
- *    Description:  Implementation of hyperdex timestamper stub.
+ *    Description:  Implementation of timestamper storage stub.
  *
  *        Created:  2014-02-27 15:18:59
  *
@@ -29,6 +29,7 @@ void
 hyper_stub :: init(uint64_t vtid)
 {
     vt_id = vtid;
+    store = storage_backend::create("vt" + std::to_string(vt_id));
 }
 
 std::unordered_map<node_handle_t, uint64_t>
@@ -38,14 +39,14 @@ hyper_stub :: get_mappings(std::unordered_set<node_handle_t> &get_set)
 
     if (get_set.size() == 1) {
         node_handle_t h = *get_set.begin();
-        uint64_t loc = get_nmap(h);
+        uint64_t loc = store->get_nmap(h);
         if (loc != UINT64_MAX) {
             ret.emplace(h, loc);
         } else {
             ret.clear();
         }
     } else if (!get_set.empty()) {
-        ret = get_nmap(get_set, false);
+        ret = store->get_nmap(get_set, false);
     }
 
     return ret;
@@ -54,7 +55,7 @@ hyper_stub :: get_mappings(std::unordered_set<node_handle_t> &get_set)
 bool
 hyper_stub :: get_idx(std::unordered_map<std::string, std::pair<std::string, uint64_t>> &idx_map)
 {
-    return get_indices(idx_map, false);
+    return store->get_indices(idx_map, false);
 }
 
 void
@@ -72,92 +73,121 @@ hyper_stub :: clean_up(std::unordered_map<node_handle_t, db::node*> &nodes)
     nodes.clear();
 }
 
+// a tx that fails alone is aborted, txs that failed together are retried one at a time
 void
-hyper_stub :: do_tx(std::unordered_set<node_handle_t> &get_set,
-    std::unordered_set<node_handle_t> &del_set,
-    std::unordered_map<node_handle_t, uint64_t> &put_map,
-    std::unordered_set<std::string> &idx_get_set,
-    std::unordered_map<std::string, db::node*> &idx_add,
-    std::shared_ptr<transaction::pending_tx> tx,
-    bool &ready,
-    bool &error,
-    order::oracle *time_oracle)
+hyper_stub :: group_failed(std::vector<group_tx*> &txs)
 {
-#define ERROR_FAIL \
-    error = true; \
-    abort_tx(); \
-    clean_up(old_nodes); \
-    clean_up(new_nodes); \
-    return;
-
-    ready = false;
-    error = false;
-
-    std::unordered_map<node_handle_t, db::node*> old_nodes, new_nodes;
-    begin_tx();
-
-    // get aux indices from HyperDex
-    std::unordered_map<std::string, std::pair<node_handle_t, uint64_t>> indices;
-    if (AuxIndex) {
-        indices.reserve(idx_get_set.size());
-        std::pair<node_handle_t, uint64_t> empty_pair;
-        for (const std::string &i: idx_get_set) {
-            if (idx_add.find(i) == idx_add.end()) {
-                indices.emplace(i, empty_pair);
-            }
-        }
-        if (!indices.empty()) {
-            if (!get_indices(indices, true)) {
-                WDEBUG << "get_indices" << std::endl;
-                ERROR_FAIL;
-            }
-        }
-
-        for (const auto &p: indices) {
-            if (put_map.find(p.second.first) == put_map.end()
-             && get_set.find(p.second.first) == get_set.end()) {
-                get_set.emplace(p.second.first);
-            }
+    if (txs.size() == 1) {
+        txs[0]->error = true;
+    } else {
+        for (group_tx *gtx: txs) {
+            gtx->solo = true;
         }
     }
+}
 
-    // get all nodes from Hyperdex (we need at least last upd clk)
+// txs in a group cannot touch the same node or index entry
+// returns false if gtx conflicts with an earlier tx, else claims its keys
+bool
+hyper_stub :: claim(group_tx &gtx, const std::unordered_set<node_handle_t> &get_set, std::unordered_set<std::string> &claimed)
+{
     for (const node_handle_t &h: get_set) {
-        if (put_map.find(h) != put_map.end()) {
-            WDEBUG << "logical error, get node already in put map " << h << std::endl;
-            ERROR_FAIL;
+        if (claimed.find(h) != claimed.end()) {
+            return false;
         }
-        old_nodes[h] = new db::node(h, UINT64_MAX, dummy_clk, &dummy_mtx);
     }
-    for (const node_handle_t &h: del_set) {
-        if (old_nodes.find(h) == old_nodes.end()) {
-            old_nodes[h] = new db::node(h, UINT64_MAX, dummy_clk, &dummy_mtx);
+    for (const node_handle_t &h: gtx.del_set) {
+        if (claimed.find(h) != claimed.end()) {
+            return false;
         }
     }
-    if (!get_nodes(old_nodes, true)) {
-        WDEBUG << "get nodes" << std::endl;
-        ERROR_FAIL;
+    for (const auto &p: gtx.put_map) {
+        if (claimed.find(p.first) != claimed.end()) {
+            return false;
+        }
+    }
+    for (const std::string &alias: gtx.idx_get_set) {
+        if (claimed.find(alias) != claimed.end()) {
+            return false;
+        }
+    }
+    for (const auto &p: gtx.idx_add) {
+        if (claimed.find(p.first) != claimed.end()) {
+            return false;
+        }
     }
 
-    // last upd clk check
-    std::vector<vc::vclock> before;
-    before.reserve(old_nodes.size());
-    for (const auto &p: old_nodes) {
-        before.emplace_back(*p.second->last_upd_clk);
+    claimed.insert(get_set.begin(), get_set.end());
+    claimed.insert(gtx.del_set.begin(), gtx.del_set.end());
+    claimed.insert(gtx.idx_get_set.begin(), gtx.idx_get_set.end());
+    for (const auto &p: gtx.put_map) {
+        claimed.emplace(p.first);
     }
-    if (!time_oracle->assign_vt_order(before, tx->timestamp)) {
-        // will retry with higher timestamp
-        abort_tx();
-        return;
+    for (const auto &p: gtx.idx_add) {
+        claimed.emplace(p.first);
     }
 
+    return true;
+}
+
+// place new nodes that were left unplaced when the tx was prepared, given the shards
+// of their nbrs among nodes read in this storage tx and nodes placed before them
+// a tx that is retried keeps the shards picked in its first attempt
+void
+hyper_stub :: place_new_nodes(group_tx &gtx, tx_state &state,
+    std::function<uint64_t(const std::vector<uint64_t>&)> &place_node)
+{
+    std::vector<uint64_t> nbr_locs;
+    for (const auto &p: gtx.new_nbrs) {
+        uint64_t &loc = gtx.put_map[p.first];
+        if (loc != UINT64_MAX) {
+            continue;
+        }
+
+        nbr_locs.clear();
+        for (const node_handle_t &nbr: p.second) {
+            auto put_iter = gtx.put_map.find(nbr);
+            if (put_iter != gtx.put_map.end()) {
+                if (put_iter->second != UINT64_MAX) {
+                    nbr_locs.emplace_back(put_iter->second);
+                }
+            } else {
+                auto node_iter = state.old_nodes.find(nbr);
+                if (node_iter != state.old_nodes.end()) {
+                    nbr_locs.emplace_back(node_iter->second->shard);
+                }
+            }
+        }
+        loc = place_node(nbr_locs);
+    }
+}
+
+// apply writes of tx to nodes read from storage
+// sets upd->loc for each upd in tx
+// sets tx->shard_write bool_vector (shard_write[i] = true iff there is a tx component at shard i)
+bool
+hyper_stub :: apply_tx(group_tx &gtx, tx_state &state)
+{
+    std::shared_ptr<transaction::pending_tx> tx = gtx.tx;
+    std::unordered_map<node_handle_t, db::node*> &old_nodes = state.old_nodes;
+    std::unordered_map<node_handle_t, db::node*> &new_nodes = state.new_nodes;
+    std::unordered_map<std::string, std::pair<node_handle_t, uint64_t>> &indices = state.indices;
+    std::unordered_map<std::string, db::node*> &idx_add = state.idx_add;
+    std::vector<std::string> &idx_del = state.idx_del;
+
+    // idx_add is filled in below, keep gtx.idx_add as prepared in case tx is retried
+    idx_add = gtx.idx_add;
+
     vc::vclock_ptr_t tx_clk_ptr(new vc::vclock(tx->timestamp));
-    for (const auto &p: put_map) {
+    for (const auto &p: gtx.put_map) {
         new_nodes[p.first] = new db::node(p.first, p.second, tx_clk_ptr, &dummy_mtx);
         new_nodes[p.first]->last_upd_clk.reset(new vc::vclock(*tx_clk_ptr));
         new_nodes[p.first]->restore_clk.reset(new vc::vclock_t(tx_clk_ptr->clock));
     }
 
+#define ERROR_FAIL \
+    return false;
+
 #define CHECK_LOC(loc, handle, alias) \
     if (loc == UINT64_MAX) { \
         if (handle != "") { \
@@ -205,7 +235,6 @@ hyper_stub :: do_tx(std::unordered_set<node_handle_t> &get_set,
     auto idx_get_iter = indices.end();
     auto idx_add_iter = idx_add.end();
     db::node *n = nullptr;
-    std::vector<std::string> idx_del;
 
     for (std::shared_ptr<transaction::pending_update> upd: tx->writes) {
         switch (upd->type) {
@@ -215,6 +244,7 @@ hyper_stub :: do_tx(std::unordered_set<node_handle_t> &get_set,
                     ERROR_FAIL;
                 }
                 GET_NODE(upd->handle);
+                upd->loc1 = n->shard;
                 idx_add.emplace(upd->handle, n);
                 break;
 
@@ -326,8 +356,9 @@ hyper_stub :: do_tx(std::unordered_set<node_handle_t> &get_set,
 
 #undef CHECK_LOC
 #undef GET_NODE
+#undef CHECK_AUX_INDEX
 
-    for (const node_handle_t &h: del_set) {
+    for (const node_handle_t &h: gtx.del_set) {
         node_iter = old_nodes.find(h);
         if (node_iter == old_nodes.end()) {
             node_iter = new_nodes.find(h);
@@ -351,159 +382,250 @@ hyper_stub :: do_tx(std::unordered_set<node_handle_t> &get_set,
         delete n;
     }
 
-    if (!put_nodes(old_nodes, false)
-     || !put_nodes(new_nodes, true)
-     || !add_indices(idx_add, true, true)
-     || !del_nodes(del_set)
-     || !del_indices(idx_del)) {
-        WDEBUG << "hyperdex error with put_nodes/add_indices/del_nodes/del_indices" << std::endl;
-        ERROR_FAIL;
+#undef ERROR_FAIL
+
+    return true;
+}
+
+// validate and write all txs in group in a single storage transaction
+// each tx is either ready (committed), error (aborted), or neither (retry with new timestamp)
+void
+hyper_stub :: do_group_tx(std::vector<group_tx*> &group, order::oracle *time_oracle,
+    std::function<uint64_t(const std::vector<uint64_t>&)> place_node)
+{
+    std::vector<tx_state> state(group.size());
+
+#define GROUP_FAIL(txs) \
+    store->abort_tx(); \
+    group_failed(txs); \
+    for (tx_state &s: state) { \
+        clean_up(s.old_nodes); \
+        clean_up(s.new_nodes); \
+    } \
+    return;
+
+    for (group_tx *gtx: group) {
+        gtx->ready = false;
+        gtx->error = false;
+    }
+
+    store->begin_tx();
+
+    // get aux indices of all txs from HyperDex
+    std::unordered_map<std::string, std::pair<node_handle_t, uint64_t>> indices;
+    if (AuxIndex) {
+        std::pair<node_handle_t, uint64_t> empty_pair;
+        for (group_tx *gtx: group) {
+            for (const std::string &i: gtx->idx_get_set) {
+                if (gtx->idx_add.find(i) == gtx->idx_add.end()) {
+                    indices.emplace(i, empty_pair);
+                }
+            }
+        }
+        if (!indices.empty()) {
+            if (!store->get_indices(indices, true)) {
+                WDEBUG << "get_indices" << std::endl;
+                GROUP_FAIL(group);
+            }
+        }
+    }
+
+    // pick txs that do not conflict with earlier txs in the group, others are retried
+    std::unordered_set<std::string> claimed;
+    std::unordered_map<node_handle_t, db::node*> all_nodes;
+    std::vector<group_tx*> active;
+    for (uint64_t i = 0; i < group.size(); i++) {
+        group_tx &gtx = *group[i];
+        tx_state &s = state[i];
+
+        // aliases may point elsewhere when the tx is retried, so gtx.get_set is left as prepared
+        s.get_set = gtx.get_set;
+        for (const std::string &alias: gtx.idx_get_set) {
+            auto idx_iter = indices.find(alias);
+            if (idx_iter != indices.end()) {
+                s.indices.emplace(*idx_iter);
+                if (gtx.put_map.find(idx_iter->second.first) == gtx.put_map.end()) {
+                    s.get_set.emplace(idx_iter->second.first);
+                }
+            }
+        }
+
+        for (const node_handle_t &h: s.get_set) {
+            if (gtx.put_map.find(h) != gtx.put_map.end()) {
+                WDEBUG << "logical error, get node already in put map " << h << std::endl;
+                gtx.error = true;
+                break;
+            }
+        }
+        if (gtx.error || !claim(gtx, s.get_set, claimed)) {
+            continue;
+        }
+
+        // get all nodes from Hyperdex (we need at least last upd clk)
+        for (const node_handle_t &h: s.get_set) {
+            s.old_nodes[h] = new db::node(h, UINT64_MAX, dummy_clk, &dummy_mtx);
+        }
+        for (const node_handle_t &h: gtx.del_set) {
+            if (s.old_nodes.find(h) == s.old_nodes.end()) {
+                s.old_nodes[h] = new db::node(h, UINT64_MAX, dummy_clk, &dummy_mtx);
+            }
+        }
+        all_nodes.insert(s.old_nodes.begin(), s.old_nodes.end());
+
+        s.active = true;
+        active.emplace_back(&gtx);
+    }
+
+    if (!all_nodes.empty() && !store->get_nodes(all_nodes, true)) {
+        WDEBUG << "get nodes" << std::endl;
+        GROUP_FAIL(active);
     }
 
-    hyperdex_client_attribute attr[NUM_TX_ATTRS];
-    attr[0].attr = tx_attrs[0];
-    attr[0].value = (const char*)&vt_id;
-    attr[0].value_sz = sizeof(int64_t);
-    attr[0].datatype = tx_dtypes[0];
-
-    uint64_t buf_sz = message::size(*tx);
-    std::unique_ptr<e::buffer> buf(e::buffer::create(buf_sz));
-    e::buffer::packer packer = buf->pack_at(0);
-    message::pack_buffer(packer, *tx);
-
-    attr[1].attr = tx_attrs[1];
-    attr[1].value = (const char*)buf->data();
-    attr[1].value_sz = buf->size();
-    attr[1].datatype = tx_dtypes[1];
-
-    if (!call(&hyperdex_client_xact_put, tx_space, (const char*)&tx->id, sizeof(int64_t), attr, NUM_TX_ATTRS)) {
-        WDEBUG << "hyperdex tx put error, tx id " << tx->id << std::endl;
-        ERROR_FAIL;
+    std::unordered_map<node_handle_t, db::node*> put_old, put_new;
+    std::unordered_map<std::string, db::node*> idx_add;
+    std::unordered_set<node_handle_t> del_set;
+    std::vector<std::string> idx_del;
+    std::vector<group_tx*> committing;
+
+    for (uint64_t i = 0; i < group.size(); i++) {
+        group_tx &gtx = *group[i];
+        tx_state &s = state[i];
+        if (!s.active) {
+            continue;
+        }
+
+        // last upd clk check
+        std::vector<vc::vclock> before;
+        before.reserve(s.old_nodes.size());
+        for (const auto &p: s.old_nodes) {
+            before.emplace_back(*p.second->last_upd_clk);
+        }
+        if (!time_oracle->assign_vt_order(before, gtx.tx->timestamp)) {
+            // will retry with higher timestamp
+            continue;
+        }
+
+        place_new_nodes(gtx, s, place_node);
+        if (!apply_tx(gtx, s)) {
+            gtx.error = true;
+            continue;
+        }
+
+        put_old.insert(s.old_nodes.begin(), s.old_nodes.end());
+        put_new.insert(s.new_nodes.begin(), s.new_nodes.end());
+        idx_add.insert(s.idx_add.begin(), s.idx_add.end());
+        del_set.insert(gtx.del_set.begin(), gtx.del_set.end());
+        idx_del.insert(idx_del.end(), s.idx_del.begin(), s.idx_del.end());
+        committing.emplace_back(&gtx);
     }
 
-    hyperdex_client_returncode commit_status = HYPERDEX_CLIENT_GARBAGE;
-    commit_tx(commit_status);
+    if (committing.empty()) {
+        store->abort_tx();
+        for (tx_state &s: state) {
+            clean_up(s.old_nodes);
+            clean_up(s.new_nodes);
+        }
+        return;
+    }
 
-    switch(commit_status) {
-        case HYPERDEX_CLIENT_SUCCESS:
-            ready = true;
-            assert(!error);
+    if (!store->put_nodes(put_old, false)
+     || !store->put_nodes(put_new, true)
+     || !store->add_indices(idx_add, true, true)
+     || !store->del_nodes(del_set)
+     || !store->del_indices(idx_del)) {
+        WDEBUG << "storage error with put_nodes/add_indices/del_nodes/del_indices" << std::endl;
+        GROUP_FAIL(committing);
+    }
+
+    for (group_tx *gtx: committing) {
+        if (!store->put_tx_data(vt_id, *gtx->tx)) {
+            WDEBUG << "storage tx put error, tx id " << gtx->tx->id << std::endl;
+            GROUP_FAIL(committing);
+        }
+    }
+
+    switch (store->commit_tx()) {
+        case STORAGE_COMMITTED:
+            for (group_tx *gtx: committing) {
+                gtx->ready = true;
+            }
             break;
 
-        case HYPERDEX_CLIENT_ABORTED:
-            ready = false;
-            assert(!error);
+        case STORAGE_ABORTED:
+            // conflicting tx, all retry
             break;
 
         default:
-            error = true;
-            ready = false;
+            group_failed(committing);
     }
 
-    clean_up(old_nodes);
-    clean_up(new_nodes);
+    for (tx_state &s: state) {
+        clean_up(s.old_nodes);
+        clean_up(s.new_nodes);
+    }
 
-#undef ERROR_FAIL
+#undef GROUP_FAIL
 }
 
 
 void
 hyper_stub :: clean_tx(uint64_t tx_id)
 {
-    begin_tx();
-    if (del(tx_space, (const char*)&tx_id, sizeof(int64_t))) {
-        hyperdex_client_returncode commit_status = HYPERDEX_CLIENT_GARBAGE;
-        commit_tx(commit_status);
-
-        switch (commit_status) {
-            case HYPERDEX_CLIENT_SUCCESS:
-                break;
-            
-            default:
-                WDEBUG << "problem in committing tx for clean_tx, returned status = "
-                       << hyperdex_client_returncode_to_string(commit_status) << std::endl;
+    store->begin_tx();
+    if (store->del_tx_data(tx_id)) {
+        if (store->commit_tx() != STORAGE_COMMITTED) {
+            WDEBUG << "problem in committing tx for clean_tx, tx id " << tx_id << std::endl;
         }
     } else {
-        abort_tx();
+        store->abort_tx();
     }
 }
 
-// status = false if not prepared
-void
-hyper_stub :: recreate_tx(const hyperdex_client_attribute *cl_attr,
-    transaction::pending_tx &tx)
+// nodes bulk loaded by a shard which keeps them in its own local storage
+// this store needs them to validate later writes, and indexes them as the shard would in HyperDex
+// nodes are deleted after they are written
+bool
+hyper_stub :: bulk_load(std::unordered_map<node_handle_t, db::node*> &nodes, std::vector<std::pair<std::string, node_handle_t>> &aliases)
 {
-    int tx_data_idx;
-    if (strncmp(cl_attr[0].attr, tx_attrs[1], 7) == 0) {
-        tx_data_idx = 0;
-    } else if (strncmp(cl_attr[2].attr, tx_attrs[1], 7) == 0) {
-        tx_data_idx = 2;
-    } else {
-        assert(strncmp(cl_attr[1].attr, tx_attrs[1], 7) == 0);
-        tx_data_idx = 1;
+    vc::vclock zero_clk(0,0);
+    bool success = store->put_nodes_bulk(nodes, zero_clk, zero_clk.clock);
+
+    if (success && AuxIndex) {
+        std::unordered_map<std::string, db::node*> idx_add_if_not_exist = nodes;
+        std::unordered_map<std::string, db::node*> idx_add;
+        for (auto &p: nodes) {
+            for (const node_handle_t &alias: p.second->aliases) {
+                idx_add_if_not_exist.emplace(alias, p.second);
+            }
+            for (auto &x: p.second->out_edges) {
+                idx_add_if_not_exist.emplace(x.first, p.second);
+            }
+        }
+        for (const auto &p: aliases) {
+            auto node_iter = nodes.find(p.second);
+            if (node_iter != nodes.end()) {
+                idx_add.emplace(p.first, node_iter->second);
+            }
+        }
+        success = store->add_indices(idx_add_if_not_exist, false, true)
+               && store->add_indices(idx_add, false, false);
     }
-    assert(cl_attr[tx_data_idx].datatype == tx_dtypes[1]);
 
-    std::unique_ptr<e::buffer> buf(e::buffer::create(cl_attr[tx_data_idx].value,
-                                                     cl_attr[tx_data_idx].value_sz));
-    e::unpacker unpacker = buf->unpack_from(0);
-    message::unpack_buffer(unpacker, tx);
+    clean_up(nodes);
+    return success;
+}
+
+bool
+hyper_stub :: update_mappings(const std::unordered_map<node_handle_t, uint64_t> &mappings)
+{
+    return store->update_nmap_bulk(mappings);
 }
 
 void
 hyper_stub :: restore_backup(std::vector<std::shared_ptr<transaction::pending_tx>> &txs)
 {
-    const hyperdex_client_attribute *cl_attr;
-    size_t num_attrs;
-
-    // tx list
-    const hyperdex_client_attribute_check attr_check = {tx_attrs[0], (const char*)&vt_id, sizeof(int64_t), tx_dtypes[0], HYPERPREDICATE_EQUALS};
-    enum hyperdex_client_returncode search_status, loop_status;
-
-    int64_t call_id = hyperdex_client_search(cl, tx_space, &attr_check, 1, &search_status, &cl_attr, &num_attrs);
-    if (call_id < 0) {
-        WDEBUG << "Hyperdex function failed, op id = " << call_id
-               << ", status = " << hyperdex_client_returncode_to_string(search_status) << std::endl;
-        WDEBUG << "error message: " << hyperdex_client_error_message(cl) << std::endl;
-        WDEBUG << "error loc: " << hyperdex_client_error_location(cl) << std::endl;
-        return;
-    }
-
-    int64_t loop_id;
-    bool loop_done = false;
-    std::shared_ptr<transaction::pending_tx> tx;
-    while (!loop_done) {
-        // loop until search done
-        loop_id = hyperdex_client_loop(cl, -1, &loop_status);
-        if (loop_id != call_id
-         || loop_status != HYPERDEX_CLIENT_SUCCESS
-         || (search_status != HYPERDEX_CLIENT_SUCCESS && search_status != HYPERDEX_CLIENT_SEARCHDONE)) {
-            WDEBUG << "Hyperdex function failed, call id = " << call_id
-                   << ", loop_id = " << loop_id
-                   << ", loop status = " << hyperdex_client_returncode_to_string(loop_status)
-                   << ", search status = " << hyperdex_client_returncode_to_string(search_status) << std::endl;
-            WDEBUG << "error message: " << hyperdex_client_error_message(cl) << std::endl;
-            WDEBUG << "error loc: " << hyperdex_client_error_location(cl) << std::endl;
-            return;
-        }
-
-        switch (search_status) {
-            case HYPERDEX_CLIENT_SEARCHDONE:
-            loop_done = true;
-            break;
-
-            case HYPERDEX_CLIENT_SUCCESS:
-            assert(num_attrs == (NUM_TX_ATTRS+1));
-
-            tx = std::make_shared<transaction::pending_tx>(transaction::UPDATE);
-            recreate_tx(cl_attr, *tx);
-            txs.emplace_back(tx);
-            hyperdex_client_destroy_attrs(cl_attr, num_attrs);
-            break;
-
-            default:
-            WDEBUG << "unexpected hyperdex client status on search: " << search_status << std::endl;
-        }
+    if (!store->get_vt_txs(vt_id, txs)) {
+        WDEBUG << "restore backup failed for vt " << vt_id << std::endl;
     }
 
     WDEBUG << "Got " << txs.size() << " transactions for vt " << vt_id << std::endl;
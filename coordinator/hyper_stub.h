@@ -1,6 +1,6 @@
 /*
  * ===============================================================
- *    Description:  Hyperdex client stub for timestamper state.
+ *    Description:  Storage stub for timestamper state.
  *
  *        Created:  2014-02-26 13:37:34
  *
@@ -14,15 +14,47 @@
 #ifndef weaver_coordinator_hyper_stub_h_
 #define weaver_coordinator_hyper_stub_h_
 
+#include <functional>
+
 #include "common/event_order.h"
-#include "common/hyper_stub_base.h"
+#include "common/storage_backend.h"
 
 namespace coordinator
 {
-    class hyper_stub : private hyper_stub_base
+    // write tx waiting to be committed to storage along with other txs
+    struct group_tx
+    {
+        std::shared_ptr<transaction::pending_tx> tx;
+        std::unordered_set<node_handle_t> get_set, del_set;
+        std::unordered_map<node_handle_t, uint64_t> put_map;
+        std::unordered_set<std::string> idx_get_set;
+        std::unordered_map<std::string, db::node*> idx_add;
+        // new nodes in put_map with their nbrs in this tx, placed at commit
+        std::vector<std::pair<node_handle_t, std::vector<node_handle_t>>> new_nbrs;
+        bool ready, error;
+        bool solo; // commit in a group of its own, set when a group write failed
+
+        group_tx() : ready(false), error(false), solo(false) { }
+    };
+
+    class hyper_stub
     {
         private:
+            // storage side state of one tx in a group
+            struct tx_state
+            {
+                bool active;
+                std::unordered_set<node_handle_t> get_set; // gtx get_set and nodes of its aliases, for this attempt
+                std::unordered_map<node_handle_t, db::node*> old_nodes, new_nodes;
+                std::unordered_map<std::string, std::pair<node_handle_t, uint64_t>> indices;
+                std::unordered_map<std::string, db::node*> idx_add;
+                std::vector<std::string> idx_del;
+
+                tx_state() : active(false) { }
+            };
+
             uint64_t vt_id;
+            std::unique_ptr<storage_backend> store;
             po6::threads::mutex dummy_mtx;
             vclock_ptr_t dummy_clk;
 
@@ -31,21 +63,21 @@ namespace coordinator
             void init(uint64_t vt_id);
             std::unordered_map<node_handle_t, uint64_t> get_mappings(std::unordered_set<node_handle_t> &get_set);
             bool get_idx(std::unordered_map<std::string, std::pair<std::string, uint64_t>>&);
-            void do_tx(std::unordered_set<node_handle_t> &get_set,
-                std::unordered_set<node_handle_t> &del_set,
-                std::unordered_map<node_handle_t, uint64_t> &put_map,
-                std::unordered_set<std::string> &idx_get_set,
-                std::unordered_map<std::string, db::node*> &idx_add,
-                std::shared_ptr<transaction::pending_tx> tx,
-                bool &ready,
-                bool &error,
-                order::oracle *time_oracle);
+            void do_group_tx(std::vector<group_tx*> &group, order::oracle *time_oracle,
+                std::function<uint64_t(const std::vector<uint64_t>&)> place_node);
             void clean_tx(uint64_t tx_id);
+            // shard writes, with local storage
+            bool bulk_load(std::unordered_map<node_handle_t, db::node*> &nodes, std::vector<std::pair<std::string, node_handle_t>> &aliases);
+            bool update_mappings(const std::unordered_map<node_handle_t, uint64_t> &mappings);
             void restore_backup(std::vector<std::shared_ptr<transaction::pending_tx>> &txs);
 
         private:
             void clean_up(std::unordered_map<node_handle_t, db::node*> &nodes);
-            void recreate_tx(const hyperdex_client_attribute *attr, transaction::pending_tx &tx);
+            bool claim(group_tx &gtx, const std::unordered_set<node_handle_t> &get_set, std::unordered_set<std::string> &claimed);
+            void place_new_nodes(group_tx &gtx, tx_state &state,
+                std::function<uint64_t(const std::vector<uint64_t>&)> &place_node);
+            bool apply_tx(group_tx &gtx, tx_state &state);
+            void group_failed(std::vector<group_tx*> &txs);
     };
 }
 
@@ -13,12 +13,14 @@
  */
 
 #include <iostream>
+#include <algorithm>
 #include <thread>
 #include <vector>
 #include <deque>
 #include <stdlib.h>
 #include <signal.h>
 #include <sys/time.h>
+#include <sstream>
 #include <e/popt.h>
 
 #define weaver_debug_
@@ -27,6 +29,7 @@
 #include "common/event_order.h"
 #include "common/config_constants.h"
 #include "common/bool_vector.h"
+#include "common/metrics.h"
 #include "node_prog/node_prog_type.h"
 #include "node_prog/node_program.h"
 #include "coordinator/timestamper.h"
@@ -38,15 +41,135 @@ using coordinator::blocked_prog;
 using transaction::done_req_t;
 static coordinator::timestamper *vts;
 static uint64_t vt_id;
+static const char *metrics_file = nullptr;
 
 // tx functions
+void finish_group_tx(coordinator::group_tx *gtx);
+void group_commit_tx(coordinator::group_tx *gtx, coordinator::hyper_stub *hstub, order::oracle *time_oracle);
 void prepare_tx(std::shared_ptr<transaction::pending_tx> tx, coordinator::hyper_stub *hstub, order::oracle *time_oracle);
 void end_tx(uint64_t tx_id, coordinator::hyper_stub *hstub, uint64_t shard_id);
 
+// reply to client once gtx is ready or error
+void
+finish_group_tx(coordinator::group_tx *gtx)
+{
+    message::message msg;
+    if (gtx->error) {
+        msg.prepare_message(message::CLIENT_TX_ABORT);
+    } else {
+        msg.prepare_message(message::CLIENT_TX_SUCCESS);
+    }
+    vts->comm.send_to_client(gtx->tx->sender, msg.buf);
+    delete gtx;
+    vts->tx_queue_loop();
+}
+
+// queue tx for writing to storage together with other txs
+// the thread that finds no group in progress commits queued txs until the queue is empty,
+// other threads return right after queueing and the leader replies to their clients
+// the leader waits TX_GROUP_WINDOW_NANO for more txs only if some are still being prepared
+void
+group_commit_tx(coordinator::group_tx *gtx, coordinator::hyper_stub *hstub, order::oracle *time_oracle)
+{
+    timespec sleep_time;
+    sleep_time.tv_sec  = TX_GROUP_WINDOW_NANO / NANO;
+    sleep_time.tv_nsec = TX_GROUP_WINDOW_NANO % NANO;
+
+    vts->group_mtx.lock();
+    vts->group_queue.emplace_back(gtx);
+    vts->preparing_txs--;
+
+    if (vts->group_leader) {
+        vts->group_mtx.unlock();
+        return;
+    }
+    vts->group_leader = true;
+
+    while (!vts->group_queue.empty()) {
+        bool wait = TX_GROUP_WINDOW_NANO > 0
+                 && vts->preparing_txs > 0
+                 && vts->group_queue.size() < TX_GROUP_MAX_TXS;
+        vts->group_mtx.unlock();
+
+        if (wait) {
+            int sleep_ret = clock_nanosleep(CLOCK_REALTIME, 0, &sleep_time, nullptr);
+            assert((sleep_ret == 0 || sleep_ret == EINTR) && "error in clock_nanosleep");
+            UNUSED(sleep_ret);
+        }
+
+        // a tx which failed as part of a group is committed alone
+        std::vector<coordinator::group_tx*> group;
+        vts->group_mtx.lock();
+        if (vts->group_queue.front()->solo) {
+            group.emplace_back(vts->group_queue.front());
+            vts->group_queue.pop_front();
+        } else {
+            while (!vts->group_queue.empty()
+                && !vts->group_queue.front()->solo
+                && group.size() < TX_GROUP_MAX_TXS) {
+                group.emplace_back(vts->group_queue.front());
+                vts->group_queue.pop_front();
+            }
+        }
+        vts->group_mtx.unlock();
+
+        // consecutive timestamps for txs in group
+        vts->clk_rw_mtx.wrlock();
+        for (coordinator::group_tx *g: group) {
+            vts->vclk.increment_clock();
+            vts->out_queue_counter++;
+            g->tx->timestamp = vts->vclk;
+            g->tx->vt_seq = vts->out_queue_counter;
+        }
+        vts->clk_rw_mtx.unlock();
+
+        // write txs in warp
+        // gets/puts/dels node mappings
+        // sets error for txs whose warp operations returned error
+        hstub->do_group_tx(group, time_oracle, [](const std::vector<uint64_t> &nbr_locs) {
+            return vts->place_node(nbr_locs);
+        });
+
+        for (coordinator::group_tx *g: group) {
+            assert(!(g->ready && g->error)); // can't be ready after some error
+
+            std::shared_ptr<transaction::pending_tx> to_enq;
+            if (!g->ready || g->error) {
+                to_enq = g->tx->copy_fail_transaction();
+            } else {
+                to_enq = g->tx;
+            }
+            vts->enqueue_tx(to_enq);
+        }
+
+        // txs that are not done retry with a new timestamp, ahead of later txs
+        std::vector<coordinator::group_tx*> finished;
+        vts->group_mtx.lock();
+        for (auto riter = group.rbegin(); riter != group.rend(); riter++) {
+            coordinator::group_tx *g = *riter;
+            if (g->ready || g->error) {
+                finished.emplace_back(g);
+            } else {
+                vts->group_queue.emplace_front(g);
+            }
+        }
+        vts->group_mtx.unlock();
+
+        for (auto riter = finished.rbegin(); riter != finished.rend(); riter++) {
+            finish_group_tx(*riter);
+        }
+
+        vts->group_mtx.lock();
+    }
+
+    vts->group_leader = false;
+    vts->group_mtx.unlock();
+}
 
 void
 prepare_tx(std::shared_ptr<transaction::pending_tx> tx, coordinator::hyper_stub *hstub, order::oracle *time_oracle)
 {
+    vts->preparing_txs++;
     tx->id = vts->generate_req_id();
 
     std::unordered_set<node_handle_t> get_set;
@@ -83,13 +206,40 @@ prepare_tx(std::shared_ptr<transaction::pending_tx> tx, coordinator::hyper_stub
         CHECK_LOC(handle, loc); \
     }
 
+    // with LDG placement, new nodes are placed at commit near the nbrs they get edges to in this tx,
+    // from the shards of nbrs read in the storage tx, till then their loc is UINT64_MAX
+    std::vector<std::pair<node_handle_t, std::vector<node_handle_t>>> new_nbrs;
+    if (VT_LDG_PLACEMENT) {
+        std::unordered_map<node_handle_t, uint64_t> new_idx;
+        for (std::shared_ptr<transaction::pending_update> upd: tx->writes) {
+            if (upd->type == transaction::NODE_CREATE_REQ) {
+                new_idx.emplace(upd->handle, new_nbrs.size());
+                new_nbrs.emplace_back(upd->handle, std::vector<node_handle_t>());
+            }
+        }
+        for (std::shared_ptr<transaction::pending_update> upd: tx->writes) {
+            if (upd->type != transaction::EDGE_CREATE_REQ
+             || upd->handle1 == ""
+             || upd->handle2 == "") {
+                continue;
+            }
+            auto iter1 = new_idx.find(upd->handle1);
+            auto iter2 = new_idx.find(upd->handle2);
+            if (iter1 != new_idx.end()) {
+                new_nbrs[iter1->second].second.emplace_back(upd->handle2);
+            }
+            if (iter2 != new_idx.end()) {
+                new_nbrs[iter2->second].second.emplace_back(upd->handle1);
+            }
+        }
+    }
+
     bool error = false;
     for (std::shared_ptr<transaction::pending_update> upd: tx->writes) {
         switch (upd->type) {
 
             case transaction::NODE_CREATE_REQ:
-                // randomly assign shard for this node
-                upd->loc1 = vts->generate_loc(); // node will be placed on this shard
+                upd->loc1 = VT_LDG_PLACEMENT? UINT64_MAX : vts->generate_loc(); // shard of the node, LDG places it at commit
                 put_map.emplace(upd->handle, upd->loc1);
                 break;
 
@@ -143,43 +293,25 @@ prepare_tx(std::shared_ptr<transaction::pending_tx> tx, coordinator::hyper_stub
 #undef CHECK_LOC
 #undef HANDLE_OR_ALIAS
 
-    uint64_t sender = tx->sender;
-    bool ready = false;
-
-    while (!ready && !error) {
-        vts->clk_rw_mtx.wrlock();
-        vts->vclk.increment_clock();
-        vts->out_queue_counter++;
-        tx->timestamp = vts->vclk;
-        tx->vt_seq = vts->out_queue_counter;
-        vts->clk_rw_mtx.unlock();
-
-        // write tx in warp
-        // gets/puts/dels node mappings
-        // sets error if any warp operation returns error
-        // sets upd->loc for each upd in tx
-        // sets tx->shard_write bool_vector (shard_write[i] = true iff there is a tx component at shard i)
-        hstub->do_tx(get_set, del_set, put_map, idx_get, idx_add, tx, ready, error, time_oracle);
-
-        assert(!(ready && error)); // can't be ready after some error
-
-        std::shared_ptr<transaction::pending_tx> to_enq;
-        if (!ready || error) {
-            to_enq = tx->copy_fail_transaction();
-        } else {
-            to_enq = tx;
-        }
-        vts->enqueue_tx(to_enq);
+    if (!error) {
+        coordinator::group_tx *gtx = new coordinator::group_tx();
+        gtx->tx = tx;
+        gtx->get_set = std::move(get_set);
+        gtx->del_set = std::move(del_set);
+        gtx->put_map = std::move(put_map);
+        gtx->idx_get_set = std::move(idx_get);
+        gtx->idx_add = std::move(idx_add);
+        gtx->new_nbrs = std::move(new_nbrs);
+
+        // client reply is sent by the group commit leader
+        group_commit_tx(gtx, hstub, time_oracle);
+        return;
     }
 
+    vts->preparing_txs--;
     message::message msg;
-    if (error) {
-        // fail tx
-        msg.prepare_message(message::CLIENT_TX_ABORT);
-    } else {
-        msg.prepare_message(message::CLIENT_TX_SUCCESS);
-    }
-    vts->comm.send_to_client(sender, msg.buf);
+    msg.prepare_message(message::CLIENT_TX_ABORT);
+    vts->comm.send_to_client(tx->sender, msg.buf);
     vts->tx_queue_loop();
 }
 
@@ -207,23 +339,26 @@ end_tx(uint64_t tx_id, uint64_t shard_id, coordinator::hyper_stub *hstub)
 }
 
 // single dedicated thread which wakes up after given timeout, sends updates, and sleeps
+// timeout doubles while there are no writes or reads, and drops back to VT_TIMEOUT_NANO when reads wait
 void
 nop_function()
 {
     timespec sleep_time;
     int sleep_ret;
     int sleep_flags = 0;
-    std::shared_ptr<transaction::pending_tx> tx = nullptr;
+    std::shared_ptr<transaction::pending_tx> tx = nullptr, lease_tx = nullptr;
+    uint64_t nop_interval = VT_TIMEOUT_NANO;
+    std::vector<bool> nop_shards;
+    std::vector<uint64_t> nop_skips; // consecutive suppressed nops per shard
 
     uint64_t loop_count = 0;
     bool kronos_call;
     chronos_client kronos(KronosIpaddr, KronosPort);
     vc::vclock_t kronos_cleanup_clk(ClkSz, 0);
 
-    sleep_time.tv_sec  = VT_TIMEOUT_NANO / NANO;
-    sleep_time.tv_nsec = VT_TIMEOUT_NANO % NANO;
-
     while (true) {
+        sleep_time.tv_sec  = nop_interval / NANO;
+        sleep_time.tv_nsec = nop_interval % NANO;
         sleep_ret = clock_nanosleep(CLOCK_REALTIME, sleep_flags, &sleep_time, nullptr);
         assert((sleep_ret == 0 || sleep_ret == EINTR) && "error in clock_nanosleep");
 
@@ -233,10 +368,33 @@ nop_function()
             kronos_call = false;
         }
 
+        vts->tx_prog_mutex.lock();
+        bool progs_pending = !vts->pend_progs.empty();
+        vts->tx_prog_mutex.unlock();
+
         vts->periodic_update_mutex.lock();
 
+        // shards that got a write since last round do not need a nop to make progress
+        // still send one every VT_MAX_NOP_SKIPS rounds for state cleanup
+        bool wrote = false, reads_queued = false;
+        nop_shards = vts->to_nop;
+        nop_skips.resize(nop_shards.size(), 0);
+        for (uint64_t shard_id = 0; shard_id < nop_shards.size(); shard_id++) {
+            wrote = wrote || vts->shard_wrote[shard_id];
+            reads_queued = reads_queued || (vts->shard_queued_reads[shard_id] > 0);
+            if (nop_shards[shard_id]
+             && vts->shard_wrote[shard_id]
+             && vts->shard_queued_reads[shard_id] == 0
+             && nop_skips[shard_id] < VT_MAX_NOP_SKIPS) {
+                nop_shards[shard_id] = false;
+                nop_skips[shard_id]++;
+                vts->nops_suppressed++;
+            }
+        }
+        weaver_util::reset_all(vts->shard_wrote);
+
         // send nops and state cleanup info to shards
-        if (weaver_util::any(vts->to_nop)) {
+        if (weaver_util::any(nop_shards)) {
             tx = std::make_shared<transaction::pending_tx>(transaction::NOP);
             tx->nop = std::make_shared<transaction::nop_data>();
 
@@ -246,7 +404,7 @@ nop_function()
             vts->out_queue_counter++;
             tx->timestamp = vts->vclk;
             tx->vt_seq = vts->out_queue_counter;
-            tx->shard_write = vts->to_nop;
+            tx->shard_write = nop_shards;
             vts->clk_rw_mtx.unlock();
 
             vts->tx_prog_mutex.lock();
@@ -263,7 +421,7 @@ nop_function()
 
             for (auto &p: vts->done_txs) {
                 for (uint64_t shard_id = 0; shard_id < p.second.size(); shard_id++) {
-                    if (vts->to_nop[shard_id] && !p.second[shard_id]) {
+                    if (nop_shards[shard_id] && !p.second[shard_id]) {
                         p.second[shard_id] = true;
                     }
                 }
@@ -277,17 +435,65 @@ nop_function()
 
             vts->tx_prog_mutex.unlock();
 
-            weaver_util::reset_all(vts->to_nop);
+            for (uint64_t shard_id = 0; shard_id < nop_shards.size(); shard_id++) {
+                if (nop_shards[shard_id]) {
+                    vts->to_nop[shard_id] = false;
+                    nop_skips[shard_id] = 0;
+                    vts->nops_sent++;
+                }
+            }
         } else {
             kronos_call = false;
         }
 
+        // while reads wait, shards not getting a nop (awaiting ack or skipped) get a read lease
+        // a lease lets reads through like a nop, without going through shard write queues or an ack
+        if (reads_queued || progs_pending) {
+            std::vector<bool> lease_shards(nop_shards.size(), false);
+            for (uint64_t shard_id = 0; shard_id < nop_shards.size(); shard_id++) {
+                lease_shards[shard_id] = !nop_shards[shard_id];
+            }
+
+            if (weaver_util::any(lease_shards)) {
+                lease_tx = std::make_shared<transaction::pending_tx>(transaction::READ_LEASE);
+                vts->clk_rw_mtx.wrlock();
+                vts->vclk.increment_clock();
+                vts->out_queue_counter++;
+                lease_tx->timestamp = vts->vclk;
+                lease_tx->vt_seq = vts->out_queue_counter;
+                lease_tx->shard_write = lease_shards;
+                vts->clk_rw_mtx.unlock();
+
+                for (uint64_t shard_id = 0; shard_id < lease_shards.size(); shard_id++) {
+                    if (lease_shards[shard_id]) {
+                        vts->leases_sent++;
+                    }
+                }
+            }
+        }
+
         vts->periodic_update_mutex.unlock();
 
-        if (tx != nullptr) {
-            vts->enqueue_tx(tx);
+        // reads from this vt or queued at shards need nops soon, otherwise back off while idle
+        if (reads_queued || progs_pending) {
+            nop_interval = VT_TIMEOUT_NANO;
+        } else if (!wrote && nop_interval < VT_MAX_TIMEOUT_NANO) {
+            nop_interval *= 2;
+            if (nop_interval > VT_MAX_TIMEOUT_NANO) {
+                nop_interval = VT_MAX_TIMEOUT_NANO;
+            }
+        }
+
+        if (tx != nullptr || lease_tx != nullptr) {
+            if (tx != nullptr) {
+                vts->enqueue_tx(tx);
+            }
+            if (lease_tx != nullptr) {
+                vts->enqueue_tx(lease_tx);
+            }
             vts->tx_queue_loop();
             tx = nullptr;
+            lease_tx = nullptr;
         }
 
         if (kronos_call) {
@@ -333,9 +539,8 @@ clk_update_function()
     vc::vclock vclk(vt_id, 0);
     uint64_t config_version;
     std::vector<server::state_t> vts_state(NumVts, server::NOT_AVAILABLE);
-
-    sleep_time.tv_sec  = VT_CLK_TIMEOUT_NANO / NANO;
-    sleep_time.tv_nsec = VT_CLK_TIMEOUT_NANO % NANO;
+    uint64_t clk_interval = VT_CLK_TIMEOUT_NANO;
+    bool config_changed = true;
 
     vts->periodic_update_mutex.lock();
     config_version = vts->periodic_update_config.version();
@@ -347,6 +552,8 @@ clk_update_function()
     vts->periodic_update_mutex.unlock();
 
     while (true) {
+        sleep_time.tv_sec  = clk_interval / NANO;
+        sleep_time.tv_nsec = clk_interval % NANO;
         sleep_ret = clock_nanosleep(CLOCK_REALTIME, sleep_flags, &sleep_time, nullptr);
         if (sleep_ret != 0 && sleep_ret != EINTR) {
             assert(false);
@@ -355,6 +562,7 @@ clk_update_function()
 
         if (config_version < vts->periodic_update_config.version()) {
             config_version = vts->periodic_update_config.version();
+            config_changed = true;
 
             for (server::state_t &s: vts_state) {
                 s = server::NOT_AVAILABLE;
@@ -368,9 +576,25 @@ clk_update_function()
         }
 
         // update vclock at other timestampers
+        // an unchanged clock is resent only to new timestampers, and gossip backs off while it does not change
         vts->clk_rw_mtx.rdlock();
+        bool clk_changed = (vclk.clock != vts->vclk.clock);
         vclk.clock = vts->vclk.clock;
         vts->clk_rw_mtx.unlock();
+        if (clk_changed) {
+            clk_interval = VT_CLK_TIMEOUT_NANO;
+        } else if (clk_interval < VT_MAX_TIMEOUT_NANO) {
+            clk_interval *= 2;
+            if (clk_interval > VT_MAX_TIMEOUT_NANO) {
+                clk_interval = VT_MAX_TIMEOUT_NANO;
+            }
+        }
+        if (!clk_changed && !config_changed) {
+            vts->periodic_update_mutex.unlock();
+            continue;
+        }
+        config_changed = false;
+
         for (uint64_t i = 0; i < NumVts; i++) {
             if (i == vt_id || vts_state[i] != server::AVAILABLE) {
                 continue;
@@ -405,6 +629,11 @@ void node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueT
     // map from locations to a list of start_node_params to send to that shard
     std::unordered_map<uint64_t, std::deque<std::pair<node_handle_t, ParamsType>>> initial_batches; 
 
+    // sampled for tracing
+    uint64_t trace_period = vts->trace_period.load(std::memory_order_relaxed);
+    bool traced = trace_period != 0 && (vts->trace_counter++ % trace_period) == 0;
+    uint64_t trace_start = traced? metrics::clock_ns() : 0;
+
     // lookup mappings
     std::unordered_map<node_handle_t, uint64_t> loc_map;
     std::unordered_set<node_handle_t> get_set;
@@ -458,7 +687,10 @@ void node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueT
         }
     }
 
-    for (const auto &p: initial_args) {
+    uint64_t mapping_ns = traced? metrics::clock_ns() - trace_start : 0;
+
+    for (auto &p: initial_args) {
+        p.second.set_start_locs(loc_map);
         initial_batches[loc_map[p.first]].emplace_back(p);
     }
 
@@ -477,9 +709,26 @@ void node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueT
     vts->outstanding_progs.emplace(req_id);
     vts->tx_prog_mutex.unlock();
 
+    uint64_t trace_id = 0;
+    if (traced) {
+        vts->trace_mtx.lock();
+        // programs that never return leave their traces pending, do not let them pile up
+        if (vts->pending_traces.size() < PROG_TRACE_KEEP) {
+            coordinator::pending_trace &pt = vts->pending_traces[req_id];
+            pt.start_ns = trace_start;
+            pt.mapping_ns = mapping_ns;
+            pt.total_ns = 0;
+            pt.shards_left = 0;
+            vts->traces_pending++;
+            trace_id = req_id;
+        }
+        vts->trace_mtx.unlock();
+    }
+
     message::message msg_to_send;
+    uint64_t parent_hop = 0; // sent by the vt
     for (auto &batch_pair: initial_batches) {
-        msg_to_send.prepare_message(message::NODE_PROG, pType, vt_id, req_timestamp, req_id, cp_int, batch_pair.second);
+        msg_to_send.prepare_message(message::NODE_PROG, pType, vt_id, req_timestamp, req_id, trace_id, parent_hop, cp_int, batch_pair.second);
         vts->comm.send(batch_pair.first, msg_to_send.buf);
     }
 
@@ -495,7 +744,7 @@ void node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueT
 
 template <typename ParamsType, typename NodeStateType, typename CacheValueType>
 void node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueType> ::
-    unpack_and_run_db(std::unique_ptr<message::message>, order::oracle*)
+    unpack_and_run_db(std::unique_ptr<message::message>, order::oracle*, uint64_t)
 { }
 
 template <typename ParamsType, typename NodeStateType, typename CacheValueType>
@@ -531,6 +780,386 @@ node_prog_done(uint64_t req_id, current_prog *cp)
     return true;
 }
 
+// tell all shards to run the current superstep of a bsp job
+// caution: need to hold vts->bsp_mtx
+void
+send_bsp_superstep(uint64_t req_id, coordinator::bsp_job *job)
+{
+    uint64_t num_shards = job->expected.size();
+    message::message msg;
+    for (uint64_t i = 0; i < num_shards; i++) {
+        msg.prepare_message(message::BSP_SUPERSTEP, vt_id, job->vclk, req_id, job->params,
+            job->step, job->final_step, job->expected[i], job->num_nodes, job->dangling);
+        vts->comm.send(i + ShardIdIncr, msg.buf);
+    }
+
+    job->shards_left = num_shards;
+    job->expected.assign(num_shards, 0);
+    job->active = 0;
+    job->dangling = 0;
+}
+
+// bsp jobs read the whole graph at one snapshot, which is held like that of a node program
+void
+start_bsp_job(uint64_t client, std::unique_ptr<message::message> msg)
+{
+    bsp::params params;
+    msg->unpack_message(message::CLIENT_BSP_REQ, params);
+
+    vts->clk_rw_mtx.wrlock();
+    vts->vclk.increment_clock();
+    vc::vclock req_timestamp = vts->vclk;
+    assert(req_timestamp.clock.size() == ClkSz);
+
+    vts->tx_prog_mutex.lock();
+    vts->clk_rw_mtx.unlock();
+
+    uint64_t req_id = vts->generate_req_id();
+    current_prog *cp = new current_prog(req_id, client, req_timestamp);
+    vts->pend_progs.emplace_back(cp);
+    vts->outstanding_progs.emplace(req_id);
+    vts->tx_prog_mutex.unlock();
+
+    coordinator::bsp_job *job = new coordinator::bsp_job(cp, params, req_timestamp, get_num_shards());
+    vts->bsp_mtx.lock();
+    vts->bsp_jobs.emplace(req_id, job);
+    send_bsp_superstep(req_id, job);
+    vts->bsp_mtx.unlock();
+}
+
+// whether the superstep that all shards just finished is the last one with work
+static bool
+bsp_converged(coordinator::bsp_job *job)
+{
+    uint64_t max_steps = job->params.max_supersteps;
+    switch (job->params.algo) {
+        case bsp::PAGERANK:
+            // the final superstep does the last iteration
+            return job->step >= 1 && job->step >= max_steps;
+
+        case bsp::CONNECTED_COMPONENTS:
+            return job->step >= 1 && (job->active == 0 || (max_steps > 0 && job->step >= max_steps));
+
+        case bsp::DEGREE_DISTRIBUTION:
+            return job->step >= 1;
+
+        default:
+            return true;
+    }
+}
+
+// combine partial results of all shards into job->res
+static void
+bsp_merge_result(coordinator::bsp_job *job)
+{
+    bsp::result &res = job->res;
+    res.supersteps = job->step;
+    res.num_nodes = job->num_nodes;
+    uint64_t k;
+    auto greater_second = [](const std::pair<node_handle_t, double> &a, const std::pair<node_handle_t, double> &b) {
+        return a.second > b.second;
+    };
+
+    switch (job->params.algo) {
+        case bsp::PAGERANK:
+            k = std::min((uint64_t)job->params.top_k, (uint64_t)res.top.size());
+            std::partial_sort(res.top.begin(), res.top.begin() + k, res.top.end(), greater_second);
+            res.top.resize(k);
+            break;
+
+        case bsp::CONNECTED_COMPONENTS:
+            res.top.clear();
+            for (auto &p: job->component_sizes) {
+                res.top.emplace_back(p.first, p.second);
+                job->histogram[p.second]++;
+            }
+            res.num_components = job->component_sizes.size();
+            res.histogram.assign(job->histogram.begin(), job->histogram.end());
+            k = std::min((uint64_t)job->params.top_k, (uint64_t)res.top.size());
+            std::partial_sort(res.top.begin(), res.top.begin() + k, res.top.end(), greater_second);
+            res.top.resize(k);
+            break;
+
+        case bsp::DEGREE_DISTRIBUTION:
+            res.histogram.assign(job->histogram.begin(), job->histogram.end());
+            res.in_histogram.assign(job->in_histogram.begin(), job->in_histogram.end());
+            break;
+
+        default:
+            break;
+    }
+}
+
+// shard finished a superstep, start the next one once all shards have
+void
+bsp_step_done(std::unique_ptr<message::message> msg)
+{
+    uint64_t req_id, shard_id, step, num_vertices, active;
+    std::vector<uint64_t> sent;
+    double dangling;
+    bsp::result partial;
+    msg->unpack_message(message::BSP_STEP_DONE, req_id, shard_id, step, sent, num_vertices, active, dangling, partial);
+
+    vts->bsp_mtx.lock();
+    auto iter = vts->bsp_jobs.find(req_id);
+    assert(iter != vts->bsp_jobs.end());
+    coordinator::bsp_job *job = iter->second;
+    assert(job->step == step);
+
+    if (step == 0) {
+        job->num_nodes += num_vertices;
+    }
+    for (uint64_t i = 0; i < sent.size(); i++) {
+        job->expected[i] += sent[i];
+    }
+    job->active += active;
+    job->dangling += dangling;
+
+    if (job->final_step) {
+        switch (job->params.algo) {
+            case bsp::PAGERANK:
+                job->res.top.insert(job->res.top.end(), partial.top.begin(), partial.top.end());
+                break;
+
+            case bsp::CONNECTED_COMPONENTS:
+                for (auto &p: partial.top) {
+                    job->component_sizes[p.first] += (uint64_t)p.second;
+                }
+                break;
+
+            case bsp::DEGREE_DISTRIBUTION:
+                for (auto &p: partial.histogram) {
+                    job->histogram[p.first] += p.second;
+                }
+                for (auto &p: partial.in_histogram) {
+                    job->in_histogram[p.first] += p.second;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    if (--job->shards_left > 0) {
+        vts->bsp_mtx.unlock();
+        return;
+    }
+
+    if (!job->final_step) {
+        job->final_step = bsp_converged(job);
+        job->step++;
+        send_bsp_superstep(req_id, job);
+        vts->bsp_mtx.unlock();
+        return;
+    }
+
+    vts->bsp_jobs.erase(req_id);
+    vts->bsp_mtx.unlock();
+
+    bsp_merge_result(job);
+    current_prog *cp = job->cp;
+    uint64_t client = cp->client;
+    msg->prepare_message(message::CLIENT_BSP_REPLY, job->res);
+    delete job;
+
+    vts->tx_prog_mutex.lock();
+    bool to_process = node_prog_done(req_id, cp);
+    vts->tx_prog_mutex.unlock();
+
+    if (to_process) {
+        vts->comm.send_to_client(client, msg->buf);
+    }
+}
+
+// counters of this vt, beyond those in metrics::server_metrics
+void
+vt_metrics_extra(std::vector<std::pair<std::string, uint64_t>> &extra)
+{
+    vts->clk_rw_mtx.rdlock();
+    extra.emplace_back("vclk_updates", vts->clk_updates);
+    vts->clk_rw_mtx.unlock();
+
+    vts->periodic_update_mutex.lock();
+    extra.emplace_back("nops_sent", vts->nops_sent);
+    extra.emplace_back("nops_suppressed", vts->nops_suppressed);
+    extra.emplace_back("read_leases_sent", vts->leases_sent);
+    vts->periodic_update_mutex.unlock();
+
+    vts->tx_prog_mutex.lock();
+    extra.emplace_back("outstanding_progs", vts->outstanding_progs.size());
+    vts->tx_prog_mutex.unlock();
+}
+
+std::string
+vt_metrics_server()
+{
+    return "vt" + std::to_string(vt_id);
+}
+
+// traced program returned, fetch spans from all shards
+void
+trace_prog_returned(uint64_t req_id)
+{
+    vts->trace_mtx.lock();
+    auto iter = vts->pending_traces.find(req_id);
+    if (iter == vts->pending_traces.end()) {
+        vts->trace_mtx.unlock();
+        return;
+    }
+    coordinator::pending_trace &pt = iter->second;
+    pt.total_ns = metrics::clock_ns() - pt.start_ns;
+    uint64_t num_shards = get_num_shards();
+    pt.shards_left = num_shards;
+    vts->trace_mtx.unlock();
+
+    message::message msg;
+    for (uint64_t i = 0; i < num_shards; i++) {
+        msg.prepare_message(message::TRACE_FETCH, vt_id, req_id);
+        vts->comm.send(i + ShardIdIncr, msg.buf);
+    }
+}
+
+void
+trace_spans(std::unique_ptr<message::message> msg)
+{
+    uint64_t req_id;
+    std::vector<prog_trace::span> spans;
+    msg->unpack_message(message::TRACE_SPANS, req_id, spans);
+
+    vts->trace_mtx.lock();
+    auto iter = vts->pending_traces.find(req_id);
+    if (iter == vts->pending_traces.end()) {
+        vts->trace_mtx.unlock();
+        WDEBUG << "trace spans for unknown request " << req_id << std::endl;
+        return;
+    }
+
+    coordinator::pending_trace &pt = iter->second;
+    pt.spans.insert(pt.spans.end(), spans.begin(), spans.end());
+    if (--pt.shards_left == 0) {
+        vts->done_traces.emplace_back(prog_trace::critical_path(req_id, pt.total_ns, pt.mapping_ns, pt.spans));
+        if (vts->done_traces.size() > PROG_TRACE_KEEP) {
+            vts->done_traces.pop_front();
+        }
+        vts->pending_traces.erase(iter);
+        vts->traces_pending--;
+    }
+    vts->trace_mtx.unlock();
+}
+
+// this vt's dump goes first, shards reply to METRICS_REQ with theirs
+void
+start_metrics_req(uint64_t client, std::unique_ptr<message::message> msg)
+{
+    std::vector<std::pair<std::string, uint64_t>> extra;
+    vt_metrics_extra(extra);
+    std::ostringstream dump;
+    metrics::dump_prometheus(dump, vt_metrics_server(), extra);
+
+    uint64_t num_shards = get_num_shards();
+    if (num_shards == 0) {
+        std::vector<std::string> dumps(1, dump.str());
+        msg->prepare_message(message::CLIENT_METRICS_REPLY, dumps);
+        vts->comm.send_to_client(client, msg->buf);
+        return;
+    }
+
+    uint64_t req_id = vts->generate_req_id();
+    vts->metrics_mtx.lock();
+    coordinator::metrics_req &req = vts->metrics_reqs[req_id];
+    req.client = client;
+    req.shards_left = num_shards;
+    req.dumps.emplace_back(dump.str());
+    vts->metrics_mtx.unlock();
+
+    for (uint64_t i = 0; i < num_shards; i++) {
+        msg->prepare_message(message::METRICS_REQ, vt_id, req_id);
+        vts->comm.send(i + ShardIdIncr, msg->buf);
+    }
+}
+
+void
+metrics_reply(std::unique_ptr<message::message> msg)
+{
+    uint64_t req_id;
+    std::string dump;
+    msg->unpack_message(message::METRICS_REPLY, req_id, dump);
+
+    vts->metrics_mtx.lock();
+    auto iter = vts->metrics_reqs.find(req_id);
+    if (iter == vts->metrics_reqs.end()) {
+        vts->metrics_mtx.unlock();
+        WDEBUG << "metrics reply for unknown request " << req_id << std::endl;
+        return;
+    }
+
+    coordinator::metrics_req &req = iter->second;
+    req.dumps.emplace_back(std::move(dump));
+    if (--req.shards_left > 0) {
+        vts->metrics_mtx.unlock();
+        return;
+    }
+
+    uint64_t client = req.client;
+    msg->prepare_message(message::CLIENT_METRICS_REPLY, req.dumps);
+    vts->metrics_reqs.erase(iter);
+    vts->metrics_mtx.unlock();
+
+    vts->comm.send_to_client(client, msg->buf);
+}
+
+// rewrite metrics_file every METRICS_DUMP_INTERVAL_SECS
+void
+metrics_file_loop()
+{
+    timespec sleep_time;
+    sleep_time.tv_sec = METRICS_DUMP_INTERVAL_SECS;
+    sleep_time.tv_nsec = 0;
+    std::vector<std::pair<std::string, uint64_t>> extra;
+    while (true) {
+        nanosleep(&sleep_time, nullptr);
+        extra.clear();
+        vt_metrics_extra(extra);
+        metrics::dump_prometheus_file(metrics_file, vt_metrics_server(), extra);
+    }
+}
+
+// nodes a shard bulk loaded into its local storage
+void
+store_bulk_load(std::unique_ptr<message::message> msg, coordinator::hyper_stub *hstub)
+{
+    enum message::msg_type mtype;
+    uint64_t shard;
+    std::vector<node_handle_t> handles;
+    std::unordered_map<node_handle_t, db::node*> nodes;
+    std::vector<std::pair<std::string, node_handle_t>> aliases;
+    vclock_ptr_t dummy_clock;
+    po6::threads::mutex dummy_mtx;
+
+    // nodes are unpacked in place, so cannot use unpack_message
+    e::unpacker unpacker = msg->buf->unpack_from(BUSYBEE_HEADER_SIZE);
+    message::unpack_buffer(unpacker, mtype);
+    assert(mtype == message::STORE_BULK_LOAD);
+    message::unpack_buffer(unpacker, shard);
+    message::unpack_buffer(unpacker, handles);
+    uint32_t num_nodes;
+    message::unpack_buffer(unpacker, num_nodes);
+    assert(num_nodes == handles.size());
+    nodes.reserve(num_nodes);
+    for (const node_handle_t &h: handles) {
+        db::node *n = new db::node(h, shard, dummy_clock, &dummy_mtx);
+        message::unpack_buffer(unpacker, *n);
+        nodes.emplace(h, n);
+    }
+    message::unpack_buffer(unpacker, aliases);
+    assert(!unpacker.error());
+
+    if (!hstub->bulk_load(nodes, aliases)) {
+        WDEBUG << "could not store " << handles.size() << " nodes bulk loaded at shard " << shard << std::endl;
+    }
+}
+
 void
 server_loop(int thread_id)
 {
@@ -552,6 +1181,7 @@ server_loop(int thread_id)
         } else {
             // good to go, unpack msg
             mtype = msg->unpack_message_type();
+            metrics::get().message_received(mtype, msg->buf->size());
 
             switch (mtype) {
                 // client messages
@@ -581,12 +1211,13 @@ server_loop(int thread_id)
                 //    break;
 
                 case message::VT_NOP_ACK: {
-                    uint64_t shard_node_count, nop_qts, sid, sender;
-                    msg->unpack_message(message::VT_NOP_ACK, sender, nop_qts, shard_node_count);
+                    uint64_t shard_node_count, nop_qts, sid, sender, queued_reads;
+                    msg->unpack_message(message::VT_NOP_ACK, sender, nop_qts, shard_node_count, queued_reads);
                     sid = sender - ShardIdIncr;
                     vts->periodic_update_mutex.lock();
                     if (nop_qts > vts->nop_ack_qts[sid]) {
-                        vts->shard_node_count[sid] = shard_node_count;
+                        vts->node_count_update(sid, shard_node_count);
+                        vts->shard_queued_reads[sid] = queued_reads;
                         vts->to_nop[sid] = true;
                         vts->nop_ack_qts[sid] = nop_qts;
                     }
@@ -602,6 +1233,48 @@ server_loop(int thread_id)
                     break;
                 }
 
+                case message::TRAVERSAL_SAMPLING: {
+                    uint64_t period;
+                    msg->unpack_message(message::TRAVERSAL_SAMPLING, period);
+                    uint64_t num_shards = get_num_shards();
+                    for (uint64_t i = 0; i < num_shards; i++) {
+                        msg->prepare_message(message::TRAVERSAL_SAMPLING, period);
+                        vts->comm.send(i + ShardIdIncr, msg->buf);
+                    }
+                    break;
+                }
+
+                case message::PROG_TRACE_SAMPLING: {
+                    uint64_t period;
+                    msg->unpack_message(message::PROG_TRACE_SAMPLING, period);
+                    vts->trace_period.store(period);
+                    WDEBUG << "node program tracing " << (period == 0? "off" : "every " + std::to_string(period) + " programs") << std::endl;
+                    break;
+                }
+
+                case message::TRACE_SPANS:
+                    trace_spans(std::move(msg));
+                    break;
+
+                case message::CLIENT_TRACES_REQ: {
+                    std::vector<std::string> traces;
+                    vts->trace_mtx.lock();
+                    traces.assign(vts->done_traces.begin(), vts->done_traces.end());
+                    vts->done_traces.clear();
+                    vts->trace_mtx.unlock();
+                    msg->prepare_message(message::CLIENT_TRACES_REPLY, traces);
+                    vts->comm.send_to_client(client_sender, msg->buf);
+                    break;
+                }
+
+                case message::CLIENT_METRICS_REQ:
+                    start_metrics_req(client_sender, std::move(msg));
+                    break;
+
+                case message::METRICS_REPLY:
+                    metrics_reply(std::move(msg));
+                    break;
+
                 case message::TX_DONE:
                     msg->unpack_message(message::TX_DONE, tx_id, shard_id);
                     end_tx(tx_id, shard_id, hstub);
@@ -624,6 +1297,19 @@ server_loop(int thread_id)
                     break;
                 }
 
+                case message::STORE_BULK_LOAD:
+                    store_bulk_load(std::move(msg), hstub);
+                    break;
+
+                case message::STORE_NMAP_UPDATE: {
+                    std::unordered_map<node_handle_t, uint64_t> mappings;
+                    msg->unpack_message(message::STORE_NMAP_UPDATE, mappings);
+                    if (!hstub->update_mappings(mappings)) {
+                        WDEBUG << "could not store " << mappings.size() << " new node locations" << std::endl;
+                    }
+                    break;
+                }
+
                 case message::MIGRATION_TOKEN: {
                     vts->migr_mutex.lock();
                     uint64_t client = vts->migr_client;
@@ -646,6 +1332,14 @@ server_loop(int thread_id)
                     //vts->comm.send_to_client(client_sender, msg->buf);
                     break;
 
+                case message::CLIENT_BSP_REQ:
+                    start_bsp_job(client_sender, std::move(msg));
+                    break;
+
+                case message::BSP_STEP_DONE:
+                    bsp_step_done(std::move(msg));
+                    break;
+
                 // node program response from a shard
                 case message::NODE_PROG_RETURN: {
                     uint64_t req_id, cp_int, client;
@@ -660,6 +1354,9 @@ server_loop(int thread_id)
 
                     if (to_process) {
                         vts->comm.send_to_client(client, msg->buf);
+                        if (vts->traces_pending.load(std::memory_order_relaxed) != 0) {
+                            trace_prog_returned(req_id);
+                        }
 #ifdef weaver_benchmark_
                         vts->test_mtx.lock();
                         vts->outstanding_cnt--;
@@ -847,6 +1544,10 @@ end_program(int signum)
     vts->clk_rw_mtx.wrlock();
     WDEBUG << "num vclk updates " << vts->clk_updates << std::endl;
     vts->clk_rw_mtx.unlock();
+    vts->periodic_update_mutex.lock();
+    WDEBUG << "nops sent " << vts->nops_sent << ", suppressed " << vts->nops_suppressed
+           << ", read leases sent " << vts->leases_sent << std::endl;
+    vts->periodic_update_mutex.unlock();
 
 #ifdef weaver_benchmark_
     WDEBUG << "max outstanding prog cnt = " << vts->max_outstanding_cnt << std::endl;
@@ -878,6 +1579,9 @@ main(int argc, const char *argv[])
     ap.arg().long_name("config-file")
             .description("full path of weaver.yaml configuration file (default ./weaver.yaml)")
             .metavar("filename").as_string(&config_file);
+    ap.arg().long_name("metrics-file")
+            .description("periodically write metrics of this timestamper to this file, in Prometheus text format (default: none)")
+            .metavar("filename").as_string(&metrics_file);
     ap.arg().long_name("log-file")
             .description("full path of file to write log to (default: stderr)")
             .metavar("filename").as_string(&log_file_name);
@@ -957,6 +1661,11 @@ main(int argc, const char *argv[])
         clk_update_thr.detach();
     }
 
+    if (metrics_file != nullptr) {
+        std::thread metrics_thr(metrics_file_loop);
+        metrics_thr.detach();
+    }
+
     // periodic nops to shard
     nop_function();
 
@@ -17,7 +17,9 @@
 #ifndef weaver_coordinator_timestamper_h_
 #define weaver_coordinator_timestamper_h_
 
+#include <atomic>
 #include <vector>
+#include <deque>
 #include <unordered_map>
 #include <po6/threads/mutex.h>
 #include <po6/threads/rwlock.h>
@@ -26,6 +28,7 @@
 #include "common/ids.h"
 #include "common/vclock.h"
 #include "common/message.h"
+#include "common/prog_trace.h"
 #include "common/configuration.h"
 #include "common/comm_wrapper.h"
 #include "common/event_order.h"
@@ -33,6 +36,7 @@
 #include "coordinator/vt_constants.h"
 #include "coordinator/current_prog.h"
 #include "coordinator/blocked_prog.h"
+#include "coordinator/bsp_job.h"
 #include "coordinator/hyper_stub.h"
 
 namespace coordinator
@@ -54,6 +58,24 @@ namespace coordinator
     using prog_queue_t = std::unique_ptr<std::vector<blocked_prog>>;
     using req_reply_t = std::unordered_map<uint64_t, std::vector<bool>>;
 
+    // client request for metrics of all servers, waiting for shard replies
+    struct metrics_req
+    {
+        uint64_t client;
+        uint64_t shards_left;
+        std::vector<std::string> dumps;
+    };
+
+    // traced node program, from dispatch until all shards sent their spans
+    struct pending_trace
+    {
+        uint64_t start_ns;
+        uint64_t mapping_ns; // node handle to shard lookups
+        uint64_t total_ns; // until NODE_PROG_RETURN
+        uint64_t shards_left;
+        std::vector<prog_trace::span> spans;
+    };
+
     class timestamper
     {
         public:
@@ -81,6 +103,7 @@ namespace coordinator
             uint64_t vt_id; // this vector timestamper's id
             uint64_t shifted_id;
             uint64_t reqid_gen, loc_gen;
+            std::vector<uint64_t> loc_placed; // nodes placed on each shard since its last nop ack
             po6::threads::mutex reqid_gen_mtx, loc_gen_mtx;
 
         public:
@@ -90,11 +113,22 @@ namespace coordinator
             uint64_t clock_update_acks, clk_updates;
             std::vector<bool> to_nop;
             std::vector<uint64_t> nop_ack_qts;
+            // nop is skipped for a shard that got a write tx since last nop, unless reads are queued there
+            std::vector<bool> shard_wrote;
+            std::vector<uint64_t> shard_queued_reads; // as of last nop ack
+            uint64_t nops_sent, nops_suppressed, leases_sent;
 
             // transactions
             std::unordered_map<uint64_t, std::shared_ptr<transaction::pending_tx>> outstanding_tx;
             req_reply_t done_txs; // tx state cleanup
 
+            // group commit of write txs
+            // one thread at a time commits groups of queued txs, others queue their tx and return
+            po6::threads::mutex group_mtx;
+            std::deque<group_tx*> group_queue;
+            bool group_leader;
+            std::atomic<uint64_t> preparing_txs; // write txs not yet queued
+
             // prog cleanup and permanent deletion
             std::unordered_set<uint64_t> outstanding_progs; // for multiple returns and ft
             std::vector<current_prog*> pend_progs, done_progs;
@@ -122,6 +156,22 @@ namespace coordinator
             uint64_t migr_client;
             std::vector<uint64_t> shard_node_count;
 
+            // bulk synchronous analytics
+            std::unordered_map<uint64_t, bsp_job*> bsp_jobs; // req id -> job
+            po6::threads::mutex bsp_mtx;
+
+            // server metrics
+            std::unordered_map<uint64_t, metrics_req> metrics_reqs; // req id -> request
+            po6::threads::mutex metrics_mtx;
+
+            // node program tracing
+            std::atomic<uint64_t> trace_period; // trace one in this many node programs, 0 for none
+            std::atomic<uint64_t> trace_counter;
+            std::atomic<uint64_t> traces_pending; // size of pending_traces, read without trace_mtx
+            std::unordered_map<uint64_t, pending_trace> pending_traces; // req id -> trace
+            std::deque<std::string> done_traces; // critical paths, until a client reads them
+            po6::threads::mutex trace_mtx;
+
             // fault tolerance
             std::pair<uint64_t, uint64_t> out_queue_clk; // (epoch num, out clk)
             uint64_t out_queue_counter;
@@ -141,6 +191,8 @@ namespace coordinator
             void update_members_new_config();
             uint64_t generate_req_id();
             uint64_t generate_loc();
+            uint64_t place_node(const std::vector<uint64_t> &nbr_locs);
+            void node_count_update(uint64_t shard_idx, uint64_t count);
             void enqueue_tx(std::shared_ptr<transaction::pending_tx> tx);
             bool process_tx_queue(std::shared_ptr<transaction::pending_tx> &tx_ptr, std::vector<std::shared_ptr<transaction::pending_tx>> &factored_tx);
             void factor_tx(std::shared_ptr<transaction::pending_tx> tx, std::vector<std::shared_ptr<transaction::pending_tx>> &factored_tx);
@@ -172,17 +224,28 @@ namespace coordinator
         , shifted_id(UINT64_MAX)
         , reqid_gen(0)
         , loc_gen(0)
+        , loc_placed(NumShards, 0)
         , vclk(UINT64_MAX, 0)
         , qts(NumShards, 0)
         , clock_update_acks(NumVts-1)
         , clk_updates(0)
         , to_nop(NumShards, true)
         , nop_ack_qts(NumShards, 0)
+        , shard_wrote(NumShards, false)
+        , shard_queued_reads(NumShards, 0)
+        , nops_sent(0)
+        , nops_suppressed(0)
+        , leases_sent(0)
+        , group_leader(false)
+        , preparing_txs(0)
         , prog_done_cnt(0)
         , max_done_clk(vc::vclock_t(ClkSz, 0))
         , load_count(0)
         , max_load_time(0)
         , shard_node_count(NumShards, 0)
+        , trace_period(ProgTraceSamplePeriod)
+        , trace_counter(0)
+        , traces_pending(0)
         , out_queue_clk(std::make_pair(0,1))
         , out_queue_counter(0)
         , prog_queue(new std::vector<blocked_prog>())
@@ -283,7 +346,12 @@ namespace coordinator
         periodic_update_mutex.lock();
         to_nop.resize(num_shards, true);
         nop_ack_qts.resize(num_shards, 0);
+        shard_wrote.resize(num_shards, false);
+        shard_queued_reads.resize(num_shards, 0);
         shard_node_count.resize(num_shards, 0);
+        loc_gen_mtx.lock();
+        loc_placed.resize(num_shards, 0);
+        loc_gen_mtx.unlock();
         std::fill(max_done_clk.begin(), max_done_clk.end(), 0);
         max_done_clk[0] = config.version();
 
@@ -368,6 +436,7 @@ namespace coordinator
                     qts[shard_id] = 0;
                     to_nop[shard_id] = true;
                     nop_ack_qts[shard_id] = 0;
+                    shard_queued_reads[shard_id] = 0;
                 }
             } else if (srv.type == server::VT) {
                 server::state_t prv_state = prev_config.get_state(srv.id);
@@ -466,6 +535,72 @@ namespace coordinator
         return new_loc;
     }
 
+    // streaming LDG placement of a new node, given the shards of its nbrs
+    // nbrs on a shard count for it, discounted by how full the shard is
+    // falls back to round robin if there are no nbrs or all shards are full
+    inline uint64_t
+    timestamper :: place_node(const std::vector<uint64_t> &nbr_locs)
+    {
+        if (nbr_locs.empty()) {
+            return generate_loc();
+        }
+
+        periodic_update_mutex.lock();
+        std::vector<uint64_t> counts = shard_node_count;
+        periodic_update_mutex.unlock();
+
+        uint64_t num_shards = get_num_shards();
+        counts.resize(num_shards, 0);
+        std::vector<uint64_t> nbr_count(num_shards, 0);
+        for (uint64_t loc: nbr_locs) {
+            if (loc >= ShardIdIncr && loc - ShardIdIncr < num_shards) {
+                nbr_count[loc - ShardIdIncr]++;
+            }
+        }
+
+        uint64_t new_loc = UINT64_MAX;
+        loc_gen_mtx.lock();
+        uint64_t total = 0;
+        for (uint64_t i = 0; i < num_shards; i++) {
+            counts[i] += loc_placed[i];
+            total += counts[i];
+        }
+        double cap = VT_PLACEMENT_SLACK * ((double)total) / num_shards + 1;
+
+        double max_score = 0;
+        for (uint64_t i = 0; i < num_shards; i++) {
+            double score = nbr_count[i] * (1 - counts[i]/cap);
+            if (score > max_score
+             || (score == max_score && score > 0 && counts[i] < counts[new_loc])) {
+                max_score = score;
+                new_loc = i;
+            }
+        }
+        if (new_loc != UINT64_MAX) {
+            loc_placed[new_loc]++;
+            new_loc += ShardIdIncr;
+        }
+        loc_gen_mtx.unlock();
+
+        if (new_loc == UINT64_MAX) {
+            new_loc = generate_loc();
+        }
+        return new_loc;
+    }
+
+    // node count reported by a shard in its nop ack, includes the nodes placed there so far
+    // caution: need to hold periodic_update_mutex
+    inline void
+    timestamper :: node_count_update(uint64_t shard_idx, uint64_t count)
+    {
+        shard_node_count[shard_idx] = count;
+        loc_gen_mtx.lock();
+        if (shard_idx < loc_placed.size()) {
+            loc_placed[shard_idx] = 0;
+        }
+        loc_gen_mtx.unlock();
+    }
+
     inline void
     timestamper :: enqueue_tx(std::shared_ptr<transaction::pending_tx> tx)
     {
@@ -564,6 +699,13 @@ namespace coordinator
                     this_nop->done_txs = nop->done_txs;
                 }
             }
+        } else if (tx->type == transaction::READ_LEASE) {
+            // lease does not take a qts, it carries qts of last tx sent to shard
+            for (uint64_t i = 0; i < num_shards; i++) {
+                if (tx->shard_write[i]) {
+                    factored_tx[i]->qts = qts[i];
+                }
+            }
         } else {
             // write tx
             for (std::shared_ptr<transaction::pending_update> upd: tx->writes) {
@@ -603,8 +745,9 @@ namespace coordinator
             // tx succeeded, send to shards
             uint64_t num_shards = tx->shard_write.size();
             bool nop = (tx->type == transaction::NOP);
+            bool lease = (tx->type == transaction::READ_LEASE);
 
-            if (!nop) {
+            if (!nop && !lease) {
                 tx_prog_mutex.lock();
                 outstanding_tx.emplace(tx->id, tx);
                 tx_prog_mutex.unlock();
@@ -614,10 +757,25 @@ namespace coordinator
             message::message msg;
             for (uint64_t i = 0; i < num_shards; i++) {
                 if (tx->shard_write[i]) {
-                    msg.prepare_message(message::TX_INIT, vt_id, factored_tx[i]->timestamp, factored_tx[i]->qts, *factored_tx[i]);
+                    if (lease) {
+                        msg.prepare_message(message::VT_READ_LEASE, vt_id, factored_tx[i]->timestamp, factored_tx[i]->qts);
+                    } else {
+                        msg.prepare_message(message::TX_INIT, vt_id, factored_tx[i]->timestamp, factored_tx[i]->qts, *factored_tx[i]);
+                    }
                     comm.send(i+ShardIdIncr, msg.buf);
                 }
             }
+
+            // write advances this vt's clock at the shards as a nop would
+            if (!nop && !lease) {
+                periodic_update_mutex.lock();
+                for (uint64_t i = 0; i < num_shards && i < shard_wrote.size(); i++) {
+                    if (tx->shard_write[i]) {
+                        shard_wrote[i] = true;
+                    }
+                }
+                periodic_update_mutex.unlock();
+            }
         }
     }
 
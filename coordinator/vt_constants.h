@@ -14,8 +14,14 @@
 #ifndef weaver_coordinator_vt_constants_h_
 #define weaver_coordinator_vt_constants_h_
 
-#define VT_TIMEOUT_NANO 1000 // number of nanoseconds between successive nops
-#define VT_CLK_TIMEOUT_NANO 1000 // number of nanoseconds between vt gossip
+#define VT_TIMEOUT_NANO 1000 // min number of nanoseconds between successive nops
+#define VT_CLK_TIMEOUT_NANO 1000 // min number of nanoseconds between vt gossip
+#define VT_MAX_TIMEOUT_NANO 1000000 // nop and gossip intervals double when idle up to this
+#define VT_MAX_NOP_SKIPS 1000 // max consecutive nops skipped for a shard that is getting writes
 #define NUM_VT_THREADS 8
+#define TX_GROUP_WINDOW_NANO 20000 // number of nanoseconds a group commit leader waits for more write txs
+#define TX_GROUP_MAX_TXS 64 // max write txs committed to storage in one transaction
+#define VT_LDG_PLACEMENT 1 // place new nodes near nbrs they get edges to in the same tx, 0 for round robin
+#define VT_PLACEMENT_SLACK 1.1 // LDG capacity of a shard for new nodes, as a multiple of the mean shard size
 
 #endif
@@ -0,0 +1,527 @@
+/*
+ * ===============================================================
+ *    Description:  Shard side of bulk synchronous analytics jobs.
+ *
+ *        Created:  2026-10-19 16:19:12
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include <algorithm>
+
+#include "common/weaver_constants.h"
+#include "common/config_constants.h"
+#include "node_prog/edge_list.h"
+#include "db/shard.h"
+#include "db/bsp_engine.h"
+
+using db::bsp_engine;
+using db::bsp_job;
+using db::bsp_vertex;
+using db::bsp_inbox;
+using db::bsp_parts;
+
+// messages sent by one superstep thread, combined per destination node
+struct bsp_outbox
+{
+    // per destination shard index
+    std::vector<std::unordered_map<node_handle_t, double>> sums;
+    std::vector<std::unordered_map<node_handle_t, node_handle_t>> labels;
+    std::vector<std::vector<std::pair<node_handle_t, db::remote_node>>> in_nbrs;
+    uint64_t active;
+    double dangling;
+
+    bsp_outbox(uint64_t num_shards)
+        : sums(num_shards)
+        , labels(num_shards)
+        , in_nbrs(num_shards)
+        , active(0)
+        , dangling(0)
+    { }
+
+    void add_sum(const db::remote_node &to, double val)
+    {
+        sums[to.loc - ShardIdIncr][to.handle] += val;
+    }
+
+    void add_label(const db::remote_node &to, const node_handle_t &label)
+    {
+        auto &shard_labels = labels[to.loc - ShardIdIncr];
+        auto iter = shard_labels.find(to.handle);
+        if (iter == shard_labels.end()) {
+            shard_labels.emplace(to.handle, label);
+        } else if (label < iter->second) {
+            iter->second = label;
+        }
+    }
+
+    // combine other into this
+    void merge(bsp_outbox &other)
+    {
+        for (uint64_t i = 0; i < sums.size(); i++) {
+            for (auto &p: other.sums[i]) {
+                sums[i][p.first] += p.second;
+            }
+            for (auto &p: other.labels[i]) {
+                db::remote_node to(i + ShardIdIncr, p.first);
+                add_label(to, p.second);
+            }
+            in_nbrs[i].insert(in_nbrs[i].end(), other.in_nbrs[i].begin(), other.in_nbrs[i].end());
+        }
+        active += other.active;
+        dangling += other.dangling;
+    }
+};
+
+bsp_engine :: bsp_engine()
+    : pool_cond(&pool_mtx)
+{ }
+
+// workers are started with the first task and never exit, like the shard recv threads
+void
+bsp_engine :: enqueue(std::function<void(order::oracle*)> task)
+{
+    pool_mtx.lock();
+    if (workers.empty()) {
+        for (uint64_t tid = 0; tid < NUM_SHARD_THREADS; tid++) {
+            oracles.emplace_back(new order::oracle());
+        }
+        for (uint64_t tid = 0; tid < NUM_SHARD_THREADS; tid++) {
+            workers.emplace_back(new std::thread(&bsp_engine::worker_loop, this, tid));
+        }
+    }
+    tasks.emplace_back(std::move(task));
+    pool_cond.signal();
+    pool_mtx.unlock();
+}
+
+void
+bsp_engine :: worker_loop(uint64_t tid)
+{
+    pool_mtx.lock();
+    order::oracle *time_oracle = oracles[tid];
+    pool_mtx.unlock();
+
+    while (true) {
+        pool_mtx.lock();
+        while (tasks.empty()) {
+            pool_cond.wait();
+        }
+        std::function<void(order::oracle*)> task = std::move(tasks.front());
+        tasks.pop_front();
+        pool_mtx.unlock();
+
+        task(time_oracle);
+    }
+}
+
+void
+bsp_engine :: run_parts(bsp_parts &parts, order::oracle *time_oracle)
+{
+    uint64_t part;
+    while ((part = parts.next++) < parts.num_parts) {
+        parts.func(part, time_oracle);
+        if (++parts.done == parts.num_parts) {
+            parts.mtx.lock();
+            parts.done_cond.broadcast();
+            parts.mtx.unlock();
+        }
+    }
+}
+
+// caller is a worker, and does every part itself if the other workers are busy
+void
+bsp_engine :: parallel_for(uint64_t num_parts,
+    std::function<void(uint64_t, order::oracle*)> func,
+    order::oracle *time_oracle)
+{
+    std::shared_ptr<bsp_parts> parts = std::make_shared<bsp_parts>();
+    parts->func = std::move(func);
+    parts->num_parts = num_parts;
+
+    for (uint64_t i = 1; i < num_parts; i++) {
+        // helpers that start after all parts are taken return at once
+        enqueue([parts](order::oracle *helper_oracle) { run_parts(*parts, helper_oracle); });
+    }
+    run_parts(*parts, time_oracle);
+
+    parts->mtx.lock();
+    while (parts->done < num_parts) {
+        parts->done_cond.wait();
+    }
+    parts->mtx.unlock();
+}
+
+bsp_job*
+bsp_engine :: get_job(uint64_t req_id)
+{
+    auto iter = jobs.find(req_id);
+    if (iter == jobs.end()) {
+        bsp_job *job = new bsp_job();
+        jobs.emplace(req_id, job);
+        return job;
+    } else {
+        return iter->second;
+    }
+}
+
+void
+bsp_engine :: superstep(shard *S, std::unique_ptr<message::message> msg)
+{
+    uint64_t vt_id, req_id, step, expected, num_nodes;
+    vc::vclock vclk;
+    bsp::params params;
+    bool final_step;
+    double dangling;
+    msg->unpack_message(message::BSP_SUPERSTEP, vt_id, vclk, req_id, params, step, final_step, expected, num_nodes, dangling);
+
+    mtx.lock();
+    bsp_job *job = get_job(req_id);
+    job->params = params;
+    job->vt_id = vt_id;
+    if (!job->vclk) {
+        job->vclk.reset(new vc::vclock(vclk));
+    }
+    job->waiting = true;
+    job->wait_step = step;
+    job->wait_batches = expected;
+    job->num_nodes = num_nodes;
+    job->dangling = dangling;
+    job->final_step = final_step;
+    mtx.unlock();
+
+    try_run(S, req_id, job);
+}
+
+void
+bsp_engine :: add_msgs(shard *S, std::unique_ptr<message::message> msg)
+{
+    uint64_t req_id, step;
+    bsp_inbox batch;
+    msg->unpack_message(message::BSP_MSGS, req_id, step, batch.sums, batch.labels, batch.in_nbrs);
+
+    mtx.lock();
+    bsp_job *job = get_job(req_id);
+    bsp_inbox &inbox = job->inboxes[step];
+    inbox.sums.insert(inbox.sums.end(), batch.sums.begin(), batch.sums.end());
+    inbox.labels.insert(inbox.labels.end(), batch.labels.begin(), batch.labels.end());
+    inbox.in_nbrs.insert(inbox.in_nbrs.end(), batch.in_nbrs.begin(), batch.in_nbrs.end());
+    inbox.batches++;
+    mtx.unlock();
+
+    try_run(S, req_id, job);
+}
+
+// queue the waiting superstep on the workers if all its messages are in, only one caller gets to run it
+void
+bsp_engine :: try_run(shard *S, uint64_t req_id, bsp_job *job)
+{
+    mtx.lock();
+    if (!job->waiting || job->inboxes[job->wait_step].batches < job->wait_batches) {
+        mtx.unlock();
+        return;
+    }
+    job->waiting = false;
+    uint64_t step = job->wait_step;
+    std::shared_ptr<bsp_inbox> inbox = std::make_shared<bsp_inbox>(std::move(job->inboxes[step]));
+    job->inboxes.erase(step);
+    mtx.unlock();
+
+    enqueue([this, S, req_id, job, step, inbox](order::oracle *time_oracle) {
+        run_claimed(S, req_id, job, step, *inbox, time_oracle);
+    });
+}
+
+void
+bsp_engine :: run_claimed(shard *S, uint64_t req_id, bsp_job *job, uint64_t step, bsp_inbox &inbox, order::oracle *time_oracle)
+{
+    if (!job->loaded) {
+        load_vertices(S, *job, time_oracle);
+    }
+    apply_inbox(*job, inbox);
+
+    if (job->final_step) {
+        finish(S, req_id, *job, step);
+        mtx.lock();
+        jobs.erase(req_id);
+        mtx.unlock();
+        delete job;
+    } else {
+        run_step(S, req_id, *job, step, time_oracle);
+    }
+}
+
+// nodes and out edges of this shard at the job snapshot, read in parallel by stripe
+void
+bsp_engine :: load_vertices(shard *S, bsp_job &job, order::oracle *caller_oracle)
+{
+    uint64_t num_threads = NUM_SHARD_THREADS;
+    std::vector<std::vector<bsp_vertex>> parts(num_threads);
+    auto load_stripes = [&](uint64_t tid, order::oracle *time_oracle) {
+        std::vector<node_handle_t> handles;
+        for (uint64_t stripe = tid; stripe < NUM_NODE_MAPS; stripe += num_threads) {
+            handles.clear();
+            S->nodes.mutex(stripe).lock();
+            S->nodes.for_each(stripe, [&](const db::node_directory::versions &vers) {
+                handles.emplace_back(vers.first->get_handle());
+            });
+            S->nodes.mutex(stripe).unlock();
+
+            for (const node_handle_t &h: handles) {
+                db::node *n = S->acquire_node_version_shared(h, *job.vclk, time_oracle);
+                if (n == nullptr) {
+                    continue;
+                }
+                // node that is migrating out is counted at its new shard
+                if (n->state == db::node::mode::STABLE) {
+                    parts[tid].emplace_back(bsp_vertex());
+                    bsp_vertex &v = parts[tid].back();
+                    v.handle = h;
+                    v.value = 0;
+                    node_prog::edge_list edges(n->out_edges, job.vclk, time_oracle);
+                    for (node_prog::edge &e: edges) {
+                        v.out_nbrs.emplace_back(e.get_neighbor());
+                    }
+                }
+                S->release_node_shared(n);
+            }
+        }
+    };
+
+    parallel_for(num_threads, load_stripes, caller_oracle);
+
+    for (std::vector<bsp_vertex> &part: parts) {
+        for (bsp_vertex &v: part) {
+            job.index.emplace(v.handle, job.vertices.size());
+            job.vertices.emplace_back(std::move(v));
+        }
+    }
+    job.loaded = true;
+}
+
+void
+bsp_engine :: apply_inbox(bsp_job &job, bsp_inbox &inbox)
+{
+    for (bsp_vertex &v: job.vertices) {
+        v.in_sum = 0;
+        v.got_label = false;
+    }
+
+    // messages for nodes not here at the snapshot are dropped
+    for (auto &p: inbox.sums) {
+        auto iter = job.index.find(p.first);
+        if (iter != job.index.end()) {
+            job.vertices[iter->second].in_sum += p.second;
+        }
+    }
+    for (auto &p: inbox.labels) {
+        auto iter = job.index.find(p.first);
+        if (iter != job.index.end()) {
+            bsp_vertex &v = job.vertices[iter->second];
+            if (!v.got_label || p.second < v.in_label) {
+                v.in_label = p.second;
+                v.got_label = true;
+            }
+        }
+    }
+    for (auto &p: inbox.in_nbrs) {
+        auto iter = job.index.find(p.first);
+        if (iter != job.index.end()) {
+            job.vertices[iter->second].in_nbrs.emplace_back(p.second);
+        }
+    }
+}
+
+static void
+compute_vertex(bsp_job &job, bsp_vertex &v, uint64_t step, uint64_t shard_id, bsp_outbox &out)
+{
+    switch (job.params.algo) {
+        case bsp::PAGERANK: {
+            // superstep 0 counts nodes, 1 sets initial ranks, each later one is an iteration
+            if (step == 0 || job.num_nodes == 0) {
+                break;
+            }
+            double n = job.num_nodes;
+            double d = job.params.damping;
+            if (step == 1) {
+                v.value = 1.0 / n;
+            } else {
+                v.value = (1.0 - d) / n + d * (v.in_sum + job.dangling / n);
+            }
+            // the final superstep computes ranks without sending
+            if (step == 1 || step <= job.params.max_supersteps) {
+                if (v.out_nbrs.empty()) {
+                    out.dangling += v.value;
+                } else {
+                    double share = v.value / v.out_nbrs.size();
+                    for (const db::remote_node &nbr: v.out_nbrs) {
+                        out.add_sum(nbr, share);
+                    }
+                }
+                out.active++;
+            }
+            break;
+        }
+
+        case bsp::CONNECTED_COMPONENTS:
+            // superstep 0 tells out neighbors about their in edges,
+            // then smallest node handle spreads along edges in both directions
+            if (step == 0) {
+                db::remote_node self(shard_id, v.handle);
+                for (const db::remote_node &nbr: v.out_nbrs) {
+                    out.in_nbrs[nbr.loc - ShardIdIncr].emplace_back(nbr.handle, self);
+                }
+            } else if (step == 1 || (v.got_label && v.in_label < v.label)) {
+                v.label = (step == 1)? v.handle : v.in_label;
+                for (const db::remote_node &nbr: v.out_nbrs) {
+                    out.add_label(nbr, v.label);
+                }
+                for (const db::remote_node &nbr: v.in_nbrs) {
+                    out.add_label(nbr, v.label);
+                }
+                out.active++;
+            }
+            break;
+
+        case bsp::DEGREE_DISTRIBUTION:
+            if (step == 0) {
+                for (const db::remote_node &nbr: v.out_nbrs) {
+                    out.add_sum(nbr, 1);
+                }
+            } else {
+                v.value = v.in_sum;
+            }
+            break;
+
+        default:
+            WDEBUG << "unknown bsp algorithm " << job.params.algo << std::endl;
+    }
+}
+
+void
+bsp_engine :: run_step(shard *S, uint64_t req_id, bsp_job &job, uint64_t step, order::oracle *time_oracle)
+{
+    uint64_t num_shards = get_num_shards();
+    uint64_t num_threads = NUM_SHARD_THREADS;
+    uint64_t num_vertices = job.vertices.size();
+    uint64_t chunk = (num_vertices + num_threads - 1) / num_threads;
+
+    std::vector<bsp_outbox> outboxes(num_threads, bsp_outbox(num_shards));
+    auto compute_range = [&](uint64_t tid, order::oracle*) {
+        uint64_t end = std::min(num_vertices, (tid+1) * chunk);
+        for (uint64_t i = tid * chunk; i < end; i++) {
+            compute_vertex(job, job.vertices[i], step, S->shard_id, outboxes[tid]);
+        }
+    };
+    parallel_for(num_threads, compute_range, time_oracle);
+    for (uint64_t tid = 1; tid < num_threads; tid++) {
+        outboxes[0].merge(outboxes[tid]);
+    }
+    bsp_outbox &out = outboxes[0];
+
+    // one message per destination shard, split if large
+    std::vector<uint64_t> sent(num_shards, 0);
+    message::message msg;
+    uint64_t my_idx = S->shard_id - ShardIdIncr;
+    for (uint64_t i = 0; i < num_shards; i++) {
+        bsp_inbox batch;
+        auto flush = [&](bool last) {
+            uint64_t entries = batch.sums.size() + batch.labels.size() + batch.in_nbrs.size();
+            if (entries == 0 || (!last && entries < BSP_BATCH_ENTRIES)) {
+                return;
+            }
+            if (i == my_idx) {
+                mtx.lock();
+                bsp_inbox &inbox = job.inboxes[step+1];
+                inbox.sums.insert(inbox.sums.end(), batch.sums.begin(), batch.sums.end());
+                inbox.labels.insert(inbox.labels.end(), batch.labels.begin(), batch.labels.end());
+                inbox.in_nbrs.insert(inbox.in_nbrs.end(), batch.in_nbrs.begin(), batch.in_nbrs.end());
+                mtx.unlock();
+            } else {
+                msg.prepare_message(message::BSP_MSGS, req_id, step+1, batch.sums, batch.labels, batch.in_nbrs);
+                S->comm.send(i + ShardIdIncr, msg.buf);
+                sent[i]++;
+            }
+            batch.sums.clear();
+            batch.labels.clear();
+            batch.in_nbrs.clear();
+        };
+
+        for (auto &p: out.sums[i]) {
+            batch.sums.emplace_back(p.first, p.second);
+            flush(false);
+        }
+        for (auto &p: out.labels[i]) {
+            batch.labels.emplace_back(p.first, p.second);
+            flush(false);
+        }
+        for (auto &p: out.in_nbrs[i]) {
+            batch.in_nbrs.emplace_back(p);
+            flush(false);
+        }
+        flush(true);
+    }
+
+    bsp::result empty;
+    msg.prepare_message(message::BSP_STEP_DONE, req_id, S->shard_id, step, sent, num_vertices, out.active, out.dangling, empty);
+    S->comm.send(job.vt_id, msg.buf);
+}
+
+// partial results of this shard, merged at the timestamper
+void
+bsp_engine :: finish(shard *S, uint64_t req_id, bsp_job &job, uint64_t step)
+{
+    bsp::result res;
+    res.supersteps = step;
+    res.num_nodes = job.vertices.size();
+
+    switch (job.params.algo) {
+        case bsp::PAGERANK: {
+            bsp_outbox unused(0);
+            for (bsp_vertex &v: job.vertices) {
+                compute_vertex(job, v, step, S->shard_id, unused);
+                res.top.emplace_back(v.handle, v.value);
+            }
+            uint64_t k = std::min((uint64_t)job.params.top_k, (uint64_t)res.top.size());
+            std::partial_sort(res.top.begin(), res.top.begin() + k, res.top.end(),
+                [](const std::pair<node_handle_t, double> &a, const std::pair<node_handle_t, double> &b) {
+                    return a.second > b.second;
+                });
+            res.top.resize(k);
+            break;
+        }
+
+        case bsp::CONNECTED_COMPONENTS: {
+            // every component with its node count here, as (label, count)
+            std::unordered_map<node_handle_t, uint64_t> sizes;
+            for (const bsp_vertex &v: job.vertices) {
+                sizes[v.label]++;
+            }
+            for (auto &p: sizes) {
+                res.top.emplace_back(p.first, p.second);
+            }
+            break;
+        }
+
+        case bsp::DEGREE_DISTRIBUTION: {
+            std::map<uint64_t, uint64_t> out_deg, in_deg;
+            for (const bsp_vertex &v: job.vertices) {
+                out_deg[v.out_nbrs.size()]++;
+                in_deg[(uint64_t)v.value]++;
+            }
+            res.histogram.assign(out_deg.begin(), out_deg.end());
+            res.in_histogram.assign(in_deg.begin(), in_deg.end());
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    message::message msg;
+    std::vector<uint64_t> sent;
+    msg.prepare_message(message::BSP_STEP_DONE, req_id, S->shard_id, step, sent, res.num_nodes, (uint64_t)0, 0.0, res);
+    S->comm.send(job.vt_id, msg.buf);
+}
@@ -0,0 +1,139 @@
+/*
+ * ===============================================================
+ *    Description:  Shard side of bulk synchronous analytics jobs.
+ *                  Runs each superstep over all nodes of the shard
+ *                  at the job snapshot, and combines messages to
+ *                  other shards.
+ *
+ *        Created:  2026-10-19 16:19:12
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_db_bsp_engine_h_
+#define weaver_db_bsp_engine_h_
+
+#include <map>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <po6/threads/mutex.h>
+#include <po6/threads/cond.h>
+
+#include "common/bsp.h"
+#include "common/vclock.h"
+#include "common/message.h"
+#include "common/event_order.h"
+#include "db/remote_node.h"
+
+// entries per BSP_MSGS message, larger batches are split
+#define BSP_BATCH_ENTRIES (1 << 16)
+
+namespace db
+{
+    class shard;
+
+    struct bsp_vertex
+    {
+        node_handle_t handle;
+        std::vector<remote_node> out_nbrs; // at the job snapshot
+        std::vector<remote_node> in_nbrs; // connected components only
+        double value; // rank, or in degree
+        node_handle_t label; // connected components
+        double in_sum; // combined messages of this superstep
+        node_handle_t in_label;
+        bool got_label;
+    };
+
+    // messages for one superstep, as received
+    struct bsp_inbox
+    {
+        uint64_t batches; // BSP_MSGS from other shards
+        std::vector<std::pair<node_handle_t, double>> sums;
+        std::vector<std::pair<node_handle_t, node_handle_t>> labels;
+        std::vector<std::pair<node_handle_t, remote_node>> in_nbrs;
+
+        bsp_inbox() : batches(0) { }
+    };
+
+    struct bsp_job
+    {
+        bsp::params params;
+        uint64_t vt_id;
+        std::shared_ptr<vc::vclock> vclk;
+        bool loaded; // vertices read from snapshot
+        std::vector<bsp_vertex> vertices;
+        std::unordered_map<node_handle_t, uint64_t> index; // handle -> position in vertices
+        std::map<uint64_t, bsp_inbox> inboxes; // superstep -> messages
+
+        // superstep that waits for messages from other shards
+        bool waiting;
+        uint64_t wait_step, wait_batches, num_nodes;
+        double dangling;
+        bool final_step;
+
+        bsp_job() : loaded(false), waiting(false) { }
+    };
+
+    // parts of one parallel loop, run by the thread that started it and any idle workers
+    struct bsp_parts
+    {
+        std::function<void(uint64_t part, order::oracle *time_oracle)> func;
+        uint64_t num_parts;
+        std::atomic<uint64_t> next, done;
+        po6::threads::mutex mtx;
+        po6::threads::cond done_cond;
+
+        bsp_parts() : num_parts(0), next(0), done(0), done_cond(&mtx) { }
+    };
+
+    // Each superstep starts when the timestamper has heard from all shards about the
+    // previous one.  The timestamper tells each shard how many message batches to
+    // expect for the superstep, and the shard runs it once they have all arrived.
+    //
+    // Supersteps run on a pool of NUM_SHARD_THREADS worker threads that lives as
+    // long as the shard, so the recv threads only queue them.  A superstep splits
+    // its loops into parts, works on them itself and lets idle workers help, so
+    // concurrent jobs cannot deadlock waiting for each other's workers.
+    class bsp_engine
+    {
+        private:
+            po6::threads::mutex mtx;
+            std::unordered_map<uint64_t, bsp_job*> jobs; // req id -> job
+
+            po6::threads::mutex pool_mtx;
+            po6::threads::cond pool_cond;
+            std::deque<std::function<void(order::oracle*)>> tasks;
+            std::vector<std::thread*> workers;
+            std::vector<order::oracle*> oracles; // one per worker
+
+            bsp_job* get_job(uint64_t req_id);
+            void try_run(shard *S, uint64_t req_id, bsp_job *job);
+            void run_claimed(shard *S, uint64_t req_id, bsp_job *job, uint64_t step, bsp_inbox &inbox, order::oracle *time_oracle);
+            void load_vertices(shard *S, bsp_job &job, order::oracle *time_oracle);
+            void apply_inbox(bsp_job &job, bsp_inbox &inbox);
+            void run_step(shard *S, uint64_t req_id, bsp_job &job, uint64_t step, order::oracle *time_oracle);
+            void finish(shard *S, uint64_t req_id, bsp_job &job, uint64_t step);
+
+            void enqueue(std::function<void(order::oracle*)> task);
+            void worker_loop(uint64_t tid);
+            static void run_parts(bsp_parts &parts, order::oracle *time_oracle);
+            // func(part, oracle) for every part in [0, num_parts), returns when all are done
+            void parallel_for(uint64_t num_parts,
+                std::function<void(uint64_t, order::oracle*)> func,
+                order::oracle *time_oracle);
+
+        public:
+            bsp_engine();
+            // BSP_SUPERSTEP from timestamper, after the job snapshot is readable
+            void superstep(shard *S, std::unique_ptr<message::message> msg);
+            // BSP_MSGS from another shard
+            void add_msgs(shard *S, std::unique_ptr<message::message> msg);
+    };
+}
+
+#endif
@@ -24,15 +24,20 @@ namespace db
         std::shared_ptr<node_prog::Cache_Value_Base> val;
         std::shared_ptr<vc::vclock> clk;
         std::shared_ptr<std::vector<db::remote_node>> watch_set;
+        uint64_t slot; // in the shard cache_manager, UINT64_MAX if not tracked
+        bool referenced; // hit since the clock hand last passed
 
-        cache_entry() { }
+        cache_entry() : slot(UINT64_MAX), referenced(false) { }
 
         cache_entry(std::shared_ptr<node_prog::Cache_Value_Base> v,
             std::shared_ptr<vc::vclock> c,
-            std::shared_ptr<std::vector<db::remote_node>> ws)
+            std::shared_ptr<std::vector<db::remote_node>> ws,
+            uint64_t s=UINT64_MAX)
             : val(v)
             , clk(c)
             , watch_set(ws)
+            , slot(s)
+            , referenced(false)
         { }
     };
 }
@@ -0,0 +1,348 @@
+/*
+ * ===============================================================
+ *    Description:  Shard wide node program cache budget.
+ *
+ *        Created:  2026-10-19 16:22:05
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include <functional>
+
+#include "common/weaver_constants.h"
+#include "common/cache_constants.h"
+#include "db/node.h"
+#include "db/cache_manager.h"
+
+using db::frequency_sketch;
+using db::cache_manager;
+
+#define SKETCH_MAX_COUNT 15
+#define SKETCH_MIN_WIDTH (1 << 10)
+#define SKETCH_MAX_WIDTH (1 << 22)
+#define SKETCH_BYTES_PER_COUNTER 256 // one sketch column per this many bytes of budget
+
+frequency_sketch :: frequency_sketch(uint64_t width)
+    : width_mask(width-1)
+    , counters(new std::atomic<uint8_t>[rows * width])
+    , additions(0)
+    , reset_at(10 * width)
+    , aging(false)
+{
+    assert((width & width_mask) == 0);
+    for (uint64_t i = 0; i < rows * width; i++) {
+        counters[i] = 0;
+    }
+}
+
+uint64_t
+frequency_sketch :: index(uint64_t hash, uint32_t row) const
+{
+    // different odd multiplier per row
+    uint64_t h = (hash + row) * (0x9e3779b97f4a7c15ULL + 2*row);
+    h ^= h >> 32;
+    return row * (width_mask+1) + (h & width_mask);
+}
+
+void
+frequency_sketch :: increment(uint64_t hash)
+{
+    for (uint32_t r = 0; r < rows; r++) {
+        std::atomic<uint8_t> &c = counters[index(hash, r)];
+        uint8_t val = c.load(std::memory_order_relaxed);
+        if (val < SKETCH_MAX_COUNT) {
+            // lost increments under contention are fine, counts are approximate
+            c.store(val+1, std::memory_order_relaxed);
+        }
+    }
+
+    if (++additions >= reset_at) {
+        bool expected = false;
+        if (aging.compare_exchange_strong(expected, true)) {
+            age();
+            additions = 0;
+            aging = false;
+        }
+    }
+}
+
+uint32_t
+frequency_sketch :: estimate(uint64_t hash) const
+{
+    uint32_t min = SKETCH_MAX_COUNT;
+    for (uint32_t r = 0; r < rows; r++) {
+        uint32_t val = counters[index(hash, r)].load(std::memory_order_relaxed);
+        if (val < min) {
+            min = val;
+        }
+    }
+    return min;
+}
+
+void
+frequency_sketch :: age()
+{
+    for (uint64_t i = 0; i < rows * (width_mask+1); i++) {
+        counters[i].store(counters[i].load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+    }
+}
+
+
+cache_manager :: cache_manager()
+    : budget(0)
+    , used(0)
+    , hand(0)
+{ }
+
+void
+cache_manager :: init(uint64_t budget_bytes)
+{
+    budget = budget_bytes;
+    if (budget > 0) {
+        uint64_t width = SKETCH_MIN_WIDTH;
+        while (width < SKETCH_MAX_WIDTH && width * SKETCH_BYTES_PER_COUNTER < budget) {
+            width <<= 1;
+        }
+        sketch.reset(new frequency_sketch(width));
+    }
+}
+
+uint64_t
+cache_manager :: entry_hash(const node_handle_t &handle, const cache_key_t &key)
+{
+    std::hash<std::string> hasher;
+    return hasher(handle) * 31 + hasher(key);
+}
+
+// memory held by one entry, the clock is shared with the rest of the request and not counted
+uint64_t
+cache_manager :: entry_bytes(const cache_key_t &key,
+    const node_prog::Cache_Value_Base &val,
+    const std::vector<remote_node> &watch_set)
+{
+    uint64_t bytes = sizeof(cache_entry) + sizeof(cache_slot) + 2*key.size() + val.size()
+                   + watch_set.capacity() * sizeof(remote_node);
+    for (const remote_node &rn: watch_set) {
+        bytes += rn.handle.size();
+    }
+    return bytes;
+}
+
+uint64_t
+cache_manager :: alloc_slot(node *n, const cache_key_t &key, uint64_t bytes, uint64_t hash, node_prog::prog_type type)
+{
+    uint64_t s;
+    if (free_slots.empty()) {
+        s = slots.size();
+        slots.emplace_back(cache_slot());
+    } else {
+        s = free_slots.back();
+        free_slots.pop_back();
+    }
+
+    cache_slot &slot = slots[s];
+    slot.n = n;
+    slot.key = key;
+    slot.bytes = bytes;
+    slot.hash = hash;
+    slot.type = type;
+    used += bytes;
+    node_slots[n].emplace_back(s);
+    return s;
+}
+
+void
+cache_manager :: free_slot(uint64_t s)
+{
+    cache_slot &slot = slots[s];
+    assert(slot.n != nullptr);
+    auto iter = node_slots.find(slot.n);
+    assert(iter != node_slots.end());
+    std::vector<uint64_t> &held = iter->second;
+    for (uint64_t i = 0; i < held.size(); i++) {
+        if (held[i] == s) {
+            held[i] = held.back();
+            held.pop_back();
+            break;
+        }
+    }
+    if (held.empty()) {
+        node_slots.erase(iter);
+    }
+    used -= slot.bytes;
+    slot.n = nullptr;
+    slot.key.clear();
+    free_slots.emplace_back(s);
+}
+
+// evict until bytes fit in the budget, returns false if the new entry is colder than the first victim
+// caution: need to hold mtx
+bool
+cache_manager :: make_room(uint64_t bytes, uint64_t hash, node_prog::prog_type type, dropped_list_t &dropped)
+{
+    bool admitted = false;
+    while (used + bytes > budget) {
+        assert(!slots.empty());
+        uint64_t s = hand;
+        hand = (hand+1) % slots.size();
+        cache_slot &slot = slots[s];
+        if (slot.n == nullptr) {
+            continue;
+        }
+
+        node *n = slot.n;
+        n->prog_mtx.lock();
+        auto iter = n->cache.find(slot.key);
+        if (iter == n->cache.end() || iter->second.slot != s) {
+            // replaced or invalidated since it was added
+            if (iter == n->cache.end()) {
+                dropped.emplace_back(n->get_handle(), slot.key);
+            }
+            n->prog_mtx.unlock();
+            free_slot(s);
+            continue;
+        }
+
+        if (iter->second.referenced) {
+            iter->second.referenced = false;
+            n->prog_mtx.unlock();
+            continue;
+        }
+
+        if (!admitted) {
+            if (sketch->estimate(hash) < sketch->estimate(slot.hash)) {
+                n->prog_mtx.unlock();
+                stats[type].rejections++;
+                return false;
+            }
+            admitted = true;
+        }
+
+        n->cache.erase(iter);
+        n->prog_mtx.unlock();
+        dropped.emplace_back(n->get_handle(), slot.key);
+        stats[slot.type].evictions++;
+        free_slot(s);
+    }
+
+    return true;
+}
+
+bool
+cache_manager :: add(node *n, node_prog::prog_type type, std::shared_ptr<vc::vclock> vclk,
+    std::shared_ptr<node_prog::Cache_Value_Base> val,
+    std::shared_ptr<std::vector<remote_node>> watch_set,
+    cache_key_t key,
+    dropped_list_t &dropped)
+{
+    std::vector<std::pair<cache_key_t, uint64_t>> node_dropped;
+    if (budget == 0) {
+        bool added = n->add_cache_value(vclk, val, watch_set, key, UINT64_MAX, &node_dropped);
+        for (auto &d: node_dropped) {
+            dropped.emplace_back(n->get_handle(), d.first);
+        }
+        if (added) {
+            stats[type].inserts++;
+        }
+        return added;
+    }
+
+    watch_set->shrink_to_fit();
+    uint64_t bytes = entry_bytes(key, *val, *watch_set);
+    uint64_t hash = entry_hash(n->get_handle(), key);
+
+    bool added = false;
+    mtx.lock();
+    if (n->permanently_deleted || bytes > budget) {
+        mtx.unlock();
+        return false;
+    }
+
+    if (make_room(bytes, hash, type, dropped)) {
+        // entry goes into the node under mtx, so the hand never sees the slot without it
+        uint64_t s = alloc_slot(n, key, bytes, hash, type);
+        if (n->add_cache_value(vclk, val, watch_set, key, s, &node_dropped)) {
+            stats[type].inserts++;
+            added = true;
+        } else {
+            free_slot(s);
+        }
+        for (auto &d: node_dropped) {
+            if (d.second < slots.size() && slots[d.second].n == n) {
+                free_slot(d.second);
+            }
+            dropped.emplace_back(n->get_handle(), d.first);
+        }
+    }
+    mtx.unlock();
+
+    return added;
+}
+
+void
+cache_manager :: record_lookup(const node_handle_t &handle, node_prog::prog_type type, const cache_key_t &key, bool hit)
+{
+    if (hit) {
+        stats[type].hits++;
+    } else {
+        stats[type].misses++;
+    }
+    if (sketch) {
+        sketch->increment(entry_hash(handle, key));
+    }
+}
+
+// also frees slots of entries the node dropped without the manager, such as
+// invalidated ones, so the hand never reaches a freed node
+void
+cache_manager :: remove_node(node *n)
+{
+    if (budget == 0) {
+        return;
+    }
+
+    mtx.lock();
+    auto iter = node_slots.find(n);
+    if (iter != node_slots.end()) {
+        std::vector<uint64_t> held = std::move(iter->second);
+        node_slots.erase(iter);
+        for (uint64_t s: held) {
+            cache_slot &slot = slots[s];
+            assert(slot.n == n);
+            used -= slot.bytes;
+            slot.n = nullptr;
+            slot.key.clear();
+            free_slots.emplace_back(s);
+        }
+    }
+    mtx.unlock();
+}
+
+void
+cache_manager :: dump_stats()
+{
+    mtx.lock();
+    WDEBUG << "node prog cache using " << used << " of " << budget << " bytes, "
+           << (slots.size() - free_slots.size()) << " tracked entries" << std::endl;
+    mtx.unlock();
+
+    for (int t = 0; t < node_prog::END; t++) {
+        cache_stats &st = stats[t];
+        if (st.hits + st.misses + st.inserts == 0) {
+            continue;
+        }
+        WDEBUG << "prog type " << t
+               << ": hits " << st.hits
+               << ", misses " << st.misses
+               << ", inserts " << st.inserts
+               << ", evictions " << st.evictions
+               << ", rejections " << st.rejections << std::endl;
+    }
+}
+
+#undef SKETCH_MAX_COUNT
+#undef SKETCH_MIN_WIDTH
+#undef SKETCH_MAX_WIDTH
+#undef SKETCH_BYTES_PER_COUNTER
@@ -0,0 +1,120 @@
+/*
+ * ===============================================================
+ *    Description:  Shard wide memory budget for node program cache
+ *                  entries, with CLOCK eviction across nodes and
+ *                  frequency based admission.
+ *
+ *        Created:  2026-10-19 16:22:05
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_db_cache_manager_h_
+#define weaver_db_cache_manager_h_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <po6/threads/mutex.h>
+
+#include "common/types.h"
+#include "common/vclock.h"
+#include "node_prog/base_classes.h"
+#include "node_prog/node_prog_type.h"
+#include "db/remote_node.h"
+
+namespace db
+{
+    class node;
+
+    // approximate access counts of (node, cache key) pairs, halved periodically so old popularity fades
+    class frequency_sketch
+    {
+        private:
+            static const uint32_t rows = 4;
+            uint64_t width_mask;
+            std::unique_ptr<std::atomic<uint8_t>[]> counters;
+            std::atomic<uint64_t> additions;
+            uint64_t reset_at;
+            std::atomic<bool> aging;
+
+            uint64_t index(uint64_t hash, uint32_t row) const;
+            void age();
+
+        public:
+            frequency_sketch(uint64_t width);
+            void increment(uint64_t hash);
+            uint32_t estimate(uint64_t hash) const;
+    };
+
+    struct cache_stats
+    {
+        std::atomic<uint64_t> hits, misses, inserts, evictions, rejections;
+
+        cache_stats() : hits(0), misses(0), inserts(0), evictions(0), rejections(0) { }
+    };
+
+    // Entries stay in the node cache maps, the manager keeps a ring of
+    // references to them for the CLOCK hand.  A hit sets the referenced bit
+    // of the entry, and the hand clears it or evicts the entry.  When a new
+    // entry would evict one that was accessed more often, it is not cached.
+    // Entries removed from a node by other means are reclaimed when the hand
+    // passes them, or when the node is freed.
+    // Lock order is the manager mutex, then the node prog_mtx.
+    class cache_manager
+    {
+        public:
+            // node handle and key of entries no longer cached
+            typedef std::vector<std::pair<node_handle_t, cache_key_t>> dropped_list_t;
+
+        private:
+            struct cache_slot
+            {
+                node *n; // nullptr if free
+                cache_key_t key;
+                uint64_t bytes;
+                uint64_t hash;
+                node_prog::prog_type type;
+            };
+
+            uint64_t budget; // bytes, 0 for no limit
+            uint64_t used;
+            po6::threads::mutex mtx;
+            std::vector<cache_slot> slots;
+            std::vector<uint64_t> free_slots;
+            // every slot held by a node, including slots of entries it no longer has,
+            // so none outlive the node
+            std::unordered_map<node*, std::vector<uint64_t>> node_slots;
+            uint64_t hand;
+            std::unique_ptr<frequency_sketch> sketch;
+            cache_stats stats[node_prog::END];
+
+            static uint64_t entry_hash(const node_handle_t &handle, const cache_key_t &key);
+            static uint64_t entry_bytes(const cache_key_t &key,
+                const node_prog::Cache_Value_Base &val,
+                const std::vector<remote_node> &watch_set);
+            uint64_t alloc_slot(node *n, const cache_key_t &key, uint64_t bytes, uint64_t hash, node_prog::prog_type type);
+            void free_slot(uint64_t s);
+            bool make_room(uint64_t bytes, uint64_t hash, node_prog::prog_type type, dropped_list_t &dropped);
+
+        public:
+            cache_manager();
+            void init(uint64_t budget_bytes);
+
+            // add_cache_func of node programs, returns true if the value was stored
+            // entries it replaces or evicts, on any node, are appended to dropped
+            bool add(node *n, node_prog::prog_type type, std::shared_ptr<vc::vclock> vclk,
+                std::shared_ptr<node_prog::Cache_Value_Base> val,
+                std::shared_ptr<std::vector<remote_node>> watch_set,
+                cache_key_t key,
+                dropped_list_t &dropped);
+            void record_lookup(const node_handle_t &handle, node_prog::prog_type type, const cache_key_t &key, bool hit);
+            // before a node is freed
+            void remove_node(node *n);
+            void dump_stats();
+    };
+}
+
+#endif
@@ -0,0 +1,542 @@
+/*
+ * ===============================================================
+ *    Description:  Push based invalidation of node program cache
+ *                  entries.
+ *
+ *        Created:  2026-10-19 16:29:22
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include "common/event_order.h"
+#include "db/shard.h"
+#include "db/cache_watch.h"
+
+using db::watch_registry;
+
+// true if all writes to the current version of the node are before tc
+static bool
+unchanged_since(db::shard *S, const node_handle_t &handle, const vc::vclock &tc)
+{
+    uint64_t hash = hash_node_handle(handle);
+    uint64_t map_idx = db::node_directory::stripe_of(hash);
+
+    bool unchanged = false;
+    db::node_directory::versions vers;
+    S->nodes.mutex(map_idx).lock();
+    if (S->nodes.find(handle, hash, vers)) {
+        db::node *n = vers.back();
+        n->prog_mtx.lock();
+        // nodes being migrated in, or restored without write clocks, are treated as changed
+        unchanged = n->state == db::node::mode::STABLE
+                 && n->max_upd_clk.size() == tc.clock.size()
+                 && order::oracle::equal_or_happens_before_no_kronos(n->max_upd_clk, tc.clock);
+        n->prog_mtx.unlock();
+    }
+    S->nodes.mutex(map_idx).unlock();
+
+    return unchanged;
+}
+
+watch_registry :: watch_registry()
+    : inflight_txs(0)
+    , watermark_seq(0)
+    , next_reg_id(0)
+{ }
+
+std::string
+watch_registry :: reg_key(const node_handle_t &owner, const cache_key_t &key)
+{
+    std::string rk;
+    rk.reserve(owner.size() + 1 + key.size());
+    rk.append(owner);
+    rk.push_back('\0');
+    rk.append(key);
+    return rk;
+}
+
+// watcher is added before the node is checked, a concurrent write is caught by one of the two
+// returns false if a watched node has changed since tc, the watches are dropped then
+// caution: need to hold mtx
+bool
+watch_registry :: watch_nonlocking(shard *S, uint64_t loc, uint64_t reg_id, const vc::vclock &tc, const std::vector<node_handle_t> &handles)
+{
+    for (const node_handle_t &h: handles) {
+        watchers[h].emplace_back(watcher{loc, reg_id});
+    }
+    watched_regs[loc][reg_id] = handles;
+    if (loc != S->shard_id) {
+        watcher_locs.emplace(loc);
+    }
+
+    for (const node_handle_t &h: handles) {
+        if (!unchanged_since(S, h, tc)) {
+            drop_watch_nonlocking(loc, reg_id);
+            return false;
+        }
+    }
+    return true;
+}
+
+// remove the watches of registration reg_id of shard loc from all nodes
+// caution: need to hold mtx
+void
+watch_registry :: drop_watch_nonlocking(uint64_t loc, uint64_t reg_id)
+{
+    auto loc_iter = watched_regs.find(loc);
+    if (loc_iter == watched_regs.end()) {
+        return;
+    }
+    auto reg_iter = loc_iter->second.find(reg_id);
+    if (reg_iter == loc_iter->second.end()) {
+        return;
+    }
+
+    for (const node_handle_t &h: reg_iter->second) {
+        auto iter = watchers.find(h);
+        if (iter == watchers.end()) {
+            continue;
+        }
+        std::vector<watcher> &node_watchers = iter->second;
+        for (uint64_t i = 0; i < node_watchers.size(); i++) {
+            if (node_watchers[i].loc == loc && node_watchers[i].reg_id == reg_id) {
+                node_watchers[i] = node_watchers.back();
+                node_watchers.pop_back();
+                break;
+            }
+        }
+        if (node_watchers.empty()) {
+            watchers.erase(iter);
+        }
+    }
+
+    loc_iter->second.erase(reg_iter);
+    if (loc_iter->second.empty()) {
+        watched_regs.erase(loc_iter);
+    }
+}
+
+// shard loc has dropped all watches of the registration
+// caution: need to hold mtx
+void
+watch_registry :: mark_dirty_nonlocking(uint64_t loc, uint64_t reg_id)
+{
+    auto iter = reg_keys.find(reg_id);
+    if (iter != reg_keys.end()) {
+        registration &reg = registrations[iter->second];
+        reg.dirty = true;
+        reg.watched.erase(loc);
+        return;
+    }
+
+    auto forgotten_iter = forgotten.find(reg_id);
+    if (forgotten_iter != forgotten.end()) {
+        forgotten_iter->second.erase(loc);
+        if (forgotten_iter->second.empty()) {
+            forgotten.erase(forgotten_iter);
+        }
+    }
+}
+
+// shards that have not acked the watch yet are sent the unwatch when they do
+// caution: need to hold mtx
+void
+watch_registry :: unregister_nonlocking(shard *S, const node_handle_t &owner, const cache_key_t &key, reg_lists_t &unwatch)
+{
+    auto iter = registrations.find(reg_key(owner, key));
+    if (iter == registrations.end()) {
+        return;
+    }
+
+    registration &reg = iter->second;
+    for (uint64_t loc: reg.watched) {
+        if (loc == S->shard_id) {
+            drop_watch_nonlocking(loc, reg.reg_id);
+        } else if (reg.pending.find(loc) != reg.pending.end()) {
+            forgotten[reg.reg_id].emplace(loc);
+        } else {
+            unwatch[loc].emplace_back(reg.reg_id);
+        }
+    }
+    reg_keys.erase(reg.reg_id);
+    registrations.erase(iter);
+
+    auto keys_iter = owner_keys.find(owner);
+    if (keys_iter != owner_keys.end()) {
+        keys_iter->second.erase(key);
+        if (keys_iter->second.empty()) {
+            owner_keys.erase(keys_iter);
+        }
+    }
+}
+
+void
+watch_registry :: send_unwatches(shard *S, reg_lists_t &unwatch)
+{
+    message::message msg;
+    for (auto &p: unwatch) {
+        msg.prepare_message(message::CACHE_UNWATCH, S->shard_id, p.second);
+        S->comm.send(p.first, msg.buf);
+    }
+}
+
+// caution: need to hold mtx
+void
+watch_registry :: collect_watchers_nonlocking(shard *S, const node_handle_t &handle, reg_lists_t &dirty)
+{
+    auto iter = watchers.find(handle);
+    if (iter == watchers.end()) {
+        return;
+    }
+
+    std::vector<watcher> fired = std::move(iter->second);
+    watchers.erase(iter);
+    for (const watcher &w: fired) {
+        if (w.loc == S->shard_id) {
+            mark_dirty_nonlocking(w.loc, w.reg_id);
+        } else {
+            dirty[w.loc].emplace_back(w.reg_id);
+        }
+        // watches are one shot, the other nodes of the entry need not be watched either
+        drop_watch_nonlocking(w.loc, w.reg_id);
+    }
+}
+
+// messages are counted under mtx, so that a watermark taken later accounts for them
+// caution: need to hold mtx
+void
+watch_registry :: count_invalidations_nonlocking(const reg_lists_t &acks, const reg_lists_t &dirty)
+{
+    for (const auto &p: acks) {
+        inval_sent[p.first]++;
+    }
+    for (const auto &p: dirty) {
+        if (acks.find(p.first) == acks.end()) {
+            inval_sent[p.first]++;
+        }
+    }
+}
+
+void
+watch_registry :: send_invalidations(shard *S, reg_lists_t &acks, reg_lists_t &dirty)
+{
+    std::vector<uint64_t> empty;
+    message::message msg;
+    for (auto &p: acks) {
+        auto dirty_iter = dirty.find(p.first);
+        if (dirty_iter == dirty.end()) {
+            msg.prepare_message(message::CACHE_INVALIDATE, S->shard_id, p.second, empty);
+        } else {
+            msg.prepare_message(message::CACHE_INVALIDATE, S->shard_id, p.second, dirty_iter->second);
+        }
+        S->comm.send(p.first, msg.buf);
+    }
+    for (auto &p: dirty) {
+        if (acks.find(p.first) == acks.end()) {
+            msg.prepare_message(message::CACHE_INVALIDATE, S->shard_id, empty, p.second);
+            S->comm.send(p.first, msg.buf);
+        }
+    }
+}
+
+// caution: need to hold mtx
+void
+watch_registry :: install_watermark_nonlocking(uint64_t loc, watermark &wm)
+{
+    auto iter = marks.find(loc);
+    if (iter != marks.end() && iter->second.seq >= wm.seq) {
+        return;
+    }
+
+    watermark &installed = marks[loc];
+    installed.seq = wm.seq;
+    installed.invalidations = wm.invalidations;
+    installed.clocks = std::move(wm.clocks);
+    installed.clocks_ptr.clear();
+    for (vc::vclock_t &clk: installed.clocks) {
+        installed.clocks_ptr.emplace_back(&clk);
+    }
+}
+
+void
+watch_registry :: add_watches(shard *S, const node_handle_t &owner, const cache_key_t &key,
+    const vc::vclock &tc, const std::vector<remote_node> &watch_set)
+{
+    std::unordered_map<uint64_t, std::vector<node_handle_t>> per_loc;
+    for (const remote_node &rn: watch_set) {
+        per_loc[rn.loc].emplace_back(rn.handle);
+    }
+    std::string rk = reg_key(owner, key);
+    reg_lists_t unwatch;
+
+    mtx.lock();
+    // watches of the value this one replaces
+    unregister_nonlocking(S, owner, key, unwatch);
+
+    uint64_t reg_id = next_reg_id++;
+    registration &reg = registrations[rk];
+    reg.reg_id = reg_id;
+    reg.tc = tc;
+    reg.dirty = false;
+    reg_keys[reg_id] = rk;
+    owner_keys[owner].emplace(key);
+
+    for (auto &p: per_loc) {
+        if (p.first == S->shard_id) {
+            if (watch_nonlocking(S, S->shard_id, reg_id, tc, p.second)) {
+                reg.watched.emplace(S->shard_id);
+            } else {
+                reg.dirty = true;
+            }
+        } else {
+            reg.pending.emplace(p.first);
+            reg.watched.emplace(p.first);
+        }
+    }
+    mtx.unlock();
+
+    send_unwatches(S, unwatch);
+
+    message::message msg;
+    for (auto &p: per_loc) {
+        if (p.first != S->shard_id) {
+            msg.prepare_message(message::CACHE_WATCH, S->shard_id, reg_id, tc, p.second);
+            S->comm.send(p.first, msg.buf);
+        }
+    }
+}
+
+enum watch_registry::lookup_result
+watch_registry :: check(shard *S, const node_handle_t &owner, const cache_key_t &key,
+    const vc::vclock &tc, const vc::vclock &req_clk, const std::vector<remote_node> &watch_set)
+{
+    enum lookup_result res = CLEAN;
+
+    mtx.lock();
+    auto iter = registrations.find(reg_key(owner, key));
+    if (iter == registrations.end()
+     || iter->second.dirty
+     || !iter->second.pending.empty()
+     || iter->second.tc != tc) {
+        res = UNKNOWN;
+    } else {
+        for (const remote_node &rn: watch_set) {
+            if (rn.loc == S->shard_id) {
+                // local writes mark entries dirty before they are recorded
+                if (inflight_txs > 0) {
+                    res = UNKNOWN;
+                    break;
+                }
+            } else {
+                auto mark_iter = marks.find(rn.loc);
+                if (mark_iter == marks.end()
+                 || !order::oracle::happens_before_no_kronos(req_clk.clock, mark_iter->second.clocks_ptr)) {
+                    res = UNKNOWN;
+                    break;
+                }
+            }
+        }
+    }
+    mtx.unlock();
+
+    return res;
+}
+
+void
+watch_registry :: forget(shard *S, const node_handle_t &owner, const cache_key_t &key)
+{
+    reg_lists_t unwatch;
+
+    mtx.lock();
+    unregister_nonlocking(S, owner, key, unwatch);
+    mtx.unlock();
+
+    send_unwatches(S, unwatch);
+}
+
+// also forgets entries of other versions of the node with the same handle, which then fetch contexts
+void
+watch_registry :: forget_node(shard *S, const node_handle_t &owner)
+{
+    reg_lists_t unwatch;
+
+    mtx.lock();
+    auto iter = owner_keys.find(owner);
+    if (iter != owner_keys.end()) {
+        std::unordered_set<cache_key_t> keys = std::move(iter->second);
+        owner_keys.erase(iter);
+        for (const cache_key_t &key: keys) {
+            unregister_nonlocking(S, owner, key, unwatch);
+        }
+    }
+    mtx.unlock();
+
+    send_unwatches(S, unwatch);
+}
+
+void
+watch_registry :: recv_invalidations(shard *S, std::unique_ptr<message::message> msg)
+{
+    uint64_t from_loc;
+    std::vector<uint64_t> acks, dirty;
+    msg->unpack_message(message::CACHE_INVALIDATE, from_loc, acks, dirty);
+    reg_lists_t unwatch;
+
+    mtx.lock();
+    // dirty first, a shard that reports a registration dirty has dropped its watches
+    for (uint64_t reg_id: dirty) {
+        mark_dirty_nonlocking(from_loc, reg_id);
+    }
+    for (uint64_t reg_id: acks) {
+        auto iter = reg_keys.find(reg_id);
+        if (iter != reg_keys.end()) {
+            registrations[iter->second].pending.erase(from_loc);
+            continue;
+        }
+        auto forgotten_iter = forgotten.find(reg_id);
+        if (forgotten_iter != forgotten.end() && forgotten_iter->second.erase(from_loc) > 0) {
+            unwatch[from_loc].emplace_back(reg_id);
+            if (forgotten_iter->second.empty()) {
+                forgotten.erase(forgotten_iter);
+            }
+        }
+    }
+
+    uint64_t recd = ++inval_recd[from_loc];
+    auto pending_iter = pending_marks.find(from_loc);
+    if (pending_iter != pending_marks.end() && recd >= pending_iter->second.invalidations) {
+        install_watermark_nonlocking(from_loc, pending_iter->second);
+        pending_marks.erase(pending_iter);
+    }
+    mtx.unlock();
+
+    send_unwatches(S, unwatch);
+}
+
+void
+watch_registry :: recv_watermark(std::unique_ptr<message::message> msg)
+{
+    uint64_t from_loc;
+    watermark wm;
+    msg->unpack_message(message::CACHE_WATERMARK, from_loc, wm.seq, wm.invalidations, wm.clocks);
+
+    mtx.lock();
+    if (inval_recd[from_loc] >= wm.invalidations) {
+        install_watermark_nonlocking(from_loc, wm);
+    } else {
+        // wait for invalidations sent before this watermark
+        auto pending_iter = pending_marks.find(from_loc);
+        if (pending_iter == pending_marks.end() || pending_iter->second.seq < wm.seq) {
+            pending_marks[from_loc] = std::move(wm);
+        }
+    }
+    mtx.unlock();
+}
+
+void
+watch_registry :: recv_watch(shard *S, std::unique_ptr<message::message> msg)
+{
+    uint64_t owner_loc, reg_id;
+    vc::vclock tc;
+    std::vector<node_handle_t> handles;
+    msg->unpack_message(message::CACHE_WATCH, owner_loc, reg_id, tc, handles);
+
+    reg_lists_t acks, dirty;
+    acks[owner_loc].emplace_back(reg_id);
+
+    mtx.lock();
+    if (!watch_nonlocking(S, owner_loc, reg_id, tc, handles)) {
+        dirty[owner_loc].emplace_back(reg_id);
+    }
+    count_invalidations_nonlocking(acks, dirty);
+    mtx.unlock();
+
+    send_invalidations(S, acks, dirty);
+}
+
+void
+watch_registry :: recv_unwatch(std::unique_ptr<message::message> msg)
+{
+    uint64_t owner_loc;
+    std::vector<uint64_t> reg_ids;
+    msg->unpack_message(message::CACHE_UNWATCH, owner_loc, reg_ids);
+
+    mtx.lock();
+    for (uint64_t reg_id: reg_ids) {
+        drop_watch_nonlocking(owner_loc, reg_id);
+    }
+    mtx.unlock();
+}
+
+void
+watch_registry :: begin_tx()
+{
+    mtx.lock();
+    inflight_txs++;
+    mtx.unlock();
+}
+
+void
+watch_registry :: end_tx(shard *S, const std::vector<node_handle_t> &written)
+{
+    reg_lists_t acks, dirty;
+
+    mtx.lock();
+    if (!watchers.empty()) {
+        for (const node_handle_t &h: written) {
+            collect_watchers_nonlocking(S, h, dirty);
+        }
+        count_invalidations_nonlocking(acks, dirty);
+    }
+    assert(inflight_txs > 0);
+    inflight_txs--;
+    mtx.unlock();
+
+    if (!dirty.empty()) {
+        send_invalidations(S, acks, dirty);
+    }
+}
+
+void
+watch_registry :: node_moved(shard *S, const node_handle_t &handle)
+{
+    reg_lists_t acks, dirty;
+
+    mtx.lock();
+    collect_watchers_nonlocking(S, handle, dirty);
+    count_invalidations_nonlocking(acks, dirty);
+    mtx.unlock();
+
+    if (!dirty.empty()) {
+        send_invalidations(S, acks, dirty);
+    }
+}
+
+void
+watch_registry :: send_watermark(shard *S)
+{
+    std::vector<std::pair<uint64_t, uint64_t>> dests; // shard, invalidations sent
+    std::vector<vc::vclock_t> clocks;
+    uint64_t seq;
+
+    mtx.lock();
+    // writes still being applied may not have sent their invalidations
+    if (inflight_txs > 0 || watcher_locs.empty()) {
+        mtx.unlock();
+        return;
+    }
+    clocks = S->qm.get_last_clocks();
+    seq = ++watermark_seq;
+    for (uint64_t loc: watcher_locs) {
+        dests.emplace_back(loc, inval_sent[loc]);
+    }
+    mtx.unlock();
+
+    message::message msg;
+    for (auto &d: dests) {
+        msg.prepare_message(message::CACHE_WATERMARK, S->shard_id, seq, d.second, clocks);
+        S->comm.send(d.first, msg.buf);
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ * ===============================================================
+ *    Description:  Watches on nodes in the watch sets of cached
+ *                  node program values.  Shards holding watched
+ *                  nodes push invalidations on writes, so that a
+ *                  cache hit need not fetch contexts.
+ *
+ *        Created:  2026-10-19 16:29:22
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_db_cache_watch_h_
+#define weaver_db_cache_watch_h_
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <po6/threads/mutex.h>
+
+#include "common/types.h"
+#include "common/vclock.h"
+#include "common/message.h"
+#include "db/remote_node.h"
+
+namespace db
+{
+    class shard;
+
+    // A cache entry at time T_c is registered with every shard in its watch
+    // set.  The watched shard marks the entry dirty if a watched node has been
+    // written since T_c, or is written later.  Watches are one shot.
+    //
+    // Every nop, a watched shard sends its read watermark (the clocks up to
+    // which its writes are applied) along with the number of invalidation
+    // messages it has sent.  Once the owner has received all those messages,
+    // a clean, fully registered entry is valid at any clock before the
+    // watermarks of all its watched shards, with no changes since T_c.  In
+    // all other cases the owner fetches contexts as before.
+    //
+    // When an entry is replaced, evicted, or its node freed, the owner sends
+    // unwatches to the shards that still hold its watches.  An unwatch is sent
+    // only after the shard acked the watch, so it never overtakes the watch.
+    //
+    // Lock order is the registry mutex, then node directory stripe mutex,
+    // then node prog_mtx.
+    class watch_registry
+    {
+        private:
+            struct watcher
+            {
+                uint64_t loc;
+                uint64_t reg_id;
+            };
+
+            // entry owned by this shard
+            struct registration
+            {
+                uint64_t reg_id;
+                vc::vclock tc;
+                std::unordered_set<uint64_t> pending; // watched shards yet to ack
+                std::unordered_set<uint64_t> watched; // shards that may still hold its watches
+                bool dirty;
+            };
+
+            struct watermark
+            {
+                uint64_t seq;
+                uint64_t invalidations; // sent before this watermark
+                std::vector<vc::vclock_t> clocks;
+                std::vector<vc::vclock_t*> clocks_ptr;
+            };
+
+            po6::threads::mutex mtx;
+
+            // watched side
+            std::unordered_map<node_handle_t, std::vector<watcher>> watchers;
+            std::unordered_map<uint64_t, std::unordered_map<uint64_t, std::vector<node_handle_t>>> watched_regs; // watcher shard -> reg id -> nodes
+            std::unordered_set<uint64_t> watcher_locs; // shards that have registered watches here
+            std::unordered_map<uint64_t, uint64_t> inval_sent; // CACHE_INVALIDATE messages per shard
+            uint64_t inflight_txs;
+            uint64_t watermark_seq;
+
+            // owner side
+            uint64_t next_reg_id;
+            std::unordered_map<std::string, registration> registrations; // node handle + key -> registration
+            std::unordered_map<uint64_t, std::string> reg_keys;
+            std::unordered_map<node_handle_t, std::unordered_set<cache_key_t>> owner_keys;
+            std::unordered_map<uint64_t, std::unordered_set<uint64_t>> forgotten; // reg id -> shards to unwatch once they ack
+            std::unordered_map<uint64_t, uint64_t> inval_recd; // CACHE_INVALIDATE messages per shard
+            std::unordered_map<uint64_t, watermark> marks, pending_marks;
+
+            typedef std::unordered_map<uint64_t, std::vector<uint64_t>> reg_lists_t; // shard -> reg ids
+
+            static std::string reg_key(const node_handle_t &owner, const cache_key_t &key);
+            bool watch_nonlocking(shard *S, uint64_t loc, uint64_t reg_id, const vc::vclock &tc, const std::vector<node_handle_t> &handles);
+            void drop_watch_nonlocking(uint64_t loc, uint64_t reg_id);
+            void mark_dirty_nonlocking(uint64_t loc, uint64_t reg_id);
+            void unregister_nonlocking(shard *S, const node_handle_t &owner, const cache_key_t &key, reg_lists_t &unwatch);
+            void send_unwatches(shard *S, reg_lists_t &unwatch);
+            void collect_watchers_nonlocking(shard *S, const node_handle_t &handle, reg_lists_t &dirty);
+            void count_invalidations_nonlocking(const reg_lists_t &acks, const reg_lists_t &dirty);
+            void send_invalidations(shard *S, reg_lists_t &acks, reg_lists_t &dirty);
+            void install_watermark_nonlocking(uint64_t loc, watermark &wm);
+
+        public:
+            enum lookup_result
+            {
+                CLEAN, // no writes to the watch set between T_c and the request
+                UNKNOWN // fetch contexts
+            };
+
+        public:
+            watch_registry();
+
+            // owner side, after a value has been added to the cache of owner
+            void add_watches(shard *S, const node_handle_t &owner, const cache_key_t &key,
+                const vc::vclock &tc, const std::vector<remote_node> &watch_set);
+            enum lookup_result check(shard *S, const node_handle_t &owner, const cache_key_t &key,
+                const vc::vclock &tc, const vc::vclock &req_clk, const std::vector<remote_node> &watch_set);
+            // cache entry is gone
+            void forget(shard *S, const node_handle_t &owner, const cache_key_t &key);
+            // before the owner node is freed
+            void forget_node(shard *S, const node_handle_t &owner);
+            void recv_invalidations(shard *S, std::unique_ptr<message::message> msg);
+            void recv_watermark(std::unique_ptr<message::message> msg);
+
+            // watched side
+            void recv_watch(shard *S, std::unique_ptr<message::message> msg);
+            void recv_unwatch(std::unique_ptr<message::message> msg);
+            void begin_tx();
+            // after writes of a tx are applied, before the tx is recorded as completed
+            void end_tx(shard *S, const std::vector<node_handle_t> &written);
+            // node migrating away from this shard
+            void node_moved(shard *S, const node_handle_t &handle);
+            // after a nop is recorded
+            void send_watermark(shard *S);
+    };
+}
+
+#endif
@@ -22,49 +22,18 @@ using db::remote_node;
 // empty constructor for unpacking
 edge :: edge()
     : base()
-#ifdef WEAVER_CLDG
-    , msg_count(0)
-#endif
-#ifdef WEAVER_NEW_CLDG
-    , msg_count(0)
-#endif
 { }
 
 edge :: edge(const edge_handle_t &handle, vclock_ptr_t &vclk, uint64_t remote_loc, const node_handle_t &remote_handle)
     : base(handle, vclk)
     , nbr(remote_loc, remote_handle)
-#ifdef WEAVER_CLDG
-    , msg_count(0)
-#endif
-#ifdef WEAVER_NEW_CLDG
-    , msg_count(0)
-#endif
 { }
 
 edge :: edge(const edge_handle_t &handle, vclock_ptr_t &vclk, remote_node &rn)
     : base(handle, vclk)
     , nbr(rn)
-#ifdef WEAVER_CLDG
-    , msg_count(0)
-#endif
-#ifdef WEAVER_NEW_CLDG
-    , msg_count(0)
-#endif
 { }
 
-// caution: should be called with node mutex held
-// should always be called when an edge is traversed in a node program
-void
-edge :: traverse()
-{
-#ifdef WEAVER_CLDG
-    msg_count++;
-#endif
-#ifdef WEAVER_NEW_CLDG
-    msg_count++;
-#endif
-}
-
 node_prog::prop_list 
 edge :: get_properties()
 {
@@ -97,6 +66,14 @@ edge :: has_all_predicates(std::vector<predicate::prop_predicate> &preds)
     return base.has_all_predicates(preds);
 }
 
+bool
+edge :: has_all_predicates(const predicate::compiled_predicates &preds)
+{
+    assert(base.view_time != nullptr);
+    assert(base.time_oracle != nullptr);
+    return base.has_all_predicates(preds);
+}
+
 // convert this edge into a cl::edge object (see client/weaver_datastructures.h)
 void
 edge :: get_client_edge(const std::string &start_node, cl::edge &e)
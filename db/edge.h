@@ -38,19 +38,13 @@ namespace db
         public:
             element base;
             remote_node nbr; // out-neighbor for this edge
-#ifdef WEAVER_CLDG
-            uint32_t msg_count; // number of messages sent on this link
-#endif
-#ifdef WEAVER_NEW_CLDG
-            uint32_t msg_count; // number of messages sent on this link
-#endif
-            void traverse(); // indicate that this edge was traversed; useful for migration statistics
 
             const remote_node& get_neighbor() { return nbr; }
             node_prog::prop_list get_properties();
             bool has_property(std::pair<std::string, std::string> &p);
             bool has_all_properties(std::vector<std::pair<std::string, std::string>> &props);
             bool has_all_predicates(std::vector<predicate::prop_predicate> &preds);
+            bool has_all_predicates(const predicate::compiled_predicates &preds);
             const edge_handle_t& get_handle() const { return base.get_handle(); }
             void get_client_edge(const std::string &node, cl::edge &e);
 
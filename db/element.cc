@@ -17,11 +17,13 @@
 using db::element;
 using db::property;
 
+thread_local vclock_ptr_t element::view_time;
+thread_local order::oracle *element::time_oracle = nullptr;
+
 element :: element(const std::string &_handle, const vclock_ptr_t &vclk)
     : handle(_handle)
     , creat_time(vclk)
     , del_time(nullptr)
-    , time_oracle(nullptr)
 { }
 
 bool
@@ -201,7 +203,7 @@ element :: has_predicate(const predicate::prop_predicate &pred)
 {
 #ifdef weaver_large_property_maps_
 
-    auto iter = properties.find(key);
+    auto iter = properties.find(pred.key);
     if (iter != properties.end()) {
         for (const std::shared_ptr<property> p: iter->second) {
             if (pred.check(*p)
@@ -254,6 +256,48 @@ element :: has_all_predicates(const std::vector<predicate::prop_predicate> &pred
     return true;
 }
 
+// terms in order, stop at the first that no visible property satisfies
+// the visibility check can call Kronos, so it is only done for matching values
+bool
+element :: has_all_predicates(const predicate::compiled_predicates &preds)
+{
+    for (const predicate::compiled_predicates::term &t: preds.get_terms()) {
+        bool found = false;
+
+#ifdef weaver_large_property_maps_
+
+        auto iter = properties.find(t.key);
+        if (iter == properties.end()) {
+            return false;
+        }
+        for (const std::shared_ptr<property> &p: iter->second) {
+            if (t.test(p->value, t.value)
+             && time_oracle->clock_creat_before_del_after(*view_time, p->get_creat_time(), p->get_del_time())) {
+                found = true;
+                break;
+            }
+        }
+
+#else
+
+        for (const std::shared_ptr<property> &p: properties) {
+            if (p->key == t.key
+             && t.test(p->value, t.value)
+             && time_oracle->clock_creat_before_del_after(*view_time, p->get_creat_time(), p->get_del_time())) {
+                found = true;
+                break;
+            }
+        }
+
+#endif
+
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void
 element :: update_del_time(const vclock_ptr_t &tdel)
 {
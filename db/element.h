@@ -64,8 +64,10 @@ namespace db
 #else
             std::vector<std::shared_ptr<property>> properties;
 #endif
-            vclock_ptr_t view_time;
-            order::oracle *time_oracle;
+            // snapshot at which the current thread is reading elements
+            // per-thread, so that many node programs can read the same node concurrently
+            static thread_local vclock_ptr_t view_time;
+            static thread_local order::oracle *time_oracle;
 
         public:
             bool add_property(const property &prop);
@@ -78,6 +80,7 @@ namespace db
             bool has_predicate(const predicate::prop_predicate &p);
             bool has_all_properties(const std::vector<std::pair<std::string, std::string>> &props);
             bool has_all_predicates(const std::vector<predicate::prop_predicate> &preds);
+            bool has_all_predicates(const predicate::compiled_predicates &preds);
             void update_del_time(const vclock_ptr_t &del_time);
             const vclock_ptr_t& get_del_time() const;
             void update_creat_time(const vclock_ptr_t &creat_time);
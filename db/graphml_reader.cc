@@ -0,0 +1,414 @@
+/*
+ * ===============================================================
+ *    Description:  Streaming GraphML reader implementation.
+ *
+ *        Created:  2026-10-19 15:49:31
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "db/graphml_reader.h"
+
+using db::graphml_element;
+using db::graphml_reader;
+
+void
+graphml_element :: clear()
+{
+    is_node = false;
+    offset = 0;
+    id.clear();
+    source.clear();
+    target.clear();
+    data.clear();
+}
+
+graphml_reader :: graphml_reader(const char *file_name, uint64_t begin, uint64_t e)
+    : file(fopen(file_name, "r"))
+    , offset(begin)
+    , end(e)
+    , buf(GRAPHML_READ_BUF_SIZE)
+    , buf_pos(0)
+    , buf_len(0)
+{
+    if (file != nullptr && fseeko(file, begin, SEEK_SET) != 0) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+graphml_reader :: ~graphml_reader()
+{
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+uint64_t
+graphml_reader :: file_size(const char *file_name)
+{
+    struct stat st;
+    if (stat(file_name, &st) != 0) {
+        return 0;
+    }
+    return st.st_size;
+}
+
+bool
+graphml_reader :: fill()
+{
+    buf_pos = 0;
+    buf_len = fread(&buf[0], 1, buf.size(), file);
+    return buf_len > 0;
+}
+
+int
+graphml_reader :: peek()
+{
+    if (buf_pos == buf_len && !fill()) {
+        return EOF;
+    }
+    return (unsigned char)buf[buf_pos];
+}
+
+int
+graphml_reader :: get()
+{
+    int c = peek();
+    if (c != EOF) {
+        buf_pos++;
+        offset++;
+    }
+    return c;
+}
+
+void
+graphml_reader :: skip_whitespace()
+{
+    int c;
+    while ((c = peek()) == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        get();
+    }
+}
+
+// consume input up to and including 'str', what comes before 'str' is appended to 'out' if not null
+bool
+graphml_reader :: read_past(const char *str, std::string *out)
+{
+    size_t len = strlen(str);
+    assert(len > 0 && len <= 8);
+    char window[8];
+    size_t seen = 0;
+    int c;
+
+    while ((c = get()) != EOF) {
+        if (seen < len) {
+            window[seen++] = (char)c;
+        } else {
+            if (out != nullptr) {
+                out->push_back(window[0]);
+            }
+            memmove(window, window+1, len-1);
+            window[len-1] = (char)c;
+        }
+        if (seen == len && memcmp(window, str, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// after "<!": comment, CDATA section, or declaration
+bool
+graphml_reader :: skip_markup()
+{
+    if (peek() == '-') {
+        return read_past("-->", nullptr);
+    } else if (peek() == '[') {
+        return read_past("]]>", nullptr);
+    } else {
+        return skip_tag();
+    }
+}
+
+// consume rest of a tag, '>' inside quoted attribute values does not end it
+bool
+graphml_reader :: skip_tag()
+{
+    int c;
+    int quote = 0;
+    while ((c = get()) != EOF) {
+        if (quote != 0) {
+            if (c == quote) {
+                quote = 0;
+            }
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+graphml_reader :: read_name(std::string &name)
+{
+    name.clear();
+    int c;
+    while ((c = peek()) != EOF
+        && c != ' ' && c != '\t' && c != '\n' && c != '\r'
+        && c != '/' && c != '>' && c != '=') {
+        name.push_back((char)get());
+    }
+    return !name.empty();
+}
+
+// append the character for the entity after '&', or the raw text if it is unknown
+void
+graphml_reader :: read_entity(std::string &text)
+{
+    std::string ent;
+    int c;
+    while ((c = peek()) != EOF && c != ';' && c != '<' && ent.size() < 12) {
+        ent.push_back((char)get());
+    }
+    if (c != ';') {
+        text.push_back('&');
+        text.append(ent);
+        return;
+    }
+    get();
+
+    if (ent == "amp") {
+        text.push_back('&');
+    } else if (ent == "lt") {
+        text.push_back('<');
+    } else if (ent == "gt") {
+        text.push_back('>');
+    } else if (ent == "quot") {
+        text.push_back('"');
+    } else if (ent == "apos") {
+        text.push_back('\'');
+    } else if (ent.size() > 1 && ent[0] == '#') {
+        uint32_t cp = (ent[1] == 'x')? strtoul(ent.c_str()+2, nullptr, 16) : strtoul(ent.c_str()+1, nullptr, 10);
+        // utf-8 encode
+        if (cp < 0x80) {
+            text.push_back((char)cp);
+        } else if (cp < 0x800) {
+            text.push_back((char)(0xc0 | (cp >> 6)));
+            text.push_back((char)(0x80 | (cp & 0x3f)));
+        } else if (cp < 0x10000) {
+            text.push_back((char)(0xe0 | (cp >> 12)));
+            text.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+            text.push_back((char)(0x80 | (cp & 0x3f)));
+        } else {
+            text.push_back((char)(0xf0 | (cp >> 18)));
+            text.push_back((char)(0x80 | ((cp >> 12) & 0x3f)));
+            text.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+            text.push_back((char)(0x80 | (cp & 0x3f)));
+        }
+    } else {
+        text.push_back('&');
+        text.append(ent);
+        text.push_back(';');
+    }
+}
+
+// attributes of a start tag, consumes the closing '>' or '/>'
+// id, source, target go to elem, key goes to data_key if non null
+bool
+graphml_reader :: read_attributes(graphml_element &elem, std::string *data_key, bool &empty_elem)
+{
+    std::string &name = scratch_name;
+    std::string &value = scratch_value;
+    empty_elem = false;
+
+    while (true) {
+        skip_whitespace();
+        int c = peek();
+        if (c == EOF) {
+            return false;
+        } else if (c == '>') {
+            get();
+            return true;
+        } else if (c == '/') {
+            get();
+            empty_elem = true;
+            return get() == '>';
+        }
+
+        if (!read_name(name)) {
+            return false;
+        }
+        skip_whitespace();
+        if (get() != '=') {
+            return false;
+        }
+        skip_whitespace();
+        int quote = get();
+        if (quote != '"' && quote != '\'') {
+            return false;
+        }
+
+        value.clear();
+        while ((c = get()) != quote) {
+            if (c == EOF) {
+                return false;
+            } else if (c == '&') {
+                read_entity(value);
+            } else {
+                value.push_back((char)c);
+            }
+        }
+
+        if (data_key != nullptr) {
+            if (name == "key") {
+                *data_key = value;
+            }
+        } else if (name == "id") {
+            elem.id = value;
+        } else if (name == "source") {
+            elem.source = value;
+        } else if (name == "target") {
+            elem.target = value;
+        }
+    }
+}
+
+// character data up to the next tag, CDATA sections included verbatim
+bool
+graphml_reader :: read_text(std::string &text)
+{
+    int c;
+    while ((c = peek()) != EOF) {
+        if (c == '&') {
+            get();
+            read_entity(text);
+        } else if (c != '<') {
+            text.push_back((char)get());
+        } else {
+            get();
+            if (peek() != '!') {
+                return true;
+            }
+            // CDATA section or comment, both may sit in the middle of text
+            get();
+            if (peek() == '[') {
+                if (!read_past("[CDATA[", nullptr) || !read_past("]]>", &text)) {
+                    return false;
+                }
+            } else if (!skip_markup()) {
+                return false;
+            }
+        }
+    }
+    return false;
+}
+
+// children of a non empty <node> or <edge>, up to and including its end tag
+bool
+graphml_reader :: read_children(graphml_element &elem)
+{
+    std::string &name = scratch_tag;
+    std::string &discard = scratch_text;
+    std::string key;
+    const char *elem_name = elem.is_node? "node" : "edge";
+
+    while (true) {
+        discard.clear();
+        if (!read_text(discard)) {
+            return false;
+        }
+        // just consumed '<'
+        int c = peek();
+        if (c == '/') {
+            get();
+            read_name(name);
+            if (!skip_tag()) {
+                return false;
+            }
+            if (name == elem_name) {
+                return true;
+            }
+        } else if (c == '?') {
+            if (!skip_tag()) {
+                return false;
+            }
+        } else if (!read_name(name)) {
+            return false;
+        } else if (name == "data") {
+            bool empty_elem;
+            key.clear();
+            if (!read_attributes(elem, &key, empty_elem)) {
+                return false;
+            }
+            elem.data.emplace_back(std::make_pair(key, std::string()));
+            if (!empty_elem) {
+                if (!read_text(elem.data.back().second)) {
+                    return false;
+                }
+                // end tag of data
+                if (!skip_tag()) {
+                    return false;
+                }
+            }
+        } else if (!skip_tag()) {
+            return false;
+        }
+    }
+}
+
+bool
+graphml_reader :: next(graphml_element &elem)
+{
+    std::string &name = scratch_tag;
+
+    while (file != nullptr) {
+        int c;
+        while ((c = peek()) != EOF && c != '<') {
+            get();
+        }
+        if (c == EOF || offset >= end) {
+            return false;
+        }
+        uint64_t tag_offset = offset;
+        get();
+
+        c = peek();
+        if (c == '!') {
+            get();
+            skip_markup();
+            continue;
+        } else if (c == '/' || c == '?') {
+            skip_tag();
+            continue;
+        }
+
+        read_name(name);
+        if (name != "node" && name != "edge") {
+            skip_tag();
+            continue;
+        }
+
+        elem.clear();
+        elem.is_node = (name == "node");
+        elem.offset = tag_offset;
+        bool empty_elem;
+        if (!read_attributes(elem, nullptr, empty_elem)) {
+            return false;
+        }
+        if (!empty_elem && !read_children(elem)) {
+            return false;
+        }
+        return true;
+    }
+
+    return false;
+}
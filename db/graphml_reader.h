@@ -0,0 +1,78 @@
+/*
+ * ===============================================================
+ *    Description:  Streaming GraphML reader for bulk loading, reads
+ *                  node and edge elements from a byte range of
+ *                  the file without building a DOM.
+ *
+ *        Created:  2026-10-19 15:49:31
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_db_graphml_reader_h_
+#define weaver_db_graphml_reader_h_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define GRAPHML_READ_BUF_SIZE (1 << 20)
+
+namespace db
+{
+    // a <node> or <edge> element with its <data> children
+    struct graphml_element
+    {
+        bool is_node;
+        uint64_t offset; // file offset of element, unique per element
+        std::string id;
+        std::string source, target; // edges only
+        std::vector<std::pair<std::string, std::string>> data; // key, value
+
+        void clear();
+    };
+
+    // Reads every <node> and <edge> element that starts in [begin, end) of the file.
+    // Ranges of consecutive readers can be cut at arbitrary bytes: an element is read by
+    // the reader whose range contains its '<', even if the element runs past the range.
+    // A range must not start inside a comment or CDATA section that itself contains
+    // node or edge markup, which graph dumps do not have.
+    // Nested graphs are not supported, their nodes and edges are read as top level ones.
+    class graphml_reader
+    {
+        private:
+            FILE *file;
+            uint64_t offset; // file offset of buf[buf_pos]
+            uint64_t end;
+            std::vector<char> buf;
+            size_t buf_pos, buf_len;
+            // reused across elements to avoid allocations
+            std::string scratch_tag, scratch_name, scratch_value, scratch_text;
+
+            int get();
+            int peek();
+            bool fill();
+            void skip_whitespace();
+            bool read_past(const char *str, std::string *out);
+            bool skip_markup();
+            bool skip_tag();
+            bool read_name(std::string &name);
+            bool read_attributes(graphml_element &elem, std::string *data_key, bool &empty_elem);
+            bool read_text(std::string &text);
+            void read_entity(std::string &text);
+            bool read_children(graphml_element &elem);
+
+        public:
+            graphml_reader(const char *file_name, uint64_t begin, uint64_t end);
+            ~graphml_reader();
+
+            bool good() const { return file != nullptr; }
+            bool next(graphml_element &elem);
+
+            static uint64_t file_size(const char *file_name);
+    };
+}
+
+#endif
@@ -1,6 +1,6 @@
 /*
  * ===============================================================
- *    Description:  Shard hyperdex stub implementation.
+ *    Description:  Shard storage stub implementation.
  *
  *        Created:  2014-02-18 15:32:42
  *
@@ -21,142 +21,70 @@ using db::hyper_stub;
 
 hyper_stub :: hyper_stub(uint64_t sid)
     : shard_id(sid)
+    , store(storage_backend::create("shard" + std::to_string(sid)))
 { }
 
 void
-hyper_stub :: restore_backup(db::data_map<std::vector<node*>> *nodes,
-    /*XXX std::unordered_map<node_handle_t, std::unordered_set<node_version_t, node_version_hash>> &edge_map,*/
-    po6::threads::mutex *shard_mutexes)
+hyper_stub :: restore_backup(db::node_directory &nodes, db::in_edge_index &in_edges)
 {
-    const hyperdex_client_attribute *cl_attr;
-    size_t num_attrs;
-
-    // node list
-    const hyperdex_client_attribute_check attr_check = {graph_attrs[0], (const char*)&shard_id, sizeof(int64_t), graph_dtypes[0], HYPERPREDICATE_EQUALS};
-    enum hyperdex_client_returncode search_status, loop_status;
-
-    int64_t call_id = hyperdex_client_search(cl, graph_space, &attr_check, 1, &search_status, &cl_attr, &num_attrs);
-    if (call_id < 0) {
-        WDEBUG << "Hyperdex function failed, op id = " << call_id
-               << ", status = " << hyperdex_client_returncode_to_string(search_status) << std::endl;
-        WDEBUG << "error message: " << hyperdex_client_error_message(cl) << std::endl;
-        WDEBUG << "error loc: " << hyperdex_client_error_location(cl) << std::endl;
-        return;
-    }
-
-    std::vector<node_handle_t> node_list;
-    int loop_id;
-    bool loop_done = false;
-    char *handle_str = (char*)malloc(sizeof(char)*128);
-    size_t handle_sz = 128;
-    size_t cur_sz;
-    node_handle_t node_handle;
     vc::vclock_ptr_t dummy_clock;
-    node *n;
-    uint64_t map_idx;
-
-    while (!loop_done) {
-        // loop until search done
-        loop_id = hyperdex_client_loop(cl, -1, &loop_status);
-        if (loop_id != call_id
-         || loop_status != HYPERDEX_CLIENT_SUCCESS
-         || (search_status != HYPERDEX_CLIENT_SUCCESS && search_status != HYPERDEX_CLIENT_SEARCHDONE)) {
-            WDEBUG << "Hyperdex function failed, call id = " << call_id
-                   << ", loop_id = " << loop_id
-                   << ", loop status = " << hyperdex_client_returncode_to_string(loop_status)
-                   << ", search status = " << hyperdex_client_returncode_to_string(search_status) << std::endl;
-            WDEBUG << "error message: " << hyperdex_client_error_message(cl) << std::endl;
-            WDEBUG << "error loc: " << hyperdex_client_error_location(cl) << std::endl;
-            return;
-        }
-
-        if (search_status == HYPERDEX_CLIENT_SEARCHDONE) {
-            loop_done = true;
-        } else if (search_status == HYPERDEX_CLIENT_SUCCESS) {
-            assert(num_attrs == NUM_GRAPH_ATTRS+1); // node handle + graph attrs
-
-            uint64_t key_idx = UINT64_MAX;
-            hyperdex_client_attribute node_attrs[NUM_GRAPH_ATTRS];
-            for (uint64_t i = 0, j = 0; i < num_attrs; i++) {
-                if (strncmp(cl_attr[i].attr, graph_key, 4) == 0) {
-                    key_idx = i;
-                } else {
-                    node_attrs[j++] = cl_attr[i];
-                }
-            }
-            assert(key_idx != UINT64_MAX);
 
-            // null terminated copy of the obtained handle
-            cur_sz = cl_attr[key_idx].value_sz + 1;
-            if (handle_sz < cur_sz) {
-                while(handle_sz < cur_sz) {
-                    handle_sz *= 2;
-                }
-                handle_str = (char*)realloc(handle_str, handle_sz);
-            }
-            memcpy(handle_str, cl_attr[key_idx].value, cur_sz-1);
-            handle_str[cur_sz-1] = '\0';
-            node_handle = node_handle_t(handle_str);
-
-            // recreate node
-            map_idx = hash_node_handle(node_handle) % NUM_NODE_MAPS;
-            n = new node(node_handle, UINT64_MAX, dummy_clock, shard_mutexes+map_idx);
-            recreate_node(node_attrs, *n);
-
-            //XXX edge map
-            //for (const auto &p: n->out_edges) {
-            //    assert(p.second.size() == 1);
-            //    edge *e = p.second.front();
-            //    edge_map[e->nbr.handle].emplace(std::make_pair(node_handle, e->base.get_creat_time()));
-            //}
+    bool success = store->get_shard_nodes(shard_id,
+        [&](const node_handle_t &handle) {
+            uint64_t map_idx = db::node_directory::stripe_of(hash_node_handle(handle));
+            return new node(handle, UINT64_MAX, dummy_clock, &nodes.mutex(map_idx));
+        },
+        [&](node *n) {
+            in_edges.add_node(*n);
 
             // node map
-            auto &node_map = nodes[map_idx];
-            assert(node_map.find(node_handle) == node_map.end());
-            node_map[node_handle] = std::vector<node*>(1, n);
-
-            hyperdex_client_destroy_attrs(cl_attr, num_attrs);
-        } else {
-            WDEBUG << "unexpected search status " << search_status << std::endl;
-        }
+            const node_handle_t &handle = n->get_handle();
+            uint64_t hash = hash_node_handle(handle);
+            uint64_t map_idx = db::node_directory::stripe_of(hash);
+            nodes.mutex(map_idx).lock();
+            nodes.add_version(handle, hash, n);
+            nodes.mutex(map_idx).unlock();
+        });
+
+    if (!success) {
+        WDEBUG << "restore backup failed for shard " << shard_id << std::endl;
     }
-
-    free(handle_str);
 }
 
 void
-hyper_stub :: memory_efficient_bulk_load(int thread_id, db::data_map<std::vector<node*>> *nodes_arr)
+hyper_stub :: memory_efficient_bulk_load(int thread_id, const db::node_directory &nodes)
 {
-    WDEBUG << "starting HyperDex bulk load." << std::endl;
+    WDEBUG << "starting storage bulk load." << std::endl;
     assert(NUM_NODE_MAPS % NUM_SHARD_THREADS == 0);
     vc::vclock zero_clk(0,0);
 
     std::unordered_map<node_handle_t, node*> node_map;
     int progress = 0;
     for (int tid = thread_id; tid < NUM_NODE_MAPS; tid += NUM_SHARD_THREADS) {
-        for (const auto &p: nodes_arr[tid]) {
-            assert(p.second.size() == 1);
-            node_map.emplace(p.first, p.second.front());
+        nodes.for_each(tid, [&](const db::node_directory::versions &vers) {
+            assert(vers.size() == 1);
+            node_map.emplace(vers.first->get_handle(), vers.first);
             if (node_map.size() >= 1000) {
-                put_nodes_bulk(node_map, zero_clk, zero_clk.clock);
+                store->put_nodes_bulk(node_map, zero_clk, zero_clk.clock);
                 node_map.clear();
-                WDEBUG << "bulk load hyperdex progress " << ++progress << std::endl;
+                WDEBUG << "bulk load storage progress " << ++progress << std::endl;
             }
-        }
+        });
     }
 
-    put_nodes_bulk(node_map, zero_clk, zero_clk.clock);
+    store->put_nodes_bulk(node_map, zero_clk, zero_clk.clock);
 
     progress = 0;
     int ine_progress = 0;
-    if (AuxIndex) {
+    // with local storage, the timestamper indexes the nodes that the shard sends it
+    if (AuxIndex && StorageBackend != "local") {
         std::unordered_map<std::string, node*> idx_add_if_not_exist;
         std::unordered_map<std::string, node*> idx_add;
 
         for (int tid = thread_id; tid < NUM_NODE_MAPS; tid += NUM_SHARD_THREADS) {
-            for (const auto &p: nodes_arr[tid]) {
-                node *n = p.second.front();
-                idx_add_if_not_exist.emplace(p.first, n);
+            nodes.for_each(tid, [&](const db::node_directory::versions &vers) {
+                node *n = vers.first;
+                idx_add_if_not_exist.emplace(n->get_handle(), n);
                 for (const node_handle_t &alias: n->aliases) {
                     assert(idx_add_if_not_exist.find(alias) == idx_add_if_not_exist.end());
                     idx_add_if_not_exist.emplace(alias, n);
@@ -176,20 +104,20 @@ hyper_stub :: memory_efficient_bulk_load(int thread_id, db::data_map<std::vector
                 }
 
                 if (idx_add_if_not_exist.size() >= 10000) {
-                    add_indices(idx_add_if_not_exist, false, true);
+                    store->add_indices(idx_add_if_not_exist, false, true);
                     idx_add_if_not_exist.clear();
                     WDEBUG << "aux index if not exist progress " << ++ine_progress << std::endl;
                 }
                 if (idx_add.size() >= 10000) {
-                    add_indices(idx_add, false, false);
+                    store->add_indices(idx_add, false, false);
                     idx_add.clear();
                     WDEBUG << "aux index progress " << ++progress << std::endl;
                 }
-            }
+            });
         }
 
-        add_indices(idx_add_if_not_exist, false, true);
-        add_indices(idx_add, false, false);
+        store->add_indices(idx_add_if_not_exist, false, true);
+        store->add_indices(idx_add, false, false);
     }
 
     WDEBUG << "bulk load done." << std::endl;
@@ -209,7 +137,7 @@ hyper_stub :: bulk_load(int thread_id, std::unordered_map<node_handle_t, std::ve
         }
     }
 
-    put_nodes_bulk(node_map, zero_clk, zero_clk.clock);
+    store->put_nodes_bulk(node_map, zero_clk, zero_clk.clock);
 
     if (AuxIndex) {
         std::unordered_map<std::string, node*> idx_add = node_map;
@@ -226,14 +154,56 @@ hyper_stub :: bulk_load(int thread_id, std::unordered_map<node_handle_t, std::ve
             }
         }
 
-        add_indices(idx_add, false, true);
+        store->add_indices(idx_add, false, true);
+    }
+}
+
+// local storage: latest versions of put nodes and removal of del nodes in one commit to this shard's log
+// acquire returns nullptr for nodes that are gone or moving out, each node is encoded between acquire and release
+bool
+hyper_stub :: persist_nodes(const std::vector<node_handle_t> &put,
+    std::unordered_set<node_handle_t> &del,
+    vc::vclock &clk,
+    std::function<node*(const node_handle_t&)> acquire,
+    std::function<void(node*)> release)
+{
+    std::unordered_map<node_handle_t, node*> node_map;
+    store->begin_tx();
+    for (const node_handle_t &h: put) {
+        if (del.find(h) != del.end()) {
+            continue;
+        }
+        node *n = acquire(h);
+        if (n == nullptr) {
+            continue;
+        }
+        node_map.emplace(h, n);
+        bool success = store->put_nodes_bulk(node_map, clk, clk.clock);
+        node_map.clear();
+        release(n);
+        if (!success) {
+            store->abort_tx();
+            return false;
+        }
     }
+    if (!del.empty() && !store->del_nodes(del)) {
+        store->abort_tx();
+        return false;
+    }
+
+    return store->commit_tx() == STORAGE_COMMITTED;
 }
 
 bool
 hyper_stub :: update_mapping(const node_handle_t &handle, uint64_t loc)
 {
-    return update_nmap(handle, loc);
+    return store->update_nmap(handle, loc);
+}
+
+bool
+hyper_stub :: update_mappings(const std::unordered_map<node_handle_t, uint64_t> &mappings)
+{
+    return store->update_nmap_bulk(mappings);
 }
 
 #undef weaver_debug_
@@ -1,6 +1,6 @@
 /*
  * ===============================================================
- *    Description:  Hyperdex client stub for shard state.
+ *    Description:  Storage stub for shard state.
  *
  *        Created:  2014-02-02 16:54:42
  *
@@ -16,10 +16,12 @@
 
 #include <po6/threads/mutex.h>
 
-#include "common/hyper_stub_base.h"
+#include "common/storage_backend.h"
 #include "common/vclock.h"
 #include "db/types.h"
 #include "db/node.h"
+#include "db/node_directory.h"
+#include "db/in_edge_index.h"
 #include "db/edge.h"
 
 namespace db
@@ -30,21 +32,27 @@ namespace db
         ACTIVE // this shard does have the token
     };
 
-    class hyper_stub : private hyper_stub_base
+    class hyper_stub
     {
         private:
             const uint64_t shard_id;
+            std::unique_ptr<storage_backend> store;
 
         public:
             hyper_stub(uint64_t sid);
-            void restore_backup(db::data_map<std::vector<node*>> *nodes,
-                /*XXX std::unordered_map<node_handle_t, std::unordered_set<node_version_t, node_version_hash>> &edge_map,*/
-                po6::threads::mutex *shard_mutexes);
+            void restore_backup(node_directory &nodes, in_edge_index &in_edges);
             // bulk loading
             void bulk_load(int tid, std::unordered_map<node_handle_t, std::vector<node*>> *nodes);
-            void memory_efficient_bulk_load(int tid, db::data_map<std::vector<node*>> *nodes);
+            void memory_efficient_bulk_load(int tid, const node_directory &nodes);
+            // local storage, writes to this shard's partition
+            bool persist_nodes(const std::vector<node_handle_t> &put,
+                std::unordered_set<node_handle_t> &del,
+                vc::vclock &clk,
+                std::function<node*(const node_handle_t&)> acquire,
+                std::function<void(node*)> release);
             // migration
             bool update_mapping(const node_handle_t &handle, uint64_t loc);
+            bool update_mappings(const std::unordered_map<node_handle_t, uint64_t> &mappings);
     };
 }
 
@@ -0,0 +1,159 @@
+/*
+ * ===============================================================
+ *    Description:  Reverse index of edges stored at a shard.
+ *
+ *        Created:  2026-10-19 16:38:05
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include "common/weaver_constants.h"
+#include "db/edge.h"
+#include "db/node.h"
+#include "db/node_directory.h"
+#include "db/in_edge_index.h"
+
+using db::in_edge_index;
+
+in_edge_index :: in_edge_index()
+    : num_entries(0)
+{ }
+
+uint64_t
+in_edge_index :: stripe_of(const node_handle_t &dst)
+{
+    return hash_node_handle(dst) % IN_EDGE_STRIPES;
+}
+
+void
+in_edge_index :: add(const node_handle_t &dst, const node_handle_t &src,
+    const edge_handle_t &edge, const vclock_ptr_t &tcreat)
+{
+    stripe &st = stripes[stripe_of(dst)];
+    st.mtx.lock();
+    st.in_edges[dst][std::make_pair(src, edge)].emplace_back(in_edge{tcreat, vclock_ptr_t()});
+    st.mtx.unlock();
+    num_entries++;
+}
+
+// latest undeleted version of the edge, as in shard::delete_edge_nonlocking
+void
+in_edge_index :: mark_deleted(const node_handle_t &dst, const node_handle_t &src,
+    const edge_handle_t &edge, const vclock_ptr_t &tdel)
+{
+    stripe &st = stripes[stripe_of(dst)];
+    st.mtx.lock();
+    auto iter = st.in_edges.find(dst);
+    if (iter != st.in_edges.end()) {
+        auto edge_iter = iter->second.find(std::make_pair(src, edge));
+        if (edge_iter != iter->second.end()) {
+            std::vector<in_edge> &versions = edge_iter->second;
+            for (auto riter = versions.rbegin(); riter != versions.rend(); riter++) {
+                if (!riter->tdel) {
+                    riter->tdel = tdel;
+                    break;
+                }
+            }
+        }
+    }
+    st.mtx.unlock();
+}
+
+void
+in_edge_index :: remove_entry(const node_handle_t &dst, const node_handle_t &src,
+    const edge_handle_t &edge, const vclock_ptr_t &tcreat)
+{
+    stripe &st = stripes[stripe_of(dst)];
+    st.mtx.lock();
+    auto iter = st.in_edges.find(dst);
+    if (iter != st.in_edges.end()) {
+        auto edge_iter = iter->second.find(std::make_pair(src, edge));
+        if (edge_iter != iter->second.end()) {
+            std::vector<in_edge> &versions = edge_iter->second;
+            for (uint64_t i = 0; i < versions.size(); i++) {
+                if (versions[i].tcreat == tcreat) {
+                    versions.erase(versions.begin() + i);
+                    num_entries--;
+                    break;
+                }
+            }
+            if (versions.empty()) {
+                iter->second.erase(edge_iter);
+            }
+        }
+        if (iter->second.empty()) {
+            st.in_edges.erase(iter);
+        }
+    }
+    st.mtx.unlock();
+}
+
+void
+in_edge_index :: remove(const node_handle_t &src, const edge &e)
+{
+    remove_entry(e.nbr.handle, src, e.get_handle(), e.base.get_creat_time());
+}
+
+void
+in_edge_index :: add_node(const node &n)
+{
+    const node_handle_t &src = n.get_handle();
+    for (const auto &x: n.out_edges) {
+        for (const db::edge *e: x.second) {
+            stripe &st = stripes[stripe_of(e->nbr.handle)];
+            st.mtx.lock();
+            st.in_edges[e->nbr.handle][std::make_pair(src, x.first)].emplace_back(in_edge{e->base.get_creat_time(), e->base.get_del_time()});
+            st.mtx.unlock();
+            num_entries++;
+        }
+    }
+}
+
+void
+in_edge_index :: remove_node(const node &n)
+{
+    const node_handle_t &src = n.get_handle();
+    for (const auto &x: n.out_edges) {
+        for (const db::edge *e: x.second) {
+            remove(src, *e);
+        }
+    }
+}
+
+void
+in_edge_index :: sources(const node_handle_t &dst, std::vector<node_handle_t> &srcs)
+{
+    stripe &st = stripes[stripe_of(dst)];
+    st.mtx.lock();
+    auto iter = st.in_edges.find(dst);
+    if (iter != st.in_edges.end()) {
+        for (const auto &p: iter->second) {
+            srcs.emplace_back(p.first.first);
+        }
+    }
+    st.mtx.unlock();
+}
+
+// approximate, clocks are shared with the edges and not counted
+uint64_t
+in_edge_index :: bytes()
+{
+    uint64_t total = sizeof(in_edge_index);
+    for (stripe &st: stripes) {
+        st.mtx.lock();
+        total += st.in_edges.bucket_count() * sizeof(void*);
+        for (const auto &p: st.in_edges) {
+            total += sizeof(p) + 2*sizeof(void*) + p.first.capacity()
+                   + p.second.bucket_count() * sizeof(void*);
+            for (const auto &q: p.second) {
+                total += sizeof(q) + 2*sizeof(void*)
+                       + q.first.first.capacity() + q.first.second.capacity()
+                       + q.second.capacity() * sizeof(in_edge);
+            }
+        }
+        st.mtx.unlock();
+    }
+    return total;
+}
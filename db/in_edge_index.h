@@ -0,0 +1,88 @@
+/*
+ * ===============================================================
+ *    Description:  Reverse index of edges stored at a shard, from
+ *                  destination node to the local nodes with an
+ *                  edge to it.
+ *
+ *        Created:  2026-10-19 16:38:05
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_db_in_edge_index_h_
+#define weaver_db_in_edge_index_h_
+
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <po6/threads/mutex.h>
+
+#include "common/types.h"
+#include "common/utils.h"
+#include "common/vclock.h"
+
+#define IN_EDGE_STRIPES 64
+
+namespace db
+{
+    class node;
+    class edge;
+
+    // One entry per edge version stored at this shard, keyed by the handle
+    // of the nbr the edge points to, which may live on any shard.  Entries
+    // carry the create and delete clocks of the edge, shared with the edge
+    // itself.  Deleted edges stay until they are permanently deleted, so the
+    // index can be read at any clock a node program may run at.  Versions of
+    // an edge are grouped by (src, edge handle), so updates do not scan all
+    // in edges of a high in-degree node.
+    //
+    // Kept in step with the out edges of local nodes: edge create and delete,
+    // permanent deletion, nodes migrating in and out, and restore.
+    // Stripe mutexes are leaf locks, nothing else is acquired under them.
+    class in_edge_index
+    {
+        private:
+            // one version of an edge
+            struct in_edge
+            {
+                vclock_ptr_t tcreat, tdel;
+            };
+            typedef std::pair<node_handle_t, edge_handle_t> in_edge_key; // src, edge
+            typedef std::unordered_map<in_edge_key, std::vector<in_edge>> in_edge_map;
+
+            struct stripe
+            {
+                po6::threads::mutex mtx;
+                std::unordered_map<node_handle_t, in_edge_map> in_edges;
+            };
+
+            stripe stripes[IN_EDGE_STRIPES];
+            std::atomic<uint64_t> num_entries;
+
+            static uint64_t stripe_of(const node_handle_t &dst);
+            void remove_entry(const node_handle_t &dst, const node_handle_t &src,
+                const edge_handle_t &edge, const vclock_ptr_t &tcreat);
+
+        public:
+            in_edge_index();
+
+            void add(const node_handle_t &dst, const node_handle_t &src,
+                const edge_handle_t &edge, const vclock_ptr_t &tcreat);
+            void mark_deleted(const node_handle_t &dst, const node_handle_t &src,
+                const edge_handle_t &edge, const vclock_ptr_t &tdel);
+            // edge permanently deleted
+            void remove(const node_handle_t &src, const edge &e);
+            // all edges of a node that migrated here or was restored, caller holds the node
+            void add_node(const node &n);
+            // all edges of a node that migrated away or was permanently deleted, caller holds the node
+            void remove_node(const node &n);
+
+            // local nodes with an edge to dst, whether or not deleted
+            void sources(const node_handle_t &dst, std::vector<node_handle_t> &srcs);
+            uint64_t size() const { return num_entries; }
+            uint64_t bytes();
+    };
+}
+
+#endif
@@ -26,12 +26,14 @@ namespace db
             message_wrapper(enum message::msg_type mt, std::unique_ptr<message::message> m)
                 : type(mt)
                 , msg(std::move(m))
+                , enqueue_time(0)
             { }
 
         public:
             enum message::msg_type type;
             std::unique_ptr<message::message> msg;
             order::oracle *time_oracle;
+            uint64_t enqueue_time; // set if the message waited in a queue
     };
 }
 
@@ -34,14 +34,21 @@ node :: node(const node_handle_t &_handle, uint64_t shrd, vclock_ptr_t &vclk, po
     : base(_handle, vclk)
     , shard(shrd)
     , state(mode::NASCENT)
+    , live_out_edges(EDGE_COUNT_UNKNOWN)
+    , out_index_ready(false)
     , cv(mtx)
     , migr_cv(mtx)
     , in_use(true)
     , waiters(0)
+    , readers(0)
+    , prog_cv(&prog_mtx)
     , permanently_deleted(false)
     , last_perm_deletion(nullptr)
     , temp_aliases(nullptr)
 {
+    if (vclk) {
+        max_upd_clk = vclk->clock;
+    }
     std::string empty("");
     out_edges.set_deleted_key(empty);
     aliases.set_deleted_key(empty);
@@ -56,6 +63,12 @@ void
 node :: add_edge_unique(edge *e)
 {
     out_edges[e->get_handle()] = std::vector<edge*>(1,e);
+    // may replace an edge with the same handle
+    live_out_edges = EDGE_COUNT_UNKNOWN;
+    if (out_index_ready) {
+        out_index_ready = false;
+        out_index.reset(nullptr);
+    }
 }
 
 void
@@ -68,6 +81,38 @@ node :: add_edge(edge *e)
         assert(iter->second.back()->base.get_del_time() && "cannot create two concurrent edges with same handle");
         iter->second.emplace_back(e);
     }
+
+    if (live_out_edges != EDGE_COUNT_UNKNOWN) {
+        live_out_edges++;
+    }
+    if (out_index_ready) {
+        out_index->add_edge(e);
+    }
+}
+
+void
+node :: edge_deleted()
+{
+    if (live_out_edges != EDGE_COUNT_UNKNOWN) {
+        assert(live_out_edges > 0);
+        live_out_edges--;
+    }
+}
+
+void
+node :: edge_property_added(edge *e, const std::string &key, const std::string &value)
+{
+    if (out_index_ready) {
+        out_index->add_property(e, key, value);
+    }
+}
+
+void
+node :: edge_removed(edge *e)
+{
+    if (out_index_ready) {
+        out_index->remove_edge(e);
+    }
 }
 
 bool
@@ -112,7 +157,21 @@ node :: get_edges()
 {
     assert(base.view_time != nullptr);
     assert(base.time_oracle != nullptr);
-    return node_prog::edge_list(out_edges, base.view_time, base.time_oracle);
+    if (EdgeIndexMinDegree > 0
+     && !out_index_ready.load(std::memory_order_acquire)
+     && out_edges.size() >= EdgeIndexMinDegree) {
+        // concurrent readers of this node, writers hold it exclusively
+        prog_mtx.lock();
+        if (!out_index_ready.load(std::memory_order_relaxed)) {
+            out_index.reset(new out_edge_index());
+            out_index->build(out_edges);
+            out_index_ready.store(true, std::memory_order_release);
+        }
+        prog_mtx.unlock();
+    }
+
+    out_edge_index *index = out_index_ready.load(std::memory_order_acquire)? out_index.get() : nullptr;
+    return node_prog::edge_list(out_edges, base.view_time, base.time_oracle, &live_out_edges, &max_upd_clk, index);
 };
 
 node_prog::prop_list
@@ -147,6 +206,14 @@ node :: has_all_predicates(std::vector<predicate::prop_predicate> &preds)
     return base.has_all_predicates(preds);
 }
 
+bool
+node :: has_all_predicates(const predicate::compiled_predicates &preds)
+{
+    assert(base.view_time != nullptr);
+    assert(base.time_oracle != nullptr);
+    return base.has_all_predicates(preds);
+}
+
 void
 node :: add_alias(const node_handle_t &alias)
 {
@@ -165,13 +232,26 @@ node :: is_alias(const node_handle_t &alias) const
     return (aliases.find(alias) != aliases.end());
 }
 
-void
+bool
 node :: add_cache_value(vclock_ptr_t vc,
     std::shared_ptr<node_prog::Cache_Value_Base> cache_value,
     std::shared_ptr<std::vector<remote_node>> watch_set,
-    cache_key_t key)
+    cache_key_t key,
+    uint64_t slot,
+    std::vector<std::pair<cache_key_t, uint64_t>> *dropped)
 {
+    bool added = false;
     if (MaxCacheEntries) {
+        prog_mtx.lock();
+        // newer value for the same key replaces the old one
+        auto old_iter = cache.find(key);
+        if (old_iter != cache.end()) {
+            if (dropped != nullptr) {
+                dropped->emplace_back(old_iter->first, old_iter->second.slot);
+            }
+            cache.erase(old_iter);
+        }
+
         // clear oldest entry if cache is full
         if (cache.size() >= MaxCacheEntries) {
             std::vector<vc::vclock_t*> oldest(1, &vc->clock);
@@ -184,14 +264,94 @@ node :: add_cache_value(vclock_ptr_t vc,
                     oldest[0] = &to_cmp.clock;
                 }
             }
-            cache.erase(key_to_del);
+            auto del_iter = cache.find(key_to_del);
+            if (del_iter != cache.end()) {
+                if (dropped != nullptr) {
+                    dropped->emplace_back(del_iter->first, del_iter->second.slot);
+                }
+                cache.erase(del_iter);
+            }
         }
 
         if (cache.size() < MaxCacheEntries) {
-            cache_entry new_entry(cache_value, vc, watch_set);
+            cache_entry new_entry(cache_value, vc, watch_set, slot);
             cache.emplace(key, new_entry);
+            added = true;
         }
+        prog_mtx.unlock();
+    }
+    return added;
+}
+
+static void
+merge_clock(vc::vclock_t &into, const vc::vclock_t &clk)
+{
+    if (into.empty()) {
+        into = clk;
+        return;
+    }
+
+    assert(into.size() == clk.size());
+    for (uint64_t i = 0; i < clk.size(); i++) {
+        if (clk[i] > into[i]) {
+            into[i] = clk[i];
+        }
+    }
+}
+
+void
+node :: record_write(const vclock_ptr_t &clk)
+{
+    prog_mtx.lock();
+    if (max_upd_clk.size() == clk->clock.size()) {
+        merge_clock(max_upd_clk, clk->clock);
     }
+    prog_mtx.unlock();
+}
+
+void
+node :: record_write(const vclock_ptr_t &clk, const edge_handle_t &changed)
+{
+    record_write(clk);
+
+    change_log.emplace_back(clk, changed);
+    if (change_log.size() > NODE_CHANGE_LOG_MAX) {
+        merge_clock(change_log_floor, change_log.front().clk->clock);
+        change_log.pop_front();
+    }
+}
+
+// drop writes up to the permanent deletion horizon, cached values before it are invalid anyway
+void
+node :: trim_change_log(const vc::vclock_t &horizon)
+{
+    for (auto iter = change_log.begin(); iter != change_log.end();) {
+        if (order::oracle::equal_or_happens_before_no_kronos(iter->clk->clock, horizon)) {
+            merge_clock(change_log_floor, iter->clk->clock);
+            iter = change_log.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+void
+node :: start_change_log()
+{
+    change_log.clear();
+    if (max_upd_clk.empty()) {
+        change_log_floor = vc::vclock_t(ClkSz, UINT64_MAX);
+    } else {
+        change_log_floor = max_upd_clk;
+    }
+}
+
+// true if the log has all writes that may not be before clk
+bool
+node :: change_log_covers(const vc::vclock_t &clk) const
+{
+    return change_log_floor.empty()
+        || order::oracle::equal_or_happens_before_no_kronos(change_log_floor, clk);
 }
 
 void
@@ -18,6 +18,7 @@
 #include <vector>
 #include <unordered_map>
 #include <deque>
+#include <atomic>
 #include <po6/threads/mutex.h>
 #include <po6/threads/cond.h>
 
@@ -30,6 +31,7 @@
 #include "db/cache_entry.h"
 #include "db/element.h"
 #include "db/edge.h"
+#include "db/out_edge_index.h"
 #include "db/shard_constants.h"
 #include "client/datastructures.h"
 
@@ -44,12 +46,6 @@ namespace db
     {
         uint64_t new_loc;
         std::vector<double> migr_score;
-#ifdef WEAVER_CLDG
-        std::vector<uint32_t> msg_count;
-#endif
-#ifdef WEAVER_NEW_CLDG
-        std::vector<uint32_t> msg_count;
-#endif
         bool already_migr;
         // queued requests, for the time when the node is marked in transit
         // but requests cannot yet be forwarded to new location which is still
@@ -59,6 +55,15 @@ namespace db
         migr_data();
     };
 
+    // write to a node, for computing cache contexts
+    struct change_entry
+    {
+        vclock_ptr_t clk;
+        edge_handle_t edge; // empty for node properties
+
+        change_entry(const vclock_ptr_t &c, const edge_handle_t &e) : clk(c), edge(e) { }
+    };
+
     class node : public node_prog::node
     {
         public:
@@ -78,11 +83,22 @@ namespace db
             uint64_t shard;
             enum mode state;
             data_map<std::vector<edge*>> out_edges;
+            // out edges without a deletion time, EDGE_COUNT_UNKNOWN until a node program counts them
+            // nodes unpacked from HyperDex or a migration fill out_edges directly, so start unknown
+            std::atomic<uint64_t> live_out_edges;
+            // by nbr and indexed edge properties, for nodes with at least EdgeIndexMinDegree out edges
+            // built under prog_mtx by the first node program to read the node, valid once out_index_ready
+            std::unique_ptr<out_edge_index> out_index;
+            std::atomic<bool> out_index_ready;
             po6::threads::cond cv; // for locking node
             po6::threads::cond migr_cv; // make reads/writes wait while node is being migrated
             std::deque<std::pair<uint64_t, uint64_t>> tx_queue; // queued txs, identified by <vt_id, queue timestamp> tuple
-            bool in_use;
-            uint32_t waiters; // count of number of waiters
+            std::atomic<bool> in_use; // exclusively held by a write, migration, or deletion
+            std::atomic<uint32_t> waiters; // count of number of waiters
+            std::atomic<uint32_t> readers; // count of node programs holding shared access
+            po6::threads::mutex prog_mtx; // guards cache and prog_states, which concurrent readers update
+            po6::threads::cond prog_cv; // wait for another visit of the same request at this node to finish
+            std::vector<uint64_t> active_progs; // req ids of node programs currently reading this node
             bool permanently_deleted;
             std::unique_ptr<vc::vclock> last_perm_deletion; // vclock of last edge/property permanently deleted at this node
             string_set aliases;
@@ -93,10 +109,28 @@ namespace db
 
             // node program cache
             std::unordered_map<cache_key_t, cache_entry> cache;
-            void add_cache_value(vclock_ptr_t vc,
+            // returns false if the value was not stored
+            // keys and slots of entries it replaces or evicts are appended to dropped
+            bool add_cache_value(vclock_ptr_t vc,
                 std::shared_ptr<node_prog::Cache_Value_Base> cache_value,
                 std::shared_ptr<std::vector<remote_node>> watch_set,
-                cache_key_t key);
+                cache_key_t key,
+                uint64_t slot=UINT64_MAX,
+                std::vector<std::pair<cache_key_t, uint64_t>> *dropped=nullptr);
+            // element wise max of clocks of all writes to this node, guarded by prog_mtx
+            // empty if unknown, e.g. after restore from backup
+            vc::vclock_t max_upd_clk;
+            // last NODE_CHANGE_LOG_MAX edge and property writes, in the order applied
+            // only modified with the node held exclusively, so node programs can read it
+            std::deque<change_entry> change_log;
+            // element wise max of clocks of writes not in the log, empty if none
+            vc::vclock_t change_log_floor;
+            // caller holds node exclusively
+            void record_write(const vclock_ptr_t &clk); // node deletion
+            void record_write(const vclock_ptr_t &clk, const edge_handle_t &changed); // empty edge handle for node properties
+            void trim_change_log(const vc::vclock_t &horizon);
+            void start_change_log(); // after unpacking a node, earlier writes are not in the log
+            bool change_log_covers(const vc::vclock_t &clk) const;
 
             // node program state
             typedef std::unordered_map<uint64_t, std::shared_ptr<node_prog::Node_State_Base>> id_to_state_t;
@@ -111,6 +145,9 @@ namespace db
         public:
             void add_edge_unique(edge *e); // bulk loading
             void add_edge(edge *e);
+            void edge_deleted(); // caller set the deletion time of a live out edge
+            void edge_property_added(edge *e, const std::string &key, const std::string &value);
+            void edge_removed(edge *e); // permanently deleted, before the edge is freed
             bool edge_exists(const edge_handle_t&);
             edge& get_edge(const edge_handle_t&);
             node_prog::edge_list get_edges();
@@ -118,6 +155,7 @@ namespace db
             bool has_property(std::pair<std::string, std::string> &p);
             bool has_all_properties(std::vector<std::pair<std::string, std::string>> &props);
             bool has_all_predicates(std::vector<predicate::prop_predicate> &preds);
+            bool has_all_predicates(const predicate::compiled_predicates &preds);
             void set_handle(const node_handle_t &_handle) { base.set_handle(_handle); }
             const node_handle_t& get_handle() const { return base.get_handle(); }
             void add_alias(const node_handle_t &alias);
@@ -0,0 +1,405 @@
+/*
+ * ===============================================================
+ *    Description:  Concurrent node directory implementation.
+ *
+ *        Created:  2026-10-19 15:43:35
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "common/thread_index.h"
+#include "db/node_directory.h"
+
+using db::node_directory;
+
+#define QUIESCENT UINT64_MAX
+#define INIT_CAPACITY 8
+
+node_directory :: node_directory()
+    : overflow_readers(0)
+    , overflow_epoch(QUIESCENT)
+    , global_epoch(0)
+{
+    for (uint64_t i = 0; i < NUM_NODE_MAPS; i++) {
+        stripes[i].tbl.store(new_table(INIT_CAPACITY));
+        stripes[i].size = 0;
+        stripes[i].used = 0;
+    }
+    for (uint64_t i = 0; i < NODE_DIR_MAX_THREADS; i++) {
+        epochs[i].epoch.store(QUIESCENT);
+        epochs[i].depth = 0;
+    }
+}
+
+node_directory :: ~node_directory()
+{
+    reclaim();
+    for (uint64_t i = 0; i < NUM_NODE_MAPS; i++) {
+        table *t = stripes[i].tbl.load();
+        for (uint64_t j = 0; j <= t->mask; j++) {
+            slot &s = t->slots[j];
+            if (s.state == FULL) {
+                if (s.len > NODE_DIR_INLINE_HANDLE) {
+                    free((void*)handle_bytes(s));
+                }
+                delete s.more;
+            }
+        }
+        delete[] t->slots;
+        delete t;
+    }
+}
+
+node_directory::table*
+node_directory :: new_table(uint64_t capacity)
+{
+    assert((capacity & (capacity-1)) == 0);
+    table *t = new table();
+    t->mask = capacity - 1;
+    t->slots = new slot[capacity];
+    for (uint64_t i = 0; i < capacity; i++) {
+        t->slots[i].seq.store(0, std::memory_order_relaxed);
+        t->slots[i].state = EMPTY;
+        t->slots[i].len = 0;
+        t->slots[i].first = nullptr;
+        t->slots[i].more = nullptr;
+    }
+    return t;
+}
+
+const char*
+node_directory :: handle_bytes(const slot &s)
+{
+    if (s.len > NODE_DIR_INLINE_HANDLE) {
+        const char *ptr;
+        memcpy(&ptr, s.handle, sizeof(ptr));
+        return ptr;
+    } else {
+        return s.handle;
+    }
+}
+
+bool
+node_directory :: slot_matches(const slot &s, const node_handle_t &handle)
+{
+    return s.len == handle.size() && memcmp(handle_bytes(s), handle.data(), s.len) == 0;
+}
+
+void
+node_directory :: read_begin()
+{
+    uint64_t idx = thread_index::get();
+    if (idx >= NODE_DIR_MAX_THREADS) {
+        // nested calls just count twice, the first reader in sets the epoch
+        overflow_mtx.lock();
+        if (overflow_readers++ == 0) {
+            overflow_epoch.store(global_epoch.load());
+        }
+        overflow_mtx.unlock();
+        return;
+    }
+
+    thread_epoch &my_epoch = epochs[idx];
+    if (my_epoch.depth++ == 0) {
+        my_epoch.epoch.store(global_epoch.load());
+    }
+}
+
+void
+node_directory :: read_end()
+{
+    uint64_t idx = thread_index::get();
+    if (idx >= NODE_DIR_MAX_THREADS) {
+        overflow_mtx.lock();
+        assert(overflow_readers > 0);
+        if (--overflow_readers == 0) {
+            overflow_epoch.store(QUIESCENT, std::memory_order_release);
+        }
+        overflow_mtx.unlock();
+        return;
+    }
+
+    thread_epoch &my_epoch = epochs[idx];
+    assert(my_epoch.depth > 0);
+    if (--my_epoch.depth == 0) {
+        my_epoch.epoch.store(QUIESCENT, std::memory_order_release);
+    }
+}
+
+bool
+node_directory :: find(const node_handle_t &handle, uint64_t hash, versions &vers) const
+{
+    const stripe &st = stripes[stripe_of(hash)];
+    uint32_t tag = slot_tag(hash);
+
+    while (true) {
+        const table *t = st.tbl.load(std::memory_order_acquire);
+        uint64_t idx = slot_idx(hash) & t->mask;
+        bool retry = false;
+
+        for (uint64_t probes = 0; probes <= t->mask; probes++, idx = (idx+1) & t->mask) {
+            const slot &s = t->slots[idx];
+            uint32_t seq = s.seq.load(std::memory_order_acquire);
+            if (seq & 1) {
+                retry = true;
+                break;
+            }
+
+            // copy out the slot, pointers in it may be garbage until seq is validated
+            uint8_t state = s.state;
+            uint32_t s_tag = s.tag;
+            uint32_t len = s.len;
+            char bytes[NODE_DIR_INLINE_HANDLE];
+            memcpy(bytes, s.handle, NODE_DIR_INLINE_HANDLE);
+            node *first = s.first;
+            const std::vector<node*> *more = s.more;
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) != seq) {
+                retry = true;
+                break;
+            }
+
+            if (state == EMPTY) {
+                return false;
+            } else if (state == FULL && s_tag == tag && len == handle.size()) {
+                const char *handle_ptr = bytes;
+                if (len > NODE_DIR_INLINE_HANDLE) {
+                    memcpy(&handle_ptr, bytes, sizeof(handle_ptr));
+                }
+                if (memcmp(handle_ptr, handle.data(), len) == 0) {
+                    vers.first = first;
+                    vers.more = more;
+                    return true;
+                }
+            }
+        }
+
+        if (!retry) {
+            return false;
+        }
+    }
+}
+
+void
+node_directory :: write_begin(slot &s)
+{
+    uint32_t seq = s.seq.load(std::memory_order_relaxed);
+    s.seq.store(seq+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void
+node_directory :: write_end(slot &s)
+{
+    uint32_t seq = s.seq.load(std::memory_order_relaxed);
+    s.seq.store(seq+1, std::memory_order_release);
+}
+
+node_directory::slot*
+node_directory :: find_slot_nonlocking(const stripe &st, const node_handle_t &handle, uint64_t hash)
+{
+    table *t = st.tbl.load(std::memory_order_relaxed);
+    uint32_t tag = slot_tag(hash);
+    uint64_t idx = slot_idx(hash) & t->mask;
+    for (uint64_t probes = 0; probes <= t->mask; probes++, idx = (idx+1) & t->mask) {
+        slot &s = t->slots[idx];
+        if (s.state == EMPTY) {
+            return nullptr;
+        } else if (s.state == FULL && s.tag == tag && slot_matches(s, handle)) {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+// rehash into a table at most half full, drops DELETED slots
+// old table is still visible to concurrent readers, so it is retired rather than freed
+void
+node_directory :: grow(stripe &st)
+{
+    table *old_t = st.tbl.load(std::memory_order_relaxed);
+    uint64_t capacity = INIT_CAPACITY;
+    while (capacity < 2*(st.size+1)) {
+        capacity *= 2;
+    }
+    table *t = new_table(capacity);
+
+    for (uint64_t i = 0; i <= old_t->mask; i++) {
+        slot &old_s = old_t->slots[i];
+        if (old_s.state != FULL) {
+            continue;
+        }
+        // slot position needs the full hash, recompute from the handle
+        node_handle_t handle(handle_bytes(old_s), old_s.len);
+        uint64_t idx = slot_idx(hash_node_handle(handle)) & t->mask;
+        while (t->slots[idx].state != EMPTY) {
+            idx = (idx+1) & t->mask;
+        }
+        slot &s = t->slots[idx];
+        s.tag = old_s.tag;
+        s.state = FULL;
+        s.len = old_s.len;
+        memcpy(s.handle, old_s.handle, NODE_DIR_INLINE_HANDLE); // also copies pointer to long handle
+        s.first = old_s.first;
+        s.more = old_s.more;
+    }
+
+    st.used = st.size;
+    st.tbl.store(t, std::memory_order_release);
+    retire(old_t, [](void *p) {
+        table *tp = (table*)p;
+        delete[] tp->slots;
+        delete tp;
+    });
+}
+
+void
+node_directory :: add_version(const node_handle_t &handle, uint64_t hash, node *n)
+{
+    stripe &st = stripes[stripe_of(hash)];
+    slot *s = find_slot_nonlocking(st, handle, hash);
+
+    if (s != nullptr) {
+        // node was deleted and recreated, versions go to overflow vector
+        std::vector<node*> *new_more = s->more? new std::vector<node*>(*s->more) : new std::vector<node*>(1, s->first);
+        new_more->emplace_back(n);
+        std::vector<node*> *old_more = s->more;
+        write_begin(*s);
+        s->more = new_more;
+        write_end(*s);
+        if (old_more != nullptr) {
+            retire(old_more, [](void *p) { delete (std::vector<node*>*)p; });
+        }
+        return;
+    }
+
+    table *t = st.tbl.load(std::memory_order_relaxed);
+    if (4*(st.used+1) > 3*(t->mask+1)) {
+        grow(st);
+        t = st.tbl.load(std::memory_order_relaxed);
+    }
+
+    uint64_t idx = slot_idx(hash) & t->mask;
+    while (t->slots[idx].state == FULL) {
+        idx = (idx+1) & t->mask;
+    }
+    slot &new_s = t->slots[idx];
+    bool reuse = (new_s.state == DELETED);
+
+    write_begin(new_s);
+    new_s.tag = slot_tag(hash);
+    new_s.len = handle.size();
+    if (new_s.len > NODE_DIR_INLINE_HANDLE) {
+        char *long_handle = (char*)malloc(new_s.len);
+        memcpy(long_handle, handle.data(), new_s.len);
+        memcpy(new_s.handle, &long_handle, sizeof(long_handle));
+    } else {
+        memcpy(new_s.handle, handle.data(), new_s.len);
+    }
+    new_s.first = n;
+    new_s.more = nullptr;
+    new_s.state = FULL;
+    write_end(new_s);
+
+    st.size++;
+    if (!reuse) {
+        st.used++;
+    }
+}
+
+// returns true if handle has no versions left and was removed from the directory
+bool
+node_directory :: remove_version(const node_handle_t &handle, uint64_t hash, node *n)
+{
+    stripe &st = stripes[stripe_of(hash)];
+    slot *s = find_slot_nonlocking(st, handle, hash);
+    assert(s != nullptr);
+
+    if (s->more != nullptr) {
+        std::vector<node*> *old_more = s->more;
+        auto iter = std::find(old_more->begin(), old_more->end(), n);
+        assert(iter != old_more->end());
+        std::vector<node*> *new_more = nullptr;
+        node *new_first;
+        if (old_more->size() == 2) {
+            new_first = (iter == old_more->begin())? old_more->back() : old_more->front();
+        } else {
+            new_more = new std::vector<node*>(*old_more);
+            new_more->erase(new_more->begin() + (iter - old_more->begin()));
+            new_first = new_more->front();
+        }
+
+        write_begin(*s);
+        s->first = new_first;
+        s->more = new_more;
+        write_end(*s);
+        retire(old_more, [](void *p) { delete (std::vector<node*>*)p; });
+        return false;
+    }
+
+    assert(s->first == n);
+    const char *long_handle = (s->len > NODE_DIR_INLINE_HANDLE)? handle_bytes(*s) : nullptr;
+    write_begin(*s);
+    s->state = DELETED;
+    s->first = nullptr;
+    write_end(*s);
+    if (long_handle != nullptr) {
+        retire((void*)long_handle, free);
+    }
+    st.size--;
+    return true;
+}
+
+void
+node_directory :: retire_node(node *n, void (*free_func)(void*))
+{
+    retire(n, free_func);
+}
+
+void
+node_directory :: retire(void *obj, void (*free_func)(void*))
+{
+    retire_mtx.lock();
+    retired.emplace_back(retired_obj{global_epoch.load(), obj, free_func});
+    if (retired.size() >= NODE_DIR_RECLAIM_BATCH) {
+        reclaim_nonlocking();
+    }
+    retire_mtx.unlock();
+}
+
+void
+node_directory :: reclaim()
+{
+    retire_mtx.lock();
+    reclaim_nonlocking();
+    retire_mtx.unlock();
+}
+
+// free everything retired before the oldest epoch still being read in
+void
+node_directory :: reclaim_nonlocking()
+{
+    uint64_t min_epoch = overflow_epoch.load();
+    for (uint64_t i = 0; i < NODE_DIR_MAX_THREADS; i++) {
+        min_epoch = std::min(min_epoch, epochs[i].epoch.load());
+    }
+
+    auto keep = std::partition(retired.begin(), retired.end(),
+        [min_epoch](const retired_obj &r) { return r.epoch >= min_epoch; });
+    for (auto iter = keep; iter != retired.end(); iter++) {
+        iter->free_func(iter->obj);
+    }
+    retired.erase(keep, retired.end());
+
+    global_epoch++;
+}
+
+#undef QUIESCENT
+#undef INIT_CAPACITY
@@ -0,0 +1,187 @@
+/*
+ * ===============================================================
+ *    Description:  Concurrent directory from node handle to the
+ *                  versions of that node stored at this shard.
+ *
+ *        Created:  2026-10-19 15:43:35
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_db_node_directory_h_
+#define weaver_db_node_directory_h_
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+#include <po6/threads/mutex.h>
+
+#include "common/types.h"
+#include "common/config_constants.h"
+#include "db/shard_constants.h"
+
+// epoch slots for reader threads, indexed by thread_index
+// threads alive beyond this many share one slower overflow slot
+#define NODE_DIR_MAX_THREADS 1024
+// handles up to this length are stored inline in the directory slot, keeps slot at 48 bytes
+#define NODE_DIR_INLINE_HANDLE 19
+// retired objects are reclaimed in batches of this size
+#define NODE_DIR_RECLAIM_BATCH 1024
+
+// hash of a handle for shard placement and directory position
+// with numeric handle hashing, numeric handles hash as integers
+// so hash_node_handle(std::to_string(id)) == hash_node_id(id)
+inline uint64_t hash_node_handle(const node_handle_t &nh)
+{
+    uint64_t id;
+    if (NumericHandleHash && parse_node_handle_id(nh, id)) {
+        return hash_node_id(id);
+    }
+    return weaver_util::murmur_hasher<std::string>()(nh);
+}
+
+namespace db
+{
+    class node;
+
+    // Directory is split into NUM_NODE_MAPS stripes, stripe = hash % NUM_NODE_MAPS.
+    // Each stripe is an open addressing (linear probing) table of fixed size slots.
+    //
+    // Readers do not lock.  Each slot is protected by a seqlock, and readers retry if
+    // the slot changed underneath them.  Tables, long handles, version vectors and
+    // nodes removed from the directory are freed only after every reader that could
+    // have seen them has left (epoch based reclamation).
+    //
+    // Writers to a stripe hold the stripe mutex, which is also the mutex for the
+    // condition variables of the nodes in that stripe.  Bulk loading threads each own
+    // disjoint stripes and can write without locking.
+    class node_directory
+    {
+        public:
+            // versions of a node handle, oldest first
+            // common case of a single version needs no allocation
+            struct versions
+            {
+                node *first;
+                const std::vector<node*> *more; // all versions, if more than one
+
+                versions() : first(nullptr), more(nullptr) { }
+                uint64_t size() const { return more? more->size() : (first? 1 : 0); }
+                bool empty() const { return first == nullptr; }
+                node* operator[](uint64_t i) const { return more? (*more)[i] : first; }
+                node* back() const { return more? more->back() : first; }
+            };
+
+        private:
+            enum slot_state
+            {
+                EMPTY = 0,
+                FULL,
+                DELETED
+            };
+
+            struct slot
+            {
+                std::atomic<uint32_t> seq; // odd while slot is being written
+                uint32_t tag; // high bits of handle hash, to skip most mismatches without comparing handles
+                node *first;
+                std::vector<node*> *more;
+                uint32_t len;
+                uint8_t state;
+                char handle[NODE_DIR_INLINE_HANDLE]; // handle bytes, or pointer to them if len > NODE_DIR_INLINE_HANDLE
+            };
+
+            struct table
+            {
+                uint64_t mask;
+                slot *slots;
+            };
+
+            struct stripe
+            {
+                po6::threads::mutex mtx;
+                std::atomic<table*> tbl;
+                uint64_t size; // FULL slots
+                uint64_t used; // FULL + DELETED slots
+            };
+
+            struct retired_obj
+            {
+                uint64_t epoch;
+                void *obj;
+                void (*free_func)(void*);
+            };
+
+            struct thread_epoch
+            {
+                std::atomic<uint64_t> epoch;
+                uint32_t depth; // nested read_begin calls
+                char pad[64 - sizeof(std::atomic<uint64_t>) - sizeof(uint32_t)];
+            };
+
+            stripe stripes[NUM_NODE_MAPS];
+            thread_epoch epochs[NODE_DIR_MAX_THREADS];
+            // readers without an epoch slot, epoch is of the oldest reader while any are in
+            po6::threads::mutex overflow_mtx;
+            uint64_t overflow_readers;
+            std::atomic<uint64_t> overflow_epoch;
+            std::atomic<uint64_t> global_epoch;
+            po6::threads::mutex retire_mtx;
+            std::vector<retired_obj> retired;
+
+        private:
+            static uint64_t slot_idx(uint64_t hash) { return hash / NUM_NODE_MAPS; }
+            static uint32_t slot_tag(uint64_t hash) { return (uint32_t)(hash >> 32); }
+            static const char* handle_bytes(const slot &s);
+            static bool slot_matches(const slot &s, const node_handle_t &handle);
+            table* new_table(uint64_t capacity);
+            void grow(stripe &st);
+            slot* find_slot_nonlocking(const stripe &st, const node_handle_t &handle, uint64_t hash);
+            void write_begin(slot &s);
+            void write_end(slot &s);
+            void retire(void *obj, void (*free_func)(void*));
+            void reclaim_nonlocking();
+
+        public:
+            node_directory();
+            ~node_directory();
+
+            static uint64_t stripe_of(uint64_t hash) { return hash % NUM_NODE_MAPS; }
+            po6::threads::mutex& mutex(uint64_t stripe) { return stripes[stripe].mtx; }
+
+            // lock free lookup, call between read_begin and read_end
+            // pointers in versions stay valid until read_end
+            void read_begin();
+            void read_end();
+            bool find(const node_handle_t &handle, uint64_t hash, versions &vers) const;
+
+            // writers, hold stripe mutex
+            void add_version(const node_handle_t &handle, uint64_t hash, node *n);
+            bool remove_version(const node_handle_t &handle, uint64_t hash, node *n);
+            uint64_t stripe_size(uint64_t stripe) const { return stripes[stripe].size; }
+            template <typename Func> void for_each(uint64_t stripe, Func func) const;
+
+            // free node once no reader can be looking at it
+            void retire_node(node *n, void (*free_func)(void*));
+            void reclaim();
+    };
+
+    template <typename Func>
+    inline void
+    node_directory :: for_each(uint64_t stripe, Func func) const
+    {
+        const table *t = stripes[stripe].tbl.load();
+        for (uint64_t i = 0; i <= t->mask; i++) {
+            const slot &s = t->slots[i];
+            if (s.state == FULL) {
+                versions vers;
+                vers.first = s.first;
+                vers.more = s.more;
+                func(vers);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * ===============================================================
+ *    Description:  Per node out edge indices implementation.
+ *
+ *        Created:  2026-10-19 17:05:56
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include <algorithm>
+
+#include "common/weaver_constants.h"
+#include "common/config_constants.h"
+#include "db/edge.h"
+#include "db/out_edge_index.h"
+
+using db::out_edge_index;
+
+out_edge_index :: out_edge_index()
+{
+    for (const std::string &key: EdgeIndexKeys) {
+        by_prop[key];
+    }
+}
+
+void
+out_edge_index :: build(data_map<std::vector<edge*>> &out_edges)
+{
+    for (auto &p: out_edges) {
+        for (edge *e: p.second) {
+            add_edge(e);
+            add_properties(e);
+        }
+    }
+}
+
+// all versions of indexed properties
+void
+out_edge_index :: add_properties(edge *e)
+{
+    if (by_prop.empty()) {
+        return;
+    }
+
+#ifdef weaver_large_property_maps_
+
+    for (auto &p: e->base.properties) {
+        auto iter = by_prop.find(p.first);
+        if (iter != by_prop.end()) {
+            for (const std::shared_ptr<property> &prop: p.second) {
+                iter->second.emplace(prop->value, e);
+            }
+        }
+    }
+
+#else
+
+    for (const std::shared_ptr<property> &prop: e->base.properties) {
+        auto iter = by_prop.find(prop->key);
+        if (iter != by_prop.end()) {
+            iter->second.emplace(prop->value, e);
+        }
+    }
+
+#endif
+}
+
+void
+out_edge_index :: add_edge(edge *e)
+{
+    by_nbr.emplace(e->nbr.handle, e);
+}
+
+void
+out_edge_index :: add_property(edge *e, const std::string &key, const std::string &value)
+{
+    auto iter = by_prop.find(key);
+    if (iter != by_prop.end()) {
+        iter->second.emplace(value, e);
+    }
+}
+
+template <typename Map>
+static void
+erase_entry(Map &m, const typename Map::key_type &key, db::edge *e)
+{
+    auto range = m.equal_range(key);
+    for (auto iter = range.first; iter != range.second;) {
+        if (iter->second == e) {
+            iter = m.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+void
+out_edge_index :: remove_edge(edge *e)
+{
+    erase_entry(by_nbr, e->nbr.handle, e);
+
+    if (by_prop.empty()) {
+        return;
+    }
+
+#ifdef weaver_large_property_maps_
+
+    for (auto &p: e->base.properties) {
+        auto iter = by_prop.find(p.first);
+        if (iter != by_prop.end()) {
+            for (const std::shared_ptr<property> &prop: p.second) {
+                erase_entry(iter->second, prop->value, e);
+            }
+        }
+    }
+
+#else
+
+    for (const std::shared_ptr<property> &prop: e->base.properties) {
+        auto iter = by_prop.find(prop->key);
+        if (iter != by_prop.end()) {
+            erase_entry(iter->second, prop->value, e);
+        }
+    }
+
+#endif
+}
+
+// an edge may be indexed more than once under the same value if the property was set again
+static void
+unique_edges(std::vector<db::edge*> &edges)
+{
+    if (edges.size() > 1) {
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+    }
+}
+
+void
+out_edge_index :: edges_to(const node_handle_t &nbr, std::vector<edge*> &edges) const
+{
+    auto range = by_nbr.equal_range(nbr);
+    for (auto iter = range.first; iter != range.second; iter++) {
+        edges.emplace_back(iter->second);
+    }
+    unique_edges(edges);
+}
+
+bool
+out_edge_index :: edges_with(const std::string &key, const std::string &value, std::vector<edge*> &edges) const
+{
+    auto prop_iter = by_prop.find(key);
+    if (prop_iter == by_prop.end()) {
+        return false;
+    }
+
+    auto range = prop_iter->second.equal_range(value);
+    for (auto iter = range.first; iter != range.second; iter++) {
+        edges.emplace_back(iter->second);
+    }
+    unique_edges(edges);
+    return true;
+}
@@ -0,0 +1,60 @@
+/*
+ * ===============================================================
+ *    Description:  Secondary indices over the out edges of one
+ *                  high degree node, by nbr handle and by value of
+ *                  configured edge property keys.
+ *
+ *        Created:  2026-10-19 17:05:56
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_db_out_edge_index_h_
+#define weaver_db_out_edge_index_h_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "common/types.h"
+#include "db/types.h"
+
+namespace db
+{
+    class edge;
+
+    // Entries point to edge versions and stay until the edge is permanently
+    // deleted, and property entries are never removed before that, so a
+    // lookup returns candidates for every clock.  Readers check visibility
+    // and property values at their own clock, as for a scan.
+    //
+    // Built by the first node program that reads a node with at least
+    // EdgeIndexMinDegree out edges, then kept in step by writes, which hold
+    // the node exclusively.
+    class out_edge_index
+    {
+        private:
+            std::multimap<node_handle_t, edge*> by_nbr;
+            // indexed key -> value -> edges which had that value
+            std::unordered_map<std::string, std::multimap<std::string, edge*>> by_prop;
+
+            void add_properties(edge *e);
+
+        public:
+            out_edge_index();
+            void build(data_map<std::vector<edge*>> &out_edges);
+
+            void add_edge(edge *e);
+            void add_property(edge *e, const std::string &key, const std::string &value);
+            void remove_edge(edge *e); // permanently deleted
+
+            bool indexed(const std::string &key) const { return by_prop.find(key) != by_prop.end(); }
+            void edges_to(const node_handle_t &nbr, std::vector<edge*> &edges) const;
+            // false if key is not indexed
+            bool edges_with(const std::string &key, const std::string &value, std::vector<edge*> &edges) const;
+    };
+}
+
+#endif
@@ -29,6 +29,7 @@ queue_manager :: queue_manager()
     , last_clocks(NumVts, vc::vclock_t(ClkSz, 0))
     , qts(NumVts, 0)
     , min_epoch(NumVts, 0)
+    , read_leases(NumVts)
 {
     last_clocks_ptr.reserve(last_clocks.size());
     for (size_t i = 0; i < last_clocks.size(); i++) {
@@ -40,6 +41,7 @@ void
 queue_manager :: enqueue_read_request(uint64_t vt_id, queued_request *t)
 {
     queue_mutex.lock();
+    t->enqueue_time = metrics::clock_ns();
     rd_queues[vt_id].push(t);
     queue_mutex.unlock();
 }
@@ -60,6 +62,7 @@ queue_manager :: enqueue_write_request(uint64_t vt_id, queued_request *t)
     queue_mutex.lock();
 
     if (t->vclock.clock[0] >= min_epoch[vt_id]) {
+        t->enqueue_time = metrics::clock_ns();
         wr_queues[vt_id].push(t);
     }
 
@@ -117,6 +120,7 @@ queue_manager :: exec_queued_request(order::oracle *time_oracle)
         return false;
     }
     req->arg->time_oracle = time_oracle;
+    req->arg->enqueue_time = req->enqueue_time;
     (*req->func)(req->arg);
     // queue timestamp is incremented by the thread, upon enqueueing this tx on node queue
     // when to increment qts depends on the tx components
@@ -130,6 +134,9 @@ queue_manager :: increment_qts(uint64_t vt_id, uint64_t incr)
 {
     queue_mutex.lock();
     qts[vt_id] += incr;
+    if (!read_leases[vt_id].empty()) {
+        apply_read_leases(vt_id);
+    }
     queue_mutex.unlock();
 }
 
@@ -146,6 +153,46 @@ queue_manager :: record_completed_tx(vc::vclock &tx_clk)
     queue_mutex.unlock();
 }
 
+// vt promises that all its writes with timestamp before lease_clk were sent with qts <= lease_qts
+void
+queue_manager :: add_read_lease(uint64_t vt_id, uint64_t lease_qts, vc::vclock &lease_clk)
+{
+    queue_mutex.lock();
+    if (lease_clk.clock[0] >= min_epoch[vt_id]) {
+        read_leases[vt_id].emplace_back(lease_qts, lease_clk.clock);
+        apply_read_leases(vt_id);
+    }
+    queue_mutex.unlock();
+}
+
+// caution: assuming caller holds queue_mutex
+void
+queue_manager :: apply_read_leases(uint64_t vt_id)
+{
+    auto &leases = read_leases[vt_id];
+    vc::vclock_t &last_clk = last_clocks[vt_id];
+    for (auto iter = leases.begin(); iter != leases.end();) {
+        if (iter->first <= qts[vt_id]) {
+            if (order::oracle::happens_before_no_kronos(last_clk, iter->second)) {
+                last_clk = iter->second;
+            }
+            iter = leases.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+// copy of the clocks up to which reads are admitted
+std::vector<vc::vclock_t>
+queue_manager :: get_last_clocks()
+{
+    queue_mutex.lock();
+    std::vector<vc::vclock_t> clocks = last_clocks;
+    queue_mutex.unlock();
+    return clocks;
+}
+
 bool
 queue_manager :: check_rd_req_nonlocking(vc::vclock_t &clk)
 {
@@ -164,6 +211,8 @@ queue_manager :: get_rd_req()
             req = pq.top();
             if (check_rd_req_nonlocking(req->vclock.clock)) {
                 pq.pop();
+
+                metrics::get().rd_queue_wait_ns.record_since(req->enqueue_time);
                 return req;
             }
         }
@@ -221,6 +270,7 @@ queue_manager :: get_wr_req()
     }
     queued_request *req = wr_queues[exec_vt_id].top();
     wr_queues[exec_vt_id].pop();
+    metrics::get().wr_queue_wait_ns.record_since(req->enqueue_time);
     return req;
 }
 
@@ -245,6 +295,7 @@ queue_manager :: reset(uint64_t dead_vt, uint64_t new_epoch)
 
     qts[dead_vt] = 0;
     last_clocks[dead_vt] = vc::vclock_t(ClkSz, 0);
+    read_leases[dead_vt].clear();
     last_clocks_ptr[dead_vt] = &last_clocks[dead_vt];
 
     pqueue_t &dead_queue = wr_queues[dead_vt];
@@ -261,3 +312,27 @@ queue_manager :: clear_queued_reads()
 {
     rd_queues = std::vector<pqueue_t>(NumVts, pqueue_t());
 }
+
+// reads waiting for vector timestampers to make progress
+uint64_t
+queue_manager :: num_queued_reads()
+{
+    uint64_t num_reads = 0;
+    queue_mutex.lock();
+    for (const pqueue_t &pq: rd_queues) {
+        num_reads += pq.size();
+    }
+    queue_mutex.unlock();
+    return num_reads;
+}
+
+// number of reads that waited in rd_queues, mean wait, and upper bound on 99th percentile wait
+void
+queue_manager :: rd_wait_stats(uint64_t &count, uint64_t &mean_nanos, uint64_t &p99_nanos)
+{
+    metrics::histogram::snapshot snap;
+    metrics::get().rd_queue_wait_ns.get_snapshot(snap);
+    count = snap.count;
+    mean_nanos = snap.count == 0? 0 : snap.sum / snap.count;
+    p99_nanos = snap.percentile(0.99);
+}
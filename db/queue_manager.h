@@ -20,6 +20,8 @@
 #include <thread>
 #include <po6/threads/mutex.h>
 
+#include "common/clock.h"
+#include "common/metrics.h"
 #include "db/queued_request.h"
 
 namespace db
@@ -44,15 +46,19 @@ namespace db
             std::vector<vc::vclock_t*> last_clocks_ptr; // vector of previous vector's entry's pointers
             vc::qtimestamp_t qts; // queue timestamps
             std::vector<uint64_t> min_epoch;
+            // read leases (qts, clock) from each vt, applied to last_clocks once qts has been reached
+            std::vector<std::vector<std::pair<uint64_t, vc::vclock_t>>> read_leases;
             po6::threads::mutex queue_mutex;
             order::oracle time_oracle;
 
+
         private:
             queued_request* get_rd_req();
             queued_request* get_wr_req();
             queued_request* get_rw_req();
             bool check_rd_req_nonlocking(vc::vclock_t &clk);
             enum queue_order check_wr_queues_timestamps(uint64_t vt_id, uint64_t qt);
+            void apply_read_leases(uint64_t vt_id);
 
         public:
             queue_manager();
@@ -63,8 +69,12 @@ namespace db
             bool exec_queued_request(order::oracle *time_oracle);
             void increment_qts(uint64_t vt_id, uint64_t incr);
             void record_completed_tx(vc::vclock &tx_clk);
+            void add_read_lease(uint64_t vt_id, uint64_t lease_qts, vc::vclock &lease_clk);
+            std::vector<vc::vclock_t> get_last_clocks();
             void reset(uint64_t dead_vt, uint64_t epoch);
             void clear_queued_reads();
+            uint64_t num_queued_reads();
+            void rd_wait_stats(uint64_t &count, uint64_t &mean_nanos, uint64_t &p99_nanos);
     };
 
 }
@@ -29,6 +29,7 @@ namespace db
                 , vclock(vclk)
                 , func(f)
                 , arg(a)
+                , enqueue_time(0)
             { }
 
         public:
@@ -36,6 +37,7 @@ namespace db
             vc::vclock vclock;
             void (*func)(message_wrapper*);
             message_wrapper *arg;
+            uint64_t enqueue_time; // metrics::clock_ns() when queued
     };
 
     // for work queues
@@ -13,13 +13,19 @@
  */
 
 #include <deque>
+#include <algorithm>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <random>
+#include <thread>
+#include <chrono>
+#include <iterator>
+#include <unordered_set>
 #include <signal.h>
+#include <unistd.h>
 #include <e/popt.h>
 #include <e/buffer.h>
-#include <pugixml.hpp>
 
 #define weaver_debug_
 #include "common/weaver_constants.h"
@@ -28,6 +34,7 @@
 #include "db/shard.h"
 #include "db/message_wrapper.h"
 #include "db/remote_node.h"
+#include "db/graphml_reader.h"
 #include "node_prog/node.h"
 #include "node_prog/node_prog_type.h"
 #include "node_prog/node_program.h"
@@ -42,9 +49,16 @@ using vc::vclock_ptr_t;
 static uint64_t shard_id;
 // shard pointer for shard.cc
 static db::shard *S;
+// edges created at this shard by bulk load threads
+static std::atomic<uint64_t> bulk_load_edge_count(0);
+static const char *traversal_stats_file = nullptr;
+static const char *metrics_file = nullptr;
+// storage stub of the worker thread, for writes to this shard's local storage
+static thread_local db::hyper_stub *worker_hstub = nullptr;
 
 void migrated_nbr_update(std::unique_ptr<message::message> msg);
 bool migrate_node_step1(db::node*, std::vector<uint64_t>&, uint64_t);
+void migrate_batch_begin();
 void migrate_node_step2_req();
 void migrate_node_step2_resp(std::unique_ptr<message::message> msg, order::oracle *time_oracle);
 bool check_step3();
@@ -54,6 +68,30 @@ void migration_wrapper();
 void migration_end();
 
 
+// resident set size of this process in bytes
+inline uint64_t
+resident_memory()
+{
+    uint64_t size = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// peak resident set size of this process in bytes
+inline uint64_t
+peak_resident_memory()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+        }
+    }
+    return 0;
+}
+
 // parse the string 'line' as a uint64_t starting at index 'idx' till the first whitespace or end of string
 // store result in 'n'
 // if overflow occurs or unexpected char encountered, store true in 'bad'
@@ -170,44 +208,244 @@ split(const std::string &s, char delim, std::vector<std::string> &elems)
     }
 }
 
-inline bool
-get_xml_element(std::ifstream &file, const std::string &name, std::string &element)
+// graphml bulk load: elements parsed by one load thread and owned by another are handed over through inboxes
+struct graphml_inbox
 {
+    po6::threads::mutex mtx;
+    std::vector<db::graphml_element> elems;
+};
+static graphml_inbox *graphml_inboxes;
+static std::atomic<int> graphml_parsing_threads;
+
+// weaver format bulk load: shard of each node, as assigned by weaver-repartition
+static std::unordered_map<uint64_t, uint64_t> weaver_placement;
+static uint64_t weaver_placement_lines; // declared in the header, load threads skip exactly these
+
+// read the placement lines at the start of a weaver format file, before the load threads start
+bool
+load_weaver_placement(const char *graph_file)
+{
+    std::ifstream file(graph_file, std::ifstream::in);
     std::string line;
-    bool in_elem = false;
-    size_t pos;
-    std::string start = "<"+name;
-    std::string end = "</"+name+">";
-
-    while(std::getline(file, line)) {
-        bool appended = false;
-        if ((pos = line.find(start)) != std::string::npos) {
-            if (in_elem) {
-                return false;
+    if (!file || !std::getline(file, line) || line.length() < 2 || line.length() > 20 || line[0] != '#'
+     || line.find_first_not_of("0123456789", 1) != std::string::npos) {
+        WDEBUG << "weaver format graph file must begin with \"#<num_nodes>\"" << std::endl;
+        return false;
+    }
+
+    uint64_t num_nodes = std::stoull(line.substr(1));
+    weaver_placement_lines = num_nodes;
+    weaver_placement.reserve(num_nodes);
+    uint64_t node, loc;
+    for (uint64_t i = 0; i < num_nodes; i++) {
+        if (!std::getline(file, line)) {
+            WDEBUG << "weaver format graph file has " << i << " placement lines, expected " << num_nodes << std::endl;
+            return false;
+        }
+        if (line.empty() || line[0] == '#' || parse_two_uint64(line, node, loc) == (size_t)-1) {
+            WDEBUG << "weaver format graph file has bad placement line " << i << ": " << line << std::endl;
+            return false;
+        }
+        weaver_placement[node] = loc;
+    }
+
+    return true;
+}
+
+inline uint64_t
+weaver_node_loc(uint64_t node, uint64_t hash, uint64_t num_shards)
+{
+    auto iter = weaver_placement.find(node);
+    if (iter == weaver_placement.end()) {
+        return (hash % num_shards) + ShardIdIncr;
+    } else {
+        return (iter->second % num_shards) + ShardIdIncr;
+    }
+}
+
+// number of nodes of the graph file that this shard loads, for sizing the node filter before the load
+// SNAP headers usually declare the node count ("#42" or "# Nodes: 42 Edges: 99"), otherwise the
+// nodes in a prefix of the file are counted and scaled to the file size, which overestimates for
+// edge lists whose later lines mostly repeat earlier nodes
+uint64_t
+estimate_bulk_load_nodes(db::graph_file_format format, const char *graph_file, uint64_t num_shards)
+{
+    uint64_t file_sz = db::graphml_reader::file_size(graph_file);
+    uint64_t sample_sz = std::min(file_sz, (uint64_t)NODE_FILTER_SAMPLE_BYTES);
+    if (sample_sz == 0) {
+        return 0;
+    }
+
+    switch (format) {
+        case db::WEAVER: {
+            uint64_t count = 0;
+            for (const auto &p: weaver_placement) {
+                if ((p.second % num_shards) + ShardIdIncr == S->shard_id) {
+                    count++;
+                }
             }
-            in_elem = true;
-            element.append(line);
-            appended = true;
+            return count;
         }
 
-        if ((pos = line.find(end)) != std::string::npos) {
-            if (!in_elem) {
-                return false;
+        case db::GRAPHML: {
+            db::graphml_reader reader(graph_file, 0, sample_sz);
+            db::graphml_element elem;
+            uint64_t sample_nodes = 0;
+            while (reader.next(elem)) {
+                if (elem.is_node) {
+                    sample_nodes++;
+                }
             }
-            if (!appended) {
-                element.append(line);
-                appended = true;
+            return (uint64_t)((double)sample_nodes * file_sz / sample_sz / num_shards);
+        }
+
+        default: {
+            std::ifstream file(graph_file, std::ifstream::in);
+            std::string line;
+            std::unordered_set<uint64_t> sample_nodes;
+            uint64_t read_sz = 0;
+            bool header = true;
+            while (read_sz < sample_sz && std::getline(file, line)) {
+                read_sz += line.length() + 1;
+                if (line.empty()) {
+                    continue;
+                } else if (line[0] == '#') {
+                    if (!header) {
+                        continue;
+                    }
+                    size_t pos = line.find("Nodes:");
+                    if (pos == std::string::npos) {
+                        if (line.length() > 1 && line.length() <= 20
+                         && line.find_first_not_of("0123456789", 1) == std::string::npos) {
+                            return std::stoull(line.substr(1)) / num_shards;
+                        }
+                        continue;
+                    }
+                    pos = line.find_first_not_of(" \t", pos + 6);
+                    if (pos != std::string::npos && isdigit(line[pos])) {
+                        return std::stoull(line.substr(pos)) / num_shards;
+                    }
+                } else if (isdigit(line[0])) {
+                    header = false;
+                    uint64_t node0, node1;
+                    if (parse_two_uint64(line, node0, node1) != (size_t)-1) {
+                        sample_nodes.emplace(node0);
+                        sample_nodes.emplace(node1);
+                    }
+                }
             }
-            return true;
+            return read_sz == 0? 0 : (uint64_t)((double)sample_nodes.size() * file_sz / read_sz / num_shards);
         }
+    }
+}
 
-        if (!appended && in_elem) {
-            element.append(line);
-            appended = true;
+// create node, or edge at its source node, with properties
+// edges whose source node is not yet created are moved to 'pending' if it is not null
+inline void
+load_graphml_element(db::graphml_element &elem, uint64_t num_shards, vclock_ptr_t &zero_clk,
+    std::vector<db::graphml_element> *pending, uint64_t &node_count, uint64_t &edge_count)
+{
+    bool prop_delim = (BulkLoadPropertyValueDelimiter != '\0');
+
+    if (elem.is_node) {
+        const node_handle_t &id0 = elem.id;
+        uint64_t map_idx = db::node_directory::stripe_of(hash_node_handle(id0));
+        db::node *n = S->bulk_load_acquire_node_nonlocking(id0, map_idx);
+        assert(n == nullptr);
+        n = S->create_node_bulk_load(id0, map_idx, zero_clk);
+
+        for (const auto &prop: elem.data) {
+            const std::string &key = prop.first;
+            const std::string &value = prop.second;
+            if (!prop_delim || value.empty()) {
+                (key == BulkLoadNodeAliasKey)? S->add_node_alias_nonlocking(n, value) :
+                                               S->set_node_property_nonlocking(n, key, value, zero_clk);
+            } else {
+                std::vector<std::string> values;
+                split(value, BulkLoadPropertyValueDelimiter, values);
+                for (std::string &v: values) {
+                    (key == BulkLoadNodeAliasKey)? S->add_node_alias_nonlocking(n, v) :
+                                                   S->set_node_property_nonlocking(n, key, v, zero_clk);
+                }
+            }
+        }
+        if (++node_count % 10000 == 0) {
+            WDEBUG << "GRAPHML node " << node_count << std::endl;
+        }
+    } else {
+        const node_handle_t &id0 = elem.source;
+        const node_handle_t &id1 = elem.target;
+        uint64_t map_idx = db::node_directory::stripe_of(hash_node_handle(id0));
+        db::node *n = S->bulk_load_acquire_node_nonlocking(id0, map_idx);
+        if (n == nullptr) {
+            if (pending != nullptr) {
+                pending->emplace_back(std::move(elem));
+            } else {
+                WDEBUG << "GRAPHML edge source node " << id0 << " not found, skipping edge" << std::endl;
+            }
+            return;
+        }
+
+        // edges without an id are named by their position in the file
+        edge_handle_t edge_handle = elem.id.empty()? BulkLoadEdgeHandlePrefix + std::to_string(elem.offset) : elem.id;
+        uint64_t loc1 = (hash_node_handle(id1) % num_shards) + ShardIdIncr;
+        S->create_edge_bulk_load(n, edge_handle, id1, loc1, zero_clk);
+
+        for (const auto &prop: elem.data) {
+            const std::string &key = prop.first;
+            const std::string &value = prop.second;
+
+            if (key == BulkLoadEdgeIndexKey) {
+                n->add_temp_index(value);
+            }
+
+            if (!prop_delim || value.empty()) {
+                S->set_edge_property_bulk_load(n, edge_handle, key, value, zero_clk);
+            } else {
+                std::vector<std::string> values;
+                split(value, BulkLoadPropertyValueDelimiter, values);
+                for (std::string &v: values) {
+                    S->set_edge_property_bulk_load(n, edge_handle, key, v, zero_clk);
+                }
+            }
+        }
+
+        if (++edge_count % 10000 == 0) {
+            WDEBUG << "GRAPHML edge " << edge_count << std::endl;
         }
     }
+}
 
-    return false;
+inline void
+graphml_handoff(int owner, std::vector<db::graphml_element> &elems)
+{
+    if (elems.empty()) {
+        return;
+    }
+    graphml_inbox &inbox = graphml_inboxes[owner];
+    inbox.mtx.lock();
+    if (inbox.elems.empty()) {
+        inbox.elems.swap(elems);
+    } else {
+        std::move(elems.begin(), elems.end(), std::back_inserter(inbox.elems));
+    }
+    inbox.mtx.unlock();
+    elems.clear();
+}
+
+inline void
+graphml_drain(int load_tid, uint64_t num_shards, vclock_ptr_t &zero_clk,
+    std::vector<db::graphml_element> &pending, uint64_t &node_count, uint64_t &edge_count)
+{
+    std::vector<db::graphml_element> elems;
+    graphml_inbox &inbox = graphml_inboxes[load_tid];
+    inbox.mtx.lock();
+    elems.swap(inbox.elems);
+    inbox.mtx.unlock();
+
+    for (db::graphml_element &e: elems) {
+        load_graphml_element(e, num_shards, zero_clk, &pending, node_count, edge_count);
+    }
 }
 
 // initial bulk graph loading method
@@ -249,16 +487,29 @@ load_graph(db::graph_file_format format, const char *graph_file, uint64_t num_sh
                     parse_two_uint64(line, node0, node1);
                     ++edge_count;
 
-                    node_handle_t id0 = std::to_string(node0);
-                    uint64_t hash0 = hash_node_handle(id0);
+                    // every load thread reads every line, with numeric handle hashing
+                    // the handle strings are built only for lines that this thread loads
+                    node_handle_t id0, id1;
+                    uint64_t hash0, hash1;
+                    if (NumericHandleHash) {
+                        hash0 = hash_node_id(node0);
+                        hash1 = hash_node_id(node1);
+                    } else {
+                        id0 = std::to_string(node0);
+                        hash0 = hash_node_handle(id0);
+                        id1 = std::to_string(node1);
+                        hash1 = hash_node_handle(id1);
+                    }
                     uint64_t loc0 = ((hash0 % num_shards) + ShardIdIncr);
-                    node_handle_t id1 = std::to_string(node1);
-                    uint64_t hash1 = hash_node_handle(id1);
                     uint64_t loc1 = ((hash1 % num_shards) + ShardIdIncr);
 
-                    uint64_t map_idx = hash0 % NUM_NODE_MAPS;
+                    uint64_t map_idx = db::node_directory::stripe_of(hash0);
                     if ((loc0 == shard_id)
                      && ((int)map_idx % load_nthreads == load_tid)) {
+                        if (NumericHandleHash) {
+                            id0 = std::to_string(node0);
+                            id1 = std::to_string(node1);
+                        }
                         edge_handle_t edge_handle = BulkLoadEdgeHandlePrefix + std::to_string(edge_count);
                         db::node *n = S->bulk_load_acquire_node_nonlocking(id0, map_idx);
                         if (n == nullptr) {
@@ -270,8 +521,11 @@ load_graph(db::graph_file_format format, const char *graph_file, uint64_t num_sh
                     }
 
                     if (loc1 == shard_id) {
-                        uint64_t map_idx = hash1 % NUM_NODE_MAPS;
+                        uint64_t map_idx = db::node_directory::stripe_of(hash1);
                         if ((int)map_idx % load_nthreads == load_tid) {
+                            if (id1.empty()) {
+                                id1 = std::to_string(node1);
+                            }
                             if (!S->bulk_load_node_exists_nonlocking(id1, map_idx)) {
                                 S->create_node_bulk_load(id1, map_idx, zero_clk);
                                 cur_shard_node_count++;
@@ -280,105 +534,152 @@ load_graph(db::graph_file_format format, const char *graph_file, uint64_t num_sh
                     }
                 }
             }
+            bulk_load_edge_count += cur_shard_edge_count;
             S->bulk_load_persistent(load_tid);
             break;
         }
 
-        case db::GRAPHML: {
-            pugi::xml_document doc;
-            std::string element;
-
-            // nodes
-            bool prop_delim = (BulkLoadPropertyValueDelimiter != '\0');
+        case db::WEAVER: {
             uint64_t cur_shard_node_count = 0;
-            while (get_xml_element(file, "node", element) && !element.empty()) {
-                assert(doc.load_buffer(element.c_str(), element.size()));
-                pugi::xml_node node = doc.child("node");
-
-                node_handle_t id0 = node.attribute("id").value();
-                uint64_t hash0 = hash_node_handle(id0);
-                uint64_t loc = (hash0 % num_shards) + ShardIdIncr;
-                uint64_t map_idx = hash0 % NUM_NODE_MAPS;
-                if ((loc == shard_id) && ((int)map_idx % load_nthreads == load_tid)) {
-                    db::node *n = S->bulk_load_acquire_node_nonlocking(id0, map_idx);
-                    assert(n == nullptr);
+            uint64_t cur_shard_edge_count = 0;
+            bool prop_delim = (BulkLoadPropertyValueDelimiter != '\0');
+
+            // nodes first, so that every edge finds its source node
+            // header and placement lines were validated by load_weaver_placement
+            std::getline(file, line);
+            for (uint64_t i = 0; i < weaver_placement_lines && std::getline(file, line); i++) {
+                uint64_t node, loc;
+                parse_two_uint64(line, node, loc);
+                node_handle_t id = std::to_string(node);
+                uint64_t hash = NumericHandleHash? hash_node_id(node) : hash_node_handle(id);
+                uint64_t map_idx = db::node_directory::stripe_of(hash);
+                if ((loc % num_shards) + ShardIdIncr == shard_id
+                 && (int)map_idx % load_nthreads == load_tid
+                 && !S->bulk_load_node_exists_nonlocking(id, map_idx)) {
+                    S->create_node_bulk_load(id, map_idx, zero_clk);
+                    cur_shard_node_count++;
+                }
+            }
+
+            std::vector<std::pair<std::string, std::string>> props;
+            while (std::getline(file, line)) {
+                line_count++;
+                if (line_count % 100000 == 0) {
+                    WDEBUG << "WEAVER bulk loading: processed " << line_count << " edges, cur shard stats: "
+                           << cur_shard_node_count << " nodes, " << cur_shard_edge_count << " edges." << std::endl;
+                }
+                if ((line.length() == 0) || (line[0] == '#')) {
+                    continue;
+                }
+
+                uint64_t node0, node1;
+                props.clear();
+                parse_weaver_edge(line, node0, node1, props);
+                ++edge_count;
+
+                node_handle_t id0 = std::to_string(node0);
+                uint64_t hash0 = NumericHandleHash? hash_node_id(node0) : hash_node_handle(id0);
+                uint64_t map_idx = db::node_directory::stripe_of(hash0);
+                if (weaver_node_loc(node0, hash0, num_shards) != shard_id
+                 || (int)map_idx % load_nthreads != load_tid) {
+                    continue;
+                }
+
+                node_handle_t id1 = std::to_string(node1);
+                uint64_t hash1 = NumericHandleHash? hash_node_id(node1) : hash_node_handle(id1);
+                uint64_t loc1 = weaver_node_loc(node1, hash1, num_shards);
+
+                db::node *n = S->bulk_load_acquire_node_nonlocking(id0, map_idx);
+                if (n == nullptr) {
+                    // edge of a node missing from the placement lines
                     n = S->create_node_bulk_load(id0, map_idx, zero_clk);
+                    cur_shard_node_count++;
+                }
+                edge_handle_t edge_handle = BulkLoadEdgeHandlePrefix + std::to_string(edge_count);
+                S->create_edge_bulk_load(n, edge_handle, id1, loc1, zero_clk);
+                cur_shard_edge_count++;
 
-                    for (pugi::xml_node prop: node.children("data")) {
-                        std::string key = prop.attribute("key").value();
-                        std::string value = prop.child_value();
-                        if (!prop_delim || value.empty()) {
-                            (key == BulkLoadNodeAliasKey)? S->add_node_alias_nonlocking(n, value) :
-                                                           S->set_node_property_nonlocking(n, key, value, zero_clk);
-                        } else {
-                            std::vector<std::string> values;
-                            split(value, BulkLoadPropertyValueDelimiter, values);
-                            for (std::string &v: values) {
-                                (key == BulkLoadNodeAliasKey)? S->add_node_alias_nonlocking(n, v) :
-                                                               S->set_node_property_nonlocking(n, key, v, zero_clk);
-                            }
-                        }
+                for (const auto &prop: props) {
+                    if (prop.first == BulkLoadEdgeIndexKey) {
+                        n->add_temp_index(prop.second);
                     }
-                    if (++cur_shard_node_count % 10000 == 0) {
-                        WDEBUG << "GRAPHML node " << cur_shard_node_count << std::endl;
+                    if (!prop_delim || prop.second.empty()) {
+                        S->set_edge_property_bulk_load(n, edge_handle, prop.first, prop.second, zero_clk);
+                    } else {
+                        std::vector<std::string> values;
+                        split(prop.second, BulkLoadPropertyValueDelimiter, values);
+                        for (std::string &v: values) {
+                            S->set_edge_property_bulk_load(n, edge_handle, prop.first, v, zero_clk);
+                        }
                     }
                 }
-
-                element.clear();
             }
+            bulk_load_edge_count += cur_shard_edge_count;
+            S->bulk_load_persistent(load_tid);
+            break;
+        }
 
-
-            // edges
+        case db::GRAPHML: {
             file.close();
-            file.open(graph_file, std::ifstream::in);
-            element.clear();
-            uint64_t cur_shard_edge_count = 0;
-            while (get_xml_element(file, "edge", element) && !element.empty()) {
-                assert(doc.load_buffer(element.c_str(), element.size()));
-                pugi::xml_node edge = doc.child("edge");
-                edge_count++;
-
-                node_handle_t id0 = edge.attribute("source").value();
-                uint64_t hash0 = hash_node_handle(id0);
-                uint64_t loc0 = (hash0 % num_shards) + ShardIdIncr;
-                uint64_t map_idx = hash0 % NUM_NODE_MAPS;
-
-                if ((loc0 == shard_id) && ((int)map_idx % load_nthreads == load_tid)) {
-                    node_handle_t id1 = edge.attribute("target").value();
-                    edge_handle_t edge_handle = edge.attribute("id").value();
-                    uint64_t loc1 = (hash_node_handle(id1) % num_shards) + ShardIdIncr;
-
-                    db::node *n = S->bulk_load_acquire_node_nonlocking(id0, map_idx);
-                    assert(n != nullptr);
-                    S->create_edge_bulk_load(n, edge_handle, id1, loc1, zero_clk);
-
-                    for (pugi::xml_node prop: edge.children("data")) {
-                        std::string key = prop.attribute("key").value();
-                        std::string value = prop.child_value();
-
-                        if (key == BulkLoadEdgeIndexKey) {
-                            n->add_temp_index(value);
-                        }
 
-                        if (!prop_delim || value.empty()) {
-                            S->set_edge_property_bulk_load(n, edge_handle, key, value, zero_clk);
-                        } else {
-                            std::vector<std::string> values;
-                            split(value, BulkLoadPropertyValueDelimiter, values);
-                            for (std::string &v: values) {
-                                S->set_edge_property_bulk_load(n, edge_handle, key, v, zero_clk);
-                            }
+            // each thread parses one byte range of the file in a single pass, and hands
+            // elements of nodes owned by other load threads to them
+            uint64_t file_sz = db::graphml_reader::file_size(graph_file);
+            db::graphml_reader reader(graph_file, file_sz*load_tid/load_nthreads, file_sz*(load_tid+1)/load_nthreads);
+            if (!reader.good()) {
+                WDEBUG << "could not read " << graph_file << std::endl;
+            }
+
+            std::vector<std::vector<db::graphml_element>> outbox(load_nthreads);
+            std::vector<db::graphml_element> pending_edges;
+            uint64_t cur_shard_node_count = 0;
+            uint64_t cur_shard_edge_count = 0;
+            uint64_t parsed = 0;
+            db::graphml_element elem;
+
+            while (reader.next(elem)) {
+                const node_handle_t &owner_node = elem.is_node? elem.id : elem.source;
+                uint64_t hash = hash_node_handle(owner_node);
+                if ((hash % num_shards) + ShardIdIncr == shard_id) {
+                    int owner = (int)(db::node_directory::stripe_of(hash) % load_nthreads);
+                    if (owner == load_tid) {
+                        load_graphml_element(elem, num_shards, zero_clk, &pending_edges, cur_shard_node_count, cur_shard_edge_count);
+                    } else {
+                        outbox[owner].emplace_back(std::move(elem));
+                        if (outbox[owner].size() >= GRAPHML_HANDOFF_BATCH) {
+                            graphml_handoff(owner, outbox[owner]);
                         }
                     }
+                }
 
-                    if (++cur_shard_edge_count % 10000 == 0) {
-                        WDEBUG << "GRAPHML edge " << cur_shard_edge_count << std::endl;
-                    }
+                if (++parsed % GRAPHML_HANDOFF_BATCH == 0) {
+                    graphml_drain(load_tid, num_shards, zero_clk, pending_edges, cur_shard_node_count, cur_shard_edge_count);
+                }
+            }
+
+            for (int i = 0; i < load_nthreads; i++) {
+                graphml_handoff(i, outbox[i]);
+            }
+            graphml_parsing_threads--;
+
+            // keep taking elements from other threads till all of them are done parsing
+            while (true) {
+                bool all_parsed = (graphml_parsing_threads.load() == 0);
+                graphml_drain(load_tid, num_shards, zero_clk, pending_edges, cur_shard_node_count, cur_shard_edge_count);
+                if (all_parsed) {
+                    break;
                 }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
 
-                element.clear();
+            // edges seen before their source node
+            for (db::graphml_element &e: pending_edges) {
+                load_graphml_element(e, num_shards, zero_clk, nullptr, cur_shard_node_count, cur_shard_edge_count);
             }
 
+            WDEBUG << "GRAPHML load thread " << load_tid << " done, " << cur_shard_node_count << " nodes, "
+                   << cur_shard_edge_count << " edges, " << pending_edges.size() << " edges seen before their node" << std::endl;
+            bulk_load_edge_count += cur_shard_edge_count;
             S->bulk_load_persistent(load_tid);
             break;
         }
@@ -393,10 +694,10 @@ load_graph(db::graph_file_format format, const char *graph_file, uint64_t num_sh
 void
 migrated_nbr_update(std::unique_ptr<message::message> msg)
 {
-    node_handle_t node;
+    std::vector<node_handle_t> nodes;
     uint64_t old_loc, new_loc;
-    msg->unpack_message(message::MIGRATED_NBR_UPDATE, node, old_loc, new_loc);
-    S->update_migrated_nbr(node, old_loc, new_loc);
+    msg->unpack_message(message::MIGRATED_NBR_UPDATE, nodes, old_loc, new_loc);
+    S->update_migrated_nbrs(nodes, old_loc, new_loc);
 }
 
 void
@@ -408,7 +709,7 @@ migrated_nbr_ack(uint64_t from_loc, std::vector<vc::vclock_t> &target_prog_clk,
             S->target_prog_clk[i] = target_prog_clk[i];
         }
     }
-    S->migr_edge_acks[from_loc - ShardIdIncr] = true;
+    S->migr_edge_acks[from_loc - ShardIdIncr]++;
     S->shard_node_count[from_loc - ShardIdIncr] = node_count;
     S->migration_mutex.unlock();
 }
@@ -439,31 +740,58 @@ unpack_migrate_request(db::message_wrapper *request)
     delete request;
 }
 
+// write nodes to this shard's local storage
+// deleted nodes were removed by their delete tx, nodes moving out are written by their new shard
+bool
+persist_nodes(const std::vector<node_handle_t> &put, std::unordered_set<node_handle_t> &del, vc::vclock &clk)
+{
+    return worker_hstub->persist_nodes(put, del, clk,
+        [](const node_handle_t &handle) {
+            db::node *n = S->acquire_node_latest(handle);
+            if (n != nullptr
+             && (n->base.get_del_time() != nullptr || n->state == db::node::mode::MOVED)) {
+                S->release_node(n);
+                n = nullptr;
+            }
+            return n;
+        },
+        [](db::node *n) {
+            S->release_node(n);
+        });
+}
+
 void
 apply_writes(uint64_t vt_id, vclock_ptr_t vclk, uint64_t qts, transaction::pending_tx &tx)
 {
+    std::vector<node_handle_t> written; // for cache watches, aliases are not part of cache contexts
+
     // apply all writes
     // acquire_node_write blocks if a preceding write has not been executed
     for (auto upd: tx.writes) {
         switch (upd->type) {
             case transaction::EDGE_CREATE_REQ:
                 S->create_edge(upd->handle, upd->handle1, upd->handle2, upd->loc2, vclk, qts);
+                written.emplace_back(upd->handle1);
                 break;
 
             case transaction::NODE_DELETE_REQ:
                 S->delete_node(upd->handle1, vclk, qts);
+                written.emplace_back(upd->handle1);
                 break;
 
             case transaction::EDGE_DELETE_REQ:
                 S->delete_edge(upd->handle1, upd->handle2, vclk, qts);
+                written.emplace_back(upd->handle2);
                 break;
 
             case transaction::NODE_SET_PROPERTY:
                 S->set_node_property(upd->handle1, std::move(upd->key), std::move(upd->value), vclk, qts);
+                written.emplace_back(upd->handle1);
                 break;
 
             case transaction::EDGE_SET_PROPERTY:
                 S->set_edge_property(upd->handle1, upd->handle2, std::move(upd->key), std::move(upd->value), vclk, qts);
+                written.emplace_back(upd->handle2);
                 break;
 
             case transaction::ADD_AUX_INDEX:
@@ -475,9 +803,51 @@ apply_writes(uint64_t vt_id, vclock_ptr_t vclk, uint64_t qts, transaction::pendi
         }
     }
 
+    // invalidations go out before reads can see this tx
+    if (MaxCacheEntries) {
+        S->watches.end_tx(S, written);
+    }
+
     // record clocks for future reads
     S->record_completed_tx(*vclk);
 
+    // with local storage, the tx is durable at this shard before it is confirmed
+    if (StorageBackend == "local") {
+        std::vector<node_handle_t> put;
+        std::unordered_set<node_handle_t> del;
+        for (auto upd: tx.writes) {
+            switch (upd->type) {
+                case transaction::NODE_CREATE_REQ:
+                    put.emplace_back(upd->handle);
+                    break;
+
+                case transaction::EDGE_CREATE_REQ:
+                case transaction::NODE_SET_PROPERTY:
+                case transaction::ADD_AUX_INDEX:
+                    put.emplace_back(upd->handle1);
+                    break;
+
+                case transaction::EDGE_DELETE_REQ:
+                case transaction::EDGE_SET_PROPERTY:
+                    put.emplace_back(upd->handle2);
+                    break;
+
+                case transaction::NODE_DELETE_REQ:
+                    del.emplace(upd->handle1);
+                    break;
+
+                default:
+                    break;
+            }
+        }
+        std::sort(put.begin(), put.end());
+        put.erase(std::unique(put.begin(), put.end()), put.end());
+        if (!persist_nodes(put, del, *vclk)) {
+            WDEBUG << "local storage write failed for tx " << tx.id << ", exiting now." << std::endl;
+            exit(-1);
+        }
+    }
+
     // send tx confirmation to coordinator
     message::message conf_msg;
     conf_msg.prepare_message(message::TX_DONE, tx.id, shard_id);
@@ -494,6 +864,11 @@ unpack_tx_request(db::message_wrapper *request)
     request->msg->unpack_message(message::TX_INIT, vt_id, vclk, qts, tx);
     vclock_ptr_t vclk_ptr = std::make_shared<vc::vclock>(vclk);
 
+    // before qts moves, so that cache watermarks wait for this tx
+    if (MaxCacheEntries) {
+        S->watches.begin_tx();
+    }
+
     // execute all create_node writes
     // establish tx order at all graph nodes for all other writes
     db::node *n;
@@ -631,8 +1006,12 @@ nop(db::message_wrapper *request)
     // record clock; reads go through
     S->record_completed_tx(tx.timestamp);
 
-    // ack to VT
-    msg.prepare_message(message::VT_NOP_ACK, shard_id, qts, cur_node_count);
+    if (MaxCacheEntries) {
+        S->watches.send_watermark(S);
+    }
+
+    // ack to VT, queued reads tell the VT to send nops more often
+    msg.prepare_message(message::VT_NOP_ACK, shard_id, qts, cur_node_count, S->qm.num_queued_reads());
     S->comm.send(vt_id, msg.buf);
 
     // call appropriate function based on check after acked to vt
@@ -647,23 +1026,50 @@ nop(db::message_wrapper *request)
     delete request;
 }
 
+// node programs hold nodes shared, so two visits of the same request at a node
+// could race on the node state for that request.  such visits take turns
+inline void
+begin_node_visit(db::node *node, uint64_t req_id)
+{
+    node->prog_mtx.lock();
+    while (std::find(node->active_progs.begin(), node->active_progs.end(), req_id) != node->active_progs.end()) {
+        node->prog_cv.wait();
+    }
+    node->active_progs.emplace_back(req_id);
+    node->prog_mtx.unlock();
+}
+
+inline void
+end_node_visit(db::node *node, uint64_t req_id)
+{
+    node->prog_mtx.lock();
+    auto iter = std::find(node->active_progs.begin(), node->active_progs.end(), req_id);
+    assert(iter != node->active_progs.end());
+    node->active_progs.erase(iter);
+    node->prog_cv.broadcast();
+    node->prog_mtx.unlock();
+}
+
 node_prog::Node_State_Base*
 get_state_if_exists(db::node &node, uint64_t req_id, node_prog::prog_type ptype)
 {
+    node_prog::Node_State_Base *toRet = nullptr;
+    node.prog_mtx.lock();
     for (auto &state_pair: node.prog_states) {
         if (state_pair.first == ptype) {
             auto &state_map = state_pair.second;
-            std::shared_ptr<node_prog::Node_State_Base> toRet;
             auto state_iter = state_map.find(req_id);
             if (state_iter != state_map.end()) {
-                return state_iter->second.get();
+                toRet = state_iter->second.get();
+                break;
             } 
         }
     }
-    return nullptr;
+    node.prog_mtx.unlock();
+    return toRet;
 }
 
-// assumes holding node lock
+// assumes holding node, shared or exclusive
 template <typename NodeStateType>
 NodeStateType& get_or_create_state(node_prog::prog_type ptype,
     uint64_t req_id,
@@ -671,6 +1077,7 @@ NodeStateType& get_or_create_state(node_prog::prog_type ptype,
     std::vector<db::node_version_t> *nodes_that_created_state)
 {
     db::node::id_to_state_t *state_map = nullptr;
+    node->prog_mtx.lock();
     for (auto &state_pair: node->prog_states) {
         if (state_pair.first == ptype) {
             state_map = &state_pair.second;
@@ -684,10 +1091,13 @@ NodeStateType& get_or_create_state(node_prog::prog_type ptype,
 
     auto state_iter = state_map->find(req_id);
     if (state_iter != state_map->end()) {
-        return dynamic_cast<NodeStateType &>(*(state_iter->second));
+        NodeStateType &state = dynamic_cast<NodeStateType &>(*(state_iter->second));
+        node->prog_mtx.unlock();
+        return state;
     } else {
         NodeStateType *ptr = new NodeStateType();
         (*state_map)[req_id] = std::unique_ptr<node_prog::Node_State_Base>(ptr);
+        node->prog_mtx.unlock();
         assert(nodes_that_created_state != nullptr);
         nodes_that_created_state->emplace_back(std::make_pair(node->get_handle(), node->base.get_creat_time()));
         return *ptr;
@@ -742,7 +1152,66 @@ fill_changed_properties(
 #endif
 }
 
+// adds changes to edge e between time_cached and cur_time to the context of its node
+inline void
+fill_edge_context(db::edge *e,
+    uint64_t loc,
+    const node_handle_t &handle,
+    std::vector<node_prog::node_cache_context> &toFill,
+    node_prog::node_cache_context *&context,
+    vc::vclock &time_cached,
+    vc::vclock &cur_time,
+    order::oracle *time_oracle)
+{
+    assert(e != nullptr);
+    const vclock_ptr_t &e_del_time = e->base.get_del_time();
+
+    bool del_after_cached = (e_del_time != nullptr) && (time_oracle->compare_two_vts(time_cached, *e_del_time) == 0);
+    bool creat_after_cached = (time_oracle->compare_two_vts(time_cached, *e->base.get_creat_time()) == 0);
+
+    bool del_before_cur = (e_del_time != nullptr) && (time_oracle->compare_two_vts(*e_del_time, cur_time) == 0);
+    bool creat_before_cur = (time_oracle->compare_two_vts(*e->base.get_creat_time(), cur_time) == 0);
+
+    if (creat_after_cached && creat_before_cur && !del_before_cur) {
+        if (context == nullptr) {
+            toFill.emplace_back(loc, handle, false);
+            context = &toFill.back();
+        }
+
+        context->edges_added.emplace_back(e->get_handle(), e->nbr);
+        node_prog::edge_cache_context &edge_context = context->edges_added.back();
+        // don't care about props deleted before req time for an edge created after cache value was stored
+        fill_changed_properties(e->base.properties, &edge_context.props_added, nullptr, time_cached, cur_time, time_oracle);
+    } else if (del_after_cached && del_before_cur) {
+        if (context == nullptr) {
+            toFill.emplace_back(loc, handle, false);
+            context = &toFill.back();
+        }
+        context->edges_deleted.emplace_back(e->get_handle(), e->nbr);
+        node_prog::edge_cache_context &edge_context = context->edges_deleted.back();
+        // don't care about props added after cache time on a deleted edge
+        fill_changed_properties(e->base.properties, nullptr, &edge_context.props_deleted, time_cached, cur_time, time_oracle);
+    } else if (del_after_cached && !creat_after_cached) {
+        // see if any properties changed on edge that didnt change
+        std::vector<node_prog::property> temp_props_added;
+        std::vector<node_prog::property> temp_props_deleted;
+        fill_changed_properties(e->base.properties, &temp_props_added,
+                &temp_props_deleted, time_cached, cur_time, time_oracle);
+        if (!temp_props_added.empty() || !temp_props_deleted.empty()) {
+            if (context == nullptr) {
+                toFill.emplace_back(loc, handle, false);
+                context = &toFill.back();
+            }
+            context->edges_modified.emplace_back(e->get_handle(), e->nbr);
+
+            context->edges_modified.back().props_added = std::move(temp_props_added);
+            context->edges_modified.back().props_deleted = std::move(temp_props_deleted);
+        }
+    }
+}
+
 // records all changes to nodes given in ids vector between time_cached and cur_time
+// only edges in the change log of a node are examined, unless the log does not reach back to time_cached
 // returns false if cache should be invalidated
 inline bool
 fetch_node_cache_contexts(uint64_t loc,
@@ -753,13 +1222,13 @@ fetch_node_cache_contexts(uint64_t loc,
     order::oracle *time_oracle)
 {
     for (node_handle_t &handle: handles) {
-        db::node *node = S->acquire_node_version(handle, time_cached, time_oracle);
+        db::node *node = S->acquire_node_version_shared(handle, time_cached, time_oracle);
 
         if (node == nullptr
          || node->state == db::node::mode::MOVED
          || (node->last_perm_deletion != nullptr && time_oracle->compare_two_vts(time_cached, *node->last_perm_deletion) == 0)) {
             if (node != nullptr) {
-                S->release_node(node);
+                S->release_node_shared(node);
             }
             WDEBUG << "node not found or migrated or some data permanently deleted, invalidating cached value" << std::endl;
             toFill.clear(); // contexts aren't valid so don't send back
@@ -772,74 +1241,59 @@ fetch_node_cache_contexts(uint64_t loc,
                 toFill.emplace_back(loc, handle, true);
             } else {
                 node_prog::node_cache_context *context = nullptr;
-                std::vector<node_prog::property> temp_props_added;
-                std::vector<node_prog::property> temp_props_deleted;
 
-                fill_changed_properties(node->base.properties, &temp_props_added, &temp_props_deleted, time_cached, cur_time, time_oracle);
-                // check for changes to node properties
-                if (!temp_props_added.empty() || !temp_props_deleted.empty()) {
-                    toFill.emplace_back(loc, handle, false);
-                    context = &toFill.back();
-
-                    context->props_added = std::move(temp_props_added);
-                    context->props_deleted = std::move(temp_props_deleted);
-                    temp_props_added.clear();
-                    temp_props_deleted.clear();
+                // log is only written with the node held exclusively
+                bool use_log = node->change_log_covers(time_cached.clock);
+                bool props_changed = !use_log;
+                std::unordered_set<edge_handle_t> changed_edges;
+                if (use_log) {
+                    for (const db::change_entry &c: node->change_log) {
+                        if (order::oracle::happens_before_no_kronos(c.clk->clock, time_cached.clock)) {
+                            continue;
+                        }
+                        if (c.edge.empty()) {
+                            props_changed = true;
+                        } else {
+                            changed_edges.emplace(c.edge);
+                        }
+                    }
                 }
-                // now check for any edge changes
-                for (auto &iter: node->out_edges) {
-                    for (db::edge *e: iter.second) {
-                        assert(e != nullptr);
-                        const vclock_ptr_t &e_del_time = e->base.get_del_time();
 
-                        bool del_after_cached = (e_del_time != nullptr) && (time_oracle->compare_two_vts(time_cached, *e_del_time) == 0);
-                        bool creat_after_cached = (time_oracle->compare_two_vts(time_cached, *e->base.get_creat_time()) == 0);
+                // check for changes to node properties
+                if (props_changed) {
+                    std::vector<node_prog::property> temp_props_added;
+                    std::vector<node_prog::property> temp_props_deleted;
 
-                        bool del_before_cur = (e_del_time != nullptr) && (time_oracle->compare_two_vts(*e_del_time, cur_time) == 0);
-                        bool creat_before_cur = (time_oracle->compare_two_vts(*e->base.get_creat_time(), cur_time) == 0);
+                    fill_changed_properties(node->base.properties, &temp_props_added, &temp_props_deleted, time_cached, cur_time, time_oracle);
+                    if (!temp_props_added.empty() || !temp_props_deleted.empty()) {
+                        toFill.emplace_back(loc, handle, false);
+                        context = &toFill.back();
 
-                        if (creat_after_cached && creat_before_cur && !del_before_cur) {
-                            if (context == nullptr) {
-                                toFill.emplace_back(loc, handle, false);
-                                context = &toFill.back();
-                            }
+                        context->props_added = std::move(temp_props_added);
+                        context->props_deleted = std::move(temp_props_deleted);
+                    }
+                }
 
-                            context->edges_added.emplace_back(e->get_handle(), e->nbr);
-                            node_prog::edge_cache_context &edge_context = context->edges_added.back();
-                            // don't care about props deleted before req time for an edge created after cache value was stored
-                            fill_changed_properties(e->base.properties, &edge_context.props_added, nullptr, time_cached, cur_time, time_oracle);
-                        } else if (del_after_cached && del_before_cur) {
-                            if (context == nullptr) {
-                                toFill.emplace_back(loc, handle, false);
-                                context = &toFill.back();
-                            }
-                            context->edges_deleted.emplace_back(e->get_handle(), e->nbr);
-                            node_prog::edge_cache_context &edge_context = context->edges_deleted.back();
-                            // don't care about props added after cache time on a deleted edge
-                            fill_changed_properties(e->base.properties, nullptr, &edge_context.props_deleted, time_cached, cur_time, time_oracle);
-                        } else if (del_after_cached && !creat_after_cached) {
-                            // see if any properties changed on edge that didnt change
-                            fill_changed_properties(e->base.properties, &temp_props_added,
-                                    &temp_props_deleted, time_cached, cur_time, time_oracle);
-                            if (!temp_props_added.empty() || !temp_props_deleted.empty()) {
-                                if (context == nullptr) {
-                                    toFill.emplace_back(loc, handle, false);
-                                    context = &toFill.back();
-                                }
-                                context->edges_modified.emplace_back(e->get_handle(), e->nbr);
-
-                                context->edges_modified.back().props_added = std::move(temp_props_added);
-                                context->edges_modified.back().props_deleted = std::move(temp_props_deleted);
-
-                                temp_props_added.clear();
-                                temp_props_deleted.clear();
+                // now check for any edge changes
+                if (use_log) {
+                    for (const edge_handle_t &edge_handle: changed_edges) {
+                        auto iter = node->out_edges.find(edge_handle);
+                        if (iter != node->out_edges.end()) {
+                            for (db::edge *e: iter->second) {
+                                fill_edge_context(e, loc, handle, toFill, context, time_cached, cur_time, time_oracle);
                             }
                         }
                     }
+                } else {
+                    for (auto &iter: node->out_edges) {
+                        for (db::edge *e: iter.second) {
+                            fill_edge_context(e, loc, handle, toFill, context, time_cached, cur_time, time_oracle);
+                        }
+                    }
                 }
             }
         }
-        S->release_node(node);
+        S->release_node_shared(node);
     }
     return true;
 }
@@ -880,7 +1334,24 @@ struct fetch_state
     fetch_state& operator=(fetch_state const&) = delete;
 };
 
-/* precondition: node_to_check is locked when called
+// add_cache_func of node programs, stored values are registered with the shards of their watch set
+inline void
+cache_add(db::node *n, node_prog::prog_type type, std::shared_ptr<vc::vclock> vclk,
+    std::shared_ptr<node_prog::Cache_Value_Base> val,
+    std::shared_ptr<std::vector<db::remote_node>> watch_set,
+    cache_key_t key)
+{
+    db::cache_manager::dropped_list_t dropped;
+    bool added = S->cache_mgr.add(n, type, vclk, val, watch_set, key, dropped);
+    for (const auto &d: dropped) {
+        S->watches.forget(S, d.first, d.second);
+    }
+    if (added && !watch_set->empty()) {
+        S->watches.add_watches(S, n->get_handle(), key, *vclk, *watch_set);
+    }
+}
+
+/* precondition: node_to_check is held shared and visited by this request when called
    returns true if it has updated cached value or there is no valid one and the node prog loop should continue
    returns false and frees node if it needs to fetch context on other shards, saves required state to continue node program later
  */
@@ -894,17 +1365,25 @@ inline bool cache_lookup(db::node*& node_to_check,
     assert(node_to_check != nullptr);
     assert(!np.cache_value); // cache_value is not already assigned
     np.cache_value = nullptr; // it is unallocated anyway
-    if (node_to_check->cache.find(cache_key) == node_to_check->cache.end()) {
+    node_to_check->prog_mtx.lock();
+    auto cache_iter = node_to_check->cache.find(cache_key);
+    if (cache_iter == node_to_check->cache.end()) {
+        node_to_check->prog_mtx.unlock();
+        S->cache_mgr.record_lookup(node_to_check->get_handle(), np.prog_type_recvd, cache_key, false);
+        S->watches.forget(S, node_to_check->get_handle(), cache_key);
         return true;
     } else {
-        auto entry = node_to_check->cache[cache_key];
+        cache_iter->second.referenced = true;
+        db::cache_entry entry = cache_iter->second;
+        node_to_check->prog_mtx.unlock();
+        S->cache_mgr.record_lookup(node_to_check->get_handle(), np.prog_type_recvd, cache_key, true);
         std::shared_ptr<node_prog::Cache_Value_Base> cval = entry.val;
         std::shared_ptr<vc::vclock> time_cached(entry.clk);
         std::shared_ptr<std::vector<db::remote_node>> watch_set = entry.watch_set;
 
         auto state = get_state_if_exists(*node_to_check, np.req_id, np.prog_type_recvd);
         if (state != nullptr && state->contexts_found.find(np.req_id) != state->contexts_found.end()) {
-            np.cache_value.reset(new node_prog::cache_response<CacheValueType>(node_to_check->cache, cache_key, cval, watch_set));
+            np.cache_value.reset(new node_prog::cache_response<CacheValueType>(node_to_check->cache, &node_to_check->prog_mtx, cache_key, cval, watch_set));
 #ifdef weaver_debug_
             S->watch_set_lookups_mutex.lock();
             S->watch_set_nops++;
@@ -920,7 +1399,19 @@ inline bool cache_lookup(db::node*& node_to_check,
         assert(cmp_1 == 0);
 
         if (watch_set->empty()) { // no context needs to be fetched
-            np.cache_value.reset(new node_prog::cache_response<CacheValueType>(node_to_check->cache, cache_key, cval, watch_set));
+            np.cache_value.reset(new node_prog::cache_response<CacheValueType>(node_to_check->cache, &node_to_check->prog_mtx, cache_key, cval, watch_set));
+            return true;
+        }
+
+        if (S->watches.check(S, node_to_check->get_handle(), cache_key, *time_cached, *np.req_vclock, *watch_set)
+                == db::watch_registry::CLEAN) {
+            // watched shards have pushed no invalidation up to req_vclock, context is empty
+            np.cache_value.reset(new node_prog::cache_response<CacheValueType>(node_to_check->cache, &node_to_check->prog_mtx, cache_key, cval, watch_set));
+#ifdef weaver_debug_
+            S->watch_set_lookups_mutex.lock();
+            S->watch_set_pushed++;
+            S->watch_set_lookups_mutex.unlock();
+#endif
             return true;
         }
 
@@ -935,7 +1426,8 @@ inline bool cache_lookup(db::node*& node_to_check,
             fstate->prog_state.start_node_params.push_back(cur_node_params);
             fstate->monitor.unlock();
 
-            S->release_node(node_to_check);
+            end_node_visit(node_to_check, np.req_id);
+            S->release_node_shared(node_to_check);
             node_to_check = nullptr;
 
 #ifdef weaver_debug_
@@ -947,8 +1439,9 @@ inline bool cache_lookup(db::node*& node_to_check,
         }
 
         std::unique_ptr<node_prog::cache_response<CacheValueType>> future_cache_response(
-                new node_prog::cache_response<CacheValueType>(node_to_check->cache, cache_key, cval, watch_set));
-        S->release_node(node_to_check);
+                new node_prog::cache_response<CacheValueType>(node_to_check->cache, &node_to_check->prog_mtx, cache_key, cval, watch_set));
+        end_node_visit(node_to_check, np.req_id);
+        S->release_node_shared(node_to_check);
         node_to_check = nullptr;
 
         // add running state to shard global structure while context is being fetched
@@ -971,6 +1464,9 @@ inline bool cache_lookup(db::node*& node_to_check,
         }
 
         fstate->replies_left = contexts_to_fetch.size();
+        if (np.trace_id != 0) {
+            fstate->prog_state.fetch_start = metrics::clock_ns();
+        }
         fstate->prog_state.cache_value.swap(future_cache_response);
         fstate->prog_state.start_node_params.push_back(cur_node_params);
         fstate->cache_valid = true;
@@ -991,6 +1487,33 @@ inline bool cache_lookup(db::node*& node_to_check,
     } 
 }
 
+// spans of one hop of a traced node program
+// recorded before the messages that end the hop are sent, so that a trace fetch finds them
+inline void
+record_prog_hop(uint64_t trace_id, uint64_t hop_id, uint64_t parent_hop,
+    uint64_t acquire_ns, uint64_t exec_ns, uint64_t visits, uint64_t forwarded, bool returned)
+{
+    S->traces.record(trace_id, hop_id, parent_hop, prog_trace::ACQUIRE, acquire_ns);
+    S->traces.record(trace_id, hop_id, parent_hop, prog_trace::EXECUTED, exec_ns, visits);
+    if (forwarded > 0) {
+        S->traces.record(trace_id, hop_id, parent_hop, prog_trace::FORWARDED, 0, forwarded);
+    }
+    if (returned) {
+        S->traces.record(trace_id, hop_id, parent_hop, prog_trace::RETURNED, 0);
+    }
+}
+
+// batch of best first programs for another shard, cheapest first
+template <typename ParamsType>
+inline void
+sort_by_priority(std::deque<std::pair<node_handle_t, ParamsType>> &progs)
+{
+    std::stable_sort(progs.begin(), progs.end(),
+        [](const std::pair<node_handle_t, ParamsType> &p1, const std::pair<node_handle_t, ParamsType> &p2) {
+            return p1.second.priority() < p2.second.priority();
+        });
+}
+
 template <typename ParamsType, typename NodeStateType, typename CacheValueType>
 inline void node_prog_loop(typename node_prog::node_function_type<ParamsType, NodeStateType, CacheValueType>::value_type func,
         node_prog::node_prog_running_state<ParamsType, NodeStateType, CacheValueType> &np,
@@ -1013,25 +1536,52 @@ inline void node_prog_loop(typename node_prog::node_function_type<ParamsType, No
     bool done_request = false;
     db::remote_node this_node(S->shard_id, "");
 
-    while (!done_request && !np.start_node_params.empty()) {
+    // untraced programs only test this flag
+    bool traced = (np.trace_id != 0);
+    uint64_t trace_start = 0, trace_acquire_ns = 0, trace_exec_ns = 0, trace_visits = 0, trace_forwarded = 0;
+
+    // local hops of best first programs, a min heap on priority()
+    // remote hops are batched unordered and sorted when a batch is sent
+    std::vector<std::pair<node_handle_t, ParamsType>> best_first_heap;
+    auto costlier = [](const std::pair<node_handle_t, ParamsType> &p1, const std::pair<node_handle_t, ParamsType> &p2) {
+        return p1.second.priority() > p2.second.priority();
+    };
+    bool best_first = false;
+
+    while (!done_request && (!np.start_node_params.empty() || !best_first_heap.empty())) {
+        // cheapest of the heap and the received params, which senders sorted
+        if (!best_first_heap.empty()
+         && (np.start_node_params.empty()
+          || best_first_heap.front().second.priority() <= np.start_node_params.front().second.priority())) {
+            std::pop_heap(best_first_heap.begin(), best_first_heap.end(), costlier);
+            np.start_node_params.emplace_front(std::move(best_first_heap.back()));
+            best_first_heap.pop_back();
+        }
+
         auto &id_params = np.start_node_params.front();
         node_handle = id_params.first;
         ParamsType &params = id_params.second;
         this_node.handle = node_handle;
 
-        db::node *node = S->acquire_node_version(node_handle, *np.req_vclock, time_oracle);
+        if (traced) {
+            trace_start = metrics::clock_ns();
+        }
+        db::node *node = S->acquire_node_version_shared(node_handle, *np.req_vclock, time_oracle);
+        if (traced) {
+            trace_acquire_ns += metrics::clock_ns() - trace_start;
+        }
 
         if (node == nullptr
          || (node->base.get_del_time() != nullptr && time_oracle->compare_two_vts(*node->base.get_del_time(), *np.req_vclock) == 0)) {
             if (node != nullptr) {
-                S->release_node(node);
+                S->release_node_shared(node);
             } else {
                 // node is being migrated here, but not yet completed
                 std::vector<std::pair<node_handle_t, ParamsType>> buf_node_params;
                 buf_node_params.emplace_back(id_params);
                 std::unique_ptr<message::message> m(new message::message());
                 assert(np.req_vclock != nullptr);
-                m->prepare_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.vt_prog_ptr, buf_node_params);
+                m->prepare_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.trace_id, np.hop_id, np.vt_prog_ptr, buf_node_params);
                 S->migration_mutex.lock();
                 if (S->deferred_reads.find(node_handle) == S->deferred_reads.end()) {
                     S->deferred_reads.emplace(node_handle, std::vector<std::unique_ptr<message::message>>());
@@ -1047,27 +1597,23 @@ inline void node_prog_loop(typename node_prog::node_function_type<ParamsType, No
             fwd_node_params.emplace_back(id_params);
             std::unique_ptr<message::message> m(new message::message());
             assert(np.req_vclock != nullptr);
-            m->prepare_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.vt_prog_ptr, fwd_node_params);
+            m->prepare_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.trace_id, np.hop_id, np.vt_prog_ptr, fwd_node_params);
             uint64_t new_loc = node->migration->new_loc;
-            S->release_node(node);
+            S->release_node_shared(node);
             S->comm.send(new_loc, m->buf);
+            S->progs_forwarded++;
+            trace_forwarded++;
             np.start_node_params.pop_front(); // pop off this one
         } else { // node does exist
             assert(node->state == db::node::mode::STABLE);
-#ifdef WEAVER_NEW_CLDG
-            assert(false && "new_cldg not supported right now");
-                /*
-                if (np.prev_server >= ShardIdIncr) {
-                    node->migration->msg_count[np.prev_server - ShardIdIncr]++;
-                }
-                */
-#endif
             if (S->check_done_prog(*np.req_vclock)) {
                 done_request = true;
-                S->release_node(node);
+                S->release_node_shared(node);
                 break;
             }
 
+            begin_node_visit(node, np.req_id);
+
             if (MaxCacheEntries) {
                 if (params.search_cache() && !np.cache_value) {
                     // cache value not already found, lookup in cache
@@ -1080,9 +1626,8 @@ inline void node_prog_loop(typename node_prog::node_function_type<ParamsType, No
                 }
 
                 using namespace std::placeholders;
-                add_cache_func = std::bind(&db::node::add_cache_value, // function pointer
-                    node, // reference to object whose member-function is invoked
-                    np.req_vclock, // first argument of the function
+                add_cache_func = std::bind(cache_add, // function pointer
+                    node, np.prog_type_recvd, np.req_vclock, // first arguments of the function
                     _1, _2, _3); // 1 is cache value, 2 is watch set, 3 is key
             }
 
@@ -1093,10 +1638,17 @@ inline void node_prog_loop(typename node_prog::node_function_type<ParamsType, No
             assert(np.req_vclock != nullptr);
             assert(np.req_vclock->clock.size() == ClkSz);
             // call node program
+            if (traced) {
+                trace_start = metrics::clock_ns();
+            }
             auto next_node_params = func(*node, this_node,
                     params, // actual parameters for this node program
                     node_state_getter, add_cache_func,
                     (node_prog::cache_response<CacheValueType>*) np.cache_value.get());
+            if (traced) {
+                trace_exec_ns += metrics::clock_ns() - trace_start;
+                trace_visits++;
+            }
             if (MaxCacheEntries) {
                 if (np.cache_value) {
                     auto state = get_state_if_exists(*node, np.req_id, np.prog_type_recvd);
@@ -1108,14 +1660,14 @@ inline void node_prog_loop(typename node_prog::node_function_type<ParamsType, No
             }
             node->base.view_time = nullptr; 
             node->base.time_oracle = nullptr;
-            S->release_node(node);
+            end_node_visit(node, np.req_id);
+            S->release_node_shared(node);
             np.start_node_params.pop_front(); // pop off this one before potentially add new front
 
             // batch the newly generated node programs for onward propagation
-#ifdef WEAVER_CLDG
-            std::unordered_map<node_handle_t, uint32_t> agg_msg_count;
-#endif
+            uint64_t hop_weight = S->traffic.sample_visit();
             uint64_t num_shards = get_num_shards();
+            uint64_t local_hops = 0, remote_hops = 0;
             for (std::pair<db::remote_node, ParamsType> &res : next_node_params.second) {
                 db::remote_node& rn = res.first; 
                 assert(rn.loc < num_shards + ShardIdIncr);
@@ -1125,35 +1677,59 @@ inline void node_prog_loop(typename node_prog::node_function_type<ParamsType, No
                     // signal to send back to vector timestamper that issued request
                     std::unique_ptr<message::message> m(new message::message());
                     m->prepare_message(message::NODE_PROG_RETURN, np.prog_type_recvd, np.req_id, np.vt_prog_ptr, res.second);
+                    if (traced) {
+                        record_prog_hop(np.trace_id, np.hop_id, np.parent_hop,
+                            trace_acquire_ns, trace_exec_ns, trace_visits, trace_forwarded, true);
+                        traced = false;
+                    }
                     S->comm.send(np.vt_id, m->buf);
                     break; // can only send one message back
                 } else {
                     std::deque<std::pair<node_handle_t, ParamsType>> &next_deque = (rn.loc == S->shard_id) ? np.start_node_params : batched_node_progs[rn.loc]; // TODO this is dumb just have a single data structure later
                     if (next_node_params.first == node_prog::search_type::DEPTH_FIRST) {
                         next_deque.emplace_front(rn.handle, std::move(res.second));
+                    } else if (next_node_params.first == node_prog::search_type::BEST_FIRST) {
+                        // each shard relaxes its cheapest pending requests first
+                        best_first = true;
+                        if (rn.loc == S->shard_id) {
+                            best_first_heap.emplace_back(rn.handle, std::move(res.second));
+                            std::push_heap(best_first_heap.begin(), best_first_heap.end(), costlier);
+                        } else {
+                            next_deque.emplace_back(rn.handle, std::move(res.second));
+                        }
                     } else { // BREADTH_FIRST
                         next_deque.emplace_back(rn.handle, std::move(res.second));
                     }
-#ifdef WEAVER_CLDG
-                    agg_msg_count[node_handle]++;
-#endif
+                    if (rn.loc == S->shard_id) {
+                        local_hops++;
+                    } else {
+                        remote_hops++;
+                    }
+                    if (hop_weight > 0) {
+                        S->traffic.record(hop_weight, node_handle, rn);
+                    }
                 }
             }
-#ifdef WEAVER_CLDG
-            S->msg_count_mutex.lock();
-            for (auto &p: agg_msg_count) {
-                S->agg_msg_count[p.first] += p.second;
+
+            metrics::server_metrics &m = metrics::get();
+            m.prog_visits.inc();
+            if (local_hops > 0) {
+                m.prog_local_hops.add(local_hops);
+            }
+            if (remote_hops > 0) {
+                m.prog_remote_hops.add(remote_hops);
             }
-            S->msg_count_mutex.unlock();
-#endif
         }
         uint64_t num_shards = get_num_shards();
         assert(batched_node_progs.size() < num_shards);
         for (auto &loc_progs_pair : batched_node_progs) {
             assert(loc_progs_pair.first != shard_id && loc_progs_pair.first < num_shards + ShardIdIncr);
             if (loc_progs_pair.second.size() > BATCH_MSG_SIZE) {
+                if (best_first) {
+                    sort_by_priority(loc_progs_pair.second);
+                }
                 assert(np.req_vclock != nullptr);
-                out_msg.prepare_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.vt_prog_ptr, loc_progs_pair.second);
+                out_msg.prepare_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.trace_id, np.hop_id, np.vt_prog_ptr, loc_progs_pair.second);
                 S->comm.send(loc_progs_pair.first, out_msg.buf);
                 loc_progs_pair.second.clear();
             }
@@ -1162,13 +1738,21 @@ inline void node_prog_loop(typename node_prog::node_function_type<ParamsType, No
             assert(np.cache_value == false); // unique ptr is not assigned
         }
     }
+    if (traced) {
+        record_prog_hop(np.trace_id, np.hop_id, np.parent_hop,
+            trace_acquire_ns, trace_exec_ns, trace_visits, trace_forwarded, false);
+    }
+
     uint64_t num_shards = get_num_shards();
     if (!done_request) {
         for (auto &loc_progs_pair : batched_node_progs) {
             if (!loc_progs_pair.second.empty()) {
                 assert(loc_progs_pair.first != shard_id && loc_progs_pair.first < num_shards + ShardIdIncr);
+                if (best_first) {
+                    sort_by_priority(loc_progs_pair.second);
+                }
                 assert(np.req_vclock != nullptr);
-                out_msg.prepare_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.vt_prog_ptr, loc_progs_pair.second);
+                out_msg.prepare_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.trace_id, np.hop_id, np.vt_prog_ptr, loc_progs_pair.second);
                 S->comm.send(loc_progs_pair.first, out_msg.buf);
                 loc_progs_pair.second.clear();
             }
@@ -1187,7 +1771,7 @@ unpack_node_program(db::message_wrapper *request)
 
     request->msg->unpack_partial_message(message::NODE_PROG, pType);
     assert(node_prog::programs.find(pType) != node_prog::programs.end());
-    node_prog::programs[pType]->unpack_and_run_db(std::move(request->msg), request->time_oracle);
+    node_prog::programs[pType]->unpack_and_run_db(std::move(request->msg), request->time_oracle, request->enqueue_time);
     delete request;
 }
 
@@ -1202,6 +1786,13 @@ unpack_context_reply(db::message_wrapper *request)
     delete request;
 }
 
+void
+unpack_bsp_superstep(db::message_wrapper *request)
+{
+    S->bsp.superstep(S, std::move(request->msg));
+    delete request;
+}
+
 template <typename ParamsType, typename NodeStateType, typename CacheValueType>
 void
 node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueType> :: unpack_context_reply_db(std::unique_ptr<message::message> msg, order::oracle *time_oracle)
@@ -1246,7 +1837,11 @@ node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueType>
     }
 
     if (run_now) {
-        node_prog_loop<ParamsType, NodeStateType, CacheValueType>(enclosed_node_prog_func, fstate->prog_state, time_oracle);
+        node_prog::node_prog_running_state<ParamsType, NodeStateType, CacheValueType> &np = fstate->prog_state;
+        if (np.trace_id != 0) {
+            S->traces.record(np.trace_id, np.hop_id, np.parent_hop, prog_trace::CACHE_FETCH, metrics::clock_ns() - np.fetch_start, 1);
+        }
+        node_prog_loop<ParamsType, NodeStateType, CacheValueType>(enclosed_node_prog_func, np, time_oracle);
         fstate->monitor.unlock();
         delete fstate;
     }
@@ -1257,14 +1852,14 @@ node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueType>
 
 template <typename ParamsType, typename NodeStateType, typename CacheValueType>
 void
-node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueType> :: unpack_and_run_db(std::unique_ptr<message::message> msg, order::oracle *time_oracle)
+node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueType> :: unpack_and_run_db(std::unique_ptr<message::message> msg, order::oracle *time_oracle, uint64_t enqueue_time)
 {
     node_prog::node_prog_running_state<ParamsType, NodeStateType, CacheValueType> np;
 
     // unpack the node program
     try {
         np.req_vclock.reset(new vc::vclock());
-        msg->unpack_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.vt_prog_ptr, np.start_node_params);
+        msg->unpack_message(message::NODE_PROG, np.prog_type_recvd, np.vt_id, *np.req_vclock, np.req_id, np.trace_id, np.parent_hop, np.vt_prog_ptr, np.start_node_params);
         assert(np.req_vclock->clock.size() == ClkSz);
     } catch (std::bad_alloc &ba) {
         WDEBUG << "bad_alloc caught " << ba.what() << std::endl;
@@ -1284,6 +1879,13 @@ node_prog :: particular_node_program<ParamsType, NodeStateType, CacheValueType>
         return; // done request
     }
 
+    if (np.trace_id != 0) {
+        np.hop_id = S->traces.new_hop_id();
+        if (enqueue_time != 0) {
+            S->traces.record(np.trace_id, np.hop_id, np.parent_hop, prog_trace::QUEUED, metrics::clock_ns() - enqueue_time);
+        }
+    }
+
     assert(!np.cache_value); // a cache value should not be allocated yet
     node_prog_loop<ParamsType, NodeStateType, CacheValueType>(enclosed_node_prog_func, np, time_oracle);
 }
@@ -1316,7 +1918,7 @@ get_balanced_assignment(std::vector<uint64_t> &shard_node_count, std::vector<uin
 
 // decide node migration shard based on migration score
 // mark node as "moved" so that subsequent requests are queued up
-// send migration information to coordinator mapper
+// add node to the batch for this round, shard_node_count tracks the batch so far
 // return false if no migration happens (max migr score = this shard), else return true
 bool
 migrate_node_step1(db::node *n,
@@ -1351,43 +1953,52 @@ migrate_node_step1(db::node *n,
 
     // mark node as "moved"
     n->state = db::node::mode::MOVED;
+    if (MaxCacheEntries) {
+        S->watches.node_moved(S, n->get_handle());
+    }
     n->migration->new_loc = migr_loc;
-    S->migr_node = n->get_handle();
-    S->migr_shard = migr_loc;
-
-    // XXX updating edge map
-    //S->edge_map_mutex.lock();
-    //for (auto &x: n->out_edges) {
-    //    for (db::edge *e: x.second) {
-    //        const node_handle_t &remote_node = e->nbr.handle;
-    //        node_version_t local_node = std::make_pair(S->migr_node, e->base.get_creat_time());
-    //        S->remove_from_edge_map(remote_node, local_node);
-    //    }
-    //}
-    //S->edge_map_mutex.unlock();
 
+    node_handle_t handle = n->get_handle();
     S->release_node(n);
 
-    // update Hyperdex map for this node
-    S->update_node_mapping(S->migr_node, migr_loc);
+    S->migration_mutex.lock();
+    S->migr_batch.emplace_back(std::make_pair(handle, migr_loc));
+    S->migration_mutex.unlock();
+
+    shard_node_count[migr_loc - ShardIdIncr]++;
+    shard_node_count[shard_id - ShardIdIncr]--;
+
+    return true;
+}
+
+// update Hyperdex map for all nodes in the batch in one round trip, and begin migration
+void
+migrate_batch_begin()
+{
+    std::unordered_map<node_handle_t, uint64_t> mappings;
+
+    S->migration_mutex.lock();
+    for (const auto &p: S->migr_batch) {
+        mappings.emplace(p.first, p.second);
+    }
+    S->migr_round_start.get_clock();
+    S->migration_mutex.unlock();
+
+    S->update_node_mappings(mappings);
 
-    // begin migration
     S->migration_mutex.lock();
     S->current_migr = true;
     for (uint64_t &x: S->nop_count) {
         x = 0;
     }
     S->migration_mutex.unlock();
-
-    return true;
 }
 
-// pack node in big message and send to new location
+// pack nodes in big messages, one or more per new location
 void
 migrate_node_step2_req()
 {
-    db::node *n;
-    message::message msg;
+    std::unordered_map<uint64_t, std::vector<node_handle_t>> per_shard;
 
     S->migration_mutex.lock();
     S->current_migr = false;
@@ -1395,51 +2006,91 @@ migrate_node_step2_req()
         vc::vclock_t &target_clk = S->target_prog_clk[idx];
         std::fill(target_clk.begin(), target_clk.end(), 0);
     }
+    for (const auto &p: S->migr_batch) {
+        per_shard[p.second].emplace_back(p.first);
+    }
     S->migration_mutex.unlock();
 
-    n = S->acquire_node_latest(S->migr_node);
-    assert(n != nullptr);
-    msg.prepare_message(message::MIGRATE_SEND_NODE, S->migr_node, shard_id, *n);
-    S->release_node(n);
-    S->comm.send(S->migr_shard, msg.buf);
+    std::vector<std::pair<uint64_t, std::unique_ptr<message::message>>> msgs;
+    for (auto &p: per_shard) {
+        const std::vector<node_handle_t> &handles = p.second;
+        for (uint64_t begin = 0; begin < handles.size(); begin += MIGR_MSG_NODES) {
+            uint64_t end = std::min(begin + MIGR_MSG_NODES, (uint64_t)handles.size());
+            std::vector<node_handle_t> chunk(handles.begin() + begin, handles.begin() + end);
+            std::vector<db::node*> nodes;
+            nodes.reserve(chunk.size());
+            for (const node_handle_t &h: chunk) {
+                db::node *n = S->acquire_node_latest(h);
+                assert(n != nullptr);
+                nodes.emplace_back(n);
+            }
+
+            std::unique_ptr<message::message> msg(new message::message());
+            msg->prepare_message(message::MIGRATE_SEND_NODE, shard_id, chunk, nodes);
+            for (db::node *n: nodes) {
+                S->release_node(n);
+            }
+            msgs.emplace_back(std::make_pair(p.first, std::move(msg)));
+        }
+    }
+
+    // every shard acks each message once, counts are set before the first send
+    S->migration_mutex.lock();
+    S->migr_msgs_sent = msgs.size();
+    std::fill(S->migr_edge_acks.begin(), S->migr_edge_acks.end(), 0);
+    S->migration_mutex.unlock();
+
+    for (auto &m: msgs) {
+        S->comm.send(m.first, m.second->buf);
+    }
 }
 
-// receive and place node which has been migrated to this shard
-// apply buffered reads and writes to node
+// receive and place nodes which have been migrated to this shard
+// apply buffered reads and writes to nodes
 // update nbrs of migrated nbrs
 void
 migrate_node_step2_resp(std::unique_ptr<message::message> msg, order::oracle *time_oracle)
 {
-    // unpack and place node
+    // unpack and place nodes
+    enum message::msg_type mtype;
     uint64_t from_loc;
-    node_handle_t node_handle;
-    db::node *n;
+    std::vector<node_handle_t> handles;
+    std::vector<db::node*> nodes;
 
-    // create a new node, unpack the message
+    // create new nodes, unpack the message
+    // nodes are unpacked in place, so cannot use unpack_message
     vclock_ptr_t dummy_clock;
-    msg->unpack_partial_message(message::MIGRATE_SEND_NODE, node_handle);
-    n = S->create_node(node_handle, dummy_clock, true); // node will be acquired on return
+    e::unpacker unpacker = msg->buf->unpack_from(BUSYBEE_HEADER_SIZE);
+    message::unpack_buffer(unpacker, mtype);
+    assert(mtype == message::MIGRATE_SEND_NODE);
+    message::unpack_buffer(unpacker, from_loc);
+    message::unpack_buffer(unpacker, handles);
+    uint32_t num_nodes;
+    message::unpack_buffer(unpacker, num_nodes);
+    assert(num_nodes == handles.size());
+    nodes.reserve(num_nodes);
     try {
-        msg->unpack_message(message::MIGRATE_SEND_NODE, node_handle, from_loc, *n);
+        for (const node_handle_t &h: handles) {
+            db::node *n = S->create_node(h, dummy_clock, true); // node will be acquired on return
+            message::unpack_buffer(unpacker, *n);
+            S->in_edges.add_node(*n);
+            nodes.emplace_back(n);
+        }
     } catch (std::bad_alloc& ba) {
         WDEBUG << "bad_alloc caught " << ba.what() << std::endl;
         return;
     }
-
-    // XXX updating edge map
-    //S->edge_map_mutex.lock();
-    //for (auto &x: n->out_edges) {
-    //    for (db::edge *e: x.second) {
-    //        const node_handle_t &remote_node = e->nbr.handle;
-    //        S->edge_map[remote_node].emplace(std::make_pair(node_handle, e->base.get_creat_time()));
-    //    }
-    //}
-    //S->edge_map_mutex.unlock();
+    assert(!unpacker.error());
 
     S->migration_mutex.lock();
     // apply buffered writes
-    if (S->deferred_writes.find(node_handle) != S->deferred_writes.end()) {
-        for (auto &dw: S->deferred_writes[node_handle]) {
+    for (db::node *n: nodes) {
+        const node_handle_t &node_handle = n->get_handle();
+        auto dw_iter = S->deferred_writes.find(node_handle);
+        if (dw_iter == S->deferred_writes.end()) {
+            continue;
+        }
+        for (auto &dw: dw_iter->second) {
             switch (dw.type) {
                 case transaction::NODE_DELETE_REQ:
                     S->delete_node_nonlocking(n, dw.vclk);
@@ -1457,53 +2108,66 @@ migrate_node_step2_resp(std::unique_ptr<message::message> msg, order::oracle *ti
                     WDEBUG << "unexpected type" << std::endl;
             }
         }
-        S->deferred_writes.erase(node_handle);
+        S->deferred_writes.erase(dw_iter);
     }
 
-    // update nbrs
+    // update nbrs, one message per shard for the whole batch
     S->migr_updating_nbrs = true;
     for (uint64_t upd_shard = ShardIdIncr; upd_shard < ShardIdIncr + S->migr_edge_acks.size(); upd_shard++) {
         if (upd_shard == shard_id) {
             continue;
         }
-        msg->prepare_message(message::MIGRATED_NBR_UPDATE, node_handle, from_loc, shard_id);
+        msg->prepare_message(message::MIGRATED_NBR_UPDATE, handles, from_loc, shard_id);
         S->comm.send(upd_shard, msg->buf);
     }
-    n->state = db::node::mode::STABLE;
 
-    std::vector<uint64_t> prog_state_reqs;
-    for (auto &state_pair: n->prog_states) {
-        for (auto &state: state_pair.second) {
-            prog_state_reqs.emplace_back(state.first);
+    // nodes are in this shard's local storage before they are visible here
+    if (StorageBackend == "local") {
+        std::unordered_set<node_handle_t> no_del;
+        vc::vclock zero_clk(0, 0);
+        auto held = nodes.begin();
+        bool success = worker_hstub->persist_nodes(handles, no_del, zero_clk,
+            [&](const node_handle_t&) {
+                db::node *n = *held++;
+                return n->base.get_del_time() == nullptr? n : nullptr;
+            },
+            [](db::node*) { });
+        if (!success) {
+            WDEBUG << "local storage write failed for migrated nodes, exiting now." << std::endl;
+            exit(-1);
         }
     }
 
-    // release node for new reads and writes
-    std::vector<node_version_t> this_node_vec(1, std::make_pair(node_handle, n->base.get_creat_time()));
-    S->release_node(n);
-
-    //for (uint64_t req_id: prog_state_reqs) {
-    //    //XXX migration need req_vclock S->mark_nodes_using_state(req_id, this_node_vec);
-    //}
+    // release nodes for new reads and writes
+    for (db::node *n: nodes) {
+        n->state = db::node::mode::STABLE;
+        S->release_node(n);
+    }
 
     // move deferred reads to local for releasing migration_mutex
-    std::vector<std::unique_ptr<message::message>> deferred_reads;
-    if (S->deferred_reads.find(node_handle) != S->deferred_reads.end()) {
-        deferred_reads = std::move(S->deferred_reads[node_handle]);
-        S->deferred_reads.erase(node_handle);
+    std::vector<std::pair<node_handle_t, std::unique_ptr<message::message>>> deferred_reads;
+    for (const node_handle_t &node_handle: handles) {
+        auto dr_iter = S->deferred_reads.find(node_handle);
+        if (dr_iter != S->deferred_reads.end()) {
+            for (auto &m: dr_iter->second) {
+                deferred_reads.emplace_back(std::make_pair(node_handle, std::move(m)));
+            }
+            S->deferred_reads.erase(dr_iter);
+        }
     }
     S->migration_mutex.unlock();
 
     // update local nbrs
-    S->update_migrated_nbr(node_handle, from_loc, shard_id);
+    S->update_migrated_nbrs(handles, from_loc, shard_id);
 
     // apply buffered reads
-    for (auto &m: deferred_reads) {
+    for (auto &dr: deferred_reads) {
+        std::unique_ptr<message::message> &m = dr.second;
         node_prog::prog_type pType;
         m->unpack_partial_message(message::NODE_PROG, pType);
-        WDEBUG << "APPLYING BUFREAD for node " << node_handle << std::endl;
+        WDEBUG << "APPLYING BUFREAD for node " << dr.first << std::endl;
         assert(node_prog::programs.find(pType) != node_prog::programs.end());
-        node_prog::programs[pType]->unpack_and_run_db(std::move(m), time_oracle);
+        node_prog::programs[pType]->unpack_and_run_db(std::move(m), time_oracle, 0);
     }
 }
 
@@ -1512,22 +2176,62 @@ migrate_node_step2_resp(std::unique_ptr<message::message> msg, order::oracle *ti
 bool
 check_step3()
 {
-    bool init_step3 = weaver_util::all(S->migr_edge_acks);
+    if (S->migr_msgs_sent == 0) {
+        return false;
+    }
+    bool init_step3 = true;
+    for (uint64_t acks: S->migr_edge_acks) {
+        if (acks < S->migr_msgs_sent) {
+            init_step3 = false;
+            break;
+        }
+    }
     for (uint64_t i = 0; i < NumVts && init_step3; i++) {
         init_step3 = order::oracle::happens_before_no_kronos(S->target_prog_clk[i], S->migr_done_clk[i]);
     }
     if (init_step3) {
-        weaver_util::reset_all(S->migr_edge_acks);
+        std::fill(S->migr_edge_acks.begin(), S->migr_edge_acks.end(), 0);
+        S->migr_msgs_sent = 0;
         S->migr_updating_nbrs = false;
     }
     return init_step3;
 }
 
-// successfully migrated node to new location, continue migration process
+// successfully migrated batch of nodes to new locations, continue migration process
 void
 migrate_node_step3()
 {
-    S->delete_migrated_node(S->migr_node);
+    S->migration_mutex.lock();
+    std::vector<std::pair<node_handle_t, uint64_t>> batch = std::move(S->migr_batch);
+    S->migr_batch.clear();
+    wclock::weaver_timer round_time;
+    round_time -= S->migr_round_start;
+    S->migration_mutex.unlock();
+
+    for (const auto &p: batch) {
+        S->delete_migrated_node(p.first);
+    }
+
+    // the new shards have written these nodes to their own local storage
+    if (StorageBackend == "local") {
+        std::vector<node_handle_t> no_put;
+        std::unordered_set<node_handle_t> del;
+        for (const auto &p: batch) {
+            del.emplace(p.first);
+        }
+        vc::vclock zero_clk(0, 0);
+        if (!persist_nodes(no_put, del, zero_clk)) {
+            WDEBUG << "local storage write failed for migrated nodes, exiting now." << std::endl;
+            exit(-1);
+        }
+    }
+
+    double secs = round_time.get_secs();
+    if (secs > 0) {
+        WDEBUG << "migrated " << batch.size() << " nodes in " << secs << " s, "
+               << batch.size() / secs << " nodes/s" << std::endl;
+    }
+
     migration_wrapper();
 }
 
@@ -1552,15 +2256,15 @@ check_migr_node(db::node *n, uint64_t migr_num_shards)
     }
 }
 
-#ifdef WEAVER_CLDG
-// stream list of nodes and cldg repartition
+// stream nodes with sampled traffic, hottest first, and repartition by communication-LDG
 inline void
 cldg_migration_wrapper(std::vector<uint64_t> &shard_node_count, uint64_t migr_num_shards, uint64_t shard_cap)
 {
-    bool no_migr = true;
+    uint64_t batch_size = 0;
+    std::vector<double> traffic(migr_num_shards, 0);
     while (S->cldg_iter != S->cldg_nodes.end()) {
         db::node *n;
-        uint64_t migr_node = S->cldg_iter->first;
+        const node_handle_t &migr_node = S->cldg_iter->first;
         S->cldg_iter++;
         n = S->acquire_node_latest(migr_node);
 
@@ -1569,47 +2273,32 @@ cldg_migration_wrapper(std::vector<uint64_t> &shard_node_count, uint64_t migr_nu
             continue;
         }
 
-        // communication-LDG
-        for (uint64_t &cnt: n->migration->msg_count) {
-            cnt = 0;
-        }
-
-        db::edge *e;
-        // get aggregate msg counts per shard
-        //std::vector<uint64_t> msg_count(NumShards, 0);
-        for (auto &e_iter: n->out_edges) {
-            e = e_iter.second;
-            //msg_count[e->nbr.loc - ShardIdIncr] += e->msg_count;
-            n->migration->msg_count[e->nbr.loc - ShardIdIncr] += e->msg_count;
+        // score shards by sampled hops to them, the node may have gone cold since the round began
+        if (!S->traffic.node_traffic_to_shards(migr_node, traffic)) {
+            S->release_node(n);
+            continue;
         }
-        // EWMA update to msg count
-        //for (uint64_t i = 0; i < NumShards; i++) {
-        //    double new_val = 0.4 * n->msg_count[i] + 0.6 * msg_count[i];
-        //    n->msg_count[i] = new_val;
-        //}
-
-        // update migration score based on CLDG
-        for (uint64_t j = 0; j < migr_num_shards; j++) {
-            double penalty = 1.0 - ((double)shard_node_count[j])/shard_cap;
-            n->migration->migr_score[j] = n->migration->msg_count[j] * penalty;
+        for (uint64_t j = 0; j < migr_num_shards && j < traffic.size(); j++) {
+            n->migration->migr_score[j] = traffic[j] * (1 - ((double)shard_node_count[j])/shard_cap);
         }
 
-        if (migrate_node_step1(n, shard_node_count, migr_num_shards)) {
-            no_migr = false;
+        if (migrate_node_step1(n, shard_node_count, migr_num_shards)
+         && ++batch_size == MIGR_BATCH_NODES) {
             break;
         }
     }
-    if (no_migr) {
+    if (batch_size == 0) {
         migration_end();
+    } else {
+        migrate_batch_begin();
     }
 }
-#endif
 
 // stream list of nodes and ldg repartition
 inline void
 ldg_migration_wrapper(std::vector<uint64_t> &shard_node_count, uint64_t migr_num_shards, uint64_t shard_cap)
 {
-    bool no_migr = true;
+    uint64_t batch_size = 0;
     while (S->ldg_iter != S->ldg_nodes.end()) {
         db::node *n;
         const node_handle_t &migr_node = *S->ldg_iter;
@@ -1631,13 +2320,15 @@ ldg_migration_wrapper(std::vector<uint64_t> &shard_node_count, uint64_t migr_num
             n->migration->migr_score[j] *= (1 - ((double)shard_node_count[j])/shard_cap);
         }
 
-        if (migrate_node_step1(n, shard_node_count, migr_num_shards)) {
-            no_migr = false;
+        if (migrate_node_step1(n, shard_node_count, migr_num_shards)
+         && ++batch_size == MIGR_BATCH_NODES) {
             break;
         }
     }
-    if (no_migr) {
+    if (batch_size == 0) {
         migration_end();
+    } else {
+        migrate_batch_begin();
     }
 }
 
@@ -1655,21 +2346,11 @@ migration_wrapper()
     uint64_t num_shards = S->migr_num_shards;
     S->migration_mutex.unlock();
 
-#ifdef WEAVER_CLDG
-    cldg_migration_wrapper(shard_node_count, num_shards, shard_cap);
-#endif
-
-#ifdef WEAVER_NEW_CLDG
-    cldg_migration_wrapper(shard_node_count, num_shards, shard_cap);
-#else
-    ldg_migration_wrapper(shard_node_count, num_shards, shard_cap);
-#endif
-}
-
-// method to sort pairs based on second coordinate
-bool agg_count_compare(std::pair<node_handle_t, uint32_t> p1, std::pair<node_handle_t, uint32_t> p2)
-{
-    return (p1.second > p2.second);
+    if (S->migr_cldg) {
+        cldg_migration_wrapper(shard_node_count, num_shards, shard_cap);
+    } else {
+        ldg_migration_wrapper(shard_node_count, num_shards, shard_cap);
+    }
 }
 
 void
@@ -1679,39 +2360,14 @@ migration_begin()
     //S->ldg_nodes = S->node_list;
     //S->migration_mutex.unlock();
 
-#ifdef WEAVER_CLDG
-    S->msg_count_mutex.lock();
-    auto agg_msg_count = std::move(S->agg_msg_count);
-    S->msg_count_mutex.unlock();
-    std::vector<std::pair<node_handle_t, uint32_t>> sorted_nodes;
-    for (const node_handle_t &n: S->ldg_nodes) {
-        if (agg_msg_count.find(n) != agg_msg_count.end()) {
-            sorted_nodes.emplace_back(std::make_pair(n, agg_msg_count[n]));
-        } else {
-            sorted_nodes.emplace_back(std::make_pair(n, 0));
-        }
-    }
-    std::sort(sorted_nodes.begin(), sorted_nodes.end(), agg_count_compare);
-    S->cldg_nodes = std::move(sorted_nodes);
-    S->cldg_iter = S->cldg_nodes.begin();
-#endif
-
-#ifdef WEAVER_NEW_CLDG
-    uint64_t mcnt;
-    for (const node_handle_t &nid: S->ldg_nodes) {
-        mcnt = 0;
-        db::node *n = S->acquire_node_latest(nid);
-        for (uint64_t cnt: n->migration->msg_count) {
-            mcnt += cnt;
-        }
-        S->release_node(n);
-        S->cldg_nodes.emplace_back(std::make_pair(nid, mcnt));
+    // with traversal sampling on, only nodes that send traffic are worth moving
+    S->migr_cldg = (S->traffic.get_sample_period() > 0);
+    if (S->migr_cldg) {
+        S->traffic.hottest_nodes(S->cldg_nodes);
+        S->cldg_iter = S->cldg_nodes.begin();
+    } else {
+        S->ldg_iter = S->ldg_nodes.begin();
     }
-    std::sort(S->cldg_nodes.begin(), S->cldg_nodes.end(), agg_count_compare);
-    S->cldg_iter = S->cldg_nodes.begin();
-#else
-    S->ldg_iter = S->ldg_nodes.begin();
-#endif
 
     migration_wrapper();
 }
@@ -1734,6 +2390,64 @@ migration_end()
     S->comm.send(next_shard, msg.buf);
 }
 
+// sampled traversal counts for weaver-repartition, one "<src> <dst> <count>" line per pair of nodes
+void
+dump_traversal_stats()
+{
+    std::string fname = std::string(traversal_stats_file) + "." + std::to_string(shard_id);
+    std::ofstream file(fname, std::ofstream::out);
+    if (!file) {
+        WDEBUG << "could not open traversal stats file " << fname << std::endl;
+        return;
+    }
+
+    uint64_t lines = S->traffic.dump(file);
+    WDEBUG << "wrote " << lines << " node pair traversal counts to " << fname << std::endl;
+}
+
+// counters of this shard, beyond those in metrics::server_metrics
+void
+shard_metrics_extra(std::vector<std::pair<std::string, uint64_t>> &extra)
+{
+    S->watch_set_lookups_mutex.lock();
+    extra.emplace_back("watch_set_lookups", S->watch_set_lookups);
+    extra.emplace_back("watch_set_nops", S->watch_set_nops);
+    extra.emplace_back("watch_set_piggybacks", S->watch_set_piggybacks);
+    extra.emplace_back("watch_set_pushed", S->watch_set_pushed);
+    S->watch_set_lookups_mutex.unlock();
+
+    extra.emplace_back("edges_created", S->edges_created.load());
+    extra.emplace_back("cut_edges_created", S->cut_edges_created.load());
+    extra.emplace_back("progs_forwarded", S->progs_forwarded.load());
+    extra.emplace_back("nbr_locs_repaired", S->nbr_locs_repaired.load());
+    extra.emplace_back("in_edge_entries", S->in_edges.size());
+    extra.emplace_back("queued_reads", S->qm.num_queued_reads());
+    extra.emplace_back("nodes", S->get_node_count());
+}
+
+std::string
+shard_metrics_server()
+{
+    return "shard" + std::to_string(shard_id);
+}
+
+// rewrite metrics_file every METRICS_DUMP_INTERVAL_SECS
+void
+metrics_file_loop()
+{
+    timespec sleep_time;
+    sleep_time.tv_sec = METRICS_DUMP_INTERVAL_SECS;
+    sleep_time.tv_nsec = 0;
+    std::string fname = std::string(metrics_file) + "." + std::to_string(shard_id);
+    std::vector<std::pair<std::string, uint64_t>> extra;
+    while (true) {
+        nanosleep(&sleep_time, nullptr);
+        extra.clear();
+        shard_metrics_extra(extra);
+        metrics::dump_prometheus_file(fname, shard_metrics_server(), extra);
+    }
+}
+
 // server msg recv loop for the shard server
 void
 recv_loop(uint64_t thread_id)
@@ -1751,6 +2465,7 @@ recv_loop(uint64_t thread_id)
     busybee_returncode bb_code;
     enum db::queue_order tx_order;
     order::oracle *time_oracle = S->time_oracles[thread_id];
+    worker_hstub = S->hstub[thread_id];
 
     while (true) {
 
@@ -1768,6 +2483,7 @@ recv_loop(uint64_t thread_id)
             unpack_buffer(unpacker, mtype);
             rec_msg->change_type(mtype);
             vclk.clock.clear();
+            metrics::get().message_received(mtype, rec_msg->buf->size());
 
             switch (mtype) {
                 case message::TX_INIT: {
@@ -1841,6 +2557,44 @@ recv_loop(uint64_t thread_id)
                     break;
                 }
 
+                case message::BSP_SUPERSTEP:
+                    rec_msg->unpack_partial_message(message::BSP_SUPERSTEP, vt_id, vclk);
+                    assert(vclk.clock.size() == ClkSz);
+                    mwrap = new db::message_wrapper(mtype, std::move(rec_msg));
+                    if (S->qm.check_rd_request(vclk.clock)) {
+                        unpack_bsp_superstep(mwrap);
+                    } else {
+                        qreq = new db::queued_request(vclk.get_clock(), vclk, unpack_bsp_superstep, mwrap);
+                        S->qm.enqueue_read_request(vt_id, qreq);
+                    }
+                    break;
+
+                case message::BSP_MSGS:
+                    S->bsp.add_msgs(S, std::move(rec_msg));
+                    break;
+
+                case message::CACHE_WATCH:
+                    S->watches.recv_watch(S, std::move(rec_msg));
+                    break;
+
+                case message::CACHE_UNWATCH:
+                    S->watches.recv_unwatch(std::move(rec_msg));
+                    break;
+
+                case message::CACHE_INVALIDATE:
+                    S->watches.recv_invalidations(S, std::move(rec_msg));
+                    break;
+
+                case message::CACHE_WATERMARK:
+                    S->watches.recv_watermark(std::move(rec_msg));
+                    break;
+
+                case message::VT_READ_LEASE:
+                    rec_msg->unpack_message(message::VT_READ_LEASE, vt_id, vclk, qts);
+                    assert(vclk.clock.size() == ClkSz);
+                    S->qm.add_read_lease(vt_id, qts, vclk);
+                    break;
+
                 case message::MIGRATE_SEND_NODE:
                 case message::MIGRATED_NBR_UPDATE:
                 case message::MIGRATED_NBR_ACK:
@@ -1874,7 +2628,41 @@ recv_loop(uint64_t thread_id)
                     break;
                 }
 
+                case message::TRAVERSAL_SAMPLING: {
+                    uint64_t period;
+                    msg->unpack_message(message::TRAVERSAL_SAMPLING, period);
+                    S->traffic.set_sample_period(period);
+                    break;
+                }
+
+                case message::TRACE_FETCH: {
+                    uint64_t trace_id;
+                    rec_msg->unpack_message(message::TRACE_FETCH, vt_id, trace_id);
+                    std::vector<prog_trace::span> spans;
+                    S->traces.collect(trace_id, spans);
+                    rec_msg->prepare_message(message::TRACE_SPANS, trace_id, spans);
+                    S->comm.send(vt_id, rec_msg->buf);
+                    break;
+                }
+
+                case message::METRICS_REQ: {
+                    rec_msg->unpack_message(message::METRICS_REQ, vt_id, req_id);
+                    std::vector<std::pair<std::string, uint64_t>> extra;
+                    shard_metrics_extra(extra);
+                    std::ostringstream dump;
+                    metrics::dump_prometheus(dump, shard_metrics_server(), extra);
+                    rec_msg->prepare_message(message::METRICS_REPLY, req_id, dump.str());
+                    S->comm.send(vt_id, rec_msg->buf);
+                    break;
+                }
+
                 case message::EXIT_WEAVER:
+                    if (MaxCacheEntries) {
+                        S->cache_mgr.dump_stats();
+                    }
+                    if (traversal_stats_file != nullptr) {
+                        dump_traversal_stats();
+                    }
                     exit(0);
                     
                 default:
@@ -2048,6 +2836,18 @@ end_program(int param)
     WDEBUG << "watch_set lookups originated from this shard " << S->watch_set_lookups << std::endl;
     WDEBUG << "watch_set nops originated from this shard " << S->watch_set_nops << std::endl;
     WDEBUG << "watch set piggybacks on this shard " << S->watch_set_piggybacks << std::endl;
+    WDEBUG << "watch set lookups served by pushed invalidations " << S->watch_set_pushed << std::endl;
+    WDEBUG << "edges created on this shard " << S->edges_created
+           << ", to nodes on other shards " << S->cut_edges_created << std::endl;
+    uint64_t in_edge_entries = S->in_edges.size();
+    WDEBUG << "in edge index " << in_edge_entries << " entries, " << S->in_edges.bytes() << " bytes" << std::endl;
+    WDEBUG << "node progs forwarded to moved nodes " << S->progs_forwarded
+           << ", local nodes repaired after nbr migration " << S->nbr_locs_repaired << std::endl;
+    S->traffic.dump_stats();
+    uint64_t rd_waits, rd_wait_mean, rd_wait_p99;
+    S->qm.rd_wait_stats(rd_waits, rd_wait_mean, rd_wait_p99);
+    WDEBUG << "reads queued " << rd_waits << ", mean wait " << rd_wait_mean
+           << " ns, p99 wait < " << rd_wait_p99 << " ns" << std::endl;
 }
 
 int
@@ -2081,11 +2881,17 @@ main(int argc, const char *argv[])
             .description("full path of bulk load input graph file (no default)")
             .metavar("filename").as_string(&graph_file);
     ap.arg().long_name("graph-format")
-            .description("bulk load input graph format (default snap)")
+            .description("bulk load input graph format, snap, graphml or weaver (default snap)")
             .metavar("filename").as_string(&graph_format);
     ap.arg().long_name("bulk-load-num-shards")
             .description("number of shards during bulk loading (default 1)")
             .metavar("num").as_long(&bulk_load_num_shards);
+    ap.arg().long_name("traversal-stats")
+            .description("on exit, write sampled traversal counts to this file, suffixed with the shard id (default: none)")
+            .metavar("filename").as_string(&traversal_stats_file);
+    ap.arg().long_name("metrics-file")
+            .description("periodically write metrics of this shard to this file, suffixed with the shard id, in Prometheus text format (default: none)")
+            .metavar("filename").as_string(&metrics_file);
     ap.arg().long_name("log-file")
             .description("full path of file to write log to (default: stderr)")
             .metavar("filename").as_string(&log_file_name);
@@ -2166,13 +2972,29 @@ main(int argc, const char *argv[])
                 format = db::SNAP;
             } else if (strcmp(graph_format, "graphml") == 0) {
                 format = db::GRAPHML;
+            } else if (strcmp(graph_format, "weaver") == 0) {
+                format = db::WEAVER;
             } else {
                 WDEBUG << "Invalid/unsupported graph file format" << std::endl;
             }
 
+            // the load threads would parse a bad header or placement block as edges
+            if (format == db::WEAVER && !load_weaver_placement(graph_file)) {
+                WDEBUG << "invalid weaver format graph file, exiting now." << std::endl;
+                return -1;
+            }
+
             wclock::weaver_timer timer;
             uint64_t load_time = timer.get_time_elapsed();
 
+            // no node is created or looked up before the load threads start
+            S->size_node_filter(estimate_bulk_load_nodes(format, graph_file, (uint64_t)bulk_load_num_shards));
+
+            if (format == db::GRAPHML) {
+                graphml_inboxes = new graphml_inbox[NUM_SHARD_THREADS];
+                graphml_parsing_threads = NUM_SHARD_THREADS;
+            }
+
             std::vector<std::thread*> bulk_load_threads;
             for (int i = 0; i < NUM_SHARD_THREADS; i++) {
                 std::thread *t = new std::thread(load_graph, format, graph_file, (uint64_t)bulk_load_num_shards, i, NUM_SHARD_THREADS);
@@ -2182,14 +3004,27 @@ main(int argc, const char *argv[])
                 bulk_load_threads[i]->join();
                 delete bulk_load_threads[i];
             }
+            if (format == db::GRAPHML) {
+                delete[] graphml_inboxes;
+            }
 
             load_time = timer.get_time_elapsed() - load_time;
+            uint64_t num_edges = bulk_load_edge_count.load();
+            WDEBUG << "bulk loaded " << num_edges << " edges in " << ((double)load_time / NANO) << " s, memory per edge "
+                   << (num_edges == 0? 0 : resident_memory() / num_edges) << " bytes"
+                   << (NumericHandleHash? " (numeric handle hashing)" : "")
+                   << ", peak memory " << (peak_resident_memory() >> 20) << " MB" << std::endl;
             message::message msg;
             msg.prepare_message(message::LOADED_GRAPH, load_time);
             S->comm.send(ShardIdIncr, msg.buf);
         }
     }
 
+    if (metrics_file != nullptr) {
+        std::thread metrics_thr(metrics_file_loop);
+        metrics_thr.detach();
+    }
+
     std::cout << "Weaver: shard instance " << S->shard_id << std::endl;
     std::cout << "THIS IS AN ALPHA RELEASE WHICH SHOULD NOT BE USED IN PRODUCTION" << std::endl;
 
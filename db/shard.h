@@ -18,6 +18,7 @@
 #include <set>
 #include <map>
 #include <vector>
+#include <atomic>
 #include <unordered_map>
 #include <po6/threads/mutex.h>
 #include <po6/net/location.h>
@@ -37,15 +38,25 @@
 #include "common/server_manager_link_wrapper.h"
 #include "common/bool_vector.h"
 #include "common/utils.h"
+#include "common/bloom_filter.h"
+#include "common/clock.h"
+#include "common/metrics.h"
+#include "common/prog_trace.h"
 #include "db/shard_constants.h"
 #include "db/types.h"
 #include "db/element.h"
 #include "db/node.h"
+#include "db/node_directory.h"
 #include "db/edge.h"
 #include "db/queue_manager.h"
 #include "db/deferred_write.h"
 #include "db/del_obj.h"
 #include "db/hyper_stub.h"
+#include "db/bsp_engine.h"
+#include "db/cache_manager.h"
+#include "db/cache_watch.h"
+#include "db/in_edge_index.h"
+#include "db/traversal_stats.h"
 
 namespace db
 {
@@ -91,23 +102,26 @@ namespace db
             void increment_qts(uint64_t vt_id, uint64_t incr);
             void record_completed_tx(vc::vclock &tx_clk);
             void node_wait_and_mark_busy(node*);
+            void node_wait_and_mark_shared(node*);
             node* acquire_node_latest(const node_handle_t &node_handle);
             node* acquire_node_specific(const node_handle_t &node_handle, const vclock_ptr_t tcreat, const vclock_ptr_t tdel);
             node* acquire_node_version(const node_handle_t &node_handle, const vc::vclock &vclk, order::oracle*);
+            node* acquire_node_version_shared(const node_handle_t &node_handle, const vc::vclock &vclk, order::oracle*);
             node* acquire_node_write(const node_handle_t &node, uint64_t vt_id, uint64_t qts);
             node* bulk_load_acquire_node_nonlocking(const node_handle_t &node_handle, uint64_t map_idx);
             void release_node_write(node *n);
             void release_node(node *n, bool migr_node);
+            void release_node_shared(node *n);
+            bool try_pin_shared(node *n);
+            static void free_node(void *n);
 
             // Graph state
-            //XXX po6::threads::mutex edge_map_mutex;
-            po6::threads::mutex node_map_mutexes[NUM_NODE_MAPS];
             uint64_t shard_id;
             server_id serv_id;
-            // node handle -> ptr to node object
-            db::data_map<std::vector<node*>> nodes[NUM_NODE_MAPS];
-            std::unordered_map<node_handle_t, // node handle n ->
-                std::unordered_set<node_version_t, node_version_hash>> edge_map; // in-neighbors of n
+            // node handle -> versions of node object
+            // stripe mutexes of the directory also guard node waiting
+            node_directory nodes;
+            in_edge_index in_edges; // local nodes with edges to node n, for every n
         public:
             node* create_node(const node_handle_t &node_handle,
                 vclock_ptr_t vclk,
@@ -168,12 +182,17 @@ namespace db
             uint64_t get_node_count();
             bool bulk_load_node_exists_nonlocking(const node_handle_t &node_handle, uint64_t map_idx);
             node_handle_t node_exists_cache[NUM_NODE_MAPS];
+            // handles of nodes created at this shard, answers most bulk load misses without a directory probe
+            weaver_util::bloom_filter node_filter;
+            void size_node_filter(uint64_t num_nodes);
+            void rebuild_node_filter();
 
             // Initial graph loading
             po6::threads::mutex graph_load_mutex;
             uint64_t max_load_time, bulk_load_num_shards;
             uint32_t load_count;
             void bulk_load_persistent(int tid);
+            void send_bulk_load(int tid);
 
             // Permanent deletion
         public:
@@ -181,7 +200,6 @@ namespace db
             std::deque<del_obj*> perm_del_queue;
             std::vector<vc::vclock_t> permdel_done_clk;
             void delete_migrated_node(const node_handle_t &migr_node);
-            // XXX void remove_from_edge_map(const node_handle_t &remote_node, const node_version_t &local_node);
             void permanent_delete_loop(uint64_t vt_id, bool outstanding_progs, order::oracle *time_oracle);
         private:
             void permanent_node_delete(node *n);
@@ -190,20 +208,14 @@ namespace db
         public:
             po6::threads::mutex migration_mutex;
             bool current_migr, migr_updating_nbrs, migr_token, migrated;
-            node_handle_t migr_node;
-            uint64_t migr_chance, migr_shard, migr_token_hops, migr_num_shards, migr_vt;
-#ifdef WEAVER_CLDG
-            std::unordered_map<node_handle_t, uint32_t> agg_msg_count;
-            std::vector<std::pair<node_handle_t, uint32_t>> cldg_nodes;
-            std::vector<std::pair<node_handle_t, uint32_t>>::iterator cldg_iter;
-            po6::threads::mutex msg_count_mutex;
-#endif
-#ifdef WEAVER_NEW_CLDG
-            std::unordered_map<node_handle_t, uint32_t> agg_msg_count;
-            std::vector<std::pair<node_handle_t, uint32_t>> cldg_nodes;
-            std::vector<std::pair<node_handle_t, uint32_t>>::iterator cldg_iter;
-            po6::threads::mutex msg_count_mutex;
-#endif
+            std::vector<std::pair<node_handle_t, uint64_t>> migr_batch; // nodes moving out this round, and their new shard
+            uint64_t migr_msgs_sent; // MIGRATE_SEND_NODE messages this round, each is acked once by every shard
+            wclock::weaver_timer migr_round_start;
+            uint64_t migr_chance, migr_token_hops, migr_num_shards, migr_vt;
+            traversal_stats traffic;
+            bool migr_cldg; // this migration streams nodes with sampled traffic, hottest first
+            std::vector<std::pair<node_handle_t, double>> cldg_nodes;
+            std::vector<std::pair<node_handle_t, double>>::iterator cldg_iter;
             std::unordered_set<node_handle_t> ldg_nodes;
             std::unordered_set<node_handle_t>::iterator ldg_iter;
             std::vector<uint64_t> shard_node_count;
@@ -213,12 +225,12 @@ namespace db
             vc::vclock max_clk // to compare against for checking if node is deleted
                 , zero_clk; // all zero clock for migration thread in queue
             void update_migrated_nbr_nonlocking(node *n, const node_handle_t &migr_node, uint64_t old_loc, uint64_t new_loc);
-            void update_migrated_nbr(const node_handle_t &node, uint64_t old_loc, uint64_t new_loc);
-            void update_node_mapping(const node_handle_t &node, uint64_t shard);
+            void update_migrated_nbrs(const std::vector<node_handle_t> &migr_nodes, uint64_t old_loc, uint64_t new_loc);
+            void update_node_mappings(const std::unordered_map<node_handle_t, uint64_t> &mappings);
             std::vector<vc::vclock_t> max_seen_clk // largest clock seen from each vector timestamper
                 , target_prog_clk
                 , migr_done_clk; // largest clock of completed node prog for each VT
-            std::vector<bool> migr_edge_acks;
+            std::vector<uint64_t> migr_edge_acks; // MIGRATED_NBR_ACKs this round per shard
 
             // node programs
         private:
@@ -237,11 +249,21 @@ namespace db
 
             std::unordered_map<std::tuple<cache_key_t, uint64_t, node_handle_t>, void *> node_prog_running_states; // used for fetching cache contexts
             po6::threads::mutex node_prog_running_states_mutex;
+            cache_manager cache_mgr; // memory budget for node program caches of all nodes
+            watch_registry watches; // pushed invalidations for cache watch sets
+            prog_trace::recorder traces; // spans of sampled node programs
 
             po6::threads::mutex watch_set_lookups_mutex;
             uint64_t watch_set_lookups;
             uint64_t watch_set_nops;
             uint64_t watch_set_piggybacks;
+            uint64_t watch_set_pushed; // hits validated by pushed invalidations, no fetch
+            std::atomic<uint64_t> edges_created, cut_edges_created; // latter have nbrs on other shards
+            std::atomic<uint64_t> progs_forwarded; // node progs sent on to the new shard of a moved node
+            std::atomic<uint64_t> nbr_locs_repaired; // local nodes with edges updated after a nbr migrated
+
+            // bulk synchronous analytics
+            bsp_engine bsp;
 
             // fault tolerance
         public:
@@ -266,12 +288,15 @@ namespace db
         , to_exit(false)
         , shard_id(UINT64_MAX)
         , serv_id(serverid)
+        , node_filter(weaver_util::bloom_filter::bits_for(NODE_FILTER_MIN_NODES, NODE_FILTER_FP_RATE))
         , permdel_done_clk(NumVts, vc::vclock_t(ClkSz, 0))
         , current_migr(false)
         , migr_updating_nbrs(false)
+        , migr_msgs_sent(0)
         , migr_token(false)
         , migrated(false)
         , migr_chance(0)
+        , migr_cldg(false)
         , nop_count(NumVts, 0)
         , max_clk(UINT64_MAX, UINT64_MAX)
         , zero_clk(0, 0)
@@ -282,11 +307,12 @@ namespace db
         , watch_set_lookups(0)
         , watch_set_nops(0)
         , watch_set_piggybacks(0)
-    {
-        for (uint64_t i = 0; i < NUM_NODE_MAPS; i++) {
-            nodes[i].set_deleted_key("");
-        }
-    }
+        , watch_set_pushed(0)
+        , edges_created(0)
+        , cut_edges_created(0)
+        , progs_forwarded(0)
+        , nbr_locs_repaired(0)
+    { }
 
     // initialize: msging layer
     //           , chronos client
@@ -296,6 +322,9 @@ namespace db
     shard :: init(uint64_t shardid)
     {
         shard_id = shardid;
+        cache_mgr.init(CacheBudgetMB * 1024 * 1024);
+        traffic.init(NUM_SHARD_THREADS, TraversalSamplePeriod);
+        traces.init(NUM_SHARD_THREADS, shard_id);
         for (int i = 0; i < NUM_SHARD_THREADS; i++) {
             hstub.push_back(new hyper_stub(shard_id));
             time_oracles.push_back(new order::oracle());
@@ -333,10 +362,10 @@ namespace db
         shard_node_count.resize(num_shards, 0);
         if (migr_updating_nbrs) {
             // currently sent out request to update nbrs
-            // set all new members to true
-            migr_edge_acks.resize(num_shards, true);
+            // new members have nothing to ack
+            migr_edge_acks.resize(num_shards, migr_msgs_sent);
         } else {
-            migr_edge_acks.resize(num_shards, false);
+            migr_edge_acks.resize(num_shards, 0);
         }
         migration_mutex.unlock();
 
@@ -405,6 +434,50 @@ namespace db
     shard :: bulk_load_persistent(int tid)
     {
         hstub[tid]->memory_efficient_bulk_load(tid, nodes);
+        if (StorageBackend == "local") {
+            send_bulk_load(tid);
+        }
+    }
+
+    // with local storage, timestampers keep the node map and aux index, and validate writes against node data
+    inline void
+    shard :: send_bulk_load(int tid)
+    {
+        std::vector<node_handle_t> handles;
+        std::vector<node*> batch;
+        std::vector<std::pair<std::string, node_handle_t>> aliases;
+
+        auto send_batch = [&]() {
+            for (uint64_t i = 0; i < NumVts; i++) {
+                message::message msg;
+                msg.prepare_message(message::STORE_BULK_LOAD, shard_id, handles, batch, aliases);
+                comm.send(i, msg.buf);
+            }
+            handles.clear();
+            batch.clear();
+            aliases.clear();
+        };
+
+        for (int map_idx = tid; map_idx < NUM_NODE_MAPS; map_idx += NUM_SHARD_THREADS) {
+            nodes.for_each(map_idx, [&](const node_directory::versions &vers) {
+                node *n = vers.first;
+                handles.emplace_back(n->get_handle());
+                batch.emplace_back(n);
+                if (n->temp_aliases != nullptr) {
+                    for (const std::string &alias: *n->temp_aliases) {
+                        aliases.emplace_back(alias, n->get_handle());
+                    }
+                    n->done_temp_index();
+                }
+                if (batch.size() >= STORE_MSG_NODES) {
+                    send_batch();
+                }
+            });
+        }
+
+        if (!batch.empty()) {
+            send_batch();
+        }
     }
 
     // Consistency methods
@@ -420,15 +493,48 @@ namespace db
         qm.record_completed_tx(tx_clk);
     }
 
+    // exclusive access to node
+    // marking in_use first keeps out new readers, then wait for current readers to drain
     inline void
     shard :: node_wait_and_mark_busy(node *n)
     {
+        // clock is read only if the acquire has to wait
+        uint64_t start = 0;
         n->waiters++;
-        while (n->in_use) {
-            n->cv.wait();
+        if (n->in_use) {
+            start = metrics::clock_ns();
+            while (n->in_use) {
+                n->cv.wait();
+            }
         }
-        n->waiters--;
         n->in_use = true;
+        if (n->readers > 0) {
+            if (start == 0) {
+                start = metrics::clock_ns();
+            }
+            while (n->readers > 0) {
+                n->cv.wait();
+            }
+        }
+        n->waiters--;
+        if (start != 0) {
+            metrics::get().node_lock_wait_ns.record_since(start);
+        }
+    }
+
+    // shared access to node, for node programs which only read a snapshot of the node
+    // blocks only while the node is exclusively held
+    inline void
+    shard :: node_wait_and_mark_shared(node *n)
+    {
+        if (n->in_use) {
+            n->waiters++;
+            while (n->in_use) {
+                n->cv.wait();
+            }
+            n->waiters--;
+        }
+        n->readers++;
     }
 
     // nodes is map<handle, vector<node*>>
@@ -439,16 +545,17 @@ namespace db
     inline node*
     shard :: acquire_node_latest(const node_handle_t &node_handle)
     {
-        uint64_t map_idx = hash_node_handle(node_handle) % NUM_NODE_MAPS;
+        uint64_t hash = hash_node_handle(node_handle);
+        uint64_t map_idx = node_directory::stripe_of(hash);
 
         node *n = nullptr;
-        node_map_mutexes[map_idx].lock();
-        auto node_iter = nodes[map_idx].find(node_handle);
-        if (node_iter != nodes[map_idx].end() && !node_iter->second.empty()) {
-            n = node_iter->second.back();
+        node_directory::versions vers;
+        nodes.mutex(map_idx).lock();
+        if (nodes.find(node_handle, hash, vers)) {
+            n = vers.back();
             node_wait_and_mark_busy(n);
         }
-        node_map_mutexes[map_idx].unlock();
+        nodes.mutex(map_idx).unlock();
 
         return n;
     }
@@ -457,13 +564,17 @@ namespace db
     inline node*
     shard :: acquire_node_specific(const node_handle_t &node_handle, const vclock_ptr_t tcreat, const vclock_ptr_t tdel)
     {
-        uint64_t map_idx = hash_node_handle(node_handle) % NUM_NODE_MAPS;
+        uint64_t hash = hash_node_handle(node_handle);
+        uint64_t map_idx = node_directory::stripe_of(hash);
 
         node *n = nullptr;
-        node_map_mutexes[map_idx].lock();
-        auto node_iter = nodes[map_idx].find(node_handle);
-        if (node_iter != nodes[map_idx].end()) {
-            for (node *n_ver: node_iter->second) {
+        node_directory::versions vers;
+        // stay in read section while scanning, versions may change when waiting for a node
+        nodes.read_begin();
+        nodes.mutex(map_idx).lock();
+        if (nodes.find(node_handle, hash, vers)) {
+            for (uint64_t i = 0; i < vers.size(); i++) {
+                node *n_ver = vers[i];
                 node_wait_and_mark_busy(n_ver);
 
                 if ((tcreat && *n_ver->base.get_creat_time() == *tcreat)
@@ -473,12 +584,13 @@ namespace db
                 } else {
                     n_ver->in_use = false;
                     if (n_ver->waiters > 0) {
-                        n_ver->cv.signal();
+                        n_ver->cv.broadcast();
                     }
                 }
             }
         }
-        node_map_mutexes[map_idx].unlock();
+        nodes.mutex(map_idx).unlock();
+        nodes.read_end();
 
         return n;
     }
@@ -488,13 +600,16 @@ namespace db
     inline node*
     shard :: acquire_node_version(const node_handle_t &node_handle, const vc::vclock &vclk, order::oracle *time_oracle)
     {
-        uint64_t map_idx = hash_node_handle(node_handle) % NUM_NODE_MAPS;
+        uint64_t hash = hash_node_handle(node_handle);
+        uint64_t map_idx = node_directory::stripe_of(hash);
 
         node *n = nullptr;
-        node_map_mutexes[map_idx].lock();
-        auto node_iter = nodes[map_idx].find(node_handle);
-        if (node_iter != nodes[map_idx].end()) {
-            for (node *n_ver: node_iter->second) {
+        node_directory::versions vers;
+        nodes.read_begin();
+        nodes.mutex(map_idx).lock();
+        if (nodes.find(node_handle, hash, vers)) {
+            for (uint64_t i = 0; i < vers.size(); i++) {
+                node *n_ver = vers[i];
                 node_wait_and_mark_busy(n_ver);
 
                 if (time_oracle->clock_creat_before_del_after(vclk, n_ver->base.get_creat_time(), n_ver->base.get_del_time())) {
@@ -503,12 +618,82 @@ namespace db
                 } else {
                     n_ver->in_use = false;
                     if (n_ver->waiters > 0) {
-                        n_ver->cv.signal();
+                        n_ver->cv.broadcast();
+                    }
+                }
+            }
+        }
+        nodes.mutex(map_idx).unlock();
+        nodes.read_end();
+
+        return n;
+    }
+
+    // pin node for reading without the stripe mutex
+    // fails if node is exclusively held, or was removed from the directory
+    inline bool
+    shard :: try_pin_shared(node *n)
+    {
+        n->readers++;
+        if (n->in_use) {
+            release_node_shared(n);
+            return false;
+        }
+        return true;
+    }
+
+    // same as acquire_node_version, but node is held shared with other node programs
+    // common case does a lock free directory lookup and pins the node without the stripe mutex
+    // falls back to waiting under the stripe mutex if node is busy, or if lookup was inconclusive
+    inline node*
+    shard :: acquire_node_version_shared(const node_handle_t &node_handle, const vc::vclock &vclk, order::oracle *time_oracle)
+    {
+        uint64_t hash = hash_node_handle(node_handle);
+        uint64_t map_idx = node_directory::stripe_of(hash);
+
+        node *n = nullptr;
+        node_directory::versions vers;
+        nodes.read_begin();
+        if (nodes.find(node_handle, hash, vers)) {
+            for (uint64_t i = 0; i < vers.size(); i++) {
+                node *n_ver = vers[i];
+                if (!try_pin_shared(n_ver)) {
+                    break;
+                }
+
+                if (time_oracle->clock_creat_before_del_after(vclk, n_ver->base.get_creat_time(), n_ver->base.get_del_time())) {
+                    n = n_ver;
+                    break;
+                } else {
+                    release_node_shared(n_ver);
+                }
+            }
+        }
+        nodes.read_end();
+
+        if (n != nullptr) {
+            return n;
+        }
+
+        nodes.read_begin();
+        nodes.mutex(map_idx).lock();
+        if (nodes.find(node_handle, hash, vers)) {
+            for (uint64_t i = 0; i < vers.size(); i++) {
+                node *n_ver = vers[i];
+                node_wait_and_mark_shared(n_ver);
+
+                if (time_oracle->clock_creat_before_del_after(vclk, n_ver->base.get_creat_time(), n_ver->base.get_del_time())) {
+                    n = n_ver;
+                    break;
+                } else {
+                    if (--n_ver->readers == 0 && n_ver->waiters > 0) {
+                        n_ver->cv.broadcast();
                     }
                 }
             }
         }
-        node_map_mutexes[map_idx].unlock();
+        nodes.mutex(map_idx).unlock();
+        nodes.read_end();
 
         return n;
     }
@@ -516,14 +701,15 @@ namespace db
     inline node*
     shard :: acquire_node_write(const node_handle_t &node_handle, uint64_t vt_id, uint64_t qts)
     {
-        uint64_t map_idx = hash_node_handle(node_handle) % NUM_NODE_MAPS;
+        uint64_t hash = hash_node_handle(node_handle);
+        uint64_t map_idx = node_directory::stripe_of(hash);
 
         node *n = nullptr;
         auto comp = std::make_pair(vt_id, qts);
-        node_map_mutexes[map_idx].lock();
-        auto node_iter = nodes[map_idx].find(node_handle);
-        if (node_iter != nodes[map_idx].end() && !node_iter->second.empty()) {
-            n = node_iter->second.back();
+        node_directory::versions vers;
+        nodes.mutex(map_idx).lock();
+        if (nodes.find(node_handle, hash, vers)) {
+            n = vers.back();
             n->waiters++;
 
             // first wait for node to become free
@@ -552,11 +738,14 @@ namespace db
                 n->tx_queue.pop_front();
             }
 
-            n->waiters--;
             n->in_use = true;
+            while (n->readers > 0) {
+                n->cv.wait();
+            }
+            n->waiters--;
         }
 
-        node_map_mutexes[map_idx].unlock();
+        nodes.mutex(map_idx).unlock();
 
         return n;
     }
@@ -564,17 +753,14 @@ namespace db
     inline node*
     shard :: bulk_load_acquire_node_nonlocking(const node_handle_t &node_handle, uint64_t map_idx)
     {
-        if (bulk_load_node_exists_nonlocking(node_handle, map_idx)) {
-            return nodes[map_idx][node_handle][0];
+        uint64_t hash = hash_node_handle(node_handle);
+        node_directory::versions vers;
+        if (node_filter.may_contain(hash) && nodes.find(node_handle, hash, vers)) {
+            assert(map_idx == node_directory::stripe_of(hash));
+            return vers.first;
         } else {
             return nullptr;
         }
-        //node *n = nullptr;
-        //auto node_iter = nodes[map_idx].find(node_handle);
-        //if (node_iter != nodes[map_idx].end() && !node_iter->second.empty()) {
-        //    n = node_iter->second.back();
-        //}
-        //return n;
     }
 
     inline void
@@ -587,75 +773,86 @@ namespace db
     inline void
     shard :: release_node(node *n, bool migr_done=false)
     {
-        uint64_t map_idx = hash_node_handle(n->get_handle()) % NUM_NODE_MAPS;
+        const node_handle_t &node_handle = n->get_handle();
+        uint64_t hash = hash_node_handle(node_handle);
+        uint64_t map_idx = node_directory::stripe_of(hash);
 
-        node_map_mutexes[map_idx].lock();
-        n->in_use = false;
+        nodes.mutex(map_idx).lock();
         if (migr_done) {
             n->migr_cv.broadcast();
         }
         if (n->waiters > 0) {
-            n->cv.signal();
-            node_map_mutexes[map_idx].unlock();
+            n->in_use = false;
+            n->cv.broadcast();
+            nodes.mutex(map_idx).unlock();
         } else if (n->permanently_deleted) {
-            const node_handle_t &node_handle = n->get_handle();
-            auto map_iter = nodes[map_idx].find(node_handle);
-            assert(map_iter != nodes[map_idx].end());
-            auto node_iter = map_iter->second.begin();
-            for (; node_iter != map_iter->second.end(); node_iter++) {
-                if (n == *node_iter) {
-                    break;
-                }
-            }
-            assert(node_iter != map_iter->second.end());
-            map_iter->second.erase(node_iter);
-            if (map_iter->second.empty()) {
-                nodes[map_idx].erase(node_handle);
-            }
-            node_map_mutexes[map_idx].unlock();
+            // node stays in_use, so that lock free readers which still find it cannot pin it
+            nodes.remove_version(node_handle, hash, n);
+            nodes.mutex(map_idx).unlock();
 
             migration_mutex.lock();
             shard_node_count[shard_id - ShardIdIncr]--;
             migration_mutex.unlock();
 
-#ifdef WEAVER_CLDG
-            msg_count_mutex.lock();
-            agg_msg_count.erase(node_handle);
-            msg_count_mutex.unlock();
-#endif
-#ifdef WEAVER_NEW_CLDG
-            msg_count_mutex.lock();
-            agg_msg_count.erase(node_handle);
-            msg_count_mutex.unlock();
-#endif
+            traffic.remove_node(node_handle);
 
             permanent_node_delete(n);
         } else {
-            node_map_mutexes[map_idx].unlock();
+            n->in_use = false;
+            nodes.mutex(map_idx).unlock();
         }
         n = nullptr;
     }
 
+    // drop shared access to the node
+    // last reader out wakes waiting writers, or finishes off a permanently deleted node
+    inline void
+    shard :: release_node_shared(node *n)
+    {
+        if (--n->readers == 0 && (n->waiters > 0 || n->permanently_deleted)) {
+            uint64_t map_idx = node_directory::stripe_of(hash_node_handle(n->get_handle()));
+
+            nodes.mutex(map_idx).lock();
+            if (n->waiters > 0) {
+                n->cv.broadcast();
+                nodes.mutex(map_idx).unlock();
+            } else if (n->readers == 0 && !n->in_use) {
+                // no one else can get to the node now, release_node will delete it
+                n->in_use = true;
+                nodes.mutex(map_idx).unlock();
+                release_node(n);
+            } else {
+                nodes.mutex(map_idx).unlock();
+            }
+        }
+    }
+
 
     // Graph state update methods
 
+    inline uint64_t
+    shard :: get_node_count()
+    {
+        migration_mutex.lock();
+        uint64_t count = shard_node_count[shard_id - ShardIdIncr];
+        migration_mutex.unlock();
+        return count;
+    }
+
     inline node*
     shard :: create_node(const node_handle_t &node_handle,
         vclock_ptr_t vclk,
         bool migrate)
     {
-        uint64_t map_idx = hash_node_handle(node_handle) % NUM_NODE_MAPS;
-        node *new_node = new node(node_handle, shard_id, vclk, node_map_mutexes+map_idx);
+        uint64_t hash = hash_node_handle(node_handle);
+        uint64_t map_idx = node_directory::stripe_of(hash);
+        node *new_node = new node(node_handle, shard_id, vclk, &nodes.mutex(map_idx));
 
-        node_map_mutexes[map_idx].lock();
-        auto map_iter = nodes[map_idx].find(node_handle);
-        if (map_iter == nodes[map_idx].end()) {
-            nodes[map_idx][node_handle] = std::vector<node*>(1, new_node);
-        } else {
-            map_iter->second.emplace_back(new_node);
-        }
+        nodes.mutex(map_idx).lock();
+        nodes.add_version(node_handle, hash, new_node);
         node_exists_cache[map_idx] = node_handle;
-        node_map_mutexes[map_idx].unlock();
+        nodes.mutex(map_idx).unlock();
+        node_filter.insert(hash);
 
         migration_mutex.lock();
         shard_node_count[shard_id - ShardIdIncr]++;
@@ -663,9 +860,6 @@ namespace db
 
         if (!migrate) {
             new_node->state = node::mode::STABLE;
-#ifdef WEAVER_CLDG
-            new_node->msg_count.resize(get_num_shards(), 0);
-#endif
             release_node(new_node);
         }
         return new_node;
@@ -676,17 +870,16 @@ namespace db
         uint64_t map_idx,
         vclock_ptr_t vclk)
     {
-        node *new_node = new node(node_handle, shard_id, vclk, node_map_mutexes+map_idx);
+        node *new_node = new node(node_handle, shard_id, vclk, &nodes.mutex(map_idx));
 
-        nodes[map_idx][node_handle] = std::vector<node*>(1, new_node);
+        uint64_t hash = hash_node_handle(node_handle);
+        nodes.add_version(node_handle, hash, new_node);
         node_exists_cache[map_idx] = node_handle;
+        node_filter.insert(hash);
 
         shard_node_count[shard_id - ShardIdIncr]++;
 
         new_node->state = node::mode::STABLE;
-#ifdef WEAVER_CLDG
-        new_node->msg_count.resize(get_num_shards(), 0);
-#endif
         new_node->in_use = false;
         return new_node;
     }
@@ -696,6 +889,7 @@ namespace db
         vclock_ptr_t tdel)
     {
         n->base.update_del_time(tdel);
+        n->record_write(tdel);
     }
 
     inline void
@@ -728,15 +922,12 @@ namespace db
     {
         edge *new_edge = new edge(handle, vclk, remote_loc, remote_node);
         n->add_edge(new_edge);
-
-        // XXX update edge map
-        //if (!init_load) {
-        //    edge_map_mutex.lock();
-        //}
-        //edge_map[remote_node].emplace(std::make_pair(n->get_handle(), vclk));
-        //if (!init_load) {
-        //    edge_map_mutex.unlock();
-        //}
+        n->record_write(vclk, handle);
+        in_edges.add(remote_node, n->get_handle(), handle, vclk);
+        edges_created++;
+        if (remote_loc != shard_id) {
+            cut_edges_created++;
+        }
     }
 
     inline void
@@ -772,6 +963,7 @@ namespace db
     {
         edge *new_edge = new edge(handle, vclk, remote_loc, remote_node);
         n->add_edge_unique(new_edge);
+        in_edges.add(remote_node, n->get_handle(), handle, vclk);
     }
 
     inline void
@@ -786,6 +978,9 @@ namespace db
         edge *e = out_edge_iter->second.back();
         assert(!e->base.get_del_time());
         e->base.update_del_time(tdel);
+        n->edge_deleted();
+        n->record_write(tdel, edge_handle);
+        in_edges.mark_deleted(e->nbr.handle, n->get_handle(), edge_handle, tdel);
     }
 
     inline void
@@ -818,6 +1013,7 @@ namespace db
         vclock_ptr_t vclk)
     {
         n->base.add_property(key, value, vclk);
+        n->record_write(vclk, edge_handle_t());
     }
 
     inline void
@@ -852,7 +1048,10 @@ namespace db
         assert(!out_edge_iter->second.empty());
         edge *e = out_edge_iter->second.back();
         assert(!e->base.get_del_time());
-        e->base.add_property(key, value, vclk);
+        if (e->base.add_property(key, value, vclk)) {
+            n->edge_property_added(e, key, value);
+        }
+        n->record_write(vclk, edge_handle);
     }
 
     inline void
@@ -884,7 +1083,9 @@ namespace db
         vclock_ptr_t vclk)
     {
         edge *e = n->out_edges[edge_handle].back();
-        e->base.add_property(key, value, vclk);
+        if (e->base.add_property(key, value, vclk)) {
+            n->edge_property_added(e, key, value);
+        }
     }
 
     void
@@ -919,7 +1120,12 @@ namespace db
         if (node_exists_cache[map_idx] == node_handle) {
             return true;
         }
-        if (nodes[map_idx].find(node_handle) != nodes[map_idx].end()) {
+        uint64_t hash = hash_node_handle(node_handle);
+        if (!node_filter.may_contain(hash)) {
+            return false;
+        }
+        node_directory::versions vers;
+        if (nodes.find(node_handle, hash, vers)) {
             node_exists_cache[map_idx] = node_handle;
             return true;
         } else {
@@ -935,6 +1141,7 @@ namespace db
         node *n;
         n = acquire_node_latest(migr_node);
         n->permanently_deleted = true;
+        in_edges.remove_node(*n);
         // deleting edges now so as to prevent sending messages to neighbors for permanent edge deletion
         // rest of deletion happens in release_node()
         for (auto &x: n->out_edges) {
@@ -961,20 +1168,6 @@ namespace db
         return false;
     }
 
-    // assuming caller holds edge_map_mutex
-    // XXX
-    //inline void
-    //shard :: remove_from_edge_map(const node_handle_t &remote_node, const node_version_t &local_node)
-    //{
-    //    auto edge_map_iter = edge_map.find(remote_node);
-    //    assert(edge_map_iter != edge_map.end());
-    //    auto &node_version_set = edge_map_iter->second;
-    //    node_version_set.erase(local_node);
-    //    if (node_version_set.empty()) {
-    //        edge_map.erase(remote_node);
-    //    }
-    //}
-
     inline void
     shard :: permanent_delete_loop(uint64_t vt_id, bool outstanding_progs, order::oracle *time_oracle)
     {
@@ -1013,13 +1206,7 @@ namespace db
                     n = acquire_node_specific(dobj->node, dobj->version, nullptr);
                     if (n != nullptr) {
                         n->permanently_deleted = true;
-                        for (auto &x: n->out_edges) {
-                            for (db::edge *e: x.second) {
-                                // XXX const node_handle_t &remote_node = e->nbr.handle;
-                                node_version_t local_node = std::make_pair(dobj->node, e->base.get_creat_time());
-                                // XXX remove_from_edge_map(remote_node, local_node);
-                            }
-                        }
+                        in_edges.remove_node(*n);
                         release_node(n);
                     }
                     break;
@@ -1045,7 +1232,10 @@ namespace db
                          || time_oracle->compare_two_vts(*n->last_perm_deletion, *e->base.get_del_time()) == 0) {
                             n->last_perm_deletion.reset(new vc::vclock(*e->base.get_del_time()));
                         }
+                        n->trim_change_log(e->base.get_del_time()->clock);
 
+                        in_edges.remove(dobj->node, *e);
+                        n->edge_removed(e);
                         delete e;
                         map_iter->second.erase(edge_iter);
                         if (map_iter->second.empty()) {
@@ -1082,8 +1272,10 @@ namespace db
     shard :: permanent_node_delete(node *n)
     {
         message::message msg;
+        // node has been removed from the directory, but lock free readers may still be
+        // trying (and failing) to pin it, so it is only freed once they are done
         assert(n->waiters == 0);
-        assert(!n->in_use);
+        assert(n->in_use);
         // this code isn't executed in case of deletion of migrated nodes
         if (n->state != node::mode::MOVED) {
             for (auto &x: n->out_edges) {
@@ -1093,7 +1285,17 @@ namespace db
             }
             n->out_edges.clear();
         }
-        delete n;
+        cache_mgr.remove_node(n);
+        if (MaxCacheEntries) {
+            watches.forget_node(this, n->get_handle());
+        }
+        nodes.retire_node(n, free_node);
+    }
+
+    inline void
+    shard :: free_node(void *n)
+    {
+        delete (node*)n;
     }
 
 
@@ -1111,44 +1313,64 @@ namespace db
         }
     }
 
+    // repoint local edges to nodes that moved from old_loc to new_loc, then ack the round to old_loc
     inline void
-    shard :: update_migrated_nbr(const node_handle_t &, uint64_t, uint64_t) { }
-    //XXX shard :: update_migrated_nbr(const node_handle_t &migr_node, uint64_t old_loc, uint64_t new_loc)
-    //{
-    //    std::unordered_set<node_version_t, node_version_hash> nbrs;
-    //    node *n;
-    //    edge_map_mutex.lock();
-    //    auto find_iter = edge_map.find(migr_node);
-    //    if (find_iter != edge_map.end()) {
-    //        nbrs = find_iter->second;
-    //    }
-    //    edge_map_mutex.unlock();
-
-    //    for (const node_version_t &nv: nbrs) {
-    //        n = acquire_node_specific(nv.first, &nv.second, nullptr);
-    //        update_migrated_nbr_nonlocking(n, migr_node, old_loc, new_loc);
-    //        release_node(n);
-    //    }
-    //    migration_mutex.lock();
-    //    if (old_loc != shard_id) {
-    //        message::message msg;
-    //        msg.prepare_message(message::MIGRATED_NBR_ACK, shard_id, max_seen_clk, shard_node_count[shard_id-ShardIdIncr]);
-    //        comm.send(old_loc, msg.buf);
-    //    } else {
-    //        for (uint64_t i = 0; i < NumVts; i++) {
-    //            if (order::oracle::happens_before_no_kronos(target_prog_clk[i], max_seen_clk[i])) {
-    //                target_prog_clk[i] = max_seen_clk[i];
-    //            }
-    //        }
-    //        migr_edge_acks[shard_id - ShardIdIncr] = true;
-    //    }
-    //    migration_mutex.unlock();
-    //}
+    shard :: update_migrated_nbrs(const std::vector<node_handle_t> &migr_nodes, uint64_t old_loc, uint64_t new_loc)
+    {
+        // each local nbr acquired once for the whole batch
+        std::unordered_map<node_handle_t, std::vector<node_handle_t>> nbrs;
+        std::vector<node_handle_t> srcs;
+        for (const node_handle_t &migr_node: migr_nodes) {
+            srcs.clear();
+            in_edges.sources(migr_node, srcs);
+            for (const node_handle_t &src: srcs) {
+                nbrs[src].emplace_back(migr_node);
+            }
+        }
+
+        node *n;
+        for (const auto &p: nbrs) {
+            n = acquire_node_latest(p.first);
+            if (n == nullptr) {
+                continue;
+            }
+            for (const node_handle_t &migr_node: p.second) {
+                update_migrated_nbr_nonlocking(n, migr_node, old_loc, new_loc);
+            }
+            release_node(n);
+        }
+        nbr_locs_repaired += nbrs.size();
+
+        migration_mutex.lock();
+        if (old_loc != shard_id) {
+            message::message msg;
+            msg.prepare_message(message::MIGRATED_NBR_ACK, shard_id, max_seen_clk, shard_node_count[shard_id-ShardIdIncr]);
+            migration_mutex.unlock();
+            comm.send(old_loc, msg.buf);
+        } else {
+            for (uint64_t i = 0; i < NumVts; i++) {
+                if (order::oracle::happens_before_no_kronos(target_prog_clk[i], max_seen_clk[i])) {
+                    target_prog_clk[i] = max_seen_clk[i];
+                }
+            }
+            migr_edge_acks[shard_id - ShardIdIncr]++;
+            migration_mutex.unlock();
+        }
+    }
 
     inline void
-    shard :: update_node_mapping(const node_handle_t &handle, uint64_t shard)
+    shard :: update_node_mappings(const std::unordered_map<node_handle_t, uint64_t> &mappings)
     {
-        hstub.back()->update_mapping(handle, shard);
+        if (StorageBackend == "local") {
+            // timestampers keep the node map in their local storage
+            for (uint64_t i = 0; i < NumVts; i++) {
+                message::message msg;
+                msg.prepare_message(message::STORE_NMAP_UPDATE, mappings);
+                comm.send(i, msg.buf);
+            }
+        } else {
+            hstub.back()->update_mappings(mappings);
+        }
     }
 
     // node program
@@ -1322,7 +1544,43 @@ namespace db
     inline void
     shard :: restore_backup()
     {
-        hstub.back()->restore_backup(nodes, /*XXX edge_map,*/ node_map_mutexes);
+        hstub.back()->restore_backup(nodes, in_edges);
+        rebuild_node_filter();
+    }
+
+    // empty filter for the expected number of nodes at this shard
+    // not safe with concurrent node creation or lookup
+    inline void
+    shard :: size_node_filter(uint64_t num_nodes)
+    {
+        num_nodes = std::max(num_nodes, (uint64_t)NODE_FILTER_MIN_NODES);
+        node_filter.resize(weaver_util::bloom_filter::bits_for(num_nodes, NODE_FILTER_FP_RATE));
+        WDEBUG << "node filter sized for " << num_nodes << " nodes, " << (node_filter.num_bits() >> 23) << " MB" << std::endl;
+    }
+
+    // drops handles of deleted nodes, which stay in the filter till it is rebuilt
+    // not safe with concurrent node creation or lookup
+    inline void
+    shard :: rebuild_node_filter()
+    {
+        // restored nodes are not in shard_node_count, count them in the directory
+        uint64_t num_nodes = 0;
+        for (uint64_t i = 0; i < NUM_NODE_MAPS; i++) {
+            nodes.mutex(i).lock();
+            nodes.for_each(i, [&num_nodes](const node_directory::versions&) {
+                num_nodes++;
+            });
+            nodes.mutex(i).unlock();
+        }
+        size_node_filter(num_nodes);
+
+        for (uint64_t i = 0; i < NUM_NODE_MAPS; i++) {
+            nodes.mutex(i).lock();
+            nodes.for_each(i, [this](const node_directory::versions &vers) {
+                node_filter.insert(hash_node_handle(vers.first->get_handle()));
+            });
+            nodes.mutex(i).unlock();
+        }
     }
 }
 
@@ -18,12 +18,22 @@
 //#define NUM_SHARD_THREADS 128
 
 #define NUM_NODE_MAPS 1024
+#define NODE_FILTER_FP_RATE 0.01 // node filter false positive rate, up to the node count it is sized for
+#define NODE_FILTER_MIN_NODES (1ULL << 20) // node filter is sized for at least this many nodes, 1.3MB
+#define NODE_FILTER_SAMPLE_BYTES (1ULL << 22) // prefix of a bulk load file read to estimate its node count
 #define SHARD_MSGRECV_TIMEOUT -1 // busybee recv timeout (ms) for shard worker threads
 
 #define BATCH_MSG_SIZE 1 // 1 == no batching
+#define GRAPHML_HANDOFF_BATCH 1024 // graphml elements handed between bulk load threads at a time
+#define NODE_CHANGE_LOG_MAX 16 // recent writes per node for cache context computation
+#define MIGR_BATCH_NODES 1024 // max nodes moved out of a shard per migration round
+#define MIGR_MSG_NODES 128 // max nodes packed in one MIGRATE_SEND_NODE message
+#define STORE_MSG_NODES 1024 // max bulk loaded nodes packed in one STORE_BULK_LOAD message
 
-// migration
-//#define WEAVER_CLDG // defined if communication-based LDG, undef otherwise
-//#define WEAVER_NEW_CLDG // defined if communication-based LDG, undef otherwise
+// sampled node program traffic, used for migration
+#define TRAVERSAL_LOG_HOPS 4096 // sampled hops buffered per worker thread before merging
+#define TRAVERSAL_HALF_LIFE_SECS 300
+#define TRAVERSAL_DECAY_INTERVAL_SECS 10
+#define TRAVERSAL_MIN_COUNT 1.0 // decayed counts below this are dropped
 
 #endif
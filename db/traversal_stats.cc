@@ -0,0 +1,250 @@
+/*
+ * ===============================================================
+ *    Description:  Sampled node program hop counts of a shard.
+ *
+ *        Created:  2026-10-19 16:47:35
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include <cmath>
+#include <assert.h>
+#include <algorithm>
+
+#include "common/weaver_constants.h"
+#include "db/shard_constants.h"
+#include "db/traversal_stats.h"
+
+using db::traversal_stats;
+
+traversal_stats :: traversal_stats()
+    : sample_period(0)
+    , visits_while_on(0)
+    , num_logs(0)
+    , last_decay(0)
+    , merged_hops(0)
+{ }
+
+void
+traversal_stats :: init(uint64_t num_threads, uint64_t period)
+{
+    assert(num_threads > 0);
+    num_logs = num_threads;
+    logs.reset(new thread_log[num_logs]);
+    last_decay = timer.get_time_elapsed();
+    set_sample_period(period);
+}
+
+void
+traversal_stats :: set_sample_period(uint64_t period)
+{
+    WDEBUG << "traversal sampling " << (period == 0? "off" : "every " + std::to_string(period) + " node visits") << std::endl;
+    sample_period.store(period, std::memory_order_relaxed);
+}
+
+uint64_t
+traversal_stats :: sample_visit()
+{
+    uint64_t period = sample_period.load(std::memory_order_relaxed);
+    if (period == 0) {
+        return 0;
+    }
+
+    static thread_local uint64_t skipped = 0;
+    if (++skipped < period) {
+        return 0;
+    }
+    skipped = 0;
+    my_log().sampled.fetch_add(1, std::memory_order_relaxed);
+    visits_while_on.fetch_add(period, std::memory_order_relaxed);
+    return period;
+}
+
+void
+traversal_stats :: record(uint64_t weight, const node_handle_t &src, const remote_node &dst)
+{
+    thread_log &log = my_log();
+    log.mtx.lock();
+    log.hops.emplace_back(hop{src, dst, weight});
+    if (log.hops.size() >= TRAVERSAL_LOG_HOPS) {
+        mtx.lock();
+        merge_log(log);
+        mtx.unlock();
+    }
+    log.mtx.unlock();
+}
+
+// caution: need to hold log.mtx and mtx
+void
+traversal_stats :: merge_log(thread_log &log)
+{
+    for (const hop &h: log.hops) {
+        uint64_t sid = h.dst.loc - ShardIdIncr;
+        if (to_shard.size() <= sid) {
+            to_shard.resize(sid+1, 0);
+        }
+        to_shard[sid] += h.weight;
+
+        node_traffic &nt = nodes[h.src];
+        if (nt.to_shard.size() <= sid) {
+            nt.to_shard.resize(sid+1, 0);
+        }
+        nt.total += h.weight;
+        nt.to_shard[sid] += h.weight;
+        nt.to_node[h.dst.handle] += h.weight;
+    }
+    merged_hops += log.hops.size();
+    log.hops.clear();
+
+    decay();
+}
+
+// caution: need to hold mtx
+void
+traversal_stats :: decay()
+{
+    uint64_t now = timer.get_time_elapsed();
+    uint64_t elapsed = now - last_decay;
+    if (elapsed < TRAVERSAL_DECAY_INTERVAL_SECS * (uint64_t)NANO) {
+        return;
+    }
+    last_decay = now;
+
+    double factor = std::pow(0.5, ((double)elapsed / NANO) / TRAVERSAL_HALF_LIFE_SECS);
+    for (double &t: to_shard) {
+        t *= factor;
+    }
+    for (auto iter = nodes.begin(); iter != nodes.end();) {
+        node_traffic &nt = iter->second;
+        nt.total *= factor;
+        if (nt.total < TRAVERSAL_MIN_COUNT) {
+            iter = nodes.erase(iter);
+            continue;
+        }
+        for (double &t: nt.to_shard) {
+            t *= factor;
+        }
+        for (auto nbr_iter = nt.to_node.begin(); nbr_iter != nt.to_node.end();) {
+            nbr_iter->second *= factor;
+            if (nbr_iter->second < TRAVERSAL_MIN_COUNT) {
+                nbr_iter = nt.to_node.erase(nbr_iter);
+            } else {
+                nbr_iter++;
+            }
+        }
+        iter++;
+    }
+}
+
+void
+traversal_stats :: merge()
+{
+    for (uint64_t i = 0; i < num_logs; i++) {
+        logs[i].mtx.lock();
+        mtx.lock();
+        merge_log(logs[i]);
+        mtx.unlock();
+        logs[i].mtx.unlock();
+    }
+}
+
+bool
+traversal_stats :: node_traffic_to_shards(const node_handle_t &handle, std::vector<double> &traffic)
+{
+    bool found = false;
+    mtx.lock();
+    auto iter = nodes.find(handle);
+    if (iter != nodes.end()) {
+        const std::vector<double> &node_to_shard = iter->second.to_shard;
+        std::fill(traffic.begin(), traffic.end(), 0);
+        if (traffic.size() < node_to_shard.size()) {
+            traffic.resize(node_to_shard.size(), 0);
+        }
+        std::copy(node_to_shard.begin(), node_to_shard.end(), traffic.begin());
+        found = true;
+    }
+    mtx.unlock();
+    return found;
+}
+
+void
+traversal_stats :: hottest_nodes(std::vector<std::pair<node_handle_t, double>> &hot)
+{
+    merge();
+
+    hot.clear();
+    mtx.lock();
+    hot.reserve(nodes.size());
+    for (const auto &p: nodes) {
+        hot.emplace_back(p.first, p.second.total);
+    }
+    mtx.unlock();
+
+    std::sort(hot.begin(), hot.end(),
+        [](const std::pair<node_handle_t, double> &p1, const std::pair<node_handle_t, double> &p2) {
+            return p1.second > p2.second;
+        });
+}
+
+void
+traversal_stats :: shard_traffic(std::vector<double> &traffic)
+{
+    merge();
+
+    mtx.lock();
+    traffic = to_shard;
+    mtx.unlock();
+}
+
+void
+traversal_stats :: remove_node(const node_handle_t &handle)
+{
+    mtx.lock();
+    nodes.erase(handle);
+    mtx.unlock();
+}
+
+uint64_t
+traversal_stats :: dump(std::ostream &out)
+{
+    merge();
+
+    uint64_t lines = 0;
+    mtx.lock();
+    for (const auto &p: nodes) {
+        for (const auto &nbr: p.second.to_node) {
+            uint64_t count = (uint64_t)(nbr.second + 0.5);
+            if (count > 0) {
+                out << p.first << " " << nbr.first << " " << count << "\n";
+                lines++;
+            }
+        }
+    }
+    mtx.unlock();
+
+    return lines;
+}
+
+void
+traversal_stats :: dump_stats()
+{
+    uint64_t sampled = 0;
+    for (uint64_t i = 0; i < num_logs; i++) {
+        sampled += logs[i].sampled.load(std::memory_order_relaxed);
+    }
+
+    std::vector<double> traffic;
+    shard_traffic(traffic);
+
+    mtx.lock();
+    WDEBUG << "traversal sampling: " << sampled << " of about " << visits_while_on.load() << " node visits sampled, "
+           << merged_hops << " hops merged, " << nodes.size() << " nodes with traffic" << std::endl;
+    mtx.unlock();
+    for (uint64_t i = 0; i < traffic.size(); i++) {
+        if (traffic[i] >= TRAVERSAL_MIN_COUNT) {
+            WDEBUG << "traversal traffic to shard " << (i + ShardIdIncr) << ": " << (uint64_t)traffic[i] << " hops" << std::endl;
+        }
+    }
+}
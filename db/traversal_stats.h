@@ -0,0 +1,111 @@
+/*
+ * ===============================================================
+ *    Description:  Sampled counts of node program hops out of the
+ *                  nodes of a shard, per node and per destination
+ *                  shard, for communication aware migration.
+ *
+ *        Created:  2026-10-19 16:47:35
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#ifndef weaver_db_traversal_stats_h_
+#define weaver_db_traversal_stats_h_
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include <unordered_map>
+#include <po6/threads/mutex.h>
+
+#include "common/types.h"
+#include "common/clock.h"
+#include "common/thread_index.h"
+#include "db/remote_node.h"
+
+namespace db
+{
+    // One in every sample_period node visits is sampled, and every hop that
+    // visit sends out is appended, weighted by sample_period, to the log of
+    // the worker thread.  Logs are merged into the shard wide counts when
+    // they fill up or when counts are read.  Merged counts decay with a
+    // half life, so they follow the current workload.
+    //
+    // Sampling is off if sample_period is 0, in which case a node visit
+    // costs one relaxed atomic load, and an unsampled visit one more
+    // thread local increment.  The period can be changed at runtime.
+    //
+    // Lock order is a thread log mutex, then the counts mutex.
+    class traversal_stats
+    {
+        private:
+            struct hop
+            {
+                node_handle_t src;
+                remote_node dst;
+                uint64_t weight;
+            };
+
+            // own cache line, written only by its thread except when merged
+            struct alignas(64) thread_log
+            {
+                po6::threads::mutex mtx;
+                std::atomic<uint64_t> sampled;
+                std::vector<hop> hops;
+
+                thread_log() : sampled(0) { }
+            };
+
+            struct node_traffic
+            {
+                double total;
+                std::vector<double> to_shard; // indexed by shard id - ShardIdIncr
+                std::unordered_map<node_handle_t, double> to_node;
+
+                node_traffic() : total(0) { }
+            };
+
+            std::atomic<uint64_t> sample_period;
+            std::atomic<uint64_t> visits_while_on; // estimated from samples
+            std::unique_ptr<thread_log[]> logs;
+            uint64_t num_logs;
+
+            po6::threads::mutex mtx;
+            std::unordered_map<node_handle_t, node_traffic> nodes;
+            std::vector<double> to_shard; // all hops from this shard
+            wclock::weaver_timer timer;
+            uint64_t last_decay;
+            uint64_t merged_hops;
+
+            thread_log& my_log() { return logs[thread_index::get() % num_logs]; }
+            void merge_log(thread_log &log);
+            void decay();
+
+        public:
+            traversal_stats();
+            void init(uint64_t num_threads, uint64_t period);
+            void set_sample_period(uint64_t period);
+            uint64_t get_sample_period() const { return sample_period.load(std::memory_order_relaxed); }
+
+            // at the start of a node visit, returns weight of the hops of this visit, 0 if not sampled
+            uint64_t sample_visit();
+            void record(uint64_t weight, const node_handle_t &src, const remote_node &dst);
+
+            void merge();
+            // sampled hops to each shard, false if the node has none
+            bool node_traffic_to_shards(const node_handle_t &handle, std::vector<double> &traffic);
+            // nodes with sampled hops, most first
+            void hottest_nodes(std::vector<std::pair<node_handle_t, double>> &hot);
+            void shard_traffic(std::vector<double> &traffic);
+            // node no longer at this shard
+            void remove_node(const node_handle_t &handle);
+
+            // "<src> <dst> <count>" per pair of nodes with sampled hops, returns number of lines
+            uint64_t dump(std::ostream &out);
+            void dump_stats();
+    };
+}
+
+#endif
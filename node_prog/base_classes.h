@@ -4,6 +4,7 @@
 #include <e/buffer.h>
 #include <vector>
 #include <unordered_set>
+#include <unordered_map>
 #include <iostream>
 
 #include "common/types.h"
@@ -33,6 +34,13 @@ namespace node_prog
     {
         virtual bool search_cache() = 0;
         virtual cache_key_t cache_key() = 0;
+
+        public:
+            // position in the shard queue of a BEST_FIRST program
+            virtual uint64_t priority() const { return 0; }
+            // called at the timestamper with the shard of each start node,
+            // lets programs that aggregate at a start node learn its location
+            virtual void set_start_locs(const std::unordered_map<node_handle_t, uint64_t>&) { }
     };
 
     class Node_State_Base : public virtual Packable, public virtual Deletable 
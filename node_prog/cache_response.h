@@ -13,6 +13,7 @@
 #include <iterator>
 #include <vector>
 #include <unordered_map>
+#include <po6/threads/mutex.h>
 
 #include "common/types.h"
 #include "node_prog/base_classes.h"
@@ -56,6 +57,7 @@ namespace node_prog
     {
         private:
             std::unordered_map<cache_key_t, db::cache_entry> &from_cache;
+            po6::threads::mutex *cache_mtx; // node programs may share the node that owns from_cache
             cache_key_t key;
             std::shared_ptr<CacheValueType> value;
             std::shared_ptr<std::vector<db::remote_node>> watch_set;
@@ -63,10 +65,12 @@ namespace node_prog
 
         public:
             cache_response(std::unordered_map<cache_key_t, db::cache_entry> &came_from,
+                po6::threads::mutex *mtx,
                 cache_key_t key_used,
                 std::shared_ptr<Cache_Value_Base> val,
                 std::shared_ptr<std::vector<db::remote_node>> watch_set_used)
                 : from_cache(came_from)
+                , cache_mtx(mtx)
                 , key(key_used)
                 , watch_set(watch_set_used)
           {
@@ -80,7 +84,12 @@ namespace node_prog
             std::shared_ptr<CacheValueType> get_value() { return value; }
             std::shared_ptr<std::vector<db::remote_node>> get_watch_set() { return watch_set; }
             std::vector<node_cache_context> &get_context() { return context; }
-            void invalidate() { from_cache.erase(key); }
+            void invalidate()
+            {
+                cache_mtx->lock();
+                from_cache.erase(key);
+                cache_mtx->unlock();
+            }
     };
 }
 
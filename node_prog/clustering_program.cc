@@ -100,7 +100,6 @@ node_prog :: clustering_node_program(
             params.is_center = false;
             params.center = rn;
             for (edge& edge : n.get_edges()) {
-                edge.traverse();
                 next.emplace_back(std::make_pair(edge.get_neighbor(), params));
                 cstate.neighbor_counts.insert(std::make_pair(edge.get_neighbor().handle, 0));
                 cstate.responses_left++;
@@ -0,0 +1,309 @@
+/*
+ * ===============================================================
+ *    Description:  Dijkstra shortest path program.
+ *
+ *        Created:  Sunday 21 April 2013 11:00:03  EDT
+ *
+ *         Author:  Ayush Dubey, Greg Hill
+ *                  dubey@cs.cornell.edu, gdh39@cornell.edu
+ *
+ * Copyright (C) 2013, Cornell University, see the LICENSE file
+ *                     for licensing agreement
+ * ================================================================
+ */
+
+#include <stdlib.h>
+
+#include "common/message.h"
+#include "node_prog/edge.h"
+#include "node_prog/prop_list.h"
+#include "node_prog/dijkstra_program.h"
+
+using node_prog::search_type;
+using node_prog::dijkstra_params;
+using node_prog::dijkstra_node_state;
+using node_prog::cache_response;
+
+// params
+dijkstra_params :: dijkstra_params()
+    : returning(false)
+    , prev_node(db::coordinator)
+    , is_widest_path(false)
+    , cost(0)
+    , found(false)
+    , bound(0)
+{ }
+
+bool
+dijkstra_params :: search_cache()
+{
+    return false;
+}
+
+// acks first, then relaxations cheapest (or widest) first
+uint64_t
+dijkstra_params :: priority() const
+{
+    if (returning) {
+        return 0;
+    } else if (is_widest_path) {
+        return UINT64_MAX - cost;
+    } else {
+        return cost;
+    }
+}
+
+uint64_t
+dijkstra_params :: size() const
+{
+    uint64_t toRet = message::size(returning)
+        + message::size(prev_node)
+        + message::size(dst_handle)
+        + message::size(edge_weight_name)
+        + message::size(edge_props)
+        + message::size(is_widest_path)
+        + message::size(cost)
+        + message::size(path)
+        + message::size(found)
+        + message::size(bound);
+    return toRet;
+}
+
+void
+dijkstra_params :: pack(e::buffer::packer &packer) const
+{
+    message::pack_buffer(packer, returning);
+    message::pack_buffer(packer, prev_node);
+    message::pack_buffer(packer, dst_handle);
+    message::pack_buffer(packer, edge_weight_name);
+    message::pack_buffer(packer, edge_props);
+    message::pack_buffer(packer, is_widest_path);
+    message::pack_buffer(packer, cost);
+    message::pack_buffer(packer, path);
+    message::pack_buffer(packer, found);
+    message::pack_buffer(packer, bound);
+}
+
+void
+dijkstra_params :: unpack(e::unpacker &unpacker)
+{
+    message::unpack_buffer(unpacker, returning);
+    message::unpack_buffer(unpacker, prev_node);
+    message::unpack_buffer(unpacker, dst_handle);
+    message::unpack_buffer(unpacker, edge_weight_name);
+    message::unpack_buffer(unpacker, edge_props);
+    message::unpack_buffer(unpacker, is_widest_path);
+    message::unpack_buffer(unpacker, cost);
+    message::unpack_buffer(unpacker, path);
+    message::unpack_buffer(unpacker, found);
+    message::unpack_buffer(unpacker, bound);
+}
+
+// state
+dijkstra_node_state :: dijkstra_node_state()
+    : labeled(false)
+    , label(0)
+    , out_count(0)
+    , bounded(false)
+    , bound(0)
+    , found(false)
+    , best_cost(0)
+{ }
+
+uint64_t
+dijkstra_node_state :: size() const
+{
+    uint64_t toRet = message::size(labeled)
+        + message::size(label)
+        + message::size(out_count)
+        + message::size(parent)
+        + message::size(bounded)
+        + message::size(bound)
+        + message::size(found)
+        + message::size(best_cost)
+        + message::size(best_path);
+    return toRet;
+}
+
+void
+dijkstra_node_state :: pack(e::buffer::packer& packer) const
+{
+    message::pack_buffer(packer, labeled);
+    message::pack_buffer(packer, label);
+    message::pack_buffer(packer, out_count);
+    message::pack_buffer(packer, parent);
+    message::pack_buffer(packer, bounded);
+    message::pack_buffer(packer, bound);
+    message::pack_buffer(packer, found);
+    message::pack_buffer(packer, best_cost);
+    message::pack_buffer(packer, best_path);
+}
+
+void
+dijkstra_node_state :: unpack(e::unpacker& unpacker)
+{
+    message::unpack_buffer(unpacker, labeled);
+    message::unpack_buffer(unpacker, label);
+    message::unpack_buffer(unpacker, out_count);
+    message::unpack_buffer(unpacker, parent);
+    message::unpack_buffer(unpacker, bounded);
+    message::unpack_buffer(unpacker, bound);
+    message::unpack_buffer(unpacker, found);
+    message::unpack_buffer(unpacker, best_cost);
+    message::unpack_buffer(unpacker, best_path);
+}
+
+
+// node prog code
+
+static inline bool
+dijkstra_better(uint64_t a, uint64_t b, bool is_widest_path)
+{
+    return is_widest_path ? a > b : a < b;
+}
+
+static inline uint64_t
+dijkstra_extend(uint64_t cost, uint64_t weight, bool is_widest_path)
+{
+    if (is_widest_path) {
+        return cost < weight ? cost : weight;
+    } else {
+        return cost + weight;
+    }
+}
+
+static uint64_t
+dijkstra_edge_weight(node_prog::edge &e, const std::string &weight_name)
+{
+    for (std::vector<std::shared_ptr<node_prog::property>> pvec: e.get_properties()) {
+        for (std::shared_ptr<node_prog::property> p: pvec) {
+            if (p->get_key() == weight_name) {
+                return strtoull(p->get_value().c_str(), nullptr, 10);
+            }
+        }
+    }
+    return 1;
+}
+
+static void
+dijkstra_bound(dijkstra_node_state &state, uint64_t cost, bool is_widest_path)
+{
+    if (!state.bounded || dijkstra_better(cost, state.bound, is_widest_path)) {
+        state.bounded = true;
+        state.bound = cost;
+    }
+}
+
+static void
+dijkstra_ack(std::vector<std::pair<db::remote_node, dijkstra_params>> &next,
+    const db::remote_node &to,
+    dijkstra_params &params,
+    dijkstra_node_state &state)
+{
+    params.returning = true;
+    params.found = state.found;
+    params.cost = state.best_cost;
+    params.path = state.best_path;
+    next.emplace_back(std::make_pair(to, params));
+}
+
+// Label-correcting search with Dijkstra-Scholten termination.
+// Every relaxation is acked.  A node that is idle when it accepts a relaxation
+// adopts the sender as parent and acks it only after all its own relaxations
+// are acked, every other relaxation is acked at once.  The source's parent is
+// the coordinator, so the source acks it when the whole search has finished.
+// Acks carry the best path to dst known to the sender and relaxations carry its
+// cost, which prunes relaxations that cannot beat it.  Shards run relaxations in
+// cost order (BEST_FIRST), so most nodes are settled by their first relaxation.
+std::pair<search_type, std::vector<std::pair<db::remote_node, dijkstra_params>>>
+node_prog :: dijkstra_node_program(
+        node &n,
+        db::remote_node &rn,
+        dijkstra_params &params,
+        std::function<dijkstra_node_state&()> state_getter,
+        std::function<void(std::shared_ptr<Cache_Value_Base>,
+            std::shared_ptr<std::vector<db::remote_node>>, cache_key_t)>&,
+        cache_response<Cache_Value_Base>*)
+{
+    dijkstra_node_state &state = state_getter();
+    std::vector<std::pair<db::remote_node, dijkstra_params>> next;
+    db::remote_node prev_node = params.prev_node;
+    params.prev_node = rn;
+    bool widest = params.is_widest_path;
+
+    if (!params.returning) { // relaxation
+        if (prev_node == db::coordinator && params.path.empty()) {
+            // start node
+            params.cost = widest ? UINT64_MAX : 0;
+        }
+        if (params.found) {
+            dijkstra_bound(state, params.bound, widest);
+        }
+
+        uint64_t cost = params.cost;
+        bool improves = (!state.labeled || dijkstra_better(cost, state.label, widest))
+                     && (!state.bounded || dijkstra_better(cost, state.bound, widest));
+        if (!improves) {
+            dijkstra_ack(next, prev_node, params, state);
+            return std::make_pair(search_type::BEST_FIRST, next);
+        }
+
+        state.labeled = true;
+        state.label = cost;
+        params.path.emplace_back(n.get_handle());
+
+        if (n.get_handle() == params.dst_handle) {
+            state.found = true;
+            state.best_cost = cost;
+            state.best_path = params.path;
+            dijkstra_bound(state, cost, widest);
+            dijkstra_ack(next, prev_node, params, state);
+            return std::make_pair(search_type::BEST_FIRST, next);
+        }
+
+        params.found = state.bounded;
+        params.bound = state.bound;
+        uint32_t sent = 0;
+        for (edge &e: n.get_edges()) {
+            if (!e.has_all_properties(params.edge_props)) {
+                continue;
+            }
+            uint64_t next_cost = dijkstra_extend(cost, dijkstra_edge_weight(e, params.edge_weight_name), widest);
+            if (state.bounded && !dijkstra_better(next_cost, state.bound, widest)) {
+                continue;
+            }
+            params.cost = next_cost;
+            next.emplace_back(std::make_pair(e.get_neighbor(), params));
+            sent++;
+        }
+
+        if (sent == 0) {
+            dijkstra_ack(next, prev_node, params, state);
+        } else if (state.out_count == 0) {
+            state.parent = prev_node;
+            state.out_count = sent;
+        } else {
+            state.out_count += sent;
+            dijkstra_ack(next, prev_node, params, state);
+        }
+        return std::make_pair(search_type::BEST_FIRST, next);
+
+    } else { // ack
+        if (state.out_count == 0) {
+            WDEBUG << "ALERT! Bad state value in dijkstra program" << std::endl;
+            return std::make_pair(search_type::BEST_FIRST, next);
+        }
+
+        if (params.found && (!state.found || dijkstra_better(params.cost, state.best_cost, widest))) {
+            state.found = true;
+            state.best_cost = params.cost;
+            state.best_path = params.path;
+            dijkstra_bound(state, params.cost, widest);
+        }
+
+        if (--state.out_count == 0) {
+            dijkstra_ack(next, state.parent, params, state);
+        }
+        return std::make_pair(search_type::BEST_FIRST, next);
+    }
+}
@@ -68,6 +68,24 @@ discover_paths_params :: unpack(e::unpacker &unpacker)
     message::unpack_buffer(unpacker, path_ancestors);
 }
 
+const predicate::compiled_predicates&
+discover_paths_params :: node_evaluator()
+{
+    if (!compiled_node_preds) {
+        compiled_node_preds = std::make_shared<predicate::compiled_predicates>(node_preds);
+    }
+    return *compiled_node_preds;
+}
+
+const predicate::compiled_predicates&
+discover_paths_params :: edge_evaluator()
+{
+    if (!compiled_edge_preds) {
+        compiled_edge_preds = std::make_shared<predicate::compiled_predicates>(edge_preds);
+    }
+    return *compiled_edge_preds;
+}
+
 // state
 dp_len_state :: dp_len_state()
     : outstanding_count(0)
@@ -162,7 +180,7 @@ node_prog :: discover_paths_node_program(node_prog::node &n,
         } else {
             // visit this node now
             dp_len_state &dp_state = state.vmap[params.path_len];
-            if (!n.has_all_predicates(params.node_preds)) {
+            if (!n.has_all_predicates(params.node_evaluator())) {
                 // node does not have all required properties, return immediately
                 params.returning = true;
                 assert(params.paths.empty());
@@ -179,10 +197,11 @@ node_prog :: discover_paths_node_program(node_prog::node &n,
                     params.prev_node = rn;
                     params.path_ancestors.emplace(n.get_handle());
 
+                    const predicate::compiled_predicates &edge_eval = params.edge_evaluator();
                     for (edge &e: n.get_edges()) {
                         const db::remote_node &nbr = e.get_neighbor();
                         if (params.path_ancestors.find(nbr.handle) == params.path_ancestors.end()
-                        &&  e.has_all_predicates(params.edge_preds)) {
+                        &&  e.has_all_predicates(edge_eval)) {
                             next.emplace_back(std::make_pair(nbr, params));
                             dp_state.outstanding_count++;
                         }
@@ -228,9 +247,10 @@ node_prog :: discover_paths_node_program(node_prog::node &n,
                 cur_node = n.get_handle();
             }
             edge_set &eset = dp_state.paths[cur_node];
+            const predicate::compiled_predicates &edge_eval = params.edge_evaluator();
             for (edge &e: n.get_edges()) {
                 node_handle_t nbr = e.get_neighbor().handle;
-                if (e.has_all_predicates(params.edge_preds) && dp_state.paths.find(nbr) != dp_state.paths.end()) {
+                if (e.has_all_predicates(edge_eval) && dp_state.paths.find(nbr) != dp_state.paths.end()) {
                     cl::edge cl_e;
                     e.get_client_edge(n.get_handle(), cl_e);
                     eset.emplace(cl_e);
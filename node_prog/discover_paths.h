@@ -15,6 +15,7 @@
 #define weaver_node_prog_discover_paths_h_
 
 #include <string>
+#include <memory>
 
 #include "common/property_predicate.h"
 #include "db/remote_node.h"
@@ -40,12 +41,20 @@ namespace node_prog
         node_handle_t src;
         std::unordered_set<node_handle_t> path_ancestors; // prevent cycles
 
+        // node_preds and edge_preds compiled on first use, not packed
+        // hops to nodes on the same shard copy params and share these
+        std::shared_ptr<predicate::compiled_predicates> compiled_node_preds;
+        std::shared_ptr<predicate::compiled_predicates> compiled_edge_preds;
+
         discover_paths_params();
         ~discover_paths_params() { }
         uint64_t size() const;
         void pack(e::buffer::packer&) const;
         void unpack(e::unpacker&);
 
+        const predicate::compiled_predicates& node_evaluator();
+        const predicate::compiled_predicates& edge_evaluator();
+
         // no caching
         bool search_cache() { return false; }
         cache_key_t cache_key() { return cache_key_t(); }
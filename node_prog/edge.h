@@ -27,12 +27,12 @@ namespace node_prog
         public:
             virtual ~edge() { }
             virtual const edge_handle_t& get_handle() const = 0;
-            virtual void traverse() = 0;
             virtual const db::remote_node& get_neighbor() = 0;
             virtual prop_list get_properties() = 0;
             virtual bool has_property(std::pair<std::string, std::string> &p) = 0;
             virtual bool has_all_properties(std::vector<std::pair<std::string, std::string>> &props) = 0;
             virtual bool has_all_predicates(std::vector<predicate::prop_predicate> &preds) = 0;
+            virtual bool has_all_predicates(const predicate::compiled_predicates &preds) = 0;
             virtual void get_client_edge(const std::string &node, cl::edge&) = 0;
    };
 }
@@ -52,9 +52,14 @@ node_prog :: edge_count_node_program(
 {
     auto elist = n.get_edges();
     params.edge_count = 0;
-    for (edge &e: elist) {
-        if (e.has_all_properties(params.edges_props)) {
-            params.edge_count++;
+    if (params.edges_props.empty()) {
+        params.edge_count = elist.visible_count();
+    } else {
+        auto &lookup = elist.lookup_property(params.edges_props);
+        for (edge &e: elist.edges_with_property(lookup.first, lookup.second)) {
+            if (params.edges_props.size() == 1 || e.has_all_properties(params.edges_props)) {
+                params.edge_count++;
+            }
         }
     }
 
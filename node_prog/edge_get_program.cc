@@ -11,6 +11,8 @@
  * ===============================================================
  */
 
+#include <unordered_set>
+
 #include "common/message.h"
 #include "node_prog/edge_get_program.h"
 
@@ -44,6 +46,30 @@ void edge_get_params :: unpack(e::unpacker& unpacker)
     message::unpack_buffer(unpacker, properties);
 }
 
+static bool
+nbr_selected(node_prog::edge &e, const std::vector<node_handle_t> &nbrs)
+{
+    if (nbrs.empty()) {
+        return true;
+    }
+
+    auto nbr = e.get_neighbor();
+    for (const node_handle_t &h: nbrs) {
+        if (h == nbr.handle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void
+add_response_edge(node_prog::node &n, node_prog::edge &e, edge_get_params &params)
+{
+    cl::edge cl_edge;
+    e.get_client_edge(n.get_handle(), cl_edge);
+    params.response_edges.emplace_back(cl_edge);
+}
+
 std::pair<search_type, std::vector<std::pair<db::remote_node, edge_get_params>>>
 node_prog :: edge_get_node_program(
     node &n,
@@ -54,41 +80,43 @@ node_prog :: edge_get_node_program(
         std::shared_ptr<std::vector<db::remote_node>>, cache_key_t)>&,
     cache_response<Cache_Value_Base>*)
 {
-    auto elist = n.get_edges();
-    for (edge &e : elist) {
-        bool select = true;
-
-        if (!params.nbrs.empty()) {
-            auto nbr = e.get_neighbor();
-            bool found = false;
-            for (const node_handle_t &h: params.nbrs) {
-                if (h == nbr.handle) {
-                    found = true;
-                    break;
-                }
+    if (!params.request_edges.empty()) {
+        // look up the requested edges, nbrs or properties instead of scanning all out edges
+        std::unordered_set<edge_handle_t> looked_up;
+        for (const edge_handle_t &h: params.request_edges) {
+            if (!looked_up.emplace(h).second || !n.edge_exists(h)) {
+                continue;
             }
-            if (!found) {
-                select = false;
+            edge &e = n.get_edge(h);
+            if (nbr_selected(e, params.nbrs) && e.has_all_properties(params.properties)) {
+                add_response_edge(n, e, params);
             }
         }
-
-        if (select && !params.request_edges.empty()) {
-            bool found = false;
-            for (const edge_handle_t &h: params.request_edges) {
-                if (e.get_handle() == h) {
-                    found = true;
-                    break;
+    } else if (!params.nbrs.empty()) {
+        auto elist = n.get_edges();
+        std::unordered_set<node_handle_t> looked_up;
+        for (const node_handle_t &nbr: params.nbrs) {
+            if (!looked_up.emplace(nbr).second) {
+                continue;
+            }
+            for (edge &e: elist.edges_to(nbr)) {
+                if (e.has_all_properties(params.properties)) {
+                    add_response_edge(n, e, params);
                 }
             }
-            if (!found) {
-                select = false;
+        }
+    } else if (!params.properties.empty()) {
+        auto elist = n.get_edges();
+        auto &lookup = elist.lookup_property(params.properties);
+        for (edge &e: elist.edges_with_property(lookup.first, lookup.second)) {
+            if (e.has_all_properties(params.properties)) {
+                add_response_edge(n, e, params);
             }
         }
-
-        if (select && e.has_all_properties(params.properties)) {
-            cl::edge cl_edge;
-            e.get_client_edge(n.get_handle(), cl_edge);
-            params.response_edges.emplace_back(cl_edge);
+    } else {
+        auto elist = n.get_edges();
+        for (edge &e : elist) {
+            add_response_edge(n, e, params);
         }
     }
 
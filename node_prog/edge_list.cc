@@ -11,69 +11,166 @@
  * ===============================================================
  */
 
+#include <assert.h>
+
+#include "db/out_edge_index.h"
 #include "node_prog/edge_list.h"
 
 using node_prog::edge_map_iter;
+using node_prog::edge_range;
 using node_prog::edge_list;
 
-edge_map_iter&
-edge_map_iter :: operator++()
+bool
+edge_map_iter :: at_end() const
+{
+    if (candidates != nullptr) {
+        return cand_idx >= candidates->size();
+    } else {
+        return internal_cur == internal_end;
+    }
+}
+
+// false at the end
+bool
+edge_map_iter :: next_position()
 {
-    while (++internal_cur != internal_end) {
-        bool to_break = false;
+    if (candidates != nullptr) {
+        return ++cand_idx < candidates->size();
+    } else {
+        return ++internal_cur != internal_end;
+    }
+}
 
-        for (db::edge *e: internal_cur->second) {
-            if (time_oracle->clock_creat_before_del_after(*req_time, e->base.get_creat_time(), e->base.get_del_time())) {
-                cur_edge = e;
-                to_break = true;
-                break;
+bool
+edge_map_iter :: selected(db::edge *e)
+{
+    if (!time_oracle->clock_creat_before_del_after(*req_time, e->base.get_creat_time(), e->base.get_del_time())) {
+        return false;
+    }
+    if (filter != nullptr) {
+        if (filter->by_nbr && e->nbr.handle != filter->nbr) {
+            return false;
+        }
+        if (filter->by_prop) {
+            e->base.view_time = req_time;
+            e->base.time_oracle = time_oracle;
+            if (!e->has_property(filter->prop)) {
+                return false;
             }
         }
+    }
 
-        if (to_break) {
+    cur_edge = e;
+    return true;
+}
+
+bool
+edge_map_iter :: select_edge()
+{
+    if (candidates != nullptr) {
+        return selected((*candidates)[cand_idx]);
+    }
+
+    // at most one version of an edge handle is visible
+    for (db::edge *e: internal_cur->second) {
+        if (time_oracle->clock_creat_before_del_after(*req_time, e->base.get_creat_time(), e->base.get_del_time())) {
+            return selected(e);
+        }
+    }
+
+    return false;
+}
+
+edge_map_iter&
+edge_map_iter :: operator++()
+{
+    if (remaining == 0) {
+        internal_cur = internal_end;
+        if (candidates != nullptr) {
+            cand_idx = candidates->size();
+        }
+        return *this;
+    }
+
+    while (next_position()) {
+        if (select_edge()) {
             break;
         }
     }
+
+    if (!at_end() && remaining != UINT64_MAX) {
+        remaining--;
+    }
     return *this;
 }
 
+void
+edge_map_iter :: first_edge()
+{
+    if (remaining == 0) {
+        internal_cur = internal_end;
+        if (candidates != nullptr) {
+            cand_idx = candidates->size();
+        }
+    } else if (!at_end()) {
+        if (select_edge()) {
+            if (remaining != UINT64_MAX) {
+                remaining--;
+            }
+        } else {
+            ++(*this);
+        }
+    }
+}
+
 edge_map_iter :: edge_map_iter(edge_map_t::iterator begin,
     edge_map_t::iterator end,
     std::shared_ptr<vc::vclock> &req_time,
-    order::oracle *to)
+    order::oracle *to,
+    uint64_t limit,
+    edge_filter *f)
     : cur_edge(nullptr)
     , internal_cur(begin)
     , internal_end(end)
+    , candidates(nullptr)
+    , cand_idx(0)
     , req_time(req_time)
     , time_oracle(to)
+    , remaining(limit)
+    , filter(f)
 {
-    if (internal_cur != internal_end) {
-        bool to_break = false;
-
-        for (db::edge *e: internal_cur->second) {
-            if (time_oracle->clock_creat_before_del_after(*req_time, e->base.get_creat_time(), e->base.get_del_time())) {
-                cur_edge = e;
-                to_break = true;
-                break;
-            }
-        }
+    first_edge();
+}
 
-        if (!to_break) {
-            ++(*this);
-        }
-    }
+edge_map_iter :: edge_map_iter(const std::vector<db::edge*> *cands,
+    uint64_t idx,
+    std::shared_ptr<vc::vclock> &req_time,
+    order::oracle *to,
+    edge_filter *f)
+    : cur_edge(nullptr)
+    , candidates(cands)
+    , cand_idx(idx)
+    , req_time(req_time)
+    , time_oracle(to)
+    , remaining(UINT64_MAX)
+    , filter(f)
+{
+    first_edge();
 }
 
 bool
 edge_map_iter :: operator==(const edge_map_iter& rhs)
 {
+    if (candidates != nullptr) {
+        return cand_idx == rhs.cand_idx && *req_time == *rhs.req_time;
+    }
     return internal_cur == rhs.internal_cur && *req_time == *rhs.req_time;
 }
 
 bool
 edge_map_iter :: operator!=(const edge_map_iter& rhs)
 {
-    return internal_cur != rhs.internal_cur || !(*req_time == *rhs.req_time);
+    return !(*this == rhs);
 }
 
 node_prog::edge&
@@ -85,12 +182,73 @@ edge_map_iter :: operator*()
     return toRet;
 }
 
+edge_range :: edge_range(edge_map_t::iterator begin,
+    edge_map_t::iterator end,
+    std::shared_ptr<vc::vclock> &req_time,
+    order::oracle *to,
+    uint64_t lim)
+    : range_begin(begin)
+    , range_end(end)
+    , req_time(req_time)
+    , time_oracle(to)
+    , limit(lim)
+{ }
+
+edge_range :: edge_range(edge_map_t::iterator begin,
+    edge_map_t::iterator end,
+    std::shared_ptr<vc::vclock> &req_time,
+    order::oracle *to,
+    const edge_filter &f)
+    : range_begin(begin)
+    , range_end(end)
+    , req_time(req_time)
+    , time_oracle(to)
+    , limit(UINT64_MAX)
+    , filter(f)
+{ }
+
+edge_range :: edge_range(std::shared_ptr<std::vector<db::edge*>> cands,
+    std::shared_ptr<vc::vclock> &req_time,
+    order::oracle *to,
+    const edge_filter &f)
+    : candidates(cands)
+    , req_time(req_time)
+    , time_oracle(to)
+    , limit(UINT64_MAX)
+    , filter(f)
+{ }
+
+edge_map_iter
+edge_range :: begin()
+{
+    edge_filter *f = (filter.by_prop || filter.by_nbr)? &filter : nullptr;
+    if (candidates) {
+        return edge_map_iter(candidates.get(), 0, req_time, time_oracle, f);
+    }
+    return edge_map_iter(range_begin, range_end, req_time, time_oracle, limit, f);
+}
+
+edge_map_iter
+edge_range :: end()
+{
+    if (candidates) {
+        return edge_map_iter(candidates.get(), candidates->size(), req_time, time_oracle, nullptr);
+    }
+    return edge_map_iter(range_end, range_end, req_time, time_oracle);
+}
+
 edge_list :: edge_list(edge_map_t &edge_list,
     std::shared_ptr<vc::vclock> &req_time,
-    order::oracle *to)
+    order::oracle *to,
+    std::atomic<uint64_t> *live,
+    const vc::vclock_t *last,
+    db::out_edge_index *idx)
     : wrapped(edge_list)
     , req_time(req_time)
     , time_oracle(to)
+    , live_edges(live)
+    , last_write(last)
+    , index(idx)
 { }
 
 edge_map_iter
@@ -110,3 +268,111 @@ edge_list :: count()
 {
     return wrapped.size();
 }
+
+uint64_t
+edge_list :: visible_count()
+{
+    if (live_edges != nullptr
+     && last_write != nullptr
+     && last_write->size() == req_time->clock.size()
+     && order::oracle::equal_or_happens_before_no_kronos(*last_write, req_time->clock)) {
+        // request sees every edge created so far, and none of the deleted ones
+        uint64_t live = live_edges->load(std::memory_order_relaxed);
+        if (live == EDGE_COUNT_UNKNOWN) {
+            live = 0;
+            for (const auto &p: wrapped) {
+                if (!p.second.empty() && !p.second.back()->base.get_del_time()) {
+                    live++;
+                }
+            }
+            // concurrent readers compute the same count, writers hold the node exclusively
+            live_edges->store(live, std::memory_order_relaxed);
+        }
+        return live;
+    }
+
+    uint64_t visible = 0;
+    for (auto iter = begin(); iter != end(); ++iter) {
+        visible++;
+    }
+    return visible;
+}
+
+edge_range
+edge_list :: edges_with_property(const std::string &key, const std::string &value)
+{
+    edge_filter filter;
+    filter.by_prop = true;
+    filter.prop = std::make_pair(key, value);
+
+    if (index != nullptr) {
+        std::shared_ptr<std::vector<db::edge*>> candidates(new std::vector<db::edge*>());
+        if (index->edges_with(key, value, *candidates)) {
+            return edge_range(candidates, req_time, time_oracle, filter);
+        }
+    }
+    return edge_range(wrapped.begin(), wrapped.end(), req_time, time_oracle, filter);
+}
+
+bool
+edge_list :: property_indexed(const std::string &key)
+{
+    return index != nullptr && index->indexed(key);
+}
+
+const std::pair<std::string, std::string>&
+edge_list :: lookup_property(const std::vector<std::pair<std::string, std::string>> &props)
+{
+    assert(!props.empty());
+    for (const auto &p: props) {
+        if (property_indexed(p.first)) {
+            return p;
+        }
+    }
+    return props.front();
+}
+
+edge_range
+edge_list :: edges_to(const node_handle_t &nbr)
+{
+    edge_filter filter;
+    filter.by_nbr = true;
+    filter.nbr = nbr;
+
+    if (index != nullptr) {
+        std::shared_ptr<std::vector<db::edge*>> candidates(new std::vector<db::edge*>());
+        index->edges_to(nbr, *candidates);
+        // nbr handles of edges never change, so the filter only checks visibility
+        filter.by_nbr = false;
+        return edge_range(candidates, req_time, time_oracle, filter);
+    }
+    return edge_range(wrapped.begin(), wrapped.end(), req_time, time_oracle, filter);
+}
+
+edge_range
+edge_list :: first_n(uint64_t n)
+{
+    return edge_range(wrapped.begin(), wrapped.end(), req_time, time_oracle, n);
+}
+
+std::vector<edge_range>
+edge_list :: partition(uint64_t num_parts)
+{
+    assert(num_parts > 0);
+    std::vector<edge_range> parts;
+    parts.reserve(num_parts);
+
+    uint64_t size = wrapped.size();
+    auto iter = wrapped.begin();
+    for (uint64_t i = 0; i < num_parts; i++) {
+        auto part_begin = iter;
+        uint64_t part_size = size / num_parts + (i < size % num_parts? 1 : 0);
+        for (uint64_t j = 0; j < part_size; j++) {
+            iter++;
+        }
+        parts.emplace_back(part_begin, iter, req_time, time_oracle);
+    }
+    assert(iter == wrapped.end());
+
+    return parts;
+}
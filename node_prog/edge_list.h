@@ -15,6 +15,10 @@
 #define weaver_node_prog_edge_list_h_
 
 #include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
 #include <iterator>
 
 #include "db/edge.h"
@@ -22,42 +26,137 @@
 #include "common/event_order.h"
 #include "node_prog/edge.h"
 
+#define EDGE_COUNT_UNKNOWN UINT64_MAX
+
+namespace db
+{
+    class out_edge_index;
+}
+
 namespace node_prog
 {
     using edge_map_t = db::data_map<std::vector<db::edge*>>;
+
+    // conditions on edges of a range, besides visibility
+    struct edge_filter
+    {
+        bool by_prop;
+        std::pair<std::string, std::string> prop;
+        bool by_nbr;
+        node_handle_t nbr;
+
+        edge_filter() : by_prop(false), by_nbr(false) { }
+    };
+
     class edge_map_iter : public std::iterator<std::input_iterator_tag, edge>
     {
         db::edge *cur_edge;
         edge_map_t::iterator internal_cur;
         edge_map_t::iterator internal_end;
+        // edge versions from an out edge index, iterated instead of the map if not null
+        const std::vector<db::edge*> *candidates;
+        uint64_t cand_idx;
         std::shared_ptr<vc::vclock> req_time;
         order::oracle *time_oracle;
+        uint64_t remaining; // visible edges left to return, for first_n
+        edge_filter *filter; // null for all visible edges
+
+        bool at_end() const;
+        bool next_position();
+        bool select_edge(); // visible edge at the current position that passes the filter
+        bool selected(db::edge *e);
+        void first_edge();
 
         public:
             edge_map_iter& operator++();
             edge_map_iter(edge_map_t::iterator begin,
                 edge_map_t::iterator end,
                 std::shared_ptr<vc::vclock> &req_time,
-                order::oracle *time_oracle);
+                order::oracle *time_oracle,
+                uint64_t limit=UINT64_MAX,
+                edge_filter *filter=nullptr);
+            edge_map_iter(const std::vector<db::edge*> *candidates,
+                uint64_t idx,
+                std::shared_ptr<vc::vclock> &req_time,
+                order::oracle *time_oracle,
+                edge_filter *filter);
             bool operator==(const edge_map_iter& rhs);
             bool operator!=(const edge_map_iter& rhs);
             edge& operator*();
     };
 
+    // part of an edge list, for range based for loops
+    // iterators point into the range, so it has to outlive them
+    class edge_range
+    {
+        private:
+            edge_map_t::iterator range_begin;
+            edge_map_t::iterator range_end;
+            std::shared_ptr<std::vector<db::edge*>> candidates;
+            std::shared_ptr<vc::vclock> req_time;
+            order::oracle *time_oracle;
+            uint64_t limit;
+            edge_filter filter;
+
+        public:
+            edge_range(edge_map_t::iterator begin,
+                edge_map_t::iterator end,
+                std::shared_ptr<vc::vclock> &req_time,
+                order::oracle *time_oracle,
+                uint64_t limit=UINT64_MAX);
+            edge_range(edge_map_t::iterator begin,
+                edge_map_t::iterator end,
+                std::shared_ptr<vc::vclock> &req_time,
+                order::oracle *time_oracle,
+                const edge_filter &filter);
+            // edge versions looked up in an index, checked against the filter like a scan
+            edge_range(std::shared_ptr<std::vector<db::edge*>> candidates,
+                std::shared_ptr<vc::vclock> &req_time,
+                order::oracle *time_oracle,
+                const edge_filter &filter);
+            edge_map_iter begin();
+            edge_map_iter end();
+            // oracles are not thread safe, a thread iterating a partition uses its own
+            void set_time_oracle(order::oracle *to) { time_oracle = to; }
+    };
+
     class edge_list
     {
         private:
             edge_map_t &wrapped;
             std::shared_ptr<vc::vclock> &req_time;
             order::oracle *time_oracle;
+            // kept by the node that owns the edges, null if there is none
+            std::atomic<uint64_t> *live_edges;
+            const vc::vclock_t *last_write;
+            db::out_edge_index *index;
 
         public:
             edge_list(edge_map_t &edge_list,
                 std::shared_ptr<vc::vclock> &req_time,
-                order::oracle *time_oracle);
+                order::oracle *time_oracle,
+                std::atomic<uint64_t> *live_edges=nullptr,
+                const vc::vclock_t *last_write=nullptr,
+                db::out_edge_index *index=nullptr);
             edge_map_iter begin();
             edge_map_iter end();
+            // edge handles in the map, including deleted edges and edges created after the request
             uint64_t count();
+            // edges visible to the request
+            // no scan if every write to the node happened before the request
+            uint64_t visible_count();
+            // index lookup if the node is indexed and key is in EdgeIndexKeys, else a scan
+            edge_range edges_with_property(const std::string &key, const std::string &value);
+            bool property_indexed(const std::string &key);
+            // property of props to look up with edges_with_property, an indexed one if there is one
+            const std::pair<std::string, std::string>& lookup_property(const std::vector<std::pair<std::string, std::string>> &props);
+            // index lookup if the node is indexed, else a scan
+            edge_range edges_to(const node_handle_t &nbr);
+            // stops after n visible edges
+            edge_range first_n(uint64_t n);
+            // splits the map into num_parts ranges of about equal size, in one pass without visibility checks
+            // ranges can be iterated by different threads while the node is held, see set_time_oracle
+            std::vector<edge_range> partition(uint64_t num_parts);
     };
 }
 
@@ -162,9 +162,10 @@ node_prog :: get_btc_block_node_program(node_prog::node &n,
                         pred.value = tx_id;
                         pred.rel = predicate::STARTS_WITH;
                         edge_preds.emplace_back(pred);
+                        predicate::compiled_predicates edge_eval(edge_preds);
 
                         for (edge &in_e: n.get_edges()) {
-                            if (in_e.has_all_predicates(edge_preds)) {
+                            if (in_e.has_all_predicates(edge_eval)) {
                                 in_e.get_client_edge(n.get_handle(), cl_edge);
                                 btc_tx.first.emplace_back(cl_edge);
                             }
@@ -0,0 +1,230 @@
+/*
+ * ===============================================================
+ *    Description:  Reachability within a bounded number of hops,
+ *                  returns a shortest path found within the bound.
+ *
+ *        Created:  Sunday 23 April 2013 11:00:03  EDT
+ *
+ *         Author:  Ayush Dubey, Greg Hill
+ *                  dubey@cs.cornell.edu, gdh39@cornell.edu
+ *
+ * Copyright (C) 2013, Cornell University, see the LICENSE file
+ *                     for licensing agreement
+ * ================================================================
+ */
+
+#include "common/message.h"
+#include "node_prog/edge.h"
+#include "node_prog/n_hop_reach_program.h"
+
+using node_prog::search_type;
+using node_prog::n_hop_reach_params;
+using node_prog::n_hop_reach_node_state;
+using node_prog::cache_response;
+
+// params
+n_hop_reach_params :: n_hop_reach_params()
+    : returning(false)
+    , prev_node(db::coordinator)
+    , hops(0)
+    , max_hops(0)
+    , reachable(false)
+{ }
+
+bool
+n_hop_reach_params :: search_cache()
+{
+    return false;
+}
+
+uint64_t
+n_hop_reach_params :: size() const
+{
+    uint64_t toRet = message::size(returning)
+        + message::size(prev_node)
+        + message::size(dest)
+        + message::size(hops)
+        + message::size(max_hops)
+        + message::size(edge_props)
+        + message::size(reachable)
+        + message::size(path);
+    return toRet;
+}
+
+void
+n_hop_reach_params :: pack(e::buffer::packer &packer) const
+{
+    message::pack_buffer(packer, returning);
+    message::pack_buffer(packer, prev_node);
+    message::pack_buffer(packer, dest);
+    message::pack_buffer(packer, hops);
+    message::pack_buffer(packer, max_hops);
+    message::pack_buffer(packer, edge_props);
+    message::pack_buffer(packer, reachable);
+    message::pack_buffer(packer, path);
+}
+
+void
+n_hop_reach_params :: unpack(e::unpacker &unpacker)
+{
+    message::unpack_buffer(unpacker, returning);
+    message::unpack_buffer(unpacker, prev_node);
+    message::unpack_buffer(unpacker, dest);
+    message::unpack_buffer(unpacker, hops);
+    message::unpack_buffer(unpacker, max_hops);
+    message::unpack_buffer(unpacker, edge_props);
+    message::unpack_buffer(unpacker, reachable);
+    message::unpack_buffer(unpacker, path);
+}
+
+// state
+n_hop_reach_node_state :: n_hop_reach_node_state()
+    : hops(UINT32_MAX)
+    , out_count(0)
+    , reachable(false)
+{ }
+
+uint64_t
+n_hop_reach_node_state :: size() const
+{
+    uint64_t toRet = message::size(hops)
+        + message::size(out_count)
+        + message::size(pending)
+        + message::size(reachable)
+        + message::size(path);
+    return toRet;
+}
+
+void
+n_hop_reach_node_state :: pack(e::buffer::packer& packer) const
+{
+    message::pack_buffer(packer, hops);
+    message::pack_buffer(packer, out_count);
+    message::pack_buffer(packer, pending);
+    message::pack_buffer(packer, reachable);
+    message::pack_buffer(packer, path);
+}
+
+void
+n_hop_reach_node_state :: unpack(e::unpacker& unpacker)
+{
+    message::unpack_buffer(unpacker, hops);
+    message::unpack_buffer(unpacker, out_count);
+    message::unpack_buffer(unpacker, pending);
+    message::unpack_buffer(unpacker, reachable);
+    message::unpack_buffer(unpacker, path);
+}
+
+
+// node prog code
+
+static void
+n_hop_reply(std::vector<std::pair<db::remote_node, n_hop_reach_params>> &next,
+    const db::remote_node &to,
+    n_hop_reach_params &params,
+    bool reachable,
+    const std::vector<node_handle_t> &path)
+{
+    params.returning = true;
+    params.reachable = reachable;
+    if (reachable) {
+        params.path = path;
+    } else {
+        params.path.clear();
+    }
+    next.emplace_back(std::make_pair(to, params));
+}
+
+// A node is explored again only if a request reaches it in fewer hops than before.
+// A request that arrives with at least as many hops is answered false right away:
+// any path to dest through this node is reported through the earlier request,
+// which has more hops left.
+std::pair<search_type, std::vector<std::pair<db::remote_node, n_hop_reach_params>>>
+node_prog :: n_hop_reach_node_program(
+        node &n,
+        db::remote_node &rn,
+        n_hop_reach_params &params,
+        std::function<n_hop_reach_node_state&()> state_getter,
+        std::function<void(std::shared_ptr<Cache_Value_Base>,
+            std::shared_ptr<std::vector<db::remote_node>>, cache_key_t)>&,
+        cache_response<Cache_Value_Base>*)
+{
+    n_hop_reach_node_state &state = state_getter();
+    std::vector<std::pair<db::remote_node, n_hop_reach_params>> next;
+    db::remote_node prev_node = params.prev_node;
+    params.prev_node = rn;
+
+    if (!params.returning) { // request mode
+        uint32_t hops = params.hops;
+        if (params.dest == n.get_handle()) {
+            std::vector<node_handle_t> path(1, n.get_handle());
+            n_hop_reply(next, prev_node, params, true, path);
+            return std::make_pair(search_type::DEPTH_FIRST, next);
+        }
+
+        if (state.reachable && hops + state.path.size() - 1 <= params.max_hops) {
+            n_hop_reply(next, prev_node, params, true, state.path);
+            return std::make_pair(search_type::DEPTH_FIRST, next);
+        }
+
+        if (hops >= state.hops || hops >= params.max_hops) {
+            n_hop_reply(next, prev_node, params, false, state.path);
+            return std::make_pair(search_type::BREADTH_FIRST, next);
+        }
+
+        state.hops = hops;
+        params.hops = hops + 1;
+        uint32_t sent = 0;
+        for (edge &e: n.get_edges()) {
+            if (e.has_all_properties(params.edge_props)) {
+                next.emplace_back(std::make_pair(e.get_neighbor(), params));
+                sent++;
+            }
+        }
+
+        if (sent == 0) {
+            n_hop_reply(next, prev_node, params, false, state.path);
+        } else {
+            state.out_count += sent;
+            state.pending.emplace_back(prev_node, hops);
+        }
+        return std::make_pair(search_type::BREADTH_FIRST, next);
+
+    } else { // reply mode
+        if (state.out_count == 0) {
+            WDEBUG << "ALERT! Bad state value in n hop reach program" << std::endl;
+            return std::make_pair(search_type::BREADTH_FIRST, next);
+        }
+        state.out_count--;
+
+        if (params.reachable && (!state.reachable || params.path.size() + 1 < state.path.size())) {
+            state.reachable = true;
+            state.path.clear();
+            state.path.reserve(params.path.size() + 1);
+            state.path.emplace_back(n.get_handle());
+            state.path.insert(state.path.end(), params.path.begin(), params.path.end());
+        }
+
+        // answer requesters whose hop budget the shortest path so far fits,
+        // and everyone once all replies are in
+        uint32_t dist = state.path.size() - 1;
+        auto iter = state.pending.begin();
+        while (iter != state.pending.end()) {
+            if (state.reachable && iter->second + dist <= params.max_hops) {
+                n_hop_reply(next, iter->first, params, true, state.path);
+                iter = state.pending.erase(iter);
+            } else if (state.out_count == 0) {
+                n_hop_reply(next, iter->first, params, false, state.path);
+                iter = state.pending.erase(iter);
+            } else {
+                iter++;
+            }
+        }
+
+        if (params.reachable) {
+            return std::make_pair(search_type::DEPTH_FIRST, next);
+        } else {
+            return std::make_pair(search_type::BREADTH_FIRST, next);
+        }
+    }
+}
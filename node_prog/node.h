@@ -33,6 +33,7 @@ namespace node_prog
             virtual bool has_property(std::pair<std::string, std::string> &p) = 0;
             virtual bool has_all_properties(std::vector<std::pair<std::string, std::string>> &props) = 0;
             virtual bool has_all_predicates(std::vector<predicate::prop_predicate> &preds) = 0;
+            virtual bool has_all_predicates(const predicate::compiled_predicates &preds) = 0;
             virtual bool is_alias(const node_handle_t &alias) const = 0;
             virtual void get_client_node(cl::node&, bool props, bool edges, bool aliases) = 0;
     };
@@ -24,7 +24,8 @@ namespace node_prog
     enum search_type
     {
         BREADTH_FIRST,
-        DEPTH_FIRST
+        DEPTH_FIRST,
+        BEST_FIRST // ordered by Node_Parameters_Base::priority(), lowest first
     };
 
     enum prog_type
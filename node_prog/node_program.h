@@ -31,6 +31,9 @@
 #include "node_prog/node_prog_type.h"
 #include "node_prog/reach_program.h"
 #include "node_prog/pathless_reach_program.h"
+#include "node_prog/n_hop_reach_program.h"
+#include "node_prog/triangle_program.h"
+#include "node_prog/dijkstra_program.h"
 #include "node_prog/clustering_program.h"
 #include "node_prog/read_node_props_program.h"
 #include "node_prog/read_n_edges_program.h"
@@ -73,11 +76,16 @@ namespace node_prog
     {
         private:
             /* constructs a clone without start_node_params or cache_value */
-            node_prog_running_state(node_prog::prog_type ptype, uint64_t vt, std::shared_ptr<vc::vclock> vclk, uint64_t rid, uint64_t vtptr)
+            node_prog_running_state(node_prog::prog_type ptype, uint64_t vt, std::shared_ptr<vc::vclock> vclk, uint64_t rid,
+                uint64_t tid, uint64_t parent, uint64_t hop, uint64_t vtptr)
                 : prog_type_recvd(ptype)
                 , vt_id(vt)
                 , req_vclock(vclk)
                 , req_id(rid)
+                , trace_id(tid)
+                , parent_hop(parent)
+                , hop_id(hop)
+                , fetch_start(0)
                 , vt_prog_ptr(vtptr)
             { }
 
@@ -86,18 +94,26 @@ namespace node_prog
             uint64_t vt_id;
             std::shared_ptr<vc::vclock> req_vclock;
             uint64_t req_id;
+            // prog_trace ids, trace_id is 0 if this program is not traced
+            uint64_t trace_id, parent_hop, hop_id;
+            uint64_t fetch_start; // when cache contexts were requested, if traced
             uint64_t vt_prog_ptr;
             std::deque<std::pair<node_handle_t, ParamsType>> start_node_params;
             std::unique_ptr<cache_response<CacheValueType>> cache_value;
 
-            node_prog_running_state() { }
+            node_prog_running_state()
+                : trace_id(0)
+                , parent_hop(0)
+                , hop_id(0)
+                , fetch_start(0)
+            { }
             // delete standard copy onstructors
             node_prog_running_state(const node_prog_running_state &) = delete;
             node_prog_running_state& operator=(node_prog_running_state const&) = delete;
 
             node_prog_running_state clone_without_start_node_params() 
             {
-                return node_prog_running_state(prog_type_recvd, vt_id, req_vclock, req_id, vt_prog_ptr);
+                return node_prog_running_state(prog_type_recvd, vt_id, req_vclock, req_id, trace_id, parent_hop, hop_id, vt_prog_ptr);
             }
 
             node_prog_running_state(node_prog_running_state&& copy_from)
@@ -105,6 +121,10 @@ namespace node_prog
                   , vt_id(copy_from.vt_id)
                   , req_vclock(copy_from.req_vclock)
                   , req_id(copy_from.req_id)
+                  , trace_id(copy_from.trace_id)
+                  , parent_hop(copy_from.parent_hop)
+                  , hop_id(copy_from.hop_id)
+                  , fetch_start(copy_from.fetch_start)
                   , vt_prog_ptr(copy_from.vt_prog_ptr)
                   , start_node_params(copy_from.start_node_params)
                   , cache_value(std::move(copy_from.cache_value))
@@ -114,7 +134,8 @@ namespace node_prog
     class node_program
     {
         public:
-            virtual void unpack_and_run_db(std::unique_ptr<message::message> msg, order::oracle *time_oracle) = 0;
+            // enqueue_time is when the message was put in a shard rd_queue, 0 if run on receipt
+            virtual void unpack_and_run_db(std::unique_ptr<message::message> msg, order::oracle *time_oracle, uint64_t enqueue_time) = 0;
             virtual void unpack_context_reply_db(std::unique_ptr<message::message> msg, order::oracle *time_oracle) = 0;
             virtual void unpack_and_start_coord(std::unique_ptr<message::message> msg, uint64_t clientID, coordinator::hyper_stub*) = 0;
 
@@ -141,7 +162,7 @@ namespace node_prog
             }
 
         public:
-            virtual void unpack_and_run_db(std::unique_ptr<message::message> msg, order::oracle *time_oracle);
+            virtual void unpack_and_run_db(std::unique_ptr<message::message> msg, order::oracle *time_oracle, uint64_t enqueue_time);
             virtual void unpack_context_reply_db(std::unique_ptr<message::message> msg, order::oracle *time_oracle);
             virtual void unpack_and_start_coord(std::unique_ptr<message::message> msg, uint64_t clientID, coordinator::hyper_stub*);
 
@@ -155,6 +176,12 @@ namespace node_prog
             new particular_node_program<reach_params, reach_node_state, reach_cache_value>(REACHABILITY, node_prog::reach_node_program) },
         { PATHLESS_REACHABILITY,
             new particular_node_program<pathless_reach_params, pathless_reach_node_state, Cache_Value_Base>(PATHLESS_REACHABILITY, node_prog::pathless_reach_node_program) },
+        { N_HOP_REACHABILITY,
+            new particular_node_program<n_hop_reach_params, n_hop_reach_node_state, Cache_Value_Base>(N_HOP_REACHABILITY, node_prog::n_hop_reach_node_program) },
+        { TRIANGLE_COUNT,
+            new particular_node_program<triangle_params, triangle_node_state, Cache_Value_Base>(TRIANGLE_COUNT, node_prog::triangle_node_program) },
+        { DIJKSTRA,
+            new particular_node_program<dijkstra_params, dijkstra_node_state, Cache_Value_Base>(DIJKSTRA, node_prog::dijkstra_node_program) },
         { CLUSTERING,
             new particular_node_program<clustering_params, clustering_node_state, Cache_Value_Base>(CLUSTERING, node_prog::clustering_node_program) },
         { TWO_NEIGHBORHOOD,
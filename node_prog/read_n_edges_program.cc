@@ -55,13 +55,20 @@ node_prog :: read_n_edges_node_program(
     cache_response<Cache_Value_Base>*)
 {
     auto elist = n.get_edges();
-    int pushcnt = 0;
-    for (edge &e : elist) {
-        if (e.has_all_properties(params.edges_props)) {
-            pushcnt++;
+    if (params.edges_props.empty()) {
+        // num_edges 0 reads all edges
+        for (edge &e: elist.first_n(params.num_edges == 0? UINT64_MAX : params.num_edges)) {
             params.return_edges.emplace_back(e.get_handle());
-            if (--params.num_edges == 0) {
-                break;
+            params.num_edges--;
+        }
+    } else {
+        auto &lookup = elist.lookup_property(params.edges_props);
+        for (edge &e: elist.edges_with_property(lookup.first, lookup.second)) {
+            if (e.has_all_properties(params.edges_props)) {
+                params.return_edges.emplace_back(e.get_handle());
+                if (--params.num_edges == 0) {
+                    break;
+                }
             }
         }
     }
@@ -71,6 +71,18 @@ traverse_props_params :: unpack(e::unpacker &unpacker)
     message::unpack_buffer(unpacker, return_edges);
 }
 
+std::shared_ptr<predicate::compiled_predicates>
+traverse_props_params :: edge_evaluator()
+{
+    if (compiled_edge_props.size() != edge_props.size()) {
+        compiled_edge_props.clear();
+        for (const auto &props: edge_props) {
+            compiled_edge_props.emplace_back(std::make_shared<predicate::compiled_predicates>(props));
+        }
+    }
+    return compiled_edge_props.front();
+}
+
 // state
 traverse_props_state :: traverse_props_state()
     : visited(false)
@@ -154,7 +166,9 @@ node_prog :: traverse_props_node_program(node &n,
                     params.return_nodes.emplace(n.get_handle());
                 }
                 auto edge_props = params.edge_props.front();
+                std::shared_ptr<predicate::compiled_predicates> edge_eval = params.edge_evaluator();
                 params.edge_props.pop_front();
+                params.compiled_edge_props.pop_front();
 
                 bool collect_edges = params.collect_edges;
                 bool propagate = !params.node_props.empty();
@@ -163,14 +177,27 @@ node_prog :: traverse_props_node_program(node &n,
                     collect_edges = true;
                 }
 
-                for (edge &e: n.get_edges()) {
-                    if (e.has_all_properties(edge_props)) {
-                        if (collect_edges) {
-                            params.return_edges.emplace(e.get_handle());
-                        }
-                        if (propagate) {
-                            next.emplace_back(std::make_pair(e.get_neighbor(), params));
-                            state.out_count++;
+                auto elist = n.get_edges();
+                auto visit_edge = [&](edge &e) {
+                    if (collect_edges) {
+                        params.return_edges.emplace(e.get_handle());
+                    }
+                    if (propagate) {
+                        next.emplace_back(std::make_pair(e.get_neighbor(), params));
+                        state.out_count++;
+                    }
+                };
+
+                if (edge_props.empty()) {
+                    for (edge &e: elist) {
+                        visit_edge(e);
+                    }
+                } else {
+                    // edges with an indexed property are looked up, not scanned
+                    auto &lookup = elist.lookup_property(edge_props);
+                    for (edge &e: elist.edges_with_property(lookup.first, lookup.second)) {
+                        if (edge_props.size() == 1 || e.has_all_predicates(*edge_eval)) {
+                            visit_edge(e);
                         }
                     }
                 }
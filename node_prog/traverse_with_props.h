@@ -20,7 +20,9 @@
 #include <string>
 #include <vector>
 #include <deque>
+#include <memory>
 
+#include "common/property_predicate.h"
 #include "db/remote_node.h"
 #include "node_prog/node.h"
 #include "node_prog/base_classes.h"
@@ -40,12 +42,19 @@ namespace node_prog
         std::unordered_set<node_handle_t> return_nodes;
         std::unordered_set<edge_handle_t> return_edges;
 
+        // edge_props of every remaining hop compiled on first use, not packed
+        // hops to nodes on the same shard copy params and share these
+        std::deque<std::shared_ptr<predicate::compiled_predicates>> compiled_edge_props;
+
         traverse_props_params();
         ~traverse_props_params() { }
         uint64_t size() const;
         void pack(e::buffer::packer &packer) const;
         void unpack(e::unpacker &unpacker);
 
+        // compiled edge_props.front()
+        std::shared_ptr<predicate::compiled_predicates> edge_evaluator();
+
         // no caching
         bool search_cache() { return false; }
         cache_key_t cache_key() { return cache_key_t(); }
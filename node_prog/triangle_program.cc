@@ -0,0 +1,273 @@
+/*
+ * ===============================================================
+ *    Description:  Triangle counting program.
+ *
+ *        Created:  Sunday 21 April 2013 11:00:03  EDT
+ *
+ *         Author:  Ayush Dubey, Greg Hill
+ *                  dubey@cs.cornell.edu, gdh39@cornell.edu
+ *
+ * Copyright (C) 2013, Cornell University, see the LICENSE file
+ *                     for licensing agreement
+ * ================================================================
+ */
+
+#include <algorithm>
+
+#include "common/message.h"
+#include "node_prog/edge.h"
+#include "node_prog/triangle_program.h"
+
+using node_prog::search_type;
+using node_prog::triangle_params;
+using node_prog::triangle_node_state;
+using node_prog::cache_response;
+
+// params
+triangle_params :: triangle_params()
+    : phase(TRIANGLE_PHASE_START)
+    , prev_node(db::coordinator)
+    , root(db::coordinator)
+    , num_nodes(0)
+    , count(0)
+{ }
+
+bool
+triangle_params :: search_cache()
+{
+    return false;
+}
+
+void
+triangle_params :: set_start_locs(const std::unordered_map<node_handle_t, uint64_t> &loc_map)
+{
+    auto iter = loc_map.find(root.handle);
+    if (iter != loc_map.end()) {
+        root.loc = iter->second;
+    }
+}
+
+uint64_t
+triangle_params :: size() const
+{
+    uint64_t toRet = message::size(phase)
+        + message::size(prev_node)
+        + message::size(root)
+        + message::size(num_nodes)
+        + message::size(targets)
+        + message::size(nbrs)
+        + message::size(count);
+    return toRet;
+}
+
+void
+triangle_params :: pack(e::buffer::packer &packer) const
+{
+    message::pack_buffer(packer, phase);
+    message::pack_buffer(packer, prev_node);
+    message::pack_buffer(packer, root);
+    message::pack_buffer(packer, num_nodes);
+    message::pack_buffer(packer, targets);
+    message::pack_buffer(packer, nbrs);
+    message::pack_buffer(packer, count);
+}
+
+void
+triangle_params :: unpack(e::unpacker &unpacker)
+{
+    message::unpack_buffer(unpacker, phase);
+    message::unpack_buffer(unpacker, prev_node);
+    message::unpack_buffer(unpacker, root);
+    message::unpack_buffer(unpacker, num_nodes);
+    message::unpack_buffer(unpacker, targets);
+    message::unpack_buffer(unpacker, nbrs);
+    message::unpack_buffer(unpacker, count);
+}
+
+// state
+triangle_node_state :: triangle_node_state()
+    : responses_left(0)
+    , total(0)
+    , is_root(false)
+    , nodes_left(0)
+    , root_total(0)
+{ }
+
+uint64_t
+triangle_node_state :: size() const
+{
+    uint64_t toRet = message::size(responses_left)
+        + message::size(total)
+        + message::size(is_root)
+        + message::size(nodes_left)
+        + message::size(root_total);
+    return toRet;
+}
+
+void
+triangle_node_state :: pack(e::buffer::packer& packer) const
+{
+    message::pack_buffer(packer, responses_left);
+    message::pack_buffer(packer, total);
+    message::pack_buffer(packer, is_root);
+    message::pack_buffer(packer, nodes_left);
+    message::pack_buffer(packer, root_total);
+}
+
+void
+triangle_node_state :: unpack(e::unpacker& unpacker)
+{
+    message::unpack_buffer(unpacker, responses_left);
+    message::unpack_buffer(unpacker, total);
+    message::unpack_buffer(unpacker, is_root);
+    message::unpack_buffer(unpacker, nodes_left);
+    message::unpack_buffer(unpacker, root_total);
+}
+
+
+// node prog code
+
+// neighbors of n sorted by handle, without duplicates and self loops
+static std::vector<db::remote_node>
+sorted_neighbors(node_prog::node &n)
+{
+    std::vector<db::remote_node> nbrs;
+    for (node_prog::edge &e: n.get_edges()) {
+        const db::remote_node &nbr = e.get_neighbor();
+        if (nbr.handle != n.get_handle()) {
+            nbrs.emplace_back(nbr);
+        }
+    }
+
+    auto handle_less = [](const db::remote_node &a, const db::remote_node &b) { return a.handle < b.handle; };
+    auto handle_eq = [](const db::remote_node &a, const db::remote_node &b) { return a.handle == b.handle; };
+    std::sort(nbrs.begin(), nbrs.end(), handle_less);
+    nbrs.erase(std::unique(nbrs.begin(), nbrs.end(), handle_eq), nbrs.end());
+    return nbrs;
+}
+
+// number of handles in nbrs greater than handle that are also neighbors of n
+static uint64_t
+count_common(node_prog::node &n, const std::vector<node_handle_t> &nbrs)
+{
+    std::vector<db::remote_node> mine = sorted_neighbors(n);
+    auto iter1 = std::upper_bound(nbrs.begin(), nbrs.end(), n.get_handle());
+    auto iter2 = mine.begin();
+    uint64_t count = 0;
+    while (iter1 != nbrs.end() && iter2 != mine.end()) {
+        if (*iter1 < iter2->handle) {
+            iter1++;
+        } else if (iter2->handle < *iter1) {
+            iter2++;
+        } else {
+            count++;
+            iter1++;
+            iter2++;
+        }
+    }
+    return count;
+}
+
+// A start node u sends the sorted list of its neighbors greater than u to every
+// neighbor v > u, and v counts the common neighbors greater than v by merging
+// the list with its own sorted neighbors.  u sends one request per shard, to one
+// of its neighbors there, which forwards the list to the other neighbors on the
+// same shard, so the neighbor list crosses the network once per shard.
+std::pair<search_type, std::vector<std::pair<db::remote_node, triangle_params>>>
+node_prog :: triangle_node_program(
+        node &n,
+        db::remote_node &rn,
+        triangle_params &params,
+        std::function<triangle_node_state&()> state_getter,
+        std::function<void(std::shared_ptr<Cache_Value_Base>,
+            std::shared_ptr<std::vector<db::remote_node>>, cache_key_t)>&,
+        cache_response<Cache_Value_Base>*)
+{
+    triangle_node_state &state = state_getter();
+    std::vector<std::pair<db::remote_node, triangle_params>> next;
+    db::remote_node prev_node = params.prev_node;
+    params.prev_node = rn;
+
+    switch (params.phase) {
+        case TRIANGLE_PHASE_START: {
+            std::vector<db::remote_node> nbrs = sorted_neighbors(n);
+            auto first_higher = std::upper_bound(nbrs.begin(), nbrs.end(), rn,
+                [](const db::remote_node &a, const db::remote_node &b) { return a.handle < b.handle; });
+
+            params.nbrs.clear();
+            std::unordered_map<uint64_t, std::vector<node_handle_t>> shard_targets;
+            for (auto iter = first_higher; iter != nbrs.end(); iter++) {
+                params.nbrs.emplace_back(iter->handle);
+                shard_targets[iter->loc].emplace_back(iter->handle);
+            }
+            state.responses_left = params.nbrs.size();
+
+            if (state.responses_left == 0) {
+                params.phase = TRIANGLE_PHASE_TOTAL;
+                params.count = 0;
+                next.emplace_back(std::make_pair(params.root, params));
+            } else {
+                params.phase = TRIANGLE_PHASE_CHECK;
+                for (auto &p: shard_targets) {
+                    db::remote_node first(p.first, p.second.front());
+                    params.targets.assign(p.second.begin()+1, p.second.end());
+                    next.emplace_back(std::make_pair(first, params));
+                }
+            }
+            break;
+        }
+
+        case TRIANGLE_PHASE_CHECK: {
+            if (!params.targets.empty()) {
+                std::vector<node_handle_t> targets = std::move(params.targets);
+                params.targets.clear();
+                std::vector<node_handle_t> all_nbrs = std::move(params.nbrs);
+                for (const node_handle_t &t: targets) {
+                    // t only needs the neighbors greater than itself
+                    auto from = std::upper_bound(all_nbrs.begin(), all_nbrs.end(), t);
+                    params.nbrs.assign(from, all_nbrs.end());
+                    params.prev_node = prev_node;
+                    next.emplace_back(std::make_pair(db::remote_node(rn.loc, t), params));
+                }
+                params.nbrs = std::move(all_nbrs);
+            }
+
+            params.count = count_common(n, params.nbrs);
+            params.phase = TRIANGLE_PHASE_COUNT;
+            params.prev_node = rn;
+            params.nbrs.clear();
+            next.emplace_back(std::make_pair(prev_node, params));
+            break;
+        }
+
+        case TRIANGLE_PHASE_COUNT:
+            if (state.responses_left == 0) {
+                WDEBUG << "ALERT! Bad state value in triangle program" << std::endl;
+                break;
+            }
+            state.total += params.count;
+            if (--state.responses_left == 0) {
+                params.phase = TRIANGLE_PHASE_TOTAL;
+                params.count = state.total;
+                next.emplace_back(std::make_pair(params.root, params));
+            }
+            break;
+
+        case TRIANGLE_PHASE_TOTAL:
+            if (!state.is_root) {
+                state.is_root = true;
+                state.nodes_left = params.num_nodes;
+            }
+            state.root_total += params.count;
+            if (--state.nodes_left == 0) {
+                params.count = state.root_total;
+                next.emplace_back(std::make_pair(db::coordinator, params));
+            }
+            break;
+
+        default:
+            WDEBUG << "bad triangle program phase " << params.phase << std::endl;
+    }
+
+    return std::make_pair(search_type::BREADTH_FIRST, next);
+}
@@ -90,6 +90,10 @@ main(int argc, const char *argv[])
             std::cout << p.second << " ";
         }
         std::cout << std::endl;
+    } else if (config == "storage_backend") {
+        std::cout << StorageBackend << std::endl;
+    } else if (config == "storage_dir") {
+        std::cout << StorageDir << std::endl;
     } else if (config == "aux_index") {
         std::cout << (AuxIndex? 1:0) << std::endl;
     } else if (config == "bulk_load_property_value_delimiter") {
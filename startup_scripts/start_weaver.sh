@@ -41,95 +41,100 @@ server_manager_port=($(weaver-parse-config -c server_manager_port $config_file_a
 kronos_ipaddr=($(weaver-parse-config -c kronos_ipaddr $config_file_args))
 kronos_port=($(weaver-parse-config -c kronos_port $config_file_args))
 aux_index=($(weaver-parse-config -c aux_index $config_file_args))
+storage_backend=$(weaver-parse-config -c storage_backend $config_file_args)
 
 rm_patterns="*.log *.sst *.old CURRENT  LOCK  LOG  MANIFEST*"
 
 shopt -s nullglob
 cd
 
-# hyperdex
-hyperdex_coord_dir=~/weaver_runtime/hyperdex/coord
-echo "Starting HyperDex coordinator at location $hyperdex_coord_ipaddr : $hyperdex_coord_port, data at $hyperdex_coord_dir"
-if [ $hyperdex_coord_ipaddr = "127.0.0.1" ]; then
-    mkdir -p $hyperdex_coord_dir
-    cd $hyperdex_coord_dir
-    rm -f $rm_patterns replicant-daemon-*
-    hyperdex coordinator -l $hyperdex_coord_ipaddr -p $hyperdex_coord_port > /dev/null 2>&1
-else
-ssh $hyperdex_coord_ipaddr 'bash -s' << EOF
-    shopt -s nullglob
-    mkdir -p $hyperdex_coord_dir
-    cd $hyperdex_coord_dir
-    rm -f $rm_patterns replicant-daemon-*
-    hyperdex coordinator -l $hyperdex_coord_ipaddr -p $hyperdex_coord_port > /dev/null 2>&1
-EOF
-fi
-sleep 3
-
-num_daemons=${#hyperdex_daemons_ipaddr[*]}
-for i in $(seq 1 $num_daemons);
-do
-    idx=$(($i-1))
-    ipaddr=${hyperdex_daemons_ipaddr[$idx]}
-    port=${hyperdex_daemons_port[$idx]}
-    directory=~/weaver_runtime/hyperdex/daemon$idx
-    echo "Starting HyperDex daemon $i at location $ipaddr : $port, data at $directory"
-    if [ $ipaddr = "127.0.0.1" ]; then
-        mkdir -p $directory
-        cd $directory
-        rm -f $rm_patterns hyperdex-daemon-*
-        hyperdex daemon --listen=$ipaddr --listen-port=$port \
-                        --coordinator=$hyperdex_coord_ipaddr --coordinator-port=$hyperdex_coord_port \
-                        > /dev/null 2>&1
+# hyperdex, not needed if shards and timestamper keep their data in local storage
+if [ "$storage_backend" = "hyperdex" ]; then
+    hyperdex_coord_dir=~/weaver_runtime/hyperdex/coord
+    echo "Starting HyperDex coordinator at location $hyperdex_coord_ipaddr : $hyperdex_coord_port, data at $hyperdex_coord_dir"
+    if [ $hyperdex_coord_ipaddr = "127.0.0.1" ]; then
+        mkdir -p $hyperdex_coord_dir
+        cd $hyperdex_coord_dir
+        rm -f $rm_patterns replicant-daemon-*
+        hyperdex coordinator -l $hyperdex_coord_ipaddr -p $hyperdex_coord_port > /dev/null 2>&1
     else
-    ssh $ipaddr 'bash -s' << EOF
+    ssh $hyperdex_coord_ipaddr 'bash -s' << EOF
         shopt -s nullglob
-        mkdir -p $directory
-        cd $directory
-        rm -f $rm_patterns hyperdex-daemon-*
-        hyperdex daemon --listen=$ipaddr --listen-port=$port \
-                        --coordinator=$hyperdex_coord_ipaddr --coordinator-port=$hyperdex_coord_port \
-                        > /dev/null 2>&1
+        mkdir -p $hyperdex_coord_dir
+        cd $hyperdex_coord_dir
+        rm -f $rm_patterns replicant-daemon-*
+        hyperdex coordinator -l $hyperdex_coord_ipaddr -p $hyperdex_coord_port > /dev/null 2>&1
 EOF
     fi
-done
+    sleep 3
+
+    num_daemons=${#hyperdex_daemons_ipaddr[*]}
+    for i in $(seq 1 $num_daemons);
+    do
+        idx=$(($i-1))
+        ipaddr=${hyperdex_daemons_ipaddr[$idx]}
+        port=${hyperdex_daemons_port[$idx]}
+        directory=~/weaver_runtime/hyperdex/daemon$idx
+        echo "Starting HyperDex daemon $i at location $ipaddr : $port, data at $directory"
+        if [ $ipaddr = "127.0.0.1" ]; then
+            mkdir -p $directory
+            cd $directory
+            rm -f $rm_patterns hyperdex-daemon-*
+            hyperdex daemon --listen=$ipaddr --listen-port=$port \
+                            --coordinator=$hyperdex_coord_ipaddr --coordinator-port=$hyperdex_coord_port \
+                            > /dev/null 2>&1
+        else
+        ssh $ipaddr 'bash -s' << EOF
+            shopt -s nullglob
+            mkdir -p $directory
+            cd $directory
+            rm -f $rm_patterns hyperdex-daemon-*
+            hyperdex daemon --listen=$ipaddr --listen-port=$port \
+                            --coordinator=$hyperdex_coord_ipaddr --coordinator-port=$hyperdex_coord_port \
+                            > /dev/null 2>&1
+EOF
+        fi
+    done
 
-sleep 3
+    sleep 3
 
-echo 'Adding HyperDex spaces'
+    echo 'Adding HyperDex spaces'
 
-hyperdex add-space -h $hyperdex_coord_ipaddr -p $hyperdex_coord_port << EOF
-space weaver_index_data
-key idx
-attributes
-    string node,
-    int shard
-tolerate 2 failures
+    hyperdex add-space -h $hyperdex_coord_ipaddr -p $hyperdex_coord_port << EOF
+    space weaver_index_data
+    key idx
+    attributes
+        string node,
+        int shard
+    tolerate 2 failures
 EOF
 
-hyperdex add-space -h $hyperdex_coord_ipaddr -p $hyperdex_coord_port << EOF
-space weaver_graph_data
-key node
-attributes
-    int shard,
-    string creat_time,
-    list(string) properties,
-    map(string, string) out_edges,
-    int migr_status,
-    string last_upd_clk,
-    string restore_clk,
-    set(string) aliases
-tolerate 2 failures
+    hyperdex add-space -h $hyperdex_coord_ipaddr -p $hyperdex_coord_port << EOF
+    space weaver_graph_data
+    key node
+    attributes
+        int shard,
+        string creat_time,
+        list(string) properties,
+        map(string, string) out_edges,
+        int migr_status,
+        string last_upd_clk,
+        string restore_clk,
+        set(string) aliases
+    tolerate 2 failures
 EOF
 
-hyperdex add-space -h $hyperdex_coord_ipaddr -p $hyperdex_coord_port << EOF
-space weaver_tx_data
-key tx_id
-attributes
-    int vt_id,
-    string tx_data
-tolerate 2 failures
+    hyperdex add-space -h $hyperdex_coord_ipaddr -p $hyperdex_coord_port << EOF
+    space weaver_tx_data
+    key tx_id
+    attributes
+        int vt_id,
+        string tx_data
+    tolerate 2 failures
 EOF
+else
+    echo "Storage backend is $storage_backend, not starting HyperDex"
+fi
 
 
 # server manager
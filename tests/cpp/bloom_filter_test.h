@@ -0,0 +1,75 @@
+/*
+ * ===============================================================
+ *    Description:  Unit test for the node filter: no false
+ *                  negatives, and false positive rate near the
+ *                  rate the filter was sized for.
+ *
+ *        Created:  2026-10-19 11:02:17
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <assert.h>
+#include <thread>
+#include <vector>
+
+#include "common/utils.h"
+#include "common/bloom_filter.h"
+
+inline uint64_t
+bloom_test_hash(uint64_t key)
+{
+    return weaver_util::murmur_hasher<std::string>()(std::to_string(key));
+}
+
+void
+bloom_filter_rate_test(uint64_t num_keys, double fp_rate)
+{
+    weaver_util::bloom_filter filter(weaver_util::bloom_filter::bits_for(num_keys, fp_rate));
+
+    // concurrent inserts of disjoint key ranges
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; t++) {
+        threads.emplace_back([&filter, t, num_keys]() {
+            for (uint64_t i = t; i < num_keys; i += 4) {
+                filter.insert(bloom_test_hash(i));
+            }
+        });
+    }
+    for (std::thread &t: threads) {
+        t.join();
+    }
+
+    for (uint64_t i = 0; i < num_keys; i++) {
+        assert(filter.may_contain(bloom_test_hash(i)));
+    }
+
+    uint64_t num_probes = 1000000;
+    uint64_t false_pos = 0;
+    for (uint64_t i = num_keys; i < num_keys + num_probes; i++) {
+        if (filter.may_contain(bloom_test_hash(i))) {
+            false_pos++;
+        }
+    }
+    double measured = (double)false_pos / num_probes;
+    WDEBUG << num_keys << " keys, " << (filter.num_bits() / num_keys) << " bits per key, false positive rate "
+           << measured << ", sized for " << fp_rate << std::endl;
+    assert(measured <= 1.5 * fp_rate);
+}
+
+void
+bloom_filter_test()
+{
+    bloom_filter_rate_test(1000, 0.01);
+    bloom_filter_rate_test(1000000, 0.01);
+    bloom_filter_rate_test(1000000, 0.001);
+
+    // resize drops all keys
+    weaver_util::bloom_filter filter(weaver_util::bloom_filter::bits_for(1000, 0.01));
+    filter.insert(bloom_test_hash(42));
+    assert(filter.may_contain(bloom_test_hash(42)));
+    filter.resize(weaver_util::bloom_filter::bits_for(100000, 0.01));
+    assert(filter.num_bits() >= weaver_util::bloom_filter::bits_for(100000, 0.01));
+    assert(!filter.may_contain(bloom_test_hash(42)));
+}
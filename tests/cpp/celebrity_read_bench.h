@@ -0,0 +1,95 @@
+/*
+ * ===============================================================
+ *    Description:  Read-only multi-client benchmark in which all
+ *                  clients read the same high-degree vertex.
+ *
+ *        Created:  2026-10-19 15:36:20
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <thread>
+#include <vector>
+#include <busybee_utils.h>
+
+#include "common/clock.h"
+#include "client/client.h"
+
+using cl::client;
+
+#define CELEB_TX_SIZE 1000
+
+// create celebrity node with num_edges out edges, each to a new node
+void
+create_celebrity(client &cl, const std::string &celeb, uint64_t num_edges)
+{
+    std::vector<std::string> no_aliases;
+    std::string handle = celeb;
+    cl.begin_tx();
+    cl.create_node(handle, no_aliases);
+    cl.end_tx();
+
+    for (uint64_t i = 0; i < num_edges; i++) {
+        if (i % CELEB_TX_SIZE == 0) {
+            cl.begin_tx();
+        }
+        std::string fan = celeb + "_fan" + std::to_string(i);
+        std::string edge = "";
+        cl.create_node(fan, no_aliases);
+        cl.create_edge(edge, celeb, "", fan, "");
+        if (i % CELEB_TX_SIZE == (CELEB_TX_SIZE-1) || i == (num_edges-1)) {
+            cl.end_tx();
+        }
+    }
+}
+
+void
+exec_celebrity_reads(const std::string &celeb, uint64_t num_requests, uint64_t *num_success)
+{
+    client cl("127.0.0.1", 2002, "/usr/local/etc/weaver.yaml");
+    node_prog::edge_count_params ecp, return_params;
+
+    for (uint64_t i = 0; i < num_requests; i++) {
+        std::vector<std::pair<std::string, node_prog::edge_count_params>> args(1, std::make_pair(celeb, ecp));
+        if (cl.edge_count_program(args, return_params) == cl::WEAVER_CLIENT_SUCCESS) {
+            (*num_success)++;
+        }
+    }
+}
+
+// num_clients concurrent clients, each issues num_requests edge count programs at the same node
+// all node programs read the node concurrently at the shard, so throughput should scale with clients
+void
+run_celebrity_read_bench(uint64_t num_edges, uint64_t num_clients, uint64_t num_requests)
+{
+    std::string celeb = "celebrity";
+    {
+        client cl("127.0.0.1", 2002, "/usr/local/etc/weaver.yaml");
+        create_celebrity(cl, celeb, num_edges);
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> num_success(num_clients, 0);
+    wclock::weaver_timer timer;
+
+    uint64_t start = timer.get_time_elapsed();
+    for (uint64_t i = 0; i < num_clients; i++) {
+        threads.emplace_back(std::thread(exec_celebrity_reads, celeb, num_requests, &num_success[i]));
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    uint64_t end = timer.get_time_elapsed();
+
+    uint64_t total = 0;
+    for (uint64_t s: num_success) {
+        total += s;
+    }
+    double secs = (double)(end - start) / NANO;
+    WDEBUG << "celebrity degree " << num_edges << ", " << num_clients << " clients, "
+           << total << " successful reads in " << secs << " s, "
+           << (total / secs) << " reads/s" << std::endl;
+}
+
+#undef CELEB_TX_SIZE
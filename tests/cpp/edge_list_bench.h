@@ -0,0 +1,169 @@
+/*
+ * ===============================================================
+ *    Description:  Latency of edge count, read n edges, edge get
+ *                  and traverse with props programs at nodes of
+ *                  growing out degree.
+ *
+ *        Created:  2026-10-19 17:02:56
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <vector>
+
+#include "common/clock.h"
+#include "client/client.h"
+
+using cl::client;
+
+#define EDGE_BENCH_TX_SIZE 1000
+#define EDGE_BENCH_TAG_PERIOD 100 // one in this many edges has property tag=1
+
+// hub with num_edges out edges, returns the handle of an edge in the middle
+std::string
+create_edge_bench_hub(client &cl, const std::string &hub, uint64_t num_edges)
+{
+    std::vector<std::string> no_aliases;
+    std::string handle = hub;
+    std::string middle;
+    cl.begin_tx();
+    cl.create_node(handle, no_aliases);
+    cl.end_tx();
+
+    for (uint64_t i = 0; i < num_edges; i++) {
+        if (i % EDGE_BENCH_TX_SIZE == 0) {
+            cl.begin_tx();
+        }
+        std::string nbr = hub + "_nbr" + std::to_string(i);
+        std::string edge = "";
+        cl.create_node(nbr, no_aliases);
+        cl.create_edge(edge, hub, "", nbr, "");
+        if (i % EDGE_BENCH_TAG_PERIOD == 0) {
+            cl.set_edge_property(hub, "", edge, "tag", "1");
+        }
+        if (i == num_edges/2) {
+            middle = edge;
+        }
+        if (i % EDGE_BENCH_TX_SIZE == (EDGE_BENCH_TX_SIZE-1) || i == (num_edges-1)) {
+            cl.end_tx();
+        }
+    }
+
+    return middle;
+}
+
+// mean latency in us of num_requests runs of one node program at the hub
+template <typename ParamsType>
+double
+time_edge_bench_prog(client &cl,
+    cl::weaver_client_returncode (client::*prog)(std::vector<std::pair<std::string, ParamsType>>&, ParamsType&),
+    const std::string &hub, const ParamsType &params, uint64_t num_requests)
+{
+    wclock::weaver_timer timer;
+    ParamsType return_params;
+    uint64_t start = timer.get_time_elapsed();
+    for (uint64_t i = 0; i < num_requests; i++) {
+        std::vector<std::pair<std::string, ParamsType>> args(1, std::make_pair(hub, params));
+        if ((cl.*prog)(args, return_params) != cl::WEAVER_CLIENT_SUCCESS) {
+            WDEBUG << "node program failed" << std::endl;
+        }
+    }
+    return (double)(timer.get_time_elapsed() - start) / (num_requests * 1000);
+}
+
+// for each degree from min_edges to max_edges, 10x apart: edge count of all and of tagged edges,
+// first 10 edges, and get of one edge by handle
+void
+run_edge_list_bench(uint64_t min_edges, uint64_t max_edges, uint64_t num_requests)
+{
+    client cl("127.0.0.1", 2002, "/usr/local/etc/weaver.yaml");
+    std::vector<std::pair<std::string, std::string>> tag(1, std::make_pair("tag", "1"));
+
+    for (uint64_t num_edges = min_edges; num_edges <= max_edges; num_edges *= 10) {
+        std::string hub = "edge_bench_hub" + std::to_string(num_edges);
+        std::string middle = create_edge_bench_hub(cl, hub, num_edges);
+
+        node_prog::edge_count_params count_all, count_tagged;
+        count_tagged.edges_props = tag;
+        node_prog::read_n_edges_params first_ten;
+        first_ten.num_edges = 10;
+        node_prog::edge_get_params get_one;
+        get_one.request_edges.emplace_back(middle);
+
+        double count_us = time_edge_bench_prog(cl, &client::edge_count_program, hub, count_all, num_requests);
+        double tagged_us = time_edge_bench_prog(cl, &client::edge_count_program, hub, count_tagged, num_requests);
+        double read_us = time_edge_bench_prog(cl, &client::read_n_edges_program, hub, first_ten, num_requests);
+        double get_us = time_edge_bench_prog(cl, &client::edge_get_program, hub, get_one, num_requests);
+
+        WDEBUG << "degree " << num_edges << ": edge count " << count_us << " us, "
+               << "tagged edge count " << tagged_us << " us, "
+               << "read 10 edges " << read_us << " us, "
+               << "edge get " << get_us << " us" << std::endl;
+    }
+}
+
+// address node of a Bitcoin style graph, as read by get_btc_block, with one out edge per tx that
+// has tx_id as an edge property, returns the tx ids
+std::vector<std::string>
+create_edge_bench_address(client &cl, const std::string &addr, uint64_t num_edges)
+{
+    std::vector<std::string> no_aliases;
+    std::vector<std::string> tx_ids;
+    std::string handle = addr;
+    cl.begin_tx();
+    cl.create_node(handle, no_aliases);
+    cl.end_tx();
+
+    for (uint64_t i = 0; i < num_edges; i++) {
+        if (i % EDGE_BENCH_TX_SIZE == 0) {
+            cl.begin_tx();
+        }
+        std::string tx = addr + "_tx" + std::to_string(i);
+        std::string edge = "";
+        cl.create_node(tx, no_aliases);
+        cl.create_edge(edge, addr, "", tx, "");
+        cl.set_edge_property(addr, "", edge, "tx_id", tx);
+        tx_ids.emplace_back(tx);
+        if (i % EDGE_BENCH_TX_SIZE == (EDGE_BENCH_TX_SIZE-1) || i == (num_edges-1)) {
+            cl.end_tx();
+        }
+    }
+
+    return tx_ids;
+}
+
+// edge of an address by tx_id and by nbr with edge get, and one hop traverse with props by tx_id
+// run once with edge_index_min_degree 0 and once with edge_index_keys "tx_id" and a min degree below num_edges
+void
+run_edge_index_bench(uint64_t min_edges, uint64_t max_edges, uint64_t num_requests)
+{
+    client cl("127.0.0.1", 2002, "/usr/local/etc/weaver.yaml");
+
+    for (uint64_t num_edges = min_edges; num_edges <= max_edges; num_edges *= 10) {
+        std::string addr = "edge_bench_addr" + std::to_string(num_edges);
+        std::vector<std::string> tx_ids = create_edge_bench_address(cl, addr, num_edges);
+        const std::string &tx = tx_ids[num_edges/2];
+
+        node_prog::edge_get_params by_tx_id, by_nbr;
+        by_tx_id.properties.emplace_back("tx_id", tx);
+        by_nbr.nbrs.emplace_back(tx);
+
+        node_prog::traverse_props_params traverse;
+        traverse.node_aliases.emplace_back(std::vector<std::string>());
+        traverse.node_props.emplace_back(std::vector<std::pair<std::string, std::string>>());
+        traverse.edge_props.emplace_back(std::vector<std::pair<std::string, std::string>>(1, std::make_pair("tx_id", tx)));
+        traverse.collect_edges = true;
+
+        double tx_id_us = time_edge_bench_prog(cl, &client::edge_get_program, addr, by_tx_id, num_requests);
+        double nbr_us = time_edge_bench_prog(cl, &client::edge_get_program, addr, by_nbr, num_requests);
+        double traverse_us = time_edge_bench_prog(cl, &client::traverse_props_program, addr, traverse, num_requests);
+
+        WDEBUG << "address degree " << num_edges << ": edge get by tx_id " << tx_id_us << " us, "
+               << "by nbr " << nbr_us << " us, "
+               << "traverse by tx_id " << traverse_us << " us" << std::endl;
+    }
+}
+
+#undef EDGE_BENCH_TX_SIZE
+#undef EDGE_BENCH_TAG_PERIOD
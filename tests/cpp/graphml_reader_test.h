@@ -0,0 +1,136 @@
+/*
+ * ===============================================================
+ *    Description:  Unit test for the GraphML bulk load reader:
+ *                  element and data parsing, and byte ranges of
+ *                  parallel readers.
+ *
+ *        Created:  2026-10-19 12:10:52
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "db/graphml_reader.h"
+
+static const char *graphml_test_doc =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\">\n"
+    "  <key id=\"name\" for=\"node\" attr.name=\"name\" attr.type=\"string\"/>\n"
+    "  <!-- weights are strings -->\n"
+    "  <graph id=\"G\" edgedefault=\"directed\">\n"
+    "    <node id=\"n0\">\n"
+    "      <desc>first <b>node</b></desc>\n"
+    "      <data key=\"name\">a &amp; b &lt;&#x41;&#66;&gt;</data>\n"
+    "      <data key=\"note\"><![CDATA[raw <b>text</b> & more]]></data>\n"
+    "      <data key=\"split\">be<!-- comment -->fore</data>\n"
+    "    </node>\n"
+    "    <node id=\"n1\"/>\n"
+    "    <node id='n2' label=\"a > b\"><data key=\"empty\"/></node>\n"
+    "    <edge id=\"e0\" source=\"n0\" target=\"n1\">\n"
+    "      <data key=\"weight\">2.5</data>\n"
+    "    </edge>\n"
+    "    <edge source = 'n1'\n"
+    "          target = 'n2'/>\n"
+    "  </graph>\n"
+    "</graphml>\n";
+
+// path of a temporary file with contents 'doc'
+inline std::string
+graphml_test_file(const std::string &doc)
+{
+    char path[] = "/tmp/weaver-graphml-test-XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    assert(write(fd, doc.data(), doc.size()) == (ssize_t)doc.size());
+    close(fd);
+    return path;
+}
+
+// elements read in [begin, end), keyed by file offset
+inline void
+graphml_test_read(const std::string &path, uint64_t begin, uint64_t end, std::map<uint64_t, db::graphml_element> &elems)
+{
+    db::graphml_reader reader(path.c_str(), begin, end);
+    assert(reader.good());
+    db::graphml_element elem;
+    while (reader.next(elem)) {
+        assert(elem.offset >= begin && elem.offset < end);
+        assert(elems.find(elem.offset) == elems.end());
+        elems.emplace(elem.offset, elem);
+    }
+}
+
+void
+graphml_reader_test()
+{
+    std::string doc = graphml_test_doc;
+    std::string path = graphml_test_file(doc);
+    uint64_t size = db::graphml_reader::file_size(path.c_str());
+    assert(size == doc.size());
+
+    std::map<uint64_t, db::graphml_element> all;
+    graphml_test_read(path, 0, size, all);
+    assert(all.size() == 5);
+    std::vector<db::graphml_element> elems;
+    for (const auto &p: all) {
+        assert(doc[p.first] == '<');
+        elems.emplace_back(p.second);
+    }
+
+    // entities, CDATA, and comments inside data text, children other than data skipped
+    assert(elems[0].is_node && elems[0].id == "n0");
+    assert(elems[0].data.size() == 3);
+    assert(elems[0].data[0].first == "name" && elems[0].data[0].second == "a & b <AB>");
+    assert(elems[0].data[1].first == "note" && elems[0].data[1].second == "raw <b>text</b> & more");
+    assert(elems[0].data[2].first == "split" && elems[0].data[2].second == "before");
+
+    // empty element, single quotes, '>' in an attribute value, empty data
+    assert(elems[1].is_node && elems[1].id == "n1" && elems[1].data.empty());
+    assert(elems[2].is_node && elems[2].id == "n2");
+    assert(elems[2].data.size() == 1 && elems[2].data[0].first == "empty" && elems[2].data[0].second.empty());
+
+    // edges, whitespace around '=' and across lines
+    assert(!elems[3].is_node && elems[3].id == "e0");
+    assert(elems[3].source == "n0" && elems[3].target == "n1");
+    assert(elems[3].data.size() == 1 && elems[3].data[0].second == "2.5");
+    assert(!elems[4].is_node && elems[4].id.empty());
+    assert(elems[4].source == "n1" && elems[4].target == "n2");
+
+    // two readers split at any byte read every element exactly once, as long as
+    // comments and CDATA sections hold no node or edge markup
+    for (uint64_t split = 0; split <= size; split++) {
+        std::map<uint64_t, db::graphml_element> parts;
+        graphml_test_read(path, 0, split, parts);
+        graphml_test_read(path, split, size, parts);
+        assert(parts.size() == all.size());
+        for (const auto &p: all) {
+            auto iter = parts.find(p.first);
+            assert(iter != parts.end());
+            assert(iter->second.id == p.second.id);
+            assert(iter->second.data == p.second.data);
+        }
+    }
+    unlink(path.c_str());
+
+    // node markup inside a top level comment is not an element
+    path = graphml_test_file("<graph><!-- <node id=\"c\"/> --><node id=\"a\"/></graph>");
+    all.clear();
+    graphml_test_read(path, 0, db::graphml_reader::file_size(path.c_str()), all);
+    assert(all.size() == 1 && all.begin()->second.id == "a");
+    unlink(path.c_str());
+
+    // element cut off by the end of the file is not returned
+    path = graphml_test_file("<graph><node id=\"a\"/><node id=\"b\"><data key=\"k\">v");
+    all.clear();
+    graphml_test_read(path, 0, db::graphml_reader::file_size(path.c_str()), all);
+    assert(all.size() == 1 && all.begin()->second.id == "a");
+    unlink(path.c_str());
+}
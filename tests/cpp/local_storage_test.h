@@ -0,0 +1,144 @@
+/*
+ * ===============================================================
+ *    Description:  Unit test for local storage recovery: replay of
+ *                  a log cut at any byte, of a corrupted record,
+ *                  and of a snapshot cut short.
+ *
+ *        Created:  2026-10-19 12:52:36
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#include "common/local_storage.h"
+
+inline std::string
+ls_test_key(uint64_t i)
+{
+    return "key" + std::to_string(i);
+}
+
+inline void
+ls_test_put(local_store &store, uint64_t i)
+{
+    std::vector<local_store::op> ops(1);
+    ops[0].type = local_store::LOCAL_PUT;
+    ops[0].table = LOCAL_TX;
+    ops[0].key = ls_test_key(i);
+    ops[0].num = i;
+    ops[0].data = std::string(i % 50, 'x');
+    std::vector<local_store::read_version> no_reads;
+    assert(store.commit(no_reads, ops) == STORAGE_COMMITTED);
+}
+
+// number of keys in the store, which must be keys 0 to n-1 with the values they were put with
+inline uint64_t
+ls_test_check_prefix(local_store &store)
+{
+    uint64_t n = 0;
+    store.for_each(LOCAL_TX, [&n](const std::string&, const local_store::record&) { n++; });
+    for (uint64_t i = 0; i < n; i++) {
+        local_store::record rec;
+        assert(store.get(LOCAL_TX, ls_test_key(i), rec));
+        assert(rec.num == i && rec.data == std::string(i % 50, 'x'));
+    }
+    return n;
+}
+
+inline uint64_t
+ls_test_file_size(const std::string &path)
+{
+    struct stat st;
+    assert(stat(path.c_str(), &st) == 0);
+    return st.st_size;
+}
+
+void
+local_storage_test()
+{
+    char dir_template[] = "/tmp/weaver-local-storage-test-XXXXXX";
+    assert(mkdtemp(dir_template) != nullptr);
+    std::string dir = dir_template;
+    std::string log = dir + "/log";
+    uint64_t num_keys = 40;
+
+    {
+        local_store store(dir);
+        assert(store.open());
+        for (uint64_t i = 0; i < num_keys; i++) {
+            ls_test_put(store, i);
+        }
+    }
+
+    // a log cut at any byte replays to a prefix of the commits, and the torn
+    // record is dropped from the log so that later commits follow the prefix
+    uint64_t full_size = ls_test_file_size(log);
+    uint64_t prev = num_keys;
+    for (uint64_t sz = full_size; sz > 0; sz--) {
+        assert(truncate(log.c_str(), sz) == 0);
+        local_store store(dir);
+        assert(store.open());
+        uint64_t n = ls_test_check_prefix(store);
+        assert(n <= prev);
+        prev = n;
+        assert(ls_test_file_size(log) <= sz);
+    }
+    assert(prev == 0);
+
+    {
+        local_store store(dir);
+        assert(store.open());
+        for (uint64_t i = 0; i < num_keys; i++) {
+            ls_test_put(store, i);
+        }
+    }
+    {
+        local_store store(dir);
+        assert(store.open());
+        assert(ls_test_check_prefix(store) == num_keys);
+    }
+
+    // a corrupted byte fails the checksum of the last record, which is dropped
+    uint64_t size = ls_test_file_size(log);
+    int fd = open(log.c_str(), O_RDWR);
+    assert(fd >= 0);
+    char c;
+    assert(pread(fd, &c, 1, size - 1) == 1);
+    c ^= 1;
+    assert(pwrite(fd, &c, 1, size - 1) == 1);
+    close(fd);
+    {
+        local_store store(dir);
+        assert(store.open());
+        assert(ls_test_check_prefix(store) == num_keys - 1);
+        ls_test_put(store, num_keys - 1);
+    }
+
+    // crash after a new log was started and before the snapshot was written:
+    // the previous log is replayed and the snapshot is finished on open
+    assert(rename(log.c_str(), (dir + "/log.old").c_str()) == 0);
+    {
+        local_store store(dir);
+        assert(store.open());
+        assert(ls_test_check_prefix(store) == num_keys);
+        assert(access((dir + "/log.old").c_str(), F_OK) != 0);
+        assert(access((dir + "/snapshot").c_str(), F_OK) == 0);
+        ls_test_put(store, num_keys);
+    }
+    {
+        local_store store(dir);
+        assert(store.open());
+        assert(ls_test_check_prefix(store) == num_keys + 1);
+    }
+
+    assert(system(("rm -rf " + dir).c_str()) == 0);
+}
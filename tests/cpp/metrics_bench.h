@@ -0,0 +1,119 @@
+/*
+ * ===============================================================
+ *    Description:  Microbenchmark for the cost of server metrics
+ *                  updates on the shard hot paths.
+ *
+ *        Created:  2026-10-19 16:54:33
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <thread>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "common/clock.h"
+#include "common/metrics.h"
+
+enum metrics_bench_op
+{
+    MB_NONE, // loop overhead only
+    MB_COUNTER, // prog_visits.inc()
+    MB_HISTOGRAM, // record of a precomputed value
+    MB_TIMED // clock_ns() and record_since(), as around a queue wait
+};
+
+void
+metrics_bench_worker(metrics_bench_op op, uint64_t num_ops, uint64_t *sink)
+{
+    metrics::server_metrics &m = metrics::get();
+    uint64_t x = 0;
+    for (uint64_t i = 0; i < num_ops; i++) {
+        x = x * 6364136223846793005ULL + 1442695040888963407ULL; // stands in for the work being measured
+        switch (op) {
+            case MB_NONE:
+                break;
+            case MB_COUNTER:
+                m.prog_visits.inc();
+                break;
+            case MB_HISTOGRAM:
+                m.rd_queue_wait_ns.record(x >> 44);
+                break;
+            case MB_TIMED: {
+                uint64_t start = metrics::clock_ns();
+                m.node_lock_wait_ns.record_since(start);
+                break;
+            }
+        }
+    }
+    *sink = x;
+}
+
+// returns ns per op
+double
+metrics_bench_phase(metrics_bench_op op, uint64_t num_ops, uint64_t num_threads)
+{
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> sink(num_threads, 0);
+    wclock::weaver_timer timer;
+
+    uint64_t start = timer.get_time_elapsed();
+    for (uint64_t t = 0; t < num_threads; t++) {
+        threads.emplace_back(std::thread(metrics_bench_worker, op, num_ops, &sink[t]));
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    uint64_t end = timer.get_time_elapsed();
+
+    return (double)(end - start) / (num_ops * num_threads);
+}
+
+// percentiles from the histogram against exact ones of the same values
+void
+metrics_bench_accuracy(uint64_t num_values)
+{
+    metrics::histogram h;
+    std::vector<uint64_t> vals;
+    vals.reserve(num_values);
+    std::mt19937_64 gen(42);
+    std::lognormal_distribution<double> latency(10.0, 2.0); // ns, median around 20us
+    for (uint64_t i = 0; i < num_values; i++) {
+        uint64_t v = (uint64_t)latency(gen);
+        vals.emplace_back(v);
+        h.record(v);
+    }
+    std::sort(vals.begin(), vals.end());
+
+    metrics::histogram::snapshot snap;
+    h.get_snapshot(snap);
+    assert(snap.count == num_values);
+    for (double p: {0.5, 0.9, 0.99, 0.999}) {
+        uint64_t exact = vals[(uint64_t)(p * num_values)];
+        uint64_t approx = snap.percentile(p);
+        assert(approx >= exact);
+        WDEBUG << "p" << p*100 << " exact " << exact << " ns, histogram " << approx
+               << " ns, error " << (100.0 * (approx - exact) / (exact + 1)) << "%" << std::endl;
+    }
+}
+
+// ns per metrics update with 1, 2, 4, .. max_threads threads, compared with an empty loop
+void
+run_metrics_bench(uint64_t num_ops, uint64_t max_threads)
+{
+    for (uint64_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        double base = metrics_bench_phase(MB_NONE, num_ops, num_threads);
+        double counter = metrics_bench_phase(MB_COUNTER, num_ops, num_threads);
+        double hist = metrics_bench_phase(MB_HISTOGRAM, num_ops, num_threads);
+        double timed = metrics_bench_phase(MB_TIMED, num_ops, num_threads);
+
+        WDEBUG << num_threads << " threads: loop " << base << " ns/op, "
+               << "counter +" << (counter - base) << " ns, "
+               << "histogram +" << (hist - base) << " ns, "
+               << "timed histogram +" << (timed - base) << " ns" << std::endl;
+    }
+
+    metrics_bench_accuracy(num_ops);
+}
@@ -0,0 +1,203 @@
+/*
+ * ===============================================================
+ *    Description:  Microbenchmark for shard node directory vs the
+ *                  old array of sparse_hash_maps behind mutexes.
+ *
+ *        Created:  2026-10-19 15:43:35
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+#include <po6/threads/mutex.h>
+
+#include "common/clock.h"
+#include "db/types.h"
+#include "db/node_directory.h"
+
+// resident set size of this process in bytes
+uint64_t
+nd_bench_rss()
+{
+    uint64_t size = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f != nullptr) {
+        if (fscanf(f, "%lu %lu", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(f);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// fake node pointers, never dereferenced
+#define ND_BENCH_NODE(i) ((db::node*)((i)+1))
+
+// node handle -> versions, as shards stored them before node_directory
+struct old_node_maps
+{
+    po6::threads::mutex mutexes[NUM_NODE_MAPS];
+    db::data_map<std::vector<db::node*>> maps[NUM_NODE_MAPS];
+
+    old_node_maps()
+    {
+        for (uint64_t i = 0; i < NUM_NODE_MAPS; i++) {
+            maps[i].set_deleted_key("");
+        }
+    }
+
+    void insert(const node_handle_t &handle, db::node *n)
+    {
+        uint64_t map_idx = hash_node_handle(handle) % NUM_NODE_MAPS;
+        mutexes[map_idx].lock();
+        maps[map_idx][handle] = std::vector<db::node*>(1, n);
+        mutexes[map_idx].unlock();
+    }
+
+    bool lookup(const node_handle_t &handle)
+    {
+        uint64_t map_idx = hash_node_handle(handle) % NUM_NODE_MAPS;
+        mutexes[map_idx].lock();
+        bool found = (maps[map_idx].find(handle) != maps[map_idx].end());
+        mutexes[map_idx].unlock();
+        return found;
+    }
+
+    void remove(const node_handle_t &handle)
+    {
+        uint64_t map_idx = hash_node_handle(handle) % NUM_NODE_MAPS;
+        mutexes[map_idx].lock();
+        maps[map_idx].erase(handle);
+        mutexes[map_idx].unlock();
+    }
+};
+
+struct new_node_maps
+{
+    db::node_directory dir;
+
+    void insert(const node_handle_t &handle, db::node *n)
+    {
+        uint64_t hash = hash_node_handle(handle);
+        uint64_t map_idx = db::node_directory::stripe_of(hash);
+        dir.mutex(map_idx).lock();
+        dir.add_version(handle, hash, n);
+        dir.mutex(map_idx).unlock();
+    }
+
+    bool lookup(const node_handle_t &handle)
+    {
+        db::node_directory::versions vers;
+        dir.read_begin();
+        bool found = dir.find(handle, hash_node_handle(handle), vers);
+        dir.read_end();
+        return found;
+    }
+
+    void remove(const node_handle_t &handle)
+    {
+        uint64_t hash = hash_node_handle(handle);
+        uint64_t map_idx = db::node_directory::stripe_of(hash);
+        db::node_directory::versions vers;
+        dir.mutex(map_idx).lock();
+        if (dir.find(handle, hash, vers)) {
+            dir.remove_version(handle, hash, vers.first);
+        }
+        dir.mutex(map_idx).unlock();
+    }
+};
+
+enum nd_bench_op
+{
+    ND_INSERT,
+    ND_LOOKUP,
+    ND_REMOVE
+};
+
+template <typename Maps>
+void
+nd_bench_worker(Maps *maps, nd_bench_op op, uint64_t num_nodes, uint64_t tid, uint64_t num_threads, uint64_t *num_found)
+{
+    uint64_t found = 0;
+    for (uint64_t i = tid; i < num_nodes; i += num_threads) {
+        // lookups hit random nodes, inserts and removes cover each node once
+        uint64_t id = (op == ND_LOOKUP)? (i * 2654435761ULL) % num_nodes : i;
+        node_handle_t handle = std::to_string(id);
+        switch (op) {
+            case ND_INSERT:
+                maps->insert(handle, ND_BENCH_NODE(id));
+                break;
+            case ND_LOOKUP:
+                if (maps->lookup(handle)) {
+                    found++;
+                }
+                break;
+            case ND_REMOVE:
+                maps->remove(handle);
+                break;
+        }
+    }
+    *num_found = found;
+}
+
+// returns ops/s
+template <typename Maps>
+double
+nd_bench_phase(Maps *maps, nd_bench_op op, uint64_t num_nodes, uint64_t num_threads)
+{
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> found(num_threads, 0);
+    wclock::weaver_timer timer;
+
+    uint64_t start = timer.get_time_elapsed();
+    for (uint64_t t = 0; t < num_threads; t++) {
+        threads.emplace_back(std::thread(nd_bench_worker<Maps>, maps, op, num_nodes, t, num_threads, &found[t]));
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    uint64_t end = timer.get_time_elapsed();
+
+    if (op == ND_LOOKUP) {
+        uint64_t total = 0;
+        for (uint64_t f: found) {
+            total += f;
+        }
+        assert(total == num_nodes);
+    }
+    return num_nodes / ((double)(end - start) / NANO);
+}
+
+// insert, lookup, and delete num_nodes handles with 1, 2, 4, .. max_threads threads
+// run once per layout in separate processes, so that the RSS numbers are comparable
+template <typename Maps>
+void
+run_node_directory_bench(const char *name, uint64_t num_nodes, uint64_t max_threads)
+{
+    for (uint64_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        uint64_t rss_start = nd_bench_rss();
+        Maps *maps = new Maps();
+
+        double insert_tput = nd_bench_phase(maps, ND_INSERT, num_nodes, num_threads);
+        uint64_t rss_full = nd_bench_rss();
+        double lookup_tput = nd_bench_phase(maps, ND_LOOKUP, num_nodes, num_threads);
+        double remove_tput = nd_bench_phase(maps, ND_REMOVE, num_nodes, num_threads);
+
+        WDEBUG << name << ": " << num_nodes << " nodes, " << num_threads << " threads, "
+               << "insert " << insert_tput << " ops/s, "
+               << "lookup " << lookup_tput << " ops/s, "
+               << "delete " << remove_tput << " ops/s" << std::endl;
+        // later rounds reuse memory freed by the first one
+        if (num_threads == 1) {
+            WDEBUG << name << ": memory " << ((double)(rss_full - rss_start) / num_nodes) << " B/node" << std::endl;
+        }
+
+        delete maps;
+    }
+}
+
+#undef ND_BENCH_NODE
@@ -0,0 +1,204 @@
+/*
+ * ===============================================================
+ *    Description:  Unit test for the shard node directory under
+ *                  concurrent lookups, inserts and removes with
+ *                  node retirement, and for thread_index reuse.
+ *
+ *        Created:  2026-10-19 11:41:05
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <assert.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <po6/threads/mutex.h>
+
+#include "common/thread_index.h"
+#include "db/node_directory.h"
+
+#define ND_TEST_LIVE 0x6c697665ULL
+#define ND_TEST_DEAD 0x64656164ULL
+
+// stands in for db::node, the directory never dereferences nodes
+struct nd_test_node
+{
+    std::atomic<uint64_t> magic;
+    uint64_t id;
+};
+
+// retired nodes are poisoned instead of freed, so that a reader that gets a
+// node after it was reclaimed sees the poison, and freed at the end of the test
+static po6::threads::mutex nd_test_dead_mtx;
+static std::vector<nd_test_node*> nd_test_dead;
+
+void
+nd_test_free(void *obj)
+{
+    nd_test_node *n = (nd_test_node*)obj;
+    n->magic.store(ND_TEST_DEAD);
+    nd_test_dead_mtx.lock();
+    nd_test_dead.emplace_back(n);
+    nd_test_dead_mtx.unlock();
+}
+
+// half the handles are too long to be stored inline in a slot
+inline node_handle_t
+nd_test_handle(uint64_t id)
+{
+    return (id % 2 == 0)? std::to_string(id) : "long-node-handle-" + std::to_string(id);
+}
+
+// writer owns ids == tid mod num_writers, and inserts and removes each of them repeatedly
+void
+nd_test_writer(db::node_directory *dir, uint64_t tid, uint64_t num_writers, uint64_t num_ids, uint64_t rounds)
+{
+    for (uint64_t r = 0; r < rounds; r++) {
+        for (uint64_t id = tid; id < num_ids; id += num_writers) {
+            node_handle_t handle = nd_test_handle(id);
+            uint64_t hash = hash_node_handle(handle);
+            uint64_t stripe = db::node_directory::stripe_of(hash);
+            db::node_directory::versions vers;
+
+            dir->mutex(stripe).lock();
+            if (dir->find(handle, hash, vers)) {
+                assert(vers.size() == 1);
+                db::node *n = vers.first;
+                assert(dir->remove_version(handle, hash, n));
+                assert(!dir->find(handle, hash, vers));
+                dir->retire_node(n, nd_test_free);
+            } else {
+                nd_test_node *n = new nd_test_node();
+                n->magic.store(ND_TEST_LIVE);
+                n->id = id;
+                dir->add_version(handle, hash, (db::node*)n);
+                assert(dir->find(handle, hash, vers) && vers.first == (db::node*)n);
+            }
+            dir->mutex(stripe).unlock();
+        }
+    }
+}
+
+void
+nd_test_reader(db::node_directory *dir, uint64_t num_ids, std::atomic<bool> *done, uint64_t *found)
+{
+    uint64_t id = 0;
+    while (!done->load()) {
+        id = (id + 2654435761ULL) % num_ids;
+        node_handle_t handle = nd_test_handle(id);
+        db::node_directory::versions vers;
+
+        dir->read_begin();
+        if (dir->find(handle, hash_node_handle(handle), vers)) {
+            nd_test_node *n = (nd_test_node*)vers.first;
+            assert(n->magic.load() == ND_TEST_LIVE);
+            assert(n->id == id);
+            (*found)++;
+        }
+        dir->read_end();
+    }
+}
+
+void
+node_directory_test()
+{
+    uint64_t num_ids = 100000;
+    uint64_t num_writers = 4;
+    uint64_t num_readers = 4;
+    uint64_t rounds = 5; // odd, so each id ends up present
+    db::node_directory *dir = new db::node_directory();
+
+    std::atomic<bool> done(false);
+    std::vector<uint64_t> found(num_readers, 0);
+    std::vector<std::thread> readers, writers;
+    for (uint64_t i = 0; i < num_readers; i++) {
+        readers.emplace_back(nd_test_reader, dir, num_ids, &done, &found[i]);
+    }
+    for (uint64_t i = 0; i < num_writers; i++) {
+        writers.emplace_back(nd_test_writer, dir, i, num_writers, num_ids, rounds);
+    }
+    for (std::thread &t: writers) {
+        t.join();
+    }
+    done.store(true);
+    for (std::thread &t: readers) {
+        t.join();
+    }
+
+    uint64_t total_found = 0;
+    for (uint64_t f: found) {
+        total_found += f;
+    }
+    WDEBUG << "node directory readers found " << total_found << " nodes during writes" << std::endl;
+
+    // all ids present after an odd number of rounds, with the node last inserted
+    uint64_t present = 0;
+    for (uint64_t stripe = 0; stripe < NUM_NODE_MAPS; stripe++) {
+        present += dir->stripe_size(stripe);
+    }
+    assert(present == num_ids);
+    for (uint64_t id = 0; id < num_ids; id++) {
+        node_handle_t handle = nd_test_handle(id);
+        db::node_directory::versions vers;
+        dir->read_begin();
+        assert(dir->find(handle, hash_node_handle(handle), vers));
+        assert(((nd_test_node*)vers.first)->magic.load() == ND_TEST_LIVE);
+        assert(((nd_test_node*)vers.first)->id == id);
+        dir->read_end();
+    }
+
+    // once no reader is in, every retired node is reclaimed
+    dir->reclaim();
+    nd_test_dead_mtx.lock();
+    assert(nd_test_dead.size() == num_ids * (rounds / 2));
+    for (nd_test_node *n: nd_test_dead) {
+        delete n;
+    }
+    nd_test_dead.clear();
+    nd_test_dead_mtx.unlock();
+
+    for (uint64_t stripe = 0; stripe < NUM_NODE_MAPS; stripe++) {
+        dir->for_each(stripe, [](const db::node_directory::versions &vers) {
+            delete (nd_test_node*)vers.first;
+        });
+    }
+    delete dir;
+}
+
+// indices of exited threads are reused, lowest first, so with no other threads alive
+// the main thread and a batch of threads use indices 0 to batch
+void
+thread_index_test()
+{
+    uint64_t batch = 8;
+    uint64_t base = thread_index::get();
+    for (uint64_t r = 0; r < 100; r++) {
+        std::vector<uint64_t> idx(batch);
+        std::vector<std::thread> threads;
+        std::atomic<uint64_t> started(0);
+        for (uint64_t i = 0; i < batch; i++) {
+            // threads of a batch are all alive while they take their index
+            threads.emplace_back([&idx, &started, batch, i]() {
+                idx[i] = thread_index::get();
+                started++;
+                while (started.load() < batch);
+                assert(thread_index::get() == idx[i]);
+            });
+        }
+        for (std::thread &t: threads) {
+            t.join();
+        }
+        for (uint64_t i = 0; i < batch; i++) {
+            assert(idx[i] != base);
+            assert(idx[i] <= batch);
+            for (uint64_t j = 0; j < i; j++) {
+                assert(idx[i] != idx[j]);
+            }
+        }
+    }
+}
+
+#undef ND_TEST_LIVE
+#undef ND_TEST_DEAD
@@ -0,0 +1,146 @@
+/*
+ * ===============================================================
+ *    Description:  Unit test for the out edge index of high degree
+ *                  nodes: lookups match a scan of the out edges as
+ *                  edges and properties are added and removed.
+ *
+ *        Created:  2026-10-19 13:14:09
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <assert.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "common/config_constants.h"
+#include "db/edge.h"
+#include "db/out_edge_index.h"
+
+#define OEI_TEST_NBRS 50
+
+// edges of all versions with nbr 'nbr', or with a version of property key=value if nbr is empty
+std::vector<db::edge*>
+oei_test_scan(db::data_map<std::vector<db::edge*>> &out_edges,
+    const node_handle_t &nbr, const std::string &key, const std::string &value)
+{
+    std::vector<db::edge*> edges;
+    for (auto &p: out_edges) {
+        for (db::edge *e: p.second) {
+            if (!nbr.empty()) {
+                if (e->nbr.handle == nbr) {
+                    edges.emplace_back(e);
+                }
+                continue;
+            }
+#ifdef weaver_large_property_maps_
+            auto iter = e->base.properties.find(key);
+            if (iter == e->base.properties.end()) {
+                continue;
+            }
+            for (const std::shared_ptr<db::property> &prop: iter->second) {
+#else
+            for (const std::shared_ptr<db::property> &prop: e->base.properties) {
+                if (prop->key != key) {
+                    continue;
+                }
+#endif
+                if (prop->value == value) {
+                    edges.emplace_back(e);
+                    break;
+                }
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    return edges;
+}
+
+void
+oei_test_check(db::out_edge_index &index, db::data_map<std::vector<db::edge*>> &out_edges)
+{
+    for (uint64_t i = 0; i < OEI_TEST_NBRS; i++) {
+        node_handle_t nbr = "nbr" + std::to_string(i);
+        std::vector<db::edge*> edges;
+        index.edges_to(nbr, edges);
+        assert(edges == oei_test_scan(out_edges, nbr, "", ""));
+    }
+    for (const std::string &value: {"red", "green", "blue", "none"}) {
+        std::vector<db::edge*> edges;
+        assert(index.edges_with("color", value, edges));
+        assert(edges == oei_test_scan(out_edges, "", "color", value));
+    }
+}
+
+void
+out_edge_index_test()
+{
+    std::vector<std::string> old_keys = EdgeIndexKeys;
+    EdgeIndexKeys = {"color"};
+    vclock_ptr_t clk(new vc::vclock(0, 0));
+    const char *colors[] = {"red", "green", "blue"};
+
+    // several edges to each nbr, some edges with more than one version
+    db::data_map<std::vector<db::edge*>> out_edges;
+    std::vector<db::edge*> all;
+    for (uint64_t i = 0; i < 1000; i++) {
+        edge_handle_t handle = "e" + std::to_string(i);
+        db::edge *e = new db::edge(handle, clk, 0, "nbr" + std::to_string(i % OEI_TEST_NBRS));
+        e->base.add_property("color", colors[i % 3], clk);
+        e->base.add_property("weight", std::to_string(i), clk);
+        out_edges[handle].emplace_back(e);
+        all.emplace_back(e);
+        if (i % 10 == 0) {
+            db::edge *v2 = new db::edge(handle, clk, 0, "nbr" + std::to_string((i + 1) % OEI_TEST_NBRS));
+            out_edges[handle].emplace_back(v2);
+            all.emplace_back(v2);
+        }
+    }
+
+    db::out_edge_index index;
+    index.build(out_edges);
+    assert(index.indexed("color"));
+    assert(!index.indexed("weight"));
+    std::vector<db::edge*> edges;
+    assert(!index.edges_with("weight", "1", edges));
+    assert(edges.empty());
+    oei_test_check(index, out_edges);
+
+    // edge added after the build, and a property set to a new value: the edge is
+    // a candidate for both values, and appears once if a value is set again
+    db::edge *e = new db::edge("new", clk, 0, "nbr7");
+    out_edges["new"].emplace_back(e);
+    all.emplace_back(e);
+    index.add_edge(e);
+    e->base.add_property("color", "red", clk);
+    index.add_property(e, "color", "red");
+    e->base.add_property("color", "blue", clk);
+    index.add_property(e, "color", "blue");
+    index.add_property(e, "color", "blue");
+    index.add_property(e, "weight", "5");
+    oei_test_check(index, out_edges);
+    edges.clear();
+    index.edges_with("color", "blue", edges);
+    assert(std::count(edges.begin(), edges.end(), e) == 1);
+
+    // permanently deleted edges leave every lookup
+    for (auto &p: out_edges) {
+        std::vector<db::edge*> &versions = p.second;
+        if (p.first.size() > 1 && p.first[1] == '1') {
+            for (db::edge *del: versions) {
+                index.remove_edge(del);
+            }
+            versions.clear();
+        }
+    }
+    oei_test_check(index, out_edges);
+
+    for (db::edge *del: all) {
+        delete del;
+    }
+    EdgeIndexKeys = old_keys;
+}
+
+#undef OEI_TEST_NBRS
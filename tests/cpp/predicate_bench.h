@@ -0,0 +1,124 @@
+/*
+ * ===============================================================
+ *    Description:  Latency of traverse with props and discover
+ *                  paths programs with 1 to 8 edge predicates.
+ *
+ *        Created:  2026-10-19 17:09:15
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <vector>
+
+#include "common/property_predicate.h"
+#include "client/client.h"
+
+// uses time_edge_bench_prog from edge_list_bench.h
+
+#define PRED_BENCH_MAX_PREDS 8
+#define PRED_BENCH_TX_SIZE 1000
+#define PRED_BENCH_MISS_PERIOD 2 // one in this many edges fails the first predicate
+
+// src with num_edges out edges to mid nodes, each with one edge to dst
+// every edge has properties p0 .. p7, so discover paths predicates hold on the mid edges
+void
+create_pred_bench_graph(client &cl, const std::string &src, const std::string &dst, uint64_t num_edges)
+{
+    std::vector<std::string> no_aliases;
+    std::string handle = src;
+    cl.begin_tx();
+    cl.create_node(handle, no_aliases);
+    handle = dst;
+    cl.create_node(handle, no_aliases);
+    cl.end_tx();
+
+    for (uint64_t i = 0; i < num_edges; i++) {
+        if (i % PRED_BENCH_TX_SIZE == 0) {
+            cl.begin_tx();
+        }
+        std::string mid = src + "_mid" + std::to_string(i);
+        std::string edge = "";
+        std::string mid_edge = "";
+        cl.create_node(mid, no_aliases);
+        cl.create_edge(edge, src, "", mid, "");
+        cl.create_edge(mid_edge, mid, "", dst, "");
+        for (uint64_t p = 0; p < PRED_BENCH_MAX_PREDS; p++) {
+            std::string value = (p == 0 && i % PRED_BENCH_MISS_PERIOD == 0)? "miss" : "value" + std::to_string(p);
+            cl.set_edge_property(src, "", edge, "p" + std::to_string(p), value);
+            cl.set_edge_property(mid, "", mid_edge, "p" + std::to_string(p), "value" + std::to_string(p));
+        }
+        if (i % PRED_BENCH_TX_SIZE == (PRED_BENCH_TX_SIZE-1) || i == (num_edges-1)) {
+            cl.end_tx();
+        }
+    }
+}
+
+// num_preds predicates on p0 .. p<num_preds-1>, cycling through the relations
+std::vector<predicate::prop_predicate>
+pred_bench_predicates(uint64_t num_preds)
+{
+    static const predicate::relation rels[] = {predicate::EQUALS,
+        predicate::STARTS_WITH,
+        predicate::CONTAINS,
+        predicate::GREATER_EQUAL,
+        predicate::ENDS_WITH,
+        predicate::LESS_EQUAL,
+        predicate::EQUALS,
+        predicate::CONTAINS};
+    std::vector<predicate::prop_predicate> preds;
+    for (uint64_t p = 0; p < num_preds; p++) {
+        predicate::prop_predicate pred;
+        pred.key = "p" + std::to_string(p);
+        pred.rel = rels[p];
+        switch (pred.rel) {
+            case predicate::STARTS_WITH:
+                pred.value = "val";
+                break;
+            case predicate::ENDS_WITH:
+                pred.value = std::to_string(p);
+                break;
+            case predicate::CONTAINS:
+                pred.value = "lue";
+                break;
+            default:
+                pred.value = "value" + std::to_string(p);
+        }
+        preds.emplace_back(pred);
+    }
+    return preds;
+}
+
+// for 1 .. 8 predicates on the out edges of a node with num_edges edges, half of which pass:
+// traverse with props over equality predicates, and discover paths of length 2 with mixed relations
+void
+run_predicate_bench(uint64_t num_edges, uint64_t num_requests)
+{
+    client cl("127.0.0.1", 2002, "/usr/local/etc/weaver.yaml");
+    std::string src = "pred_bench_src" + std::to_string(num_edges);
+    std::string dst = "pred_bench_dst" + std::to_string(num_edges);
+    create_pred_bench_graph(cl, src, dst, num_edges);
+
+    for (uint64_t num_preds = 1; num_preds <= PRED_BENCH_MAX_PREDS; num_preds++) {
+        node_prog::traverse_props_params traverse;
+        std::vector<std::pair<std::string, std::string>> edge_props;
+        for (uint64_t p = 0; p < num_preds; p++) {
+            edge_props.emplace_back("p" + std::to_string(p), "value" + std::to_string(p));
+        }
+        traverse.node_aliases.resize(2);
+        traverse.node_props.resize(2);
+        traverse.edge_props.emplace_back(edge_props);
+
+        node_prog::discover_paths_params discover;
+        discover.dest = dst;
+        discover.path_len = 2;
+        discover.edge_preds = pred_bench_predicates(num_preds);
+
+        double traverse_us = time_edge_bench_prog(cl, &client::traverse_props_program, src, traverse, num_requests);
+        double discover_us = time_edge_bench_prog(cl, &client::discover_paths_program, src, discover, num_requests);
+
+        WDEBUG << num_preds << " predicates, degree " << num_edges << ": "
+               << "traverse with props " << traverse_us << " us, "
+               << "discover paths " << discover_us << " us" << std::endl;
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ * ===============================================================
+ *    Description:  Unit test for compiled property predicates:
+ *                  relations, term order, and agreement with
+ *                  prop_predicate::check.
+ *
+ *        Created:  2026-10-19 13:31:48
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <assert.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/property_predicate.h"
+
+using predicate::prop_predicate;
+using predicate::compiled_predicates;
+
+// true if every predicate holds for some property, as element::has_all_predicates
+inline bool
+pp_test_check_all(const std::vector<prop_predicate> &preds, const std::vector<node_prog::property> &props)
+{
+    for (const prop_predicate &pred: preds) {
+        bool found = false;
+        for (const node_prog::property &prop: props) {
+            if (pred.check(prop)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool
+pp_test_check_all(const compiled_predicates &preds, const std::vector<node_prog::property> &props)
+{
+    for (const compiled_predicates::term &t: preds.get_terms()) {
+        bool found = false;
+        for (const node_prog::property &prop: props) {
+            if (prop.key == t.key && t.test(prop.value, t.value)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+property_predicate_test()
+{
+    using namespace predicate;
+
+    // relations, values compared as strings
+    assert(test_for(EQUALS)("abc", "abc") && !test_for(EQUALS)("abc", "ab"));
+    assert(test_for(LESS)("10", "9") && !test_for(LESS)("9", "9"));
+    assert(test_for(GREATER)("b", "abc") && !test_for(GREATER)("abc", "abc"));
+    assert(test_for(LESS_EQUAL)("9", "9") && !test_for(LESS_EQUAL)("b", "a"));
+    assert(test_for(GREATER_EQUAL)("9", "9") && !test_for(GREATER_EQUAL)("a", "b"));
+    assert(test_for(STARTS_WITH)("abc", "ab") && test_for(STARTS_WITH)("abc", "") && !test_for(STARTS_WITH)("ab", "abc"));
+    assert(test_for(ENDS_WITH)("abc", "bc") && !test_for(ENDS_WITH)("bc", "abc") && !test_for(ENDS_WITH)("abc", "ab"));
+    assert(test_for(CONTAINS)("abc", "b") && test_for(CONTAINS)("abc", "") && !test_for(CONTAINS)("abc", "ac"));
+
+    // most selective relation first, longer value first within a relation, duplicates dropped
+    std::vector<prop_predicate> preds = {
+        {"k", "a", CONTAINS},
+        {"k", "a", LESS},
+        {"k", "ab", STARTS_WITH},
+        {"k", "a", EQUALS},
+        {"k", "abc", ENDS_WITH},
+        {"k", "abcd", EQUALS},
+        {"k", "a", EQUALS},
+    };
+    compiled_predicates compiled(preds);
+    const std::vector<compiled_predicates::term> &terms = compiled.get_terms();
+    assert(terms.size() == 6);
+    assert(terms[0].rel == EQUALS && terms[0].value == "abcd");
+    assert(terms[1].rel == EQUALS && terms[1].value == "a");
+    assert(terms[2].rel == ENDS_WITH && terms[2].value == "abc");
+    assert(terms[3].rel == STARTS_WITH && terms[3].value == "ab");
+    assert(terms[4].rel == CONTAINS);
+    assert(terms[5].rel == LESS);
+
+    std::vector<std::pair<std::string, std::string>> pairs = {{"a", "1"}, {"b", "2"}, {"a", "1"}};
+    compiled_predicates from_pairs(pairs);
+    assert(from_pairs.get_terms().size() == 2);
+    for (const compiled_predicates::term &t: from_pairs.get_terms()) {
+        assert(t.rel == EQUALS);
+    }
+    assert(compiled_predicates(std::vector<prop_predicate>()).empty());
+
+    // compiled predicates accept the same property sets as the predicates they came from
+    std::mt19937_64 rng(42);
+    const char *keys[] = {"name", "type", "age"};
+    const char *values[] = {"", "a", "ab", "abc", "b", "ba", "10", "9"};
+    relation rels[] = {EQUALS, LESS, GREATER, LESS_EQUAL, GREATER_EQUAL, STARTS_WITH, ENDS_WITH, CONTAINS};
+    uint64_t accepted = 0;
+    for (uint64_t i = 0; i < 100000; i++) {
+        std::vector<node_prog::property> props(rng() % 5);
+        for (node_prog::property &p: props) {
+            p.key = keys[rng() % 3];
+            p.value = values[rng() % 8];
+        }
+        std::vector<prop_predicate> random_preds(rng() % 4);
+        for (prop_predicate &p: random_preds) {
+            p.key = keys[rng() % 3];
+            p.value = values[rng() % 8];
+            p.rel = rels[rng() % 8];
+        }
+        bool expected = pp_test_check_all(random_preds, props);
+        assert(pp_test_check_all(compiled_predicates(random_preds), props) == expected);
+        if (expected) {
+            accepted++;
+        }
+    }
+    WDEBUG << "compiled predicates accepted " << accepted << " of 100000 random property sets" << std::endl;
+}
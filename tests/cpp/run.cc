@@ -15,6 +15,11 @@
 #include "common/weaver_constants.h"
 
 #include "tests/cpp/read_only_vertex_bench.h"
+#include "tests/cpp/celebrity_read_bench.h"
+#include "tests/cpp/node_directory_bench.h"
+#include "tests/cpp/metrics_bench.h"
+#include "tests/cpp/edge_list_bench.h"
+#include "tests/cpp/predicate_bench.h"
 //#include "message_test.h"
 //#include "message_tx.h"
 //#include "tx_msg_nmap.h"
@@ -77,6 +82,13 @@ main(int argc, char *argv[])
     ////clustering_prog_test();
 #endif
 #ifndef __ALL_TESTS__
+    //run_celebrity_read_bench(100000, 64, 10000);
+    //run_node_directory_bench<old_node_maps>("sparse_hash_map", 100000000, 64);
+    //run_node_directory_bench<new_node_maps>("node_directory", 100000000, 64);
+    //run_metrics_bench(10000000, 64);
+    //run_edge_list_bench(10000, 10000000, 1000);
+    //run_edge_index_bench(10000, 1000000, 1000);
+    //run_predicate_bench(10000, 1000);
     //multiple_sparse_reachability(true);
     //unreachable_reach_prog(true);
     //clique_reach_prog(true);
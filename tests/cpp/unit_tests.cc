@@ -0,0 +1,41 @@
+/*
+ * ===============================================================
+ *    Description:  Unit tests of single components, run by
+ *                  make check.  Each test asserts on failure.
+ *
+ *        Created:  2026-10-19 11:00:43
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#define weaver_debug_
+#include "common/weaver_constants.h"
+
+#include "tests/cpp/bloom_filter_test.h"
+#include "tests/cpp/node_directory_test.h"
+#include "tests/cpp/graphml_reader_test.h"
+#include "tests/cpp/local_storage_test.h"
+#include "tests/cpp/out_edge_index_test.h"
+#include "tests/cpp/property_predicate_test.h"
+
+int
+main()
+{
+    bloom_filter_test();
+    WDEBUG << "Bloom filter ok." << std::endl;
+    node_directory_test();
+    WDEBUG << "Node directory ok." << std::endl;
+    thread_index_test();
+    WDEBUG << "Thread index ok." << std::endl;
+    graphml_reader_test();
+    WDEBUG << "GraphML reader ok." << std::endl;
+    local_storage_test();
+    WDEBUG << "Local storage ok." << std::endl;
+    out_edge_index_test();
+    WDEBUG << "Out edge index ok." << std::endl;
+    property_predicate_test();
+    WDEBUG << "Compiled predicates ok." << std::endl;
+
+    return 0;
+}
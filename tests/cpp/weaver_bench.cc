@@ -0,0 +1,593 @@
+/*
+ * ===============================================================
+ *    Description:  Reproducible client workloads against a running
+ *                  Weaver cluster, reports throughput and latency
+ *                  percentiles.  The transactions workload compares
+ *                  write latency of storage backends, the cachedreach
+ *                  workload shard cache budgets, the ingest workload
+ *                  initial node placement.  Graph analysis and
+ *                  whole-graph bsp workloads can run on SNAP edge
+ *                  lists.  The cluster, with its server manager,
+ *                  Kronos and storage, is started separately.
+ *
+ *        Created:  2026-10-19 15:51:21
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <e/popt.h>
+
+#include "common/clock.h"
+#include "client/client.h"
+
+using cl::client;
+
+enum bench_workload
+{
+    POINT_READS,
+    TRAVERSALS,
+    MIXED,
+    TRANSACTIONS,
+    CACHED_TRAVERSALS, // traversals among hot_nodes nodes, with the node program cache
+    INGEST, // new nodes, each created with edges to and from out_degree existing nodes
+    N_HOP_PATHS,
+    SHORTEST_PATHS,
+    TRIANGLES,
+    PAGERANK, // bsp jobs over the whole graph
+    COMPONENTS,
+    DEGREES
+};
+
+struct bench_params
+{
+    const char *host;
+    uint16_t port;
+    const char *config_file;
+    bench_workload workload;
+    uint64_t num_nodes;
+    uint64_t out_degree;
+    uint64_t num_clients;
+    uint64_t num_ops;
+    uint64_t seed;
+    double read_fraction;
+    uint64_t traversal_hops;
+    uint64_t tx_size;
+    uint64_t hot_nodes;
+    const char *snap_file;
+    uint64_t supersteps;
+};
+
+// results of one client thread
+struct bench_result
+{
+    std::vector<uint64_t> latencies; // nanoseconds
+    uint64_t failures;
+
+    bench_result() : failures(0) { }
+};
+
+static std::string
+bench_node(uint64_t i)
+{
+    return "bench" + std::to_string(i);
+}
+
+// node i has an edge to i+1, and out_degree-1 edges to random nodes
+// same seed gives the same graph
+void
+create_bench_graph(const bench_params &params)
+{
+    client cl(params.host, params.port, params.config_file);
+    std::mt19937_64 gen(params.seed);
+    std::uniform_int_distribution<uint64_t> node_dist(0, params.num_nodes-1);
+    std::vector<std::string> no_aliases;
+    const uint64_t tx_size = 1000;
+
+    for (uint64_t i = 0; i < params.num_nodes; i++) {
+        if (i % tx_size == 0) {
+            cl.begin_tx();
+        }
+        std::string handle = bench_node(i);
+        cl.create_node(handle, no_aliases);
+        if (i % tx_size == (tx_size-1) || i == (params.num_nodes-1)) {
+            if (cl.end_tx() != cl::WEAVER_CLIENT_SUCCESS) {
+                std::cerr << "node creation tx failed" << std::endl;
+            }
+        }
+    }
+
+    uint64_t num_edges = params.num_nodes * params.out_degree;
+    for (uint64_t e = 0; e < num_edges; e++) {
+        if (e % tx_size == 0) {
+            cl.begin_tx();
+        }
+        uint64_t src = e / params.out_degree;
+        uint64_t dst = (e % params.out_degree == 0)? (src+1) % params.num_nodes : node_dist(gen);
+        std::string edge_handle = "";
+        cl.create_edge(edge_handle, bench_node(src), "", bench_node(dst), "");
+        if (e % tx_size == (tx_size-1) || e == (num_edges-1)) {
+            if (cl.end_tx() != cl::WEAVER_CLIENT_SUCCESS) {
+                std::cerr << "edge creation tx failed" << std::endl;
+            }
+        }
+    }
+}
+
+// SNAP edge list, one "src dst" pair per line and '#' comments.  SNAP ids are
+// renumbered densely in order of appearance, and every edge is created in both
+// directions, as the triangle program expects.  Sets num_nodes.
+bool
+load_snap_graph(bench_params &params)
+{
+    std::ifstream file(params.snap_file);
+    if (!file) {
+        std::cerr << "could not open " << params.snap_file << std::endl;
+        return false;
+    }
+
+    std::unordered_map<uint64_t, uint64_t> ids;
+    std::vector<std::pair<uint64_t, uint64_t>> edges;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream ls(line);
+        uint64_t src, dst;
+        if (!(ls >> src >> dst)) {
+            continue;
+        }
+        src = ids.emplace(src, ids.size()).first->second;
+        dst = ids.emplace(dst, ids.size()).first->second;
+        if (src != dst) {
+            edges.emplace_back(src, dst);
+        }
+    }
+    params.num_nodes = ids.size();
+
+    client cl(params.host, params.port, params.config_file);
+    std::vector<std::string> no_aliases;
+    const uint64_t tx_size = 1000;
+    for (uint64_t i = 0; i < params.num_nodes; i++) {
+        if (i % tx_size == 0) {
+            cl.begin_tx();
+        }
+        std::string handle = bench_node(i);
+        cl.create_node(handle, no_aliases);
+        if (i % tx_size == (tx_size-1) || i == (params.num_nodes-1)) {
+            if (cl.end_tx() != cl::WEAVER_CLIENT_SUCCESS) {
+                std::cerr << "node creation tx failed" << std::endl;
+            }
+        }
+    }
+    for (uint64_t e = 0; e < edges.size(); e++) {
+        if (e % tx_size == 0) {
+            cl.begin_tx();
+        }
+        std::string edge_handle = "";
+        cl.create_edge(edge_handle, bench_node(edges[e].first), "", bench_node(edges[e].second), "");
+        edge_handle = "";
+        cl.create_edge(edge_handle, bench_node(edges[e].second), "", bench_node(edges[e].first), "");
+        if (e % tx_size == (tx_size-1) || e == (edges.size()-1)) {
+            if (cl.end_tx() != cl::WEAVER_CLIENT_SUCCESS) {
+                std::cerr << "edge creation tx failed" << std::endl;
+            }
+        }
+    }
+    std::cout << "loaded " << params.snap_file << ": " << params.num_nodes << " nodes, "
+              << edges.size() << " undirected edges" << std::endl;
+    return true;
+}
+
+// graph analysis program on random nodes, triangles and bsp jobs run over the whole graph
+cl::weaver_client_returncode
+run_analysis_op(client &cl, const bench_params &params, uint64_t node)
+{
+    cl::weaver_client_returncode code;
+    std::string dest = bench_node((node + params.traversal_hops) % params.num_nodes);
+
+    if (params.workload >= PAGERANK) {
+        bsp::params bp;
+        bsp::result res;
+        if (params.workload == PAGERANK) {
+            bp.algo = bsp::PAGERANK;
+        } else if (params.workload == COMPONENTS) {
+            bp.algo = bsp::CONNECTED_COMPONENTS;
+        } else {
+            bp.algo = bsp::DEGREE_DISTRIBUTION;
+        }
+        bp.max_supersteps = params.supersteps;
+        code = cl.run_bsp_program(bp, res);
+    } else if (params.workload == N_HOP_PATHS) {
+        node_prog::n_hop_reach_params rp, return_params;
+        rp.dest = dest;
+        rp.max_hops = params.traversal_hops;
+        std::vector<std::pair<std::string, node_prog::n_hop_reach_params>> args(1, std::make_pair(bench_node(node), rp));
+        code = cl.run_n_hop_reach_program(args, return_params);
+    } else if (params.workload == SHORTEST_PATHS) {
+        node_prog::dijkstra_params dp, return_params;
+        dp.dst_handle = dest;
+        std::vector<std::pair<std::string, node_prog::dijkstra_params>> args(1, std::make_pair(bench_node(node), dp));
+        code = cl.run_dijkstra_program(args, return_params);
+    } else {
+        node_prog::triangle_params tp, return_params;
+        std::vector<std::pair<std::string, node_prog::triangle_params>> args;
+        args.reserve(params.num_nodes);
+        for (uint64_t i = 0; i < params.num_nodes; i++) {
+            args.emplace_back(std::make_pair(bench_node(i), tp));
+        }
+        code = cl.run_triangle_program(args, return_params);
+    }
+
+    return code;
+}
+
+// write loop of tests/python/correctness/transactions.py: alternately a tx that creates
+// tx_size edges between nodes of the same parity, and a tx that deletes tx_size of them
+void
+run_write_tx(client &cl, const bench_params &params, std::mt19937_64 &gen,
+    std::vector<std::pair<std::string, std::string>> &created_edges,
+    bench_result *result)
+{
+    std::uniform_int_distribution<uint64_t> node_dist(0, params.num_nodes-1);
+    wclock::weaver_timer timer;
+    bool create = (created_edges.size() < params.tx_size) || (gen() & 1);
+    std::vector<std::pair<std::string, std::string>> tx_edges;
+
+    uint64_t start = timer.get_time_elapsed();
+    cl.begin_tx();
+    for (uint64_t j = 0; j < params.tx_size; j++) {
+        if (create) {
+            uint64_t n1 = node_dist(gen);
+            uint64_t n2 = node_dist(gen);
+            if (n1 % 2 != n2 % 2) {
+                n2 = (n2 + 1) % params.num_nodes;
+            }
+            std::string edge_handle = "";
+            cl.create_edge(edge_handle, bench_node(n1), "", bench_node(n2), "");
+            tx_edges.emplace_back(std::make_pair(edge_handle, bench_node(n1)));
+        } else {
+            std::uniform_int_distribution<uint64_t> edge_dist(0, created_edges.size()-1);
+            uint64_t idx = edge_dist(gen);
+            std::swap(created_edges[idx], created_edges.back());
+            cl.delete_edge(created_edges.back().first, created_edges.back().second, "");
+            tx_edges.emplace_back(created_edges.back());
+            created_edges.pop_back();
+        }
+    }
+    cl::weaver_client_returncode code = cl.end_tx();
+    uint64_t end = timer.get_time_elapsed();
+
+    if (code == cl::WEAVER_CLIENT_SUCCESS) {
+        result->latencies.emplace_back(end - start);
+        if (create) {
+            created_edges.insert(created_edges.end(), tx_edges.begin(), tx_edges.end());
+        }
+    } else {
+        result->failures++;
+        if (!create) {
+            // deletes did not happen
+            created_edges.insert(created_edges.end(), tx_edges.begin(), tx_edges.end());
+        }
+    }
+}
+
+// one node created together with its edges, so that the timestamper can place it near its nbrs
+// edge cut of the result is logged by shards on exit, two hop latency measured by the traversals workload
+void
+run_ingest_tx(client &cl, const bench_params &params, std::mt19937_64 &gen,
+    uint64_t client_id, uint64_t i,
+    bench_result *result)
+{
+    std::uniform_int_distribution<uint64_t> node_dist(0, params.num_nodes-1);
+    std::vector<std::string> no_aliases;
+    wclock::weaver_timer timer;
+    std::string handle = "ingest" + std::to_string(client_id) + "_" + std::to_string(i);
+
+    uint64_t start = timer.get_time_elapsed();
+    cl.begin_tx();
+    cl.create_node(handle, no_aliases);
+    for (uint64_t j = 0; j < params.out_degree; j++) {
+        std::string nbr = bench_node(node_dist(gen));
+        std::string out_edge = "", in_edge = "";
+        cl.create_edge(out_edge, handle, "", nbr, "");
+        cl.create_edge(in_edge, nbr, "", handle, "");
+    }
+    cl::weaver_client_returncode code = cl.end_tx();
+    uint64_t end = timer.get_time_elapsed();
+
+    if (code == cl::WEAVER_CLIENT_SUCCESS) {
+        result->latencies.emplace_back(end - start);
+    } else {
+        result->failures++;
+    }
+}
+
+void
+run_bench_client(const bench_params &params, uint64_t client_id, bench_result *result)
+{
+    client cl(params.host, params.port, params.config_file);
+    std::mt19937_64 gen(params.seed + client_id + 1);
+    std::uniform_int_distribution<uint64_t> node_dist(0, params.num_nodes-1);
+    std::uniform_real_distribution<double> op_dist(0.0, 1.0);
+    wclock::weaver_timer timer;
+    result->latencies.reserve(params.num_ops);
+
+    // edges created by this client and not yet deleted, (edge handle, source node)
+    std::vector<std::pair<std::string, std::string>> created_edges;
+
+    for (uint64_t i = 0; i < params.num_ops; i++) {
+        if (params.workload == TRANSACTIONS) {
+            run_write_tx(cl, params, gen, created_edges, result);
+            continue;
+        }
+        if (params.workload == INGEST) {
+            run_ingest_tx(cl, params, gen, client_id, i, result);
+            continue;
+        }
+
+        uint64_t node = node_dist(gen);
+        if (params.workload == CACHED_TRAVERSALS) {
+            node %= params.hot_nodes;
+        }
+        if (params.workload >= N_HOP_PATHS) {
+            uint64_t start = timer.get_time_elapsed();
+            cl::weaver_client_returncode code = run_analysis_op(cl, params, node);
+            uint64_t end = timer.get_time_elapsed();
+            if (code == cl::WEAVER_CLIENT_SUCCESS) {
+                result->latencies.emplace_back(end - start);
+            } else {
+                result->failures++;
+            }
+            continue;
+        }
+
+        bool read = (params.workload == POINT_READS)
+                 || (params.workload == MIXED && op_dist(gen) < params.read_fraction);
+        cl::weaver_client_returncode code;
+
+        uint64_t start = timer.get_time_elapsed();
+        if (read) {
+            node_prog::read_node_props_params rp, return_params;
+            std::vector<std::pair<std::string, node_prog::read_node_props_params>> args(1, std::make_pair(bench_node(node), rp));
+            code = cl.read_node_props_program(args, return_params);
+        } else if (params.workload == TRAVERSALS || params.workload == CACHED_TRAVERSALS) {
+            // destination is reachable along the ring, random edges usually give a shorter path
+            node_prog::reach_params rp, return_params;
+            rp.dest = bench_node((node + params.traversal_hops) % params.num_nodes);
+            rp.prev_node = db::coordinator;
+            if (params.workload == CACHED_TRAVERSALS) {
+                rp._search_cache = true;
+                rp._cache_key = rp.dest;
+            }
+            std::vector<std::pair<std::string, node_prog::reach_params>> args(1, std::make_pair(bench_node(node), rp));
+            code = cl.run_reach_program(args, return_params);
+            if (code == cl::WEAVER_CLIENT_SUCCESS && !return_params.reachable) {
+                code = cl::WEAVER_CLIENT_ABORT;
+            }
+        } else {
+            uint64_t nbr = node_dist(gen);
+            std::string edge_handle = "";
+            cl.begin_tx();
+            cl.set_node_property(bench_node(node), "", "bench_key", std::to_string(i));
+            cl.create_edge(edge_handle, bench_node(node), "", bench_node(nbr), "");
+            code = cl.end_tx();
+        }
+        uint64_t end = timer.get_time_elapsed();
+
+        if (code == cl::WEAVER_CLIENT_SUCCESS) {
+            result->latencies.emplace_back(end - start);
+        } else {
+            result->failures++;
+        }
+    }
+}
+
+static double
+percentile_ms(const std::vector<uint64_t> &sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    uint64_t idx = std::min((uint64_t)(p * sorted.size()), (uint64_t)sorted.size()-1);
+    return (double)sorted[idx] / 1000000;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    const char *host = "127.0.0.1";
+    long port = 2002;
+    const char *config_file = "/usr/local/etc/weaver.yaml";
+    const char *workload = "reads";
+    long num_nodes = 10000;
+    long out_degree = 4;
+    long num_clients = 8;
+    long num_ops = 10000;
+    long seed = 42;
+    const char *read_fraction = "0.9";
+    long traversal_hops = 3;
+    long tx_size = 100;
+    long hot_nodes = 100;
+    bool load = false;
+    const char *snap_file = nullptr;
+    long supersteps = 20;
+    long traversal_sampling = -1;
+
+    e::argparser ap;
+    ap.autohelp();
+    ap.arg().name('h', "host")
+            .description("timestamper to connect to (default: 127.0.0.1)")
+            .metavar("IP").as_string(&host);
+    ap.arg().name('p', "port")
+            .description("timestamper port (default: 2002)")
+            .metavar("port").as_long(&port);
+    ap.arg().long_name("config-file")
+            .description("full path of weaver.yaml configuration file (default /usr/local/etc/weaver.yaml)")
+            .metavar("filename").as_string(&config_file);
+    ap.arg().name('w', "workload")
+            .description("reads, traversals, mixed, transactions, cachedreach, ingest, nhop, paths, "
+                         "triangles, pagerank, components, or degrees (default: reads)")
+            .metavar("name").as_string(&workload);
+    ap.arg().name('n', "nodes")
+            .description("number of nodes in the benchmark graph (default: 10000)")
+            .metavar("num").as_long(&num_nodes);
+    ap.arg().name('d', "out-degree")
+            .description("out edges per node in the benchmark graph, and per new node in the ingest workload (default: 4)")
+            .metavar("num").as_long(&out_degree);
+    ap.arg().name('c', "clients")
+            .description("concurrent clients (default: 8)")
+            .metavar("num").as_long(&num_clients);
+    ap.arg().name('o', "ops")
+            .description("operations per client (default: 10000)")
+            .metavar("num").as_long(&num_ops);
+    ap.arg().name('s', "seed")
+            .description("random seed for graph and workload (default: 42)")
+            .metavar("num").as_long(&seed);
+    ap.arg().long_name("read-fraction")
+            .description("fraction of reads in the mixed workload (default: 0.9)")
+            .metavar("fraction").as_string(&read_fraction);
+    ap.arg().long_name("traversal-hops")
+            .description("distance along the ring between traversal source and destination (default: 3)")
+            .metavar("num").as_long(&traversal_hops);
+    ap.arg().long_name("tx-size")
+            .description("edges created or deleted per transaction in the transactions workload (default: 100)")
+            .metavar("num").as_long(&tx_size);
+    ap.arg().long_name("hot-nodes")
+            .description("traversal sources in the cachedreach workload, repeated to hit the cache (default: 100)")
+            .metavar("num").as_long(&hot_nodes);
+    ap.arg().name('l', "load")
+            .description("create the benchmark graph before running")
+            .set_true(&load);
+    ap.arg().long_name("snap-file")
+            .description("create the graph from a SNAP edge list instead of generating it")
+            .metavar("filename").as_string(&snap_file);
+    ap.arg().long_name("supersteps")
+            .description("pagerank iterations, and superstep limit for components, 0 for none (default: 20)")
+            .metavar("num").as_long(&supersteps);
+    ap.arg().long_name("traversal-sampling")
+            .description("set shards to sample one in this many node program visits before running, 0 for off (default: unchanged)")
+            .metavar("num").as_long(&traversal_sampling);
+
+    if (!ap.parse(argc, argv) || ap.args_sz() != 0) {
+        std::cerr << "args parsing failure" << std::endl;
+        return -1;
+    }
+
+    bench_params params;
+    params.host = host;
+    params.port = (uint16_t)port;
+    params.config_file = config_file;
+    params.num_nodes = num_nodes;
+    params.out_degree = out_degree;
+    params.num_clients = num_clients;
+    params.num_ops = num_ops;
+    params.seed = seed;
+    params.read_fraction = atof(read_fraction);
+    params.traversal_hops = traversal_hops;
+    params.tx_size = tx_size;
+    params.hot_nodes = hot_nodes;
+    params.snap_file = snap_file;
+    params.supersteps = supersteps;
+    if (strcmp(workload, "reads") == 0) {
+        params.workload = POINT_READS;
+    } else if (strcmp(workload, "traversals") == 0) {
+        params.workload = TRAVERSALS;
+    } else if (strcmp(workload, "mixed") == 0) {
+        params.workload = MIXED;
+    } else if (strcmp(workload, "transactions") == 0) {
+        params.workload = TRANSACTIONS;
+    } else if (strcmp(workload, "cachedreach") == 0) {
+        params.workload = CACHED_TRAVERSALS;
+    } else if (strcmp(workload, "ingest") == 0) {
+        params.workload = INGEST;
+    } else if (strcmp(workload, "nhop") == 0) {
+        params.workload = N_HOP_PATHS;
+    } else if (strcmp(workload, "paths") == 0) {
+        params.workload = SHORTEST_PATHS;
+    } else if (strcmp(workload, "triangles") == 0) {
+        params.workload = TRIANGLES;
+    } else if (strcmp(workload, "pagerank") == 0) {
+        params.workload = PAGERANK;
+    } else if (strcmp(workload, "components") == 0) {
+        params.workload = COMPONENTS;
+    } else if (strcmp(workload, "degrees") == 0) {
+        params.workload = DEGREES;
+    } else {
+        std::cerr << "unknown workload " << workload << std::endl;
+        return -1;
+    }
+
+    if (params.num_nodes == 0 || params.out_degree == 0) {
+        std::cerr << "need at least one node and one out edge per node" << std::endl;
+        return -1;
+    }
+    if (params.hot_nodes == 0) {
+        params.hot_nodes = params.num_nodes;
+    }
+
+    wclock::weaver_timer timer;
+    if (params.snap_file != nullptr) {
+        uint64_t start = timer.get_time_elapsed();
+        if (!load_snap_graph(params) || params.num_nodes == 0) {
+            return -1;
+        }
+        std::cout << "created graph in " << (double)(timer.get_time_elapsed() - start) / NANO << " s" << std::endl;
+    } else if (load) {
+        uint64_t start = timer.get_time_elapsed();
+        create_bench_graph(params);
+        std::cout << "created graph with " << params.num_nodes << " nodes, "
+                  << params.num_nodes * params.out_degree << " edges in "
+                  << (double)(timer.get_time_elapsed() - start) / NANO << " s" << std::endl;
+    }
+
+    if (traversal_sampling >= 0) {
+        client cl(params.host, params.port, params.config_file);
+        if (cl.set_traversal_sampling((uint64_t)traversal_sampling) != cl::WEAVER_CLIENT_SUCCESS) {
+            std::cerr << "could not set traversal sampling" << std::endl;
+            return -1;
+        }
+    }
+
+    std::vector<bench_result> results(params.num_clients);
+    std::vector<std::thread> threads;
+    uint64_t start = timer.get_time_elapsed();
+    for (uint64_t i = 0; i < params.num_clients; i++) {
+        threads.emplace_back(std::thread(run_bench_client, std::cref(params), i, &results[i]));
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    double secs = (double)(timer.get_time_elapsed() - start) / NANO;
+
+    std::vector<uint64_t> latencies;
+    uint64_t failures = 0;
+    for (const bench_result &r: results) {
+        latencies.insert(latencies.end(), r.latencies.begin(), r.latencies.end());
+        failures += r.failures;
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "workload " << workload << ", " << params.num_clients << " clients, seed " << params.seed << std::endl
+              << "ops " << latencies.size() << ", failed " << failures << ", time " << secs << " s" << std::endl
+              << "throughput " << (latencies.size() / secs) << " ops/s" << std::endl
+              << "latency ms: p50 " << percentile_ms(latencies, 0.5)
+              << ", p90 " << percentile_ms(latencies, 0.9)
+              << ", p99 " << percentile_ms(latencies, 0.99)
+              << ", p99.9 " << percentile_ms(latencies, 0.999)
+              << ", max " << (latencies.empty()? 0 : (double)latencies.back() / 1000000) << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,550 @@
+/*
+ * ===============================================================
+ *    Description:  Offline repartitioner.  Partitions a SNAP edge
+ *                  list with restreaming LDG, weighting edges by
+ *                  the traversal counts exported by shards, and
+ *                  writes a WEAVER format graph file with the
+ *                  placement for bulk loading.
+ *
+ *        Created:  2026-10-19 16:42:39
+ *
+ *         Author:  agent, agent@local
+ * ===============================================================
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <e/popt.h>
+
+#include "common/clock.h"
+
+#define REPART_UNASSIGNED UINT32_MAX
+#define REPART_BLOCK 4096 // nodes streamed by a thread before it picks its next block
+#define REPART_MIN_MOVED 0.001 // stop restreaming when fewer than this fraction of nodes move
+
+struct repart_params
+{
+    const char *graph_file;
+    const char *output_file;
+    std::vector<const char*> stats_files;
+    uint32_t num_shards;
+    uint32_t num_threads;
+    uint32_t passes;
+    double slack;
+    double traffic_weight;
+};
+
+// undirected graph over dense node ids, each edge stored in both directions
+struct repart_graph
+{
+    std::vector<uint64_t> ids; // dense id -> SNAP id, sorted
+    std::vector<std::pair<uint32_t, uint32_t>> edges; // directed edges of the input, dense ids
+    std::vector<uint64_t> offsets; // node -> first adjacency entry
+    std::vector<uint32_t> adj;
+    std::vector<float> weights; // 1 + traffic_weight * traversals, per adjacency entry
+    std::vector<uint64_t> traffic; // traversals per adjacency entry
+};
+
+static double
+elapsed_secs(wclock::weaver_timer &timer, uint64_t start)
+{
+    return (double)(timer.get_time_elapsed() - start) / NANO;
+}
+
+// run func(tid) on num_threads threads
+template <typename Func>
+static void
+parallel(uint32_t num_threads, Func func)
+{
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < num_threads; t++) {
+        threads.emplace_back(func, t);
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+}
+
+static bool
+parse_uint64(const char *&p, const char *end, uint64_t &n)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+    n = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        n = n*10 + (*p - '0');
+        p++;
+    }
+    return true;
+}
+
+// parses the lines starting in [begin, end) of the file, a line belongs to the range its first byte is in
+// lines of at least two unsigned ints are passed to func, '#' comments and other lines are skipped
+template <typename Func>
+static bool
+parse_range(const char *file_name, uint64_t begin, uint64_t end, Func func)
+{
+    std::ifstream file(file_name, std::ifstream::in | std::ifstream::binary);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    if (begin > 0) {
+        // the line containing begin-1 belongs to the previous range
+        file.seekg(begin-1);
+        std::getline(file, line);
+    }
+
+    while ((uint64_t)file.tellg() < end && std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const char *p = line.data();
+        const char *line_end = p + line.size();
+        uint64_t n1, n2, n3 = 1;
+        if (!parse_uint64(p, line_end, n1) || !parse_uint64(p, line_end, n2)) {
+            continue;
+        }
+        parse_uint64(p, line_end, n3);
+        func(n1, n2, n3);
+    }
+    return true;
+}
+
+static uint64_t
+file_size(const char *file_name)
+{
+    std::ifstream file(file_name, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+    return file? (uint64_t)file.tellg() : 0;
+}
+
+static uint32_t
+dense_id(const repart_graph &g, uint64_t id)
+{
+    auto iter = std::lower_bound(g.ids.begin(), g.ids.end(), id);
+    if (iter == g.ids.end() || *iter != id) {
+        return REPART_UNASSIGNED;
+    }
+    return (uint32_t)(iter - g.ids.begin());
+}
+
+// graph file is split into one byte range per thread
+static bool
+load_graph(const repart_params &params, repart_graph &g)
+{
+    uint64_t sz = file_size(params.graph_file);
+    if (sz == 0) {
+        std::cerr << "could not read " << params.graph_file << std::endl;
+        return false;
+    }
+
+    uint32_t nt = params.num_threads;
+    std::vector<std::vector<std::pair<uint64_t, uint64_t>>> raw(nt);
+    std::vector<std::vector<uint64_t>> ids(nt);
+    parallel(nt, [&](uint32_t t) {
+        parse_range(params.graph_file, sz*t/nt, sz*(t+1)/nt, [&](uint64_t n1, uint64_t n2, uint64_t) {
+            raw[t].emplace_back(n1, n2);
+            ids[t].emplace_back(n1);
+            ids[t].emplace_back(n2);
+        });
+        std::sort(ids[t].begin(), ids[t].end());
+        ids[t].erase(std::unique(ids[t].begin(), ids[t].end()), ids[t].end());
+    });
+
+    // merge sorted id lists pairwise, in parallel at each level
+    for (uint32_t step = 1; step < nt; step *= 2) {
+        parallel((nt + 2*step - 1) / (2*step), [&](uint32_t i) {
+            uint32_t a = 2*step*i, b = a + step;
+            if (b >= nt) {
+                return;
+            }
+            std::vector<uint64_t> merged;
+            merged.reserve(ids[a].size() + ids[b].size());
+            std::set_union(ids[a].begin(), ids[a].end(), ids[b].begin(), ids[b].end(), std::back_inserter(merged));
+            ids[a].swap(merged);
+            std::vector<uint64_t>().swap(ids[b]);
+        });
+    }
+    g.ids.swap(ids[0]);
+    if (g.ids.size() >= REPART_UNASSIGNED) {
+        std::cerr << "too many nodes " << g.ids.size() << std::endl;
+        return false;
+    }
+
+    std::vector<uint64_t> edge_offsets(nt+1, 0);
+    for (uint32_t t = 0; t < nt; t++) {
+        edge_offsets[t+1] = edge_offsets[t] + raw[t].size();
+    }
+    g.edges.resize(edge_offsets[nt]);
+    parallel(nt, [&](uint32_t t) {
+        uint64_t e = edge_offsets[t];
+        for (const auto &p: raw[t]) {
+            g.edges[e++] = std::make_pair(dense_id(g, p.first), dense_id(g, p.second));
+        }
+        std::vector<std::pair<uint64_t, uint64_t>>().swap(raw[t]);
+    });
+
+    // csr, adjacency of each node sorted so that traffic can be matched to edges
+    uint64_t num_nodes = g.ids.size();
+    std::unique_ptr<std::atomic<uint64_t>[]> degree(new std::atomic<uint64_t>[num_nodes]);
+    for (uint64_t v = 0; v < num_nodes; v++) {
+        degree[v] = 0;
+    }
+    parallel(nt, [&](uint32_t t) {
+        for (uint64_t e = g.edges.size()*t/nt; e < g.edges.size()*(t+1)/nt; e++) {
+            degree[g.edges[e].first]++;
+            degree[g.edges[e].second]++;
+        }
+    });
+    g.offsets.resize(num_nodes+1);
+    g.offsets[0] = 0;
+    for (uint64_t v = 0; v < num_nodes; v++) {
+        g.offsets[v+1] = g.offsets[v] + degree[v];
+        degree[v] = g.offsets[v];
+    }
+    g.adj.resize(g.offsets[num_nodes]);
+    parallel(nt, [&](uint32_t t) {
+        for (uint64_t e = g.edges.size()*t/nt; e < g.edges.size()*(t+1)/nt; e++) {
+            uint32_t u = g.edges[e].first, v = g.edges[e].second;
+            g.adj[degree[u]++] = v;
+            g.adj[degree[v]++] = u;
+        }
+    });
+    parallel(nt, [&](uint32_t t) {
+        for (uint64_t v = num_nodes*t/nt; v < num_nodes*(t+1)/nt; v++) {
+            std::sort(g.adj.begin() + g.offsets[v], g.adj.begin() + g.offsets[v+1]);
+        }
+    });
+    g.weights.assign(g.adj.size(), 1);
+    g.traffic.assign(g.adj.size(), 0);
+
+    return true;
+}
+
+// stats files have one "src dst count" line per traversed edge, as written by shards
+// counts of edges not in the graph, or with non numeric handles, are dropped
+static uint64_t
+load_traffic(const repart_params &params, repart_graph &g)
+{
+    uint32_t nt = params.num_threads;
+    std::vector<std::vector<std::pair<uint64_t, uint64_t>>> entries(nt); // adjacency entry, count
+    std::atomic<uint64_t> dropped(0);
+
+    for (const char *stats_file: params.stats_files) {
+        uint64_t sz = file_size(stats_file);
+        if (sz == 0) {
+            std::cerr << "could not read " << stats_file << ", skipping" << std::endl;
+            continue;
+        }
+        parallel(nt, [&](uint32_t t) {
+            parse_range(stats_file, sz*t/nt, sz*(t+1)/nt, [&](uint64_t n1, uint64_t n2, uint64_t count) {
+                uint32_t u = dense_id(g, n1), v = dense_id(g, n2);
+                if (u == REPART_UNASSIGNED || v == REPART_UNASSIGNED) {
+                    dropped++;
+                    return;
+                }
+                auto begin = g.adj.begin() + g.offsets[u], end = g.adj.begin() + g.offsets[u+1];
+                auto iter = std::lower_bound(begin, end, v);
+                if (iter == end || *iter != v) {
+                    dropped++;
+                    return;
+                }
+                entries[t].emplace_back(iter - g.adj.begin(), count);
+                begin = g.adj.begin() + g.offsets[v];
+                end = g.adj.begin() + g.offsets[v+1];
+                iter = std::lower_bound(begin, end, u);
+                entries[t].emplace_back(iter - g.adj.begin(), count);
+            });
+        });
+    }
+
+    uint64_t total = 0;
+    for (auto &list: entries) {
+        for (const auto &p: list) {
+            g.traffic[p.first] += p.second;
+            total += p.second;
+        }
+    }
+    for (uint64_t i = 0; i < g.adj.size(); i++) {
+        g.weights[i] = 1 + params.traffic_weight * g.traffic[i];
+    }
+    if (dropped > 0) {
+        std::cout << "dropped " << dropped << " traversal counts of edges not in the graph" << std::endl;
+    }
+    return total / 2;
+}
+
+// breadth first order over all components, so that most nodes are streamed after some of their nbrs
+static void
+bfs_order(const repart_graph &g, std::vector<uint32_t> &order)
+{
+    uint64_t num_nodes = g.ids.size();
+    std::vector<bool> seen(num_nodes, false);
+    order.clear();
+    order.reserve(num_nodes);
+    for (uint64_t root = 0; root < num_nodes; root++) {
+        if (seen[root]) {
+            continue;
+        }
+        seen[root] = true;
+        uint64_t head = order.size();
+        order.emplace_back(root);
+        for (; head < order.size(); head++) {
+            uint32_t v = order[head];
+            for (uint64_t i = g.offsets[v]; i < g.offsets[v+1]; i++) {
+                if (!seen[g.adj[i]]) {
+                    seen[g.adj[i]] = true;
+                    order.emplace_back(g.adj[i]);
+                }
+            }
+        }
+    }
+}
+
+// restreaming weighted LDG.  Threads stream disjoint blocks of nodes in
+// breadth first order, and see each other's placements as they are made.
+// A node goes to the shard with the largest weight of edges to it,
+// discounted by how full the shard is, or to the least loaded shard if it
+// has no placed nbrs.
+static void
+partition(const repart_params &params, const repart_graph &g, std::vector<uint32_t> &placement)
+{
+    uint64_t num_nodes = g.ids.size();
+    std::vector<uint32_t> order;
+    bfs_order(g, order);
+    uint32_t k = params.num_shards;
+    double cap = params.slack * num_nodes / k + 1;
+    std::unique_ptr<std::atomic<uint32_t>[]> part(new std::atomic<uint32_t>[num_nodes]);
+    std::unique_ptr<std::atomic<int64_t>[]> sizes(new std::atomic<int64_t>[k]);
+    for (uint64_t v = 0; v < num_nodes; v++) {
+        part[v] = REPART_UNASSIGNED;
+    }
+    for (uint32_t s = 0; s < k; s++) {
+        sizes[s] = 0;
+    }
+
+    wclock::weaver_timer timer;
+    for (uint32_t pass = 0; pass < params.passes; pass++) {
+        uint64_t start = timer.get_time_elapsed();
+        std::atomic<uint64_t> next_block(0), moved(0);
+        parallel(params.num_threads, [&](uint32_t) {
+            std::vector<double> score(k);
+            uint64_t my_moved = 0;
+            while (true) {
+                uint64_t begin = REPART_BLOCK * next_block++;
+                if (begin >= num_nodes) {
+                    break;
+                }
+                uint64_t end = std::min(begin + REPART_BLOCK, num_nodes);
+                for (uint64_t idx = begin; idx < end; idx++) {
+                    uint32_t v = order[idx];
+                    std::fill(score.begin(), score.end(), 0);
+                    for (uint64_t i = g.offsets[v]; i < g.offsets[v+1]; i++) {
+                        uint32_t p = part[g.adj[i]].load(std::memory_order_relaxed);
+                        if (p != REPART_UNASSIGNED) {
+                            score[p] += g.weights[i];
+                        }
+                    }
+
+                    uint32_t old_p = part[v].load(std::memory_order_relaxed);
+                    uint32_t best = REPART_UNASSIGNED;
+                    double best_score = 0;
+                    int64_t best_size = 0;
+                    for (uint32_t s = 0; s < k; s++) {
+                        int64_t size = sizes[s].load(std::memory_order_relaxed) - (s == old_p? 1 : 0);
+                        double val = score[s] * (1 - size/cap);
+                        if (best == REPART_UNASSIGNED
+                         || val > best_score
+                         || (val == best_score && size < best_size)) {
+                            best = s;
+                            best_score = val;
+                            best_size = size;
+                        }
+                    }
+
+                    if (best != old_p) {
+                        if (old_p != REPART_UNASSIGNED) {
+                            sizes[old_p]--;
+                            my_moved++;
+                        }
+                        sizes[best]++;
+                        part[v].store(best, std::memory_order_relaxed);
+                    }
+                }
+            }
+            moved += my_moved;
+        });
+
+        std::cout << "pass " << pass << ": moved " << moved << " nodes in "
+                  << elapsed_secs(timer, start) << " s" << std::endl;
+        if (pass > 0 && moved < REPART_MIN_MOVED * num_nodes) {
+            break;
+        }
+    }
+
+    placement.resize(num_nodes);
+    for (uint64_t v = 0; v < num_nodes; v++) {
+        placement[v] = part[v];
+    }
+}
+
+static void
+report_quality(const char *name, const repart_params &params, const repart_graph &g,
+    const std::vector<uint32_t> &placement, uint64_t total_traffic)
+{
+    uint32_t nt = params.num_threads;
+    std::vector<uint64_t> cut(nt, 0), traffic_cut(nt, 0);
+    parallel(nt, [&](uint32_t t) {
+        for (uint64_t e = g.edges.size()*t/nt; e < g.edges.size()*(t+1)/nt; e++) {
+            if (placement[g.edges[e].first] != placement[g.edges[e].second]) {
+                cut[t]++;
+            }
+        }
+        uint64_t num_nodes = g.ids.size();
+        for (uint64_t v = num_nodes*t/nt; v < num_nodes*(t+1)/nt; v++) {
+            for (uint64_t i = g.offsets[v]; i < g.offsets[v+1]; i++) {
+                if (placement[v] != placement[g.adj[i]]) {
+                    traffic_cut[t] += g.traffic[i];
+                }
+            }
+        }
+    });
+
+    uint64_t total_cut = 0, total_traffic_cut = 0;
+    for (uint32_t t = 0; t < nt; t++) {
+        total_cut += cut[t];
+        total_traffic_cut += traffic_cut[t];
+    }
+    std::vector<uint64_t> sizes(params.num_shards, 0);
+    for (uint32_t p: placement) {
+        sizes[p]++;
+    }
+    uint64_t max_size = *std::max_element(sizes.begin(), sizes.end());
+
+    std::cout << std::fixed << std::setprecision(4) << name
+              << ": edge cut " << (g.edges.empty()? 0 : (double)total_cut / g.edges.size())
+              << ", traversals cut " << (total_traffic == 0? 0 : (double)total_traffic_cut / 2 / total_traffic)
+              << ", max shard / mean " << (double)max_size * params.num_shards / placement.size() << std::endl;
+}
+
+// "#<num_nodes>", then "<node id> <shard>" per node with shards from 0, then the edge list
+static bool
+write_weaver_file(const repart_params &params, const repart_graph &g, const std::vector<uint32_t> &placement)
+{
+    std::ofstream out(params.output_file, std::ofstream::out | std::ofstream::binary);
+    if (!out) {
+        std::cerr << "could not write " << params.output_file << std::endl;
+        return false;
+    }
+
+    out << '#' << g.ids.size() << '\n';
+    for (uint64_t v = 0; v < g.ids.size(); v++) {
+        out << g.ids[v] << ' ' << placement[v] << '\n';
+    }
+    for (const auto &e: g.edges) {
+        out << g.ids[e.first] << ' ' << g.ids[e.second] << '\n';
+    }
+    return (bool)out;
+}
+
+int
+main(int argc, const char *argv[])
+{
+    const char *graph_file = nullptr;
+    const char *output_file = nullptr;
+    long num_shards = 8;
+    long num_threads = std::thread::hardware_concurrency();
+    long passes = 10;
+    const char *slack = "1.1";
+    const char *traffic_weight = "1.0";
+
+    e::argparser ap;
+    ap.autohelp();
+    ap.option_string("[OPTION]... [TRAVERSAL-STATS-FILE]...");
+    ap.arg().name('g', "graph-file")
+            .description("SNAP edge list to partition (no default)")
+            .metavar("filename").as_string(&graph_file);
+    ap.arg().name('o', "output-file")
+            .description("WEAVER format graph file to write (default: <graph-file>.weaver)")
+            .metavar("filename").as_string(&output_file);
+    ap.arg().name('k', "shards")
+            .description("number of shards (default: 8)")
+            .metavar("num").as_long(&num_shards);
+    ap.arg().name('t', "threads")
+            .description("partitioning threads (default: number of cores)")
+            .metavar("num").as_long(&num_threads);
+    ap.arg().long_name("passes")
+            .description("max restreaming passes (default: 10)")
+            .metavar("num").as_long(&passes);
+    ap.arg().long_name("slack")
+            .description("shard capacity as a multiple of the mean shard size (default: 1.1)")
+            .metavar("factor").as_string(&slack);
+    ap.arg().long_name("traffic-weight")
+            .description("weight of one traversal of an edge, relative to the edge itself (default: 1.0)")
+            .metavar("weight").as_string(&traffic_weight);
+
+    if (!ap.parse(argc, argv) || graph_file == nullptr || num_shards <= 0 || passes <= 0) {
+        std::cerr << "args parsing failure" << std::endl;
+        return -1;
+    }
+
+    repart_params params;
+    std::string default_output = std::string(graph_file) + ".weaver";
+    params.graph_file = graph_file;
+    params.output_file = output_file == nullptr? default_output.c_str() : output_file;
+    for (size_t i = 0; i < ap.args_sz(); i++) {
+        params.stats_files.emplace_back(ap.args()[i]);
+    }
+    params.num_shards = num_shards;
+    params.num_threads = num_threads > 0? num_threads : 1;
+    params.passes = passes;
+    params.slack = atof(slack);
+    params.traffic_weight = atof(traffic_weight);
+
+    wclock::weaver_timer timer;
+    uint64_t start = timer.get_time_elapsed();
+    repart_graph g;
+    if (!load_graph(params, g)) {
+        return -1;
+    }
+    std::cout << "loaded " << g.ids.size() << " nodes, " << g.edges.size() << " edges in "
+              << elapsed_secs(timer, start) << " s" << std::endl;
+
+    start = timer.get_time_elapsed();
+    uint64_t total_traffic = load_traffic(params, g);
+    std::cout << "loaded " << total_traffic << " traversals from " << params.stats_files.size() << " files in "
+              << elapsed_secs(timer, start) << " s" << std::endl;
+
+    // modulo placement, the hash baseline of stream_partition.py
+    std::vector<uint32_t> placement(g.ids.size());
+    for (uint64_t v = 0; v < g.ids.size(); v++) {
+        placement[v] = g.ids[v] % params.num_shards;
+    }
+    report_quality("hash", params, g, placement, total_traffic);
+
+    start = timer.get_time_elapsed();
+    partition(params, g, placement);
+    std::cout << "partitioned in " << elapsed_secs(timer, start) << " s with " << params.num_threads << " threads" << std::endl;
+    report_quality("ldg", params, g, placement, total_traffic);
+
+    start = timer.get_time_elapsed();
+    if (!write_weaver_file(params, g, placement)) {
+        return -1;
+    }
+    std::cout << "wrote " << params.output_file << " in " << elapsed_secs(timer, start) << " s" << std::endl;
+
+    return 0;
+}
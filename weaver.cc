@@ -26,6 +26,8 @@ main(int argc, const char* argv[])
     cmds.push_back(e::subcommand("timestamper",           "Start a new Weaver timestamper"));
     cmds.push_back(e::subcommand("shard",                 "Start a new Weaver shard"));
     cmds.push_back(e::subcommand("parse-config",          "Parse the Weaver configuration file"));
+    cmds.push_back(e::subcommand("bench",                 "Run a benchmark workload against a Weaver cluster"));
+    cmds.push_back(e::subcommand("repartition",           "Partition a graph file using shard edge traversal counts"));
 
     return dispatch_to_subcommands(argc, argv,
                                    "weaver", "Weaver",